@@ -36,6 +36,8 @@
 #include <errno.h>
 #include <unistd.h>
 #include <assert.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include "fpga_dma_internal.h"
 #include "fpga_dma.h"
 #include "tbb/concurrent_queue.h"
@@ -422,6 +424,108 @@ static void dump_hw_desc_log(int i, msgdma_hw_desc_t *desc, ofstream &f)
 #endif
 }
 
+// Worker wait tuning: spin, then pause, then block
+#define DMA_WAIT_SPINS 1024
+#define DMA_WAIT_PAUSES 1024
+#define DMA_WAIT_BLOCK_MS 10
+#define DMA_WAIT_MAX_SLEEP_US 64
+
+static inline void cpu_relax(void)
+{
+	__asm__ __volatile__("pause" : : : "memory");
+}
+
+static int doorbell_init(dma_doorbell_t *db)
+{
+	db->waiters = 0;
+	db->efd = eventfd(0, EFD_CLOEXEC);
+	return db->efd < 0 ? -1 : 0;
+}
+
+static void doorbell_destroy(dma_doorbell_t *db)
+{
+	if (db->efd >= 0) {
+		close(db->efd);
+		db->efd = -1;
+	}
+}
+
+// Wake the worker parked on db, if any. Called after a push.
+static void doorbell_ring(dma_doorbell_t *db)
+{
+	uint64_t one = 1;
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (db->waiters.load() && write(db->efd, &one, sizeof(one)) < 0)
+		FPGA_DMA_ERR("doorbell write failed");
+}
+
+// Pop an item from queue, waiting according to the channel's wait mode.
+template <typename T>
+static void wait_pop(fpga_dma_handle_t dma_h, concurrent_queue<T> &queue,
+		     dma_doorbell_t *db, T &item)
+{
+	uint32_t spins = 0;
+
+	while (!queue.try_pop(item)) {
+		if (dma_h->wait_mode == DMA_WAIT_POLL || spins < DMA_WAIT_SPINS) {
+			++spins;
+		} else if (spins < DMA_WAIT_SPINS + DMA_WAIT_PAUSES) {
+			cpu_relax();
+			++spins;
+		} else {
+			struct pollfd pfd = { db->efd, POLLIN, 0 };
+			uint64_t count;
+
+			db->waiters++;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			// The timeout bounds the cost of a missed wakeup.
+			if (queue.empty() &&
+			    poll(&pfd, 1, DMA_WAIT_BLOCK_MS) > 0 &&
+			    read(db->efd, &count, sizeof(count)) < 0)
+				FPGA_DMA_ERR("doorbell read failed");
+			db->waiters--;
+		}
+	}
+}
+
+// Wait for the hardware to hand a descriptor back.
+static void wait_hw_desc(fpga_dma_handle_t dma_h, msgdma_hw_desc_t *desc)
+{
+	uint32_t spins = 0;
+	useconds_t sleep_us = 1;
+
+	while (desc->owned_by_hw == 1) {
+		if (dma_h->wait_mode == DMA_WAIT_POLL || spins < DMA_WAIT_SPINS) {
+			++spins;
+		} else if (spins < DMA_WAIT_SPINS + DMA_WAIT_PAUSES) {
+			cpu_relax();
+			++spins;
+		} else if (dma_h->wait_mode == DMA_WAIT_INTERRUPT) {
+			struct pollfd pfd = { dma_h->irq_fd, POLLIN, 0 };
+			msgdma_prefetcher_status_t pre_status;
+			uint64_t count;
+
+			if (poll(&pfd, 1, DMA_WAIT_BLOCK_MS) > 0) {
+				if (read(dma_h->irq_fd, &count, sizeof(count)) < 0)
+					FPGA_DMA_ERR("interrupt read failed");
+				// acknowledge (write 1 to clear)
+				pre_status.reg = 0;
+				pre_status.st.irq = 1;
+				MMIOWrite64Blk(dma_h, PREFETCHER_STATUS(dma_h),
+					       (uint64_t)&pre_status.reg,
+					       sizeof(pre_status.reg));
+			}
+		} else {
+			// The descriptor lives in host memory written by the
+			// device, so there is nothing to block on; back off.
+			usleep(sleep_us);
+			if (sleep_us < DMA_WAIT_MAX_SLEEP_US)
+				sleep_us <<= 1;
+		}
+	}
+}
+
 // Dispatcher worker thread
 // Process transfers from ingress queue. For each transfer,
 // assign a hardware descriptor from a block
@@ -449,8 +553,9 @@ static void *dispatcherWorker(void* dma_handle) {
 		return NULL;
 	}
 
-	// open log file for debug
 	ofstream disp_log;
+#if FPGA_DMA_DEBUG
+	// open log file for debug
 	disp_log.open ("disp.log");
 
 	disp_log << std::setw(10) << "format"
@@ -460,81 +565,86 @@ static void *dispatcherWorker(void* dma_handle) {
 		<< std::setw(20) << "dst"
 		<< std::setw(20) << "len"
 		<< std::setw(20) << "next_desc\n";
+#endif
 
 	debug_print("started dispatcher worker\n");
 	while (1) {
 		// wait for a valid transfer
-		while(dma_h->ingress_queue.empty());
-		if (dma_h->ingress_queue.try_pop(sw_desc[desc_count])) {
-			if (sw_desc[desc_count]->kill_worker) {
+		wait_pop(dma_h, dma_h->ingress_queue, &dma_h->ingress_db,
+			 sw_desc[desc_count]);
+		if (sw_desc[desc_count]->kill_worker) {
+			if (disp_log.is_open())
 				disp_log.close();
-				dma_h->pending_queue.push(sw_desc[desc_count]);
-				debug_print("Killing worker\n");
-				break;
-			}
+			dma_h->pending_queue.push(sw_desc[desc_count]);
+			doorbell_ring(&dma_h->pending_db);
+			debug_print("Killing worker\n");
+			break;
+		}
 
-			// make a note of the first block descriptor
-			// mark it valid only after packing rest of the block
-			first_sw_desc = sw_desc[1];
-			is_owned_by_hw = (desc_count == 1)  ? false:true;
-
-			// refer prefetcher spec
-			if (desc_count == 1) {
-				if (sw_desc[desc_count]->transfer->is_last_buf)
-					format = 0x3;
-				else
-					format = 0x1;
-			} else if (desc_count == FPGA_DMA_BLOCK_SIZE || sw_desc[desc_count]->transfer->is_last_buf)
-				format = 0x2;
-			else
-				format = 0x0;
-			
-			// assign a free hardware descriptor to this transfer
-			// if a free descriptor isn't available, wait here
-			while(dma_h->free_desc.empty());
-			dma_h->free_desc.try_pop(hw_descp);
-
-			sw_desc[desc_count]->id = desc_count;
-			assign_hw_desc(sw_desc[desc_count], hw_descp, is_owned_by_hw, block_size, format);
-
-			// ready to dispatch the block
-			if ((desc_count == FPGA_DMA_BLOCK_SIZE) /* we have a full block*/ ||
-				sw_desc[desc_count]->transfer->is_last_buf /*app. requested block dispatch for this transfer*/
-				) {
-
-				first_sw_desc->hw_descp->hw_desc->block_size = desc_count - 1;
-				first_sw_desc->hw_descp->hw_desc->owned_by_hw = 1;
-
-				// push valid descriptors to completion queue
-				uint64_t k;
-				for(k=1; k <= desc_count; k++) {
-					dump_hw_desc_log(0, sw_desc[k]->hw_descp->hw_desc, disp_log);
-					if(k == desc_count)
-						sw_desc[k]->last = 1;
-					dma_h->pending_queue.push(sw_desc[k]);
-				}
+		// make a note of the first block descriptor
+		// mark it valid only after packing rest of the block
+		first_sw_desc = sw_desc[1];
+		is_owned_by_hw = (desc_count == 1)  ? false:true;
 
-				// Skip invalid descriptors
-				for(k=1; k<= (FPGA_DMA_BLOCK_SIZE-desc_count); k++) {
-					msgdma_hw_descp_t *unused_hw_descp;
-					while(dma_h->free_desc.empty());
-					dma_h->free_desc.try_pop(unused_hw_descp);
-					dump_hw_desc_log(0, unused_hw_descp->hw_desc, disp_log);
-					dma_h->invalid_desc_queue.push(unused_hw_descp);
-				}
+		// refer prefetcher spec
+		if (desc_count == 1) {
+			if (sw_desc[desc_count]->transfer->is_last_buf)
+				format = 0x3;
+			else
+				format = 0x1;
+		} else if (desc_count == FPGA_DMA_BLOCK_SIZE || sw_desc[desc_count]->transfer->is_last_buf)
+			format = 0x2;
+		else
+			format = 0x0;
+
+		// assign a free hardware descriptor to this transfer
+		// if a free descriptor isn't available, wait here
+		wait_pop(dma_h, dma_h->free_desc, &dma_h->free_db, hw_descp);
+
+		sw_desc[desc_count]->id = desc_count;
+		assign_hw_desc(sw_desc[desc_count], hw_descp, is_owned_by_hw, block_size, format);
+
+		// ready to dispatch the block
+		if ((desc_count == FPGA_DMA_BLOCK_SIZE) /* we have a full block*/ ||
+			sw_desc[desc_count]->transfer->is_last_buf /*app. requested block dispatch for this transfer*/
+			) {
+
+			// one interrupt per block, when its last descriptor completes
+			hw_descp->hw_desc->ctrl.transfer_irq_en =
+				(dma_h->wait_mode == DMA_WAIT_INTERRUPT) ? 1 : 0;
+
+			first_sw_desc->hw_descp->hw_desc->block_size = desc_count - 1;
+			first_sw_desc->hw_descp->hw_desc->owned_by_hw = 1;
+
+			// push valid descriptors to completion queue
+			uint64_t k;
+			for(k=1; k <= desc_count; k++) {
+				dump_hw_desc_log(0, sw_desc[k]->hw_descp->hw_desc, disp_log);
+				if(k == desc_count)
+					sw_desc[k]->last = 1;
+				dma_h->pending_queue.push(sw_desc[k]);
+			}
+			doorbell_ring(&dma_h->pending_db);
+
+			// Skip invalid descriptors
+			for(k=1; k<= (FPGA_DMA_BLOCK_SIZE-desc_count); k++) {
+				msgdma_hw_descp_t *unused_hw_descp;
+				wait_pop(dma_h, dma_h->free_desc, &dma_h->free_db, unused_hw_descp);
+				dump_hw_desc_log(0, unused_hw_descp->hw_desc, disp_log);
+				dma_h->invalid_desc_queue.push(unused_hw_descp);
+			}
 
-				// reset descriptor count
-				desc_count = 1;
-			} else
-				desc_count++;
-		}
+			// reset descriptor count
+			desc_count = 1;
+		} else
+			desc_count++;
 	}
 
 	return dma_h;
 }
 
 // Completion worker thread
-// Poll descriptors in pending queue. When the descriptor is marked 
+// Wait on descriptors in pending queue. When the descriptor is marked
 // complete in hw, return the hardware descriptor to free pool and invoke
 // callback associated with the corresponding buffer transfer
 static void *completionWorker(void* dma_handle) {
@@ -548,34 +658,33 @@ static void *completionWorker(void* dma_handle) {
 
 	debug_print("started completion worker\n");
 	while (1) {
-		while(dma_h->pending_queue.empty());
-		if (dma_h->pending_queue.try_pop(sw_desc)) {
-			if (sw_desc->kill_worker)
-				break;
-			while(sw_desc->hw_descp->hw_desc->owned_by_hw == 1);
-			sw_desc->hw_descp->hw_desc->owned_by_hw = 0;
-
-			// return hw_descp to free pool
-			dma_h->free_desc.push(sw_desc->hw_descp);
+		wait_pop(dma_h, dma_h->pending_queue, &dma_h->pending_db, sw_desc);
+		if (sw_desc->kill_worker)
+			break;
+		wait_hw_desc(dma_h, sw_desc->hw_descp->hw_desc);
+		sw_desc->hw_descp->hw_desc->owned_by_hw = 0;
 
-			if(sw_desc->last == 1 && (sw_desc->hw_descp->hw_desc_id < (FPGA_DMA_BLOCK_SIZE - 1))) {
-				for(i = (sw_desc->hw_descp->hw_desc_id + 1) ; i < FPGA_DMA_BLOCK_SIZE ; i++) {
-					msgdma_hw_descp_t *unused_hw_descp;
-					dma_h->invalid_desc_queue.try_pop(unused_hw_descp);
-					dma_h->free_desc.push(unused_hw_descp);
-				}
-			}
+		// return hw_descp to free pool
+		dma_h->free_desc.push(sw_desc->hw_descp);
 
-			if (sw_desc->transfer->cb) {
-				fpga_dma_transfer_status_t status;
-				status.eop_arrived = sw_desc->hw_descp->hw_desc->eop_arrived;
-				status.bytes_transferred = sw_desc->hw_descp->hw_desc->bytes_transferred;
-				sw_desc->transfer->cb(sw_desc->transfer->context, status);
-				destroy_sw_desc(sw_desc);
+		if(sw_desc->last == 1 && (sw_desc->hw_descp->hw_desc_id < (FPGA_DMA_BLOCK_SIZE - 1))) {
+			for(i = (sw_desc->hw_descp->hw_desc_id + 1) ; i < FPGA_DMA_BLOCK_SIZE ; i++) {
+				msgdma_hw_descp_t *unused_hw_descp;
+				dma_h->invalid_desc_queue.try_pop(unused_hw_descp);
+				dma_h->free_desc.push(unused_hw_descp);
 			}
-			// mark transfer complete
-			sem_post(&sw_desc->tf_status);
 		}
+		doorbell_ring(&dma_h->free_db);
+
+		if (sw_desc->transfer->cb) {
+			fpga_dma_transfer_status_t status;
+			status.eop_arrived = sw_desc->hw_descp->hw_desc->eop_arrived;
+			status.bytes_transferred = sw_desc->hw_descp->hw_desc->bytes_transferred;
+			sw_desc->transfer->cb(sw_desc->transfer->context, status);
+			destroy_sw_desc(sw_desc);
+		}
+		// mark transfer complete
+		sem_post(&sw_desc->tf_status);
 	}
 	return dma_h;
 }
@@ -695,6 +804,21 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_index, fpga_dma_h
 	dma_h->fpga_h = fpga;
 	dma_h->mmio_num = 0;
 	dma_h->mmio_offset = 0;
+	dma_h->wait_mode = DMA_WAIT_ADAPTIVE;
+	dma_h->irq_eh = NULL;
+	dma_h->irq_fd = -1;
+	dma_h->ingress_db.efd = dma_h->pending_db.efd = dma_h->free_db.efd = -1;
+
+	if (doorbell_init(&dma_h->ingress_db) ||
+	    doorbell_init(&dma_h->pending_db) ||
+	    doorbell_init(&dma_h->free_db)) {
+		FPGA_DMA_ERR("eventfd failed");
+		doorbell_destroy(&dma_h->ingress_db);
+		doorbell_destroy(&dma_h->pending_db);
+		doorbell_destroy(&dma_h->free_db);
+		delete dma_h;
+		return FPGA_EXCEPTION;
+	}
 
 #ifndef USE_ASE
 	res = fpgaMapMMIO(dma_h->fpga_h, 0, (uint64_t **)&dma_h->mmio_va);
@@ -864,6 +988,7 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_index, fpga_dma_h
 			ON_ERR_GOTO(FPGA_NO_MEMORY, rel_buf, "init sw desc");
 		sw_desc->kill_worker = true;
 		dma_h->ingress_queue.push(sw_desc);
+		doorbell_ring(&dma_h->ingress_db);
 
 		// wait workers to die
 		if (pthread_join(dma_h->ingress_id, &th_retval))
@@ -891,6 +1016,9 @@ out:
 		free(dma_h->block_mem);
 
 	if (!dma_found) {
+		doorbell_destroy(&dma_h->ingress_db);
+		doorbell_destroy(&dma_h->pending_db);
+		doorbell_destroy(&dma_h->free_db);
 		delete dma_h;
 		res = FPGA_NOT_FOUND;
 	}
@@ -957,6 +1085,7 @@ fpga_result fpgaDMAClose(fpga_dma_handle_t dma_h) {
 	}
 	sw_desc->kill_worker = true;
 	dma_h->ingress_queue.push(sw_desc);
+	doorbell_ring(&dma_h->ingress_db);
 
 	// wait workers to die
 	if (pthread_join(dma_h->ingress_id, &th_retval)) {
@@ -968,6 +1097,15 @@ fpga_result fpgaDMAClose(fpga_dma_handle_t dma_h) {
 	}
 	fpgaDMATransferDestroy(&dummy_transfer);
 
+	if (dma_h->irq_eh) {
+		fpgaUnregisterEvent(dma_h->fpga_h, FPGA_EVENT_INTERRUPT, dma_h->irq_eh);
+		fpgaDestroyEventHandle(&dma_h->irq_eh);
+		dma_h->irq_fd = -1;
+	}
+	doorbell_destroy(&dma_h->ingress_db);
+	doorbell_destroy(&dma_h->pending_db);
+	doorbell_destroy(&dma_h->free_db);
+
 	// stop dispatcher
 	msgdma_ctrl_t ctrl;
 	ctrl = {0};
@@ -1015,6 +1153,55 @@ out:
 	return res;
 }
 
+fpga_result fpgaDMASetWaitMode(fpga_dma_handle_t dma, fpga_dma_wait_mode_t mode) {
+	fpga_result res = FPGA_OK;
+
+	if (!dma) {
+		FPGA_DMA_ERR("Invalid DMA handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (mode != DMA_WAIT_ADAPTIVE &&
+	    mode != DMA_WAIT_POLL &&
+	    mode != DMA_WAIT_INTERRUPT) {
+		FPGA_DMA_ERR("Invalid wait mode");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (mode == DMA_WAIT_INTERRUPT && !dma->irq_eh) {
+		msgdma_prefetcher_ctrl_t prefetcher_ctrl;
+
+		res = fpgaCreateEventHandle(&dma->irq_eh);
+		ON_ERR_RETURN(res, "fpgaCreateEventHandle");
+
+		// the channel index selects the interrupt vector
+		res = fpgaRegisterEvent(dma->fpga_h, FPGA_EVENT_INTERRUPT,
+					dma->irq_eh, (uint32_t)dma->dma_channel);
+		ON_ERR_GOTO(res, out_destroy, "fpgaRegisterEvent");
+
+		res = fpgaGetOSObjectFromEventHandle(dma->irq_eh, &dma->irq_fd);
+		ON_ERR_GOTO(res, out_unregister, "fpgaGetOSObjectFromEventHandle");
+
+		// enable the prefetcher's global interrupt
+		res = MMIORead64Blk(dma, PREFETCHER_CTRL(dma), (uint64_t)&prefetcher_ctrl.reg, sizeof(prefetcher_ctrl.reg));
+		ON_ERR_GOTO(res, out_unregister, "MMIORead64Blk");
+		prefetcher_ctrl.ct.irq_mask = 1;
+		res = MMIOWrite64Blk(dma, PREFETCHER_CTRL(dma), (uint64_t)&prefetcher_ctrl.reg, sizeof(prefetcher_ctrl.reg));
+		ON_ERR_GOTO(res, out_unregister, "MMIOWrite64Blk");
+	}
+
+	dma->wait_mode = mode;
+	return FPGA_OK;
+
+out_unregister:
+	fpgaUnregisterEvent(dma->fpga_h, FPGA_EVENT_INTERRUPT, dma->irq_eh);
+out_destroy:
+	fpgaDestroyEventHandle(&dma->irq_eh);
+	dma->irq_eh = NULL;
+	dma->irq_fd = -1;
+	return res;
+}
+
 fpga_result fpgaGetDMAChannelType(fpga_dma_handle_t dma, fpga_dma_channel_type_t *ch_type) {
 	if (!dma) {
 		FPGA_DMA_ERR("Invalid DMA handle");
@@ -1389,6 +1576,7 @@ fpga_result fpgaDMATransfer(fpga_dma_handle_t dma, fpga_dma_transfer_t transfer)
 	if (!sw_desc)
 		return FPGA_EXCEPTION;
 	dma->ingress_queue.push(sw_desc);
+	doorbell_ring(&dma->ingress_db);
 
 	// Blocking transfer
 	if (!sw_desc->transfer->cb) {
@@ -79,6 +79,25 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_idx, fpga_dma_han
 */
 fpga_result fpgaDMAClose(fpga_dma_handle_t dma);
 
+/**
+* fpgaDMASetWaitMode
+*
+* @brief                  Select how the channel's worker threads wait
+*
+*                         DMA_WAIT_ADAPTIVE (the default) spins briefly on
+*                         an empty queue or a busy descriptor, then pauses,
+*                         and finally blocks on an eventfd or backs off with
+*                         short sleeps. DMA_WAIT_POLL busy-polls, as earlier
+*                         versions of this driver did. DMA_WAIT_INTERRUPT
+*                         behaves like DMA_WAIT_ADAPTIVE, but waits for
+*                         descriptor completion on the channel's interrupt.
+*
+* @param[in]  dma         DMA channel handle
+* @param[in]  mode        Wait strategy
+* @returns                FPGA_OK on success, return code otherwise
+*/
+fpga_result fpgaDMASetWaitMode(fpga_dma_handle_t dma, fpga_dma_wait_mode_t mode);
+
 /**
 * fpgaGetDMAChannelType
 *
@@ -40,6 +40,7 @@
 #include "x86-sse2.h"
 #include <iostream>
 #include <fstream>
+#include <atomic>
 
 
 using namespace std;
@@ -334,6 +335,13 @@ typedef struct msgdma_sw_desc {
 	uint64_t last;
 } msgdma_sw_desc_t;
 
+// Eventfd that a worker parks on once its queue has stayed empty
+// through the spin and pause phases of its wait
+typedef struct {
+	int efd;
+	std::atomic<uint32_t> waiters;
+} dma_doorbell_t;
+
 // DMA handle
 struct fpga_dma_handle {
 	fpga_handle fpga_h;
@@ -361,6 +369,13 @@ struct fpga_dma_handle {
 	sem_t dma_init;
 	volatile bool invalidate;
 	volatile bool terminate;
+	// worker wait strategy, see fpgaDMASetWaitMode()
+	volatile fpga_dma_wait_mode_t wait_mode;
+	dma_doorbell_t ingress_db;
+	dma_doorbell_t pending_db;
+	dma_doorbell_t free_db;
+	fpga_event_handle irq_eh;
+	int irq_fd;
 };
 
 // Prefetcher ctrl register
@@ -29,6 +29,7 @@
  */
 #include <iostream>
 #include <cmath>
+#include <sys/resource.h>
 #include "fpga_dma_test_utils.h"
 #include "fpga_dma_common.h"
 
@@ -117,6 +118,34 @@ static double getTime(struct timespec start, struct timespec end) {
 	return (double) diff/(double)1000000000L;
 }
 
+struct usage_sample {
+	struct timespec wall;
+	struct rusage ru;
+};
+
+static void usage_begin(struct usage_sample *u) {
+	clock_gettime(CLOCK_MONOTONIC, &u->wall);
+	getrusage(RUSAGE_SELF, &u->ru);
+}
+
+// Print the process CPU time as a percentage of one core over the test
+static void usage_report(const struct usage_sample *u) {
+	struct timespec wall;
+	struct rusage ru;
+	double cpu;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall);
+	getrusage(RUSAGE_SELF, &ru);
+
+	cpu = (ru.ru_utime.tv_sec - u->ru.ru_utime.tv_sec) +
+	      (ru.ru_stime.tv_sec - u->ru.ru_stime.tv_sec) +
+	      ((ru.ru_utime.tv_usec - u->ru.ru_utime.tv_usec) +
+	       (ru.ru_stime.tv_usec - u->ru.ru_stime.tv_usec)) / 1e6;
+
+	std::cout << "CPU usage = " << std::round(100.0 * cpu / getTime(u->wall, wall))
+		  << "% of one core" << std::endl;
+}
+
 static fpga_result prepare_checker(fpga_handle afc_h, uint64_t size)
 {
 	fpga_result res;
@@ -739,6 +768,7 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 	fpga_dma_handle_t rx_dma_h = NULL;
 	fpga_handle afc_h = NULL;
 	fpga_result res;
+	struct usage_sample usage;
 	#ifndef USE_ASE
 	volatile uint64_t *mmio_ptr = NULL;
 	#endif
@@ -776,9 +806,14 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 		ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
 		debug_print("opened memory to memory channel\n");
 
+		res = fpgaDMASetWaitMode(dma_h, config->wait_mode);
+		ON_ERR_GOTO(res, out_dma_close, "fpgaDMASetWaitMode");
+
 		// Run test
+		usage_begin(&usage);
 		res = non_loopback_test(afc_h, dma_h, config);
 		ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
+		usage_report(&usage);
 		debug_print("non loopback test success\n");
 	} else {
 		if(config->loopback == DMA_LOOPBACK_OFF) {
@@ -794,9 +829,14 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 				debug_print("opened stream to memory channel\n");
 			}
 
+			res = fpgaDMASetWaitMode(dma_h, config->wait_mode);
+			ON_ERR_GOTO(res, out_dma_close, "fpgaDMASetWaitMode");
+
 			// Run test
+			usage_begin(&usage);
 			res = non_loopback_test(afc_h, dma_h, config);
 			ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
+			usage_report(&usage);
 			debug_print("non loopback test success\n");
 		} else {
 			res = fpgaDMAOpen(afc_h, 0, &tx_dma_h);
@@ -805,9 +845,16 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 			res = fpgaDMAOpen(afc_h, 1, &rx_dma_h);
 			ON_ERR_GOTO(res, out_rx_close, "fpgaDMAOpen rx");
 
+			res = fpgaDMASetWaitMode(tx_dma_h, config->wait_mode);
+			ON_ERR_GOTO(res, out_rx_close, "fpgaDMASetWaitMode tx");
+			res = fpgaDMASetWaitMode(rx_dma_h, config->wait_mode);
+			ON_ERR_GOTO(res, out_rx_close, "fpgaDMASetWaitMode rx");
+
 			// Run test
+			usage_begin(&usage);
 			res = loopback_test(afc_h, tx_dma_h, rx_dma_h, config);
 			ON_ERR_GOTO(res, out_rx_close, "loopback test failed");
+			usage_report(&usage);
 			debug_print("loopback test success\n");
 		}
 	}
@@ -81,6 +81,13 @@ typedef enum {
 	MM
 } fpga_dma_channel_type_t;
 
+// Worker thread wait strategies
+typedef enum {
+	DMA_WAIT_ADAPTIVE = 0, // spin, then pause, then block
+	DMA_WAIT_POLL,         // busy-poll; lowest latency, one core per worker
+	DMA_WAIT_INTERRUPT     // adaptive, blocking on the channel's interrupt
+} fpga_dma_wait_mode_t;
+
 // Opaque object that describes a DMA transfer
 typedef struct fpga_dma_transfer *fpga_dma_transfer_t;
 
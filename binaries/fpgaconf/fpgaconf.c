@@ -434,7 +434,7 @@ int main(int argc, char *argv[])
 	if (config.dry_run)
 		printf("--dry-run is set\n");
 
-	/* allocate memory and read bitstream data */
+	/* map bitstream file and resolve its PR interface ID */
 	print_msg(1, "Reading bitstream");
 	result = opae_load_bitstream(config.filename, &info);
 	if (result != FPGA_OK) {
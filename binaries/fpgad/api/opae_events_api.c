@@ -42,6 +42,32 @@ log_printf("opae_events_api: " format, ##__VA_ARGS__)
 STATIC pthread_mutex_t list_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 STATIC api_client_event_registry *event_registry_list;
 
+// Registries hashed by (event, object_id), so that sending an
+// event visits only the subscribers of that event.
+#define EVENT_INDEX_BITS    8
+#define EVENT_INDEX_BUCKETS (1 << EVENT_INDEX_BITS)
+STATIC api_client_event_registry *event_index[EVENT_INDEX_BUCKETS];
+
+STATIC unsigned event_index_bucket(fpga_event_type e, uint64_t object_id)
+{
+	uint64_t h = (object_id ^ ((uint64_t)e << 56)) *
+		0x9e3779b97f4a7c15ULL;
+	return (unsigned)(h >> (64 - EVENT_INDEX_BITS));
+}
+
+STATIC void event_index_remove(api_client_event_registry *r)
+{
+	api_client_event_registry **trav =
+		&event_index[event_index_bucket(r->event, r->object_id)];
+
+	while (*trav && *trav != r)
+		trav = &(*trav)->index_next;
+
+	if (*trav)
+		*trav = r->index_next;
+	r->index_next = NULL;
+}
+
 int opae_api_register_event(int conn_socket,
 			    int fd,
 			    fpga_event_type e,
@@ -49,6 +75,7 @@ int opae_api_register_event(int conn_socket,
 {
 	api_client_event_registry *r =
 		(api_client_event_registry *) opae_malloc(sizeof(*r));
+	unsigned bucket;
 	int err;
 
 	if (!r)
@@ -59,12 +86,20 @@ int opae_api_register_event(int conn_socket,
 	r->data = 1;
 	r->event = e;
 	r->object_id = object_id;
+	r->prev = NULL;
+
+	bucket = event_index_bucket(e, object_id);
 
 	fpgad_mutex_lock(err, &list_lock);
 
 	r->next = event_registry_list;
+	if (event_registry_list)
+		event_registry_list->prev = r;
 	event_registry_list = r;
 
+	r->index_next = event_index[bucket];
+	event_index[bucket] = r;
+
 	fpgad_mutex_unlock(err, &list_lock);
 
 	return 0;
@@ -76,74 +111,46 @@ STATIC void release_event_registry(api_client_event_registry *r)
 	opae_free(r);
 }
 
+// Caller holds list_lock.
+STATIC void unlink_event_registry(api_client_event_registry *r)
+{
+	if (r->prev)
+		r->prev->next = r->next;
+	else
+		event_registry_list = r->next;
+
+	if (r->next)
+		r->next->prev = r->prev;
+
+	event_index_remove(r);
+}
+
 int opae_api_unregister_event(int conn_socket,
 			      fpga_event_type e,
 			      uint64_t object_id)
 {
-	api_client_event_registry *trash;
-	api_client_event_registry *save;
+	api_client_event_registry *r;
 	int err;
-	int res = 0;
+	int res = 1;
 
 	fpgad_mutex_lock(err, &list_lock);
 
-	trash = event_registry_list;
-
-	if (!trash) { // empty list
-		res = 1;
-		goto out_unlock;
-	}
-
-	if ((conn_socket == trash->conn_socket) &&
-		(e == trash->event) &&
-		(object_id == trash->object_id)) {
-
-		// found at head of list
-
-		event_registry_list = event_registry_list->next;
-		release_event_registry(trash);
-		goto out_unlock;
-	}
-
-	save = trash;
-	trash = trash->next;
-	while (trash) {
-
-		if ((conn_socket == trash->conn_socket) &&
-			(e == trash->event) &&
-			(object_id == trash->object_id))
+	for (r = event_index[event_index_bucket(e, object_id)] ;
+	     r ; r = r->index_next) {
+		if ((conn_socket == r->conn_socket) &&
+		    (e == r->event) &&
+		    (object_id == r->object_id)) {
+			unlink_event_registry(r);
+			release_event_registry(r);
+			res = 0;
 			break;
-
-		save = trash;
-		trash = trash->next;
+		}
 	}
 
-	if (!trash) { // not found
-		res = 1;
-		goto out_unlock;
-	}
-
-	// found at trash
-	save->next = trash->next;
-	release_event_registry(trash);
-
-out_unlock:
 	fpgad_mutex_unlock(err, &list_lock);
 	return res;
 }
 
-STATIC api_client_event_registry *
-find_event_for(int conn_socket)
-{
-	api_client_event_registry *r;
-
-	for (r = event_registry_list ; r ; r = r->next)
-		if (conn_socket == r->conn_socket)
-			break;
-
-	return r;
-}
-
 void opae_api_unregister_all_events_for(int conn_socket)
 {
 	api_client_event_registry *r;
@@ -151,10 +158,15 @@ void opae_api_unregister_all_events_for(int conn_socket)
 
 	fpgad_mutex_lock(err, &list_lock);
 
-	r = find_event_for(conn_socket);
-	while (r) {
-		opae_api_unregister_event(conn_socket, r->event, r->object_id);
-		r = find_event_for(conn_socket);
+	for (r = event_registry_list ; r ; ) {
+		api_client_event_registry *trash = r;
+
+		r = r->next;
+
+		if (trash->conn_socket == conn_socket) {
+			unlink_event_registry(trash);
+			release_event_registry(trash);
+		}
 	}
 
 	fpgad_mutex_unlock(err, &list_lock);
@@ -175,6 +187,7 @@ void opae_api_unregister_all_events(void)
 	}
 
 	event_registry_list = NULL;
+	memset(event_index, 0, sizeof(event_index));
 
 	fpgad_mutex_unlock(err, &list_lock);
 }
@@ -195,46 +208,37 @@ void *context)
 	fpgad_mutex_unlock(err, &list_lock);
 }
 
-STATIC void check_and_send_EVENT_ERROR(api_client_event_registry *r,
-				       void *context)
+// Signal each subscriber of (e, d->object_id).
+STATIC void send_event(fpga_event_type e,
+		       const char *name,
+		       fpgad_monitored_device *d)
 {
-	fpgad_monitored_device *d =
-		(fpgad_monitored_device *)context;
+	api_client_event_registry *r;
+	int err;
 
-	if ((r->event == FPGA_EVENT_ERROR) &&
-	    (r->object_id == d->object_id)) {
-		LOG("object_id: 0x%" PRIx64 " event: FPGA_EVENT_ERROR\n",
-			d->object_id);
+	fpgad_mutex_lock(err, &list_lock);
+
+	for (r = event_index[event_index_bucket(e, d->object_id)] ;
+	     r ; r = r->index_next) {
+		if ((r->event != e) || (r->object_id != d->object_id))
+			continue;
+
+		LOG("object_id: 0x%" PRIx64 " event: %s\n",
+			d->object_id, name);
 		if (write(r->fd, &r->data, sizeof(r->data)) < 0)
 			LOG("write failed: %s\n", strerror(errno));
 		r->data++;
 	}
-}
 
-void opae_api_send_EVENT_ERROR(fpgad_monitored_device *d)
-{
-	opae_api_for_each_registered_event(check_and_send_EVENT_ERROR,
-					   d);
+	fpgad_mutex_unlock(err, &list_lock);
 }
 
-STATIC void check_and_send_EVENT_POWER_THERMAL(api_client_event_registry *r,
-					       void *context)
+void opae_api_send_EVENT_ERROR(fpgad_monitored_device *d)
 {
-	fpgad_monitored_device *d =
-		(fpgad_monitored_device *)context;
-
-	if ((r->event == FPGA_EVENT_POWER_THERMAL) &&
-	    (r->object_id == d->object_id)) {
-		LOG("object_id: 0x%" PRIx64 " event: FPGA_EVENT_POWER_THERMAL\n",
-			d->object_id);
-		if (write(r->fd, &r->data, sizeof(r->data)) < 0)
-			LOG("write failed: %s\n", strerror(errno));
-		r->data++;
-	}
+	send_event(FPGA_EVENT_ERROR, "FPGA_EVENT_ERROR", d);
 }
 
 void opae_api_send_EVENT_POWER_THERMAL(fpgad_monitored_device *d)
 {
-	opae_api_for_each_registered_event(check_and_send_EVENT_POWER_THERMAL,
-					   d);
+	send_event(FPGA_EVENT_POWER_THERMAL, "FPGA_EVENT_POWER_THERMAL", d);
 }
@@ -41,7 +41,9 @@
 
 enum request_type {
 	REGISTER_EVENT = 0,
-	UNREGISTER_EVENT
+	UNREGISTER_EVENT,
+	GET_EVENT_STATS,   // reply: struct event_stats_response
+	GET_DEVICE_LATENCY // reply: struct device_latency_response
 };
 
 struct event_request {
@@ -50,6 +52,27 @@ struct event_request {
 	uint64_t object_id;
 };
 
+struct event_queue_counters {
+	uint64_t depth;
+	uint64_t max_depth;
+	uint64_t enqueued;
+	uint64_t coalesced;
+	uint64_t dropped;
+};
+
+struct event_stats_response {
+	struct event_queue_counters normal;
+	struct event_queue_counters high;
+};
+
+struct device_latency_response {
+	int32_t result; // 0 if object_id is monitored
+	uint64_t count;
+	uint64_t last_usec;
+	uint64_t max_usec;
+	uint64_t avg_usec;
+};
+
 typedef struct _api_client_event_registry {
 	int conn_socket;
 	int fd;
@@ -57,6 +80,9 @@ typedef struct _api_client_event_registry {
 	fpga_event_type event;
 	uint64_t object_id;
 	struct _api_client_event_registry *next;
+	struct _api_client_event_registry *prev;
+	// next registry in the same (event, object_id) bucket
+	struct _api_client_event_registry *index_next;
 } api_client_event_registry;
 
 // 0 on success
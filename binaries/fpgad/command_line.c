@@ -91,8 +91,12 @@ STATIC bool cmd_register_null_gbs(struct fpgad_config *c, char *null_gbs_path)
 			memset(&c->null_gbs[c->num_null_gbs], 0,
 				 sizeof(opae_bitstream_info));
 
+			// fpgad keeps the NULL GBS for its whole lifetime,
+			// so don't leave it mapped: a truncated file would
+			// fault the daemon on its next access.
 			if (opae_load_bitstream(canon_path,
-						&c->null_gbs[c->num_null_gbs])) {
+						&c->null_gbs[c->num_null_gbs]) ||
+			    opae_bitstream_copy_data(&c->null_gbs[c->num_null_gbs])) {
 				LOG("failed to load NULL GBS \"%s\"\n", canon_path);
 				opae_unload_bitstream(&c->null_gbs[c->num_null_gbs]);
 				opae_free(canon_path);
@@ -31,6 +31,7 @@
 #include <semaphore.h>
 #include <time.h>
 #include <inttypes.h>
+#include <unistd.h>
 #include "event_dispatcher_thread.h"
 
 #ifdef LOG
@@ -45,40 +46,37 @@ event_dispatcher_thread_config event_dispatcher_config = {
 	.sched_priority = 30,
 };
 
-#define EVENT_DISPATCH_QUEUE_DEPTH 512
+#define EVENT_DISPATCH_QUEUE_MASK (EVENT_DISPATCH_QUEUE_DEPTH - 1)
 
-typedef struct _evt_dispatch_queue {
-	event_dispatch_queue_item q[EVENT_DISPATCH_QUEUE_DEPTH];
-	unsigned head;
-	unsigned tail;
-	pthread_mutex_t lock;
-} evt_dispatch_queue;
+// Max number of normal-priority items handled per pass
+// before the high-priority queue is checked again.
+#define EVENT_DISPATCH_BATCH 32
+
+// When a queue is full, the producer wakes the dispatcher and
+// retries this many times (EVENT_QUEUE_BACKOFF_USEC apart) before
+// the item is dropped.
+#define EVENT_QUEUE_FULL_RETRIES 100
+#define EVENT_QUEUE_BACKOFF_USEC 100
 
 STATIC sem_t evt_dispatch_sem;
 
-STATIC evt_dispatch_queue normal_queue = {
-	{ { NULL, NULL, NULL }, },
-	0,
-	0,
-	PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP,
-};
+STATIC evt_dispatch_queue normal_queue;
 
-STATIC evt_dispatch_queue high_priority_queue = {
-	{ { NULL, NULL, NULL }, },
-	0,
-	0,
-	PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP,
-};
+STATIC evt_dispatch_queue high_priority_queue;
 
-STATIC void evt_queue_init(evt_dispatch_queue *q)
+STATIC void evt_queue_init(evt_dispatch_queue *q, bool coalesce)
 {
-	memset(q->q, 0, sizeof(q->q));
-	q->head = q->tail = 0;
+	uint64_t i;
+
+	memset(q, 0, sizeof(*q));
+	for (i = 0 ; i < EVENT_DISPATCH_QUEUE_DEPTH ; ++i)
+		q->q[i].seq = i;
+	q->coalesce = coalesce;
 }
 
 STATIC void evt_queue_destroy(evt_dispatch_queue *q)
 {
-	q->head = q->tail = 0;
+	evt_queue_init(q, q->coalesce);
 }
 
 STATIC volatile bool dispatcher_is_ready = (bool)0;
@@ -88,73 +86,214 @@ bool evt_dispatcher_is_ready(void)
 	return dispatcher_is_ready;
 }
 
+STATIC uint64_t evt_queue_depth(evt_dispatch_queue *q)
+{
+	uint64_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+	uint64_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+
+	return tail > head ? tail - head : 0;
+}
+
 STATIC bool evt_queue_is_full(evt_dispatch_queue *q)
 {
-	const size_t num = sizeof(q->q) / sizeof(q->q[0]);
-
-	if (q->tail > q->head) {
-		if ((q->head == 0) && (q->tail == (num - 1)))
-			return true;
-	} else if (q->tail < q->head) {
-		if (q->tail == (q->head - 1))
-			return true;
-	}
-	return false;
+	return evt_queue_depth(q) >= EVENT_DISPATCH_QUEUE_DEPTH;
 }
 
 STATIC bool evt_queue_is_empty(evt_dispatch_queue *q)
 {
-	return q->head == q->tail;
+	return evt_queue_depth(q) == 0;
 }
 
-STATIC bool _evt_queue_response(evt_dispatch_queue *q,
+#define EVT_PENDING_BITS 64
+
+// Returns the pending_responses bit for the (callback, context)
+// response of device, or 0 when it is not one of the device's
+// first EVT_PENDING_BITS responses. The context is part of the key:
+// one callback may serve several detections, each with a context
+// of its own, and those are distinct events.
+STATIC uint64_t evt_pending_bit(fpgad_monitored_device *device,
 				fpgad_respond_event_t callback,
-				fpgad_monitored_device *device,
 				void *context)
 {
-	int res;
+	static int warned;
+	unsigned i;
+
+	if (!device || !device->responses)
+		return 0;
+
+	for (i = 0 ; device->responses[i] ; ++i) {
+		if (i == EVT_PENDING_BITS) {
+			if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED))
+				LOG("a device has more than %d responses; "
+				    "events for the rest are not coalesced.\n",
+				    EVT_PENDING_BITS);
+			break;
+		}
+		if (device->responses[i] == callback &&
+		    (device->response_contexts ?
+		     device->response_contexts[i] : NULL) == context)
+			return 1ULL << i;
+	}
 
-	opae_mutex_lock(res, &q->lock);
+	return 0;
+}
 
-	if (evt_queue_is_full(q)) {
-		opae_mutex_unlock(res, &q->lock);
-		return false;
-	}
+STATIC void evt_queue_note_depth(evt_dispatch_queue *q, uint64_t depth)
+{
+	uint64_t max = __atomic_load_n(&q->max_depth, __ATOMIC_RELAXED);
 
-	q->q[q->tail].callback = callback;
-	q->q[q->tail].device = device;
-	q->q[q->tail].context = context;
+	while (depth > max &&
+	       !__atomic_compare_exchange_n(&q->max_depth, &max, depth,
+					    true, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
+}
 
-	q->tail = (q->tail + 1) % EVENT_DISPATCH_QUEUE_DEPTH;
+STATIC bool evt_queue_try_push(evt_dispatch_queue *q,
+			       fpgad_respond_event_t callback,
+			       fpgad_monitored_device *device,
+			       void *context)
+{
+	uint64_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	evt_dispatch_slot *slot;
+	int64_t diff;
+
+	while (1) {
+		slot = &q->q[pos & EVENT_DISPATCH_QUEUE_MASK];
+		diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+		if (!diff) {
+			if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1,
+							true, __ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return false; // full
+		} else {
+			pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+		}
+	}
 
-	opae_mutex_unlock(res, &q->lock);
+	slot->item.callback = callback;
+	slot->item.device = device;
+	slot->item.context = context;
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
 
-	sem_post(&evt_dispatch_sem);
+	evt_queue_note_depth(q, pos + 1 -
+			     __atomic_load_n(&q->head, __ATOMIC_RELAXED));
 
 	return true;
 }
 
-STATIC bool _evt_queue_get(evt_dispatch_queue *q,
-			   event_dispatch_queue_item *item)
+STATIC void evt_dispatcher_wake(void)
 {
-	int res;
+	int val = 0;
 
-	opae_mutex_lock(res, &q->lock);
+	// The dispatcher drains every queue on each wake-up,
+	// so one outstanding post is enough.
+	if (!sem_getvalue(&evt_dispatch_sem, &val) && val > 0)
+		return;
+	sem_post(&evt_dispatch_sem);
+}
 
-	if (evt_queue_is_empty(q)) {
-		opae_mutex_unlock(res, &q->lock);
-		return false;
+STATIC bool _evt_queue_response(evt_dispatch_queue *q,
+				fpgad_respond_event_t callback,
+				fpgad_monitored_device *device,
+				void *context)
+{
+	uint64_t bit = q->coalesce ?
+		evt_pending_bit(device, callback, context) : 0;
+	int retries = EVENT_QUEUE_FULL_RETRIES;
+
+	if (bit && (__atomic_fetch_or(&device->pending_responses, bit,
+				      __ATOMIC_ACQ_REL) & bit)) {
+		// An identical event is already queued.
+		__atomic_add_fetch(&q->coalesced, 1, __ATOMIC_RELAXED);
+		return true;
 	}
 
-	*item = q->q[q->head];
-	memset(&q->q[q->head], 0, sizeof(q->q[0]));
-	q->head = (q->head + 1) % EVENT_DISPATCH_QUEUE_DEPTH;
+	while (!evt_queue_try_push(q, callback, device, context)) {
+		if (!retries--) {
+			if (bit)
+				__atomic_fetch_and(&device->pending_responses,
+						   ~bit, __ATOMIC_RELEASE);
+			__atomic_add_fetch(&q->dropped, 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		evt_dispatcher_wake();
+		// Retry at once if the dispatcher already made room.
+		if (evt_queue_is_full(q))
+			usleep(EVENT_QUEUE_BACKOFF_USEC);
+	}
 
-	opae_mutex_unlock(res, &q->lock);
+	__atomic_add_fetch(&q->enqueued, 1, __ATOMIC_RELAXED);
+	evt_dispatcher_wake();
 
 	return true;
 }
 
+// Single consumer only.
+STATIC size_t _evt_queue_get_batch(evt_dispatch_queue *q,
+				   event_dispatch_queue_item *items,
+				   size_t max_items)
+{
+	uint64_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+	evt_dispatch_slot *slot;
+	size_t n;
+
+	for (n = 0 ; n < max_items ; ++n, ++pos) {
+		uint64_t bit;
+
+		slot = &q->q[pos & EVENT_DISPATCH_QUEUE_MASK];
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1)
+			break;
+
+		items[n] = slot->item;
+		memset(&slot->item, 0, sizeof(slot->item));
+		__atomic_store_n(&slot->seq,
+				 pos + EVENT_DISPATCH_QUEUE_DEPTH,
+				 __ATOMIC_RELEASE);
+
+		// Clear the pending bit before the response runs, so
+		// that a detection made during the response is queued.
+		bit = q->coalesce ?
+			evt_pending_bit(items[n].device,
+					items[n].callback,
+					items[n].context) : 0;
+		if (bit)
+			__atomic_fetch_and(&items[n].device->pending_responses,
+					   ~bit, __ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&q->head, pos, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+STATIC bool _evt_queue_get(evt_dispatch_queue *q,
+			   event_dispatch_queue_item *item)
+{
+	return _evt_queue_get_batch(q, item, 1) == 1;
+}
+
+STATIC void evt_queue_stats_for(evt_dispatch_queue *q, evt_queue_stats *s)
+{
+	s->depth = evt_queue_depth(q);
+	s->max_depth = __atomic_load_n(&q->max_depth, __ATOMIC_RELAXED);
+	s->enqueued = __atomic_load_n(&q->enqueued, __ATOMIC_RELAXED);
+	s->coalesced = __atomic_load_n(&q->coalesced, __ATOMIC_RELAXED);
+	s->dropped = __atomic_load_n(&q->dropped, __ATOMIC_RELAXED);
+}
+
+void evt_queue_get_stats(evt_queue_stats *normal,
+			 evt_queue_stats *high)
+{
+	if (normal)
+		evt_queue_stats_for(&normal_queue, normal);
+	if (high)
+		evt_queue_stats_for(&high_priority_queue, high);
+}
+
 bool evt_queue_response(fpgad_respond_event_t callback,
 			fpgad_monitored_device *device,
 			void *context)
@@ -170,6 +309,12 @@ bool evt_queue_get(event_dispatch_queue_item *item)
 	return _evt_queue_get(&normal_queue, item);
 }
 
+size_t evt_queue_get_batch(event_dispatch_queue_item *items,
+			   size_t max_items)
+{
+	return _evt_queue_get_batch(&normal_queue, items, max_items);
+}
+
 bool evt_queue_response_high(fpgad_respond_event_t callback,
 			     fpgad_monitored_device *device,
 			     void *context)
@@ -185,6 +330,32 @@ bool evt_queue_get_high(event_dispatch_queue_item *item)
 	return _evt_queue_get(&high_priority_queue, item);
 }
 
+STATIC void evt_dispatch_all(void)
+{
+	event_dispatch_queue_item items[EVENT_DISPATCH_BATCH];
+	event_dispatch_queue_item item;
+	size_t i;
+	size_t n;
+
+	do {
+		// Process all high-priority items first
+		while (evt_queue_get_high(&item)) {
+			LOG("dispatching (high) for object_id: 0x%" PRIx64 ".\n",
+				item.device->object_id);
+			item.callback(item.device, item.context);
+		}
+
+		n = evt_queue_get_batch(items, EVENT_DISPATCH_BATCH);
+		for (i = 0 ; i < n ; ++i) {
+			LOG("dispatching for object_id: 0x%" PRIx64 ".\n",
+				items[i].device->object_id);
+			items[i].callback(items[i].device, items[i].context);
+		}
+	} while (n ||
+		 !evt_queue_is_empty(&high_priority_queue) ||
+		 !evt_queue_is_empty(&normal_queue));
+}
+
 void *event_dispatcher_thread(void *thread_context)
 {
 	event_dispatcher_thread_config *c =
@@ -212,8 +383,11 @@ void *event_dispatcher_thread(void *thread_context)
 		}
 	}
 
-	evt_queue_init(&normal_queue);
-	evt_queue_init(&high_priority_queue);
+	// Only normal-priority events are coalesced, so that a
+	// high-priority event is never absorbed by a queued
+	// normal-priority one.
+	evt_queue_init(&normal_queue, true);
+	evt_queue_init(&high_priority_queue, false);
 
 	if (sem_init(&evt_dispatch_sem, 0, 0)) {
 		LOG("failed to init queue sem.\n");
@@ -234,22 +408,8 @@ void *event_dispatcher_thread(void *thread_context)
 
 		res = sem_timedwait(&evt_dispatch_sem, &ts);
 
-		if (!res) {
-			event_dispatch_queue_item item;
-
-			// Process all high-priority items first
-			while (evt_queue_get_high(&item)) {
-				LOG("dispatching (high) for object_id: 0x%" PRIx64 ".\n",
-					item.device->object_id);
-				item.callback(item.device, item.context);
-			}
-
-			if (evt_queue_get(&item)) {
-				LOG("dispatching for object_id: 0x%" PRIx64 ".\n",
-					item.device->object_id);
-				item.callback(item.device, item.context);
-			}
-		}
+		if (!res)
+			evt_dispatch_all();
 
 	}
 
@@ -46,14 +46,50 @@ typedef struct _event_dispatch_queue_item {
 	void *context;
 } event_dispatch_queue_item;
 
+#define EVENT_DISPATCH_QUEUE_DEPTH 512 // must be a power of 2
+
+typedef struct _evt_dispatch_slot {
+	uint64_t seq;
+	event_dispatch_queue_item item;
+} evt_dispatch_slot;
+
+// Bounded multi-producer / single-consumer ring.
+// Producers claim a slot by advancing tail with a CAS,
+// then publish it by storing seq = pos + 1. The single
+// consumer (event_dispatcher_thread) owns head.
+typedef struct _evt_dispatch_queue {
+	evt_dispatch_slot q[EVENT_DISPATCH_QUEUE_DEPTH];
+	uint64_t head;
+	uint64_t tail;
+	uint64_t enqueued;
+	uint64_t coalesced;
+	uint64_t dropped;
+	uint64_t max_depth;
+	bool coalesce;
+} evt_dispatch_queue;
+
+typedef struct _evt_queue_stats {
+	uint64_t depth;     // items currently queued
+	uint64_t max_depth; // high-water mark of depth
+	uint64_t enqueued;  // items accepted into the queue
+	uint64_t coalesced; // items merged with a pending duplicate
+	uint64_t dropped;   // items dropped because the queue stayed full
+} evt_queue_stats;
+
 bool evt_dispatcher_is_ready(void);
 
+void evt_queue_get_stats(evt_queue_stats *normal,
+			 evt_queue_stats *high);
+
 bool evt_queue_response(fpgad_respond_event_t callback,
 			fpgad_monitored_device *device,
 			void *context);
 
 bool evt_queue_get(event_dispatch_queue_item *item);
 
+size_t evt_queue_get_batch(event_dispatch_queue_item *items,
+			   size_t max_items);
+
 bool evt_queue_response_high(fpgad_respond_event_t callback,
 			     fpgad_monitored_device *device,
 			     void *context);
@@ -37,9 +37,11 @@
 
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <inttypes.h>
 #include "events_api_thread.h"
+#include "event_dispatcher_thread.h"
+#include "monitor_thread.h"
 #include "api/opae_events_api.h"
 #include "mock/opae_std.h"
 
@@ -55,113 +57,265 @@ events_api_thread_config events_api_config = {
 	.sched_priority = 10,
 };
 
-#define MAX_CLIENT_CONNECTIONS 1023
-#define SRV_SOCKET             0
-#define FIRST_CLIENT_SOCKET    1
+// Max requests (and passed fds) accepted in one message.
+#define MAX_BATCH_REQUESTS 64
+#define MAX_EPOLL_EVENTS   64
 
-/* array keeping track of all connection file descriptors (plus server socket) */
-STATIC struct pollfd pollfds[MAX_CLIENT_CONNECTIONS+1];
-STATIC nfds_t num_fds = 1;
+typedef struct _api_client {
+	int conn_socket;
+	struct _api_client *prev;
+	struct _api_client *next;
+} api_client;
+
+STATIC int epoll_fd = -1;
+STATIC api_client *client_list;
+STATIC unsigned num_clients;
 
-STATIC void remove_client(int conn_socket)
+STATIC api_client *add_client(int conn_socket)
 {
-	nfds_t i, j;
-	nfds_t removed = 0;
-
-	opae_api_unregister_all_events_for(conn_socket);
-	LOG("closing connection conn_socket=%d.\n", conn_socket);
-	opae_close(conn_socket);
-
-	for (i = j = FIRST_CLIENT_SOCKET ; i < num_fds ; ++i) {
-		if (conn_socket != pollfds[i].fd) {
-			if (j != i)
-				pollfds[j] = pollfds[i];
-			++j;
-		} else {
-			++removed;
-		}
+	struct epoll_event ev;
+	api_client *client;
+
+	client = (api_client *)opae_calloc(1, sizeof(*client));
+	if (!client) {
+		LOG("calloc failed\n");
+		return NULL;
 	}
 
-	num_fds -= removed;
+	client->conn_socket = conn_socket;
+
+	ev.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP;
+	ev.data.ptr = client;
+
+	if (epoll_fd >= 0 &&
+	    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, conn_socket, &ev) < 0) {
+		LOG("epoll_ctl(ADD, %d) failed: %s\n",
+		    conn_socket, strerror(errno));
+		opae_free(client);
+		return NULL;
+	}
+
+	client->next = client_list;
+	if (client_list)
+		client_list->prev = client;
+	client_list = client;
+	++num_clients;
+
+	return client;
 }
 
-STATIC int handle_message(int conn_socket)
+STATIC void remove_client(api_client *client)
 {
-	struct msghdr mh;
-	struct cmsghdr *cmh;
-	struct iovec iov[1];
-	struct event_request req;
-	char buf[CMSG_SPACE(sizeof(int))];
+	opae_api_unregister_all_events_for(client->conn_socket);
+	LOG("closing connection conn_socket=%d.\n", client->conn_socket);
+
+	if (epoll_fd >= 0)
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->conn_socket, NULL);
+	opae_close(client->conn_socket);
+
+	if (client->prev)
+		client->prev->next = client->next;
+	else
+		client_list = client->next;
+	if (client->next)
+		client->next->prev = client->prev;
+	--num_clients;
+
+	opae_free(client);
+}
+
+STATIC void copy_queue_counters(struct event_queue_counters *c,
+				const evt_queue_stats *s)
+{
+	c->depth = s->depth;
+	c->max_depth = s->max_depth;
+	c->enqueued = s->enqueued;
+	c->coalesced = s->coalesced;
+	c->dropped = s->dropped;
+}
+
+STATIC int send_event_stats(int conn_socket)
+{
+	struct event_stats_response resp;
+	evt_queue_stats normal;
+	evt_queue_stats high;
 	ssize_t n;
-	int *fd_ptr;
 
-	/* set up ancillary data message header */
-	iov[0].iov_base = &req;
-	iov[0].iov_len = sizeof(req);
-	memset(buf, 0, sizeof(buf));
-	mh.msg_name = NULL;
-	mh.msg_namelen = 0;
-	mh.msg_iov = iov;
-	mh.msg_iovlen = sizeof(iov) / sizeof(iov[0]);
-	mh.msg_control = buf;
-	mh.msg_controllen = CMSG_LEN(sizeof(int));
-	mh.msg_flags = 0;
-	cmh = CMSG_FIRSTHDR(&mh);
-	cmh->cmsg_len = CMSG_LEN(sizeof(int));
-	cmh->cmsg_level = SOL_SOCKET;
-	cmh->cmsg_type = SCM_RIGHTS;
+	evt_queue_get_stats(&normal, &high);
+	copy_queue_counters(&resp.normal, &normal);
+	copy_queue_counters(&resp.high, &high);
 
-	n = recvmsg(conn_socket, &mh, 0);
-	if (n < 0) {
-		LOG("recvmsg() failed: %s\n", strerror(errno));
-		return (int)n;
+	n = send(conn_socket, &resp, sizeof(resp), MSG_NOSIGNAL);
+	if (n != (ssize_t)sizeof(resp)) {
+		LOG("failed to send event stats: %s\n", strerror(errno));
+		return -1;
 	}
 
-	if (!n) { // socket closed by peer
-		remove_client(conn_socket);
-		return (int)n;
+	return 0;
+}
+
+STATIC int send_device_latency(int conn_socket, uint64_t object_id)
+{
+	struct device_latency_response resp;
+	mon_latency latency;
+	ssize_t n;
+
+	memset(&resp, 0, sizeof(resp));
+	resp.result = mon_get_latency(object_id, &latency) ? -1 : 0;
+	if (!resp.result) {
+		resp.count = latency.count;
+		resp.last_usec = latency.last_usec;
+		resp.max_usec = latency.max_usec;
+		resp.avg_usec = latency.avg_usec;
 	}
 
-	switch (req.type) {
+	n = send(conn_socket, &resp, sizeof(resp), MSG_NOSIGNAL);
+	if (n != (ssize_t)sizeof(resp)) {
+		LOG("failed to send device latency: %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+// fds[*next_fd] is the fd passed for the next REGISTER_EVENT.
+STATIC int handle_request(int conn_socket,
+			  const struct event_request *req,
+			  const int *fds,
+			  unsigned num_fds,
+			  unsigned *next_fd)
+{
+	int fd;
+
+	switch (req->type) {
 
 	case REGISTER_EVENT:
-		fd_ptr = (int *)CMSG_DATA(cmh);
+		if (*next_fd >= num_fds) {
+			LOG("register request without an fd\n");
+			return -1;
+		}
+		fd = fds[(*next_fd)++];
 
-		if (opae_api_register_event(conn_socket, *fd_ptr,
-				    req.event, req.object_id)) {
+		if (opae_api_register_event(conn_socket, fd,
+				    req->event, req->object_id)) {
 			LOG("failed to register event\n");
+			opae_close(fd);
 			return -1;
 		}
 
 		LOG("registered event sock=%d:fd=%d"
 		     "(event=%d object_id=0x%" PRIx64  ")\n",
-			conn_socket, *fd_ptr, req.event, req.object_id);
+			conn_socket, fd, req->event, req->object_id);
 
 		break;
 
 	case UNREGISTER_EVENT:
 
 		if (opae_api_unregister_event(conn_socket,
-					      req.event,
-					      req.object_id)) {
+					      req->event,
+					      req->object_id)) {
 			LOG("failed to unregister event\n");
 			return -1;
 		}
 
 		LOG("unregistered event sock=%d:"
 		     "(event=%d object_id=0x%" PRIx64  ")\n",
-			conn_socket, req.event, req.object_id);
+			conn_socket, req->event, req->object_id);
 
 		break;
 
+	case GET_EVENT_STATS:
+		return send_event_stats(conn_socket);
+
+	case GET_DEVICE_LATENCY:
+		return send_device_latency(conn_socket, req->object_id);
+
 	default:
-		LOG("unknown request type %d\n", req.type);
+		LOG("unknown request type %d\n", req->type);
 		return -1;
 	}
 
 	return 0;
 }
 
+// A message carries one or more event_request's. The fds
+// passed with it (SCM_RIGHTS) belong to its REGISTER_EVENT
+// requests, in order.
+STATIC int handle_message(api_client *client)
+{
+	struct msghdr mh;
+	struct cmsghdr *cmh;
+	struct iovec iov[1];
+	struct event_request reqs[MAX_BATCH_REQUESTS];
+	char buf[CMSG_SPACE(sizeof(int) * MAX_BATCH_REQUESTS)];
+	int fds[MAX_BATCH_REQUESTS];
+	unsigned num_fds = 0;
+	unsigned next_fd = 0;
+	size_t num_reqs;
+	size_t i;
+	ssize_t n;
+	int conn_socket = client->conn_socket;
+	int res = 0;
+
+	iov[0].iov_base = reqs;
+	iov[0].iov_len = sizeof(reqs);
+	memset(buf, 0, sizeof(buf));
+	mh.msg_name = NULL;
+	mh.msg_namelen = 0;
+	mh.msg_iov = iov;
+	mh.msg_iovlen = sizeof(iov) / sizeof(iov[0]);
+	mh.msg_control = buf;
+	mh.msg_controllen = sizeof(buf);
+	mh.msg_flags = 0;
+
+	n = recvmsg(conn_socket, &mh, MSG_CMSG_CLOEXEC);
+	if (n < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return 0;
+		LOG("recvmsg() failed: %s\n", strerror(errno));
+		remove_client(client);
+		return (int)n;
+	}
+
+	if (!n) { // socket closed by peer
+		remove_client(client);
+		return (int)n;
+	}
+
+	for (cmh = CMSG_FIRSTHDR(&mh) ; cmh ; cmh = CMSG_NXTHDR(&mh, cmh)) {
+		size_t count;
+
+		if (cmh->cmsg_level != SOL_SOCKET ||
+		    cmh->cmsg_type != SCM_RIGHTS)
+			continue;
+
+		count = (cmh->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		if (count > MAX_BATCH_REQUESTS - num_fds)
+			count = MAX_BATCH_REQUESTS - num_fds;
+		memcpy(&fds[num_fds], CMSG_DATA(cmh), count * sizeof(int));
+		num_fds += count;
+	}
+
+	if (mh.msg_flags & MSG_CTRUNC)
+		LOG("sock=%d: too many fds in one message\n", conn_socket);
+
+	num_reqs = (size_t)n / sizeof(reqs[0]);
+	if ((size_t)n % sizeof(reqs[0]))
+		LOG("sock=%d: ignoring partial request\n", conn_socket);
+
+	for (i = 0 ; i < num_reqs ; ++i) {
+		if (handle_request(conn_socket, &reqs[i],
+				   fds, num_fds, &next_fd))
+			res = -1;
+	}
+
+	// Don't leak fds that no request claimed.
+	while (next_fd < num_fds)
+		opae_close(fds[next_fd++]);
+
+	return res;
+}
+
 STATIC volatile bool evt_api_is_ready = false;
 
 bool events_api_is_ready(void)
@@ -177,11 +331,13 @@ void *events_api_thread(void *thread_context)
 	int policy = 0;
 	int res;
 
-	nfds_t i;
 	struct sockaddr_un addr;
+	struct epoll_event ev;
+	struct epoll_event events[MAX_EPOLL_EVENTS];
 	int server_socket;
 	int conn_socket;
 	size_t len;
+	int i;
 
 	LOG("starting\n");
 
@@ -222,61 +378,61 @@ void *events_api_thread(void *thread_context)
 	}
 	LOG("server socket bind success.\n");
 
-	if (listen(server_socket, 20) < 0) {
+	if (listen(server_socket, SOMAXCONN) < 0) {
 		LOG("failed to listen on socket.\n");
 		goto out_close_server;
 	}
 	LOG("listening for connections.\n");
 
-	evt_api_is_ready = true;
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
+		LOG("epoll_create1 failed: %s\n", strerror(errno));
+		goto out_close_server;
+	}
 
-	pollfds[SRV_SOCKET].fd = server_socket;
-	pollfds[SRV_SOCKET].events = POLLIN | POLLPRI;
-	num_fds = 1;
+	// data.ptr == NULL identifies the server socket.
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_socket, &ev) < 0) {
+		LOG("epoll_ctl(ADD, server) failed: %s\n", strerror(errno));
+		goto out_close_epoll;
+	}
+
+	evt_api_is_ready = true;
 
 	while (c->global->running) {
 
-		res = poll(pollfds, num_fds, 100);
+		res = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS, 100);
 		if (res < 0) {
-			LOG("poll error\n");
-			continue;
-		}
-
-		if (0 == res) // timeout
-			continue;
-
-		if ((nfds_t)res > num_fds) { // weird
-			LOG("something bad happened during poll!\n");
+			if (errno != EINTR)
+				LOG("epoll_wait error: %s\n", strerror(errno));
 			continue;
 		}
 
-		// handle requests on existing sockets
-		for (i = FIRST_CLIENT_SOCKET ; i < num_fds ; ++i) {
-			if (pollfds[i].revents) {
-				handle_message(pollfds[i].fd);
-			}
-		}
-
-		// handle new connection requests
-		if (pollfds[SRV_SOCKET].revents) {
+		for (i = 0 ; i < res ; ++i) {
+			api_client *client = (api_client *)events[i].data.ptr;
 
-			if (num_fds == MAX_CLIENT_CONNECTIONS+1) {
-				LOG("exceeded max connections!\n");
+			if (client) {
+				// handle requests on an existing socket
+				if (events[i].events & (EPOLLIN | EPOLLPRI))
+					handle_message(client);
+				else
+					remove_client(client);
 				continue;
 			}
 
-			conn_socket = accept(server_socket, NULL, NULL);
+			// handle a new connection request
+			conn_socket = accept4(server_socket, NULL, NULL,
+					      SOCK_CLOEXEC);
 
 			if (conn_socket < 0) {
 				LOG("failed to accept new connection!\n");
+			} else if (!add_client(conn_socket)) {
+				opae_close(conn_socket);
 			} else {
-				LOG("accepting connection %d.\n", conn_socket);
-
-				pollfds[num_fds].fd = conn_socket;
-				pollfds[num_fds].events = POLLIN | POLLPRI;
-				++num_fds;
+				LOG("accepting connection %d (%u clients).\n",
+				    conn_socket, num_clients);
 			}
-
 		}
 
 	}
@@ -284,10 +440,12 @@ void *events_api_thread(void *thread_context)
 	opae_api_unregister_all_events();
 
 	// close any active client sockets
-	for (i = FIRST_CLIENT_SOCKET ; i < num_fds ; ++i) {
-		opae_close(pollfds[i].fd);
-	}
+	while (client_list)
+		remove_client(client_list);
 
+out_close_epoll:
+	opae_close(epoll_fd);
+	epoll_fd = -1;
 out_close_server:
 	evt_api_is_ready = false;
 	opae_close(server_socket);
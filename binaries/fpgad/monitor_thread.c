@@ -28,8 +28,15 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <dlfcn.h>
 #include <sched.h>
+#include <poll.h>
+#include <time.h>
+#include <inttypes.h>
 #include "monitored_device.h"
 #include "monitor_thread.h"
 #include "event_dispatcher_thread.h"
@@ -45,6 +52,7 @@ monitor_thread_config monitor_config = {
 	.global = &global_config,
 	.sched_policy = SCHED_RR,
 	.sched_priority = 20,
+	.num_workers = 0,
 };
 
 STATIC pthread_mutex_t mon_list_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
@@ -62,7 +70,11 @@ STATIC void mon_queue_response(fpgad_detection_status status,
 					    response_context)) {
 			sched_yield();
 		} else {
-			LOG("high priority event queue is full. Dropping!\n");
+			evt_queue_stats high;
+
+			evt_queue_get_stats(NULL, &high);
+			LOG("high priority event queue is full. Dropping!"
+			    " (%" PRIu64 " dropped)\n", high.dropped);
 		}
 
 	} else if (status == FPGAD_STATUS_DETECTED) {
@@ -72,44 +84,301 @@ STATIC void mon_queue_response(fpgad_detection_status status,
 				       response_context)) {
 			sched_yield();
 		} else {
-			LOG("event queue is full. Dropping!\n");
+			evt_queue_stats normal;
+
+			evt_queue_get_stats(&normal, NULL);
+			LOG("event queue is full. Dropping!"
+			    " (%" PRIu64 " dropped)\n", normal.dropped);
 		}
 
 	}
 }
 
+STATIC uint64_t mon_now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+STATIC void mon_record_latency(fpgad_monitored_device *d, uint64_t usec)
+{
+	__atomic_store_n(&d->detect_last_usec, usec, __ATOMIC_RELAXED);
+	if (usec > d->detect_max_usec)
+		__atomic_store_n(&d->detect_max_usec, usec, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&d->detect_total_usec, usec, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&d->detect_count, 1, __ATOMIC_RELAXED);
+}
+
+STATIC bool mon_is_fd_driven(fpgad_monitored_device *d, unsigned i)
+{
+	return d->detection_fds && d->detection_fds[i].fd >= 0;
+}
+
+STATIC void mon_detect(fpgad_monitored_device *d, unsigned i)
+{
+	fpgad_detection_status result;
+	fpgad_detect_event_t detect =
+		d->detections[i];
+	void *detect_context =
+		d->detection_contexts ?
+		d->detection_contexts[i] : NULL;
+
+	result = detect(d, detect_context);
+
+	if (result != FPGAD_STATUS_NOT_DETECTED && d->responses) {
+		fpgad_respond_event_t response =
+			d->responses[i];
+		void *response_context =
+			d->response_contexts ?
+			d->response_contexts[i] : NULL;
+
+		if (response) {
+			mon_queue_response(result,
+					   response,
+					   d,
+					   response_context);
+		}
+	}
+}
+
+// Run the detections that are not fd-driven.
 STATIC void mon_monitor(fpgad_monitored_device *d)
 {
 	unsigned i;
+	unsigned n = 0;
+	uint64_t start;
 
 	if (!d->detections)
 		return;
 
+	start = mon_now_usec();
+
 	for (i = 0 ; d->detections[i] ; ++i) {
-		fpgad_detection_status result;
-		fpgad_detect_event_t detect =
-			d->detections[i];
-		void *detect_context =
-			d->detection_contexts ?
-			d->detection_contexts[i] : NULL;
-
-		result = detect(d, detect_context);
-
-		if (result != FPGAD_STATUS_NOT_DETECTED && d->responses) {
-			fpgad_respond_event_t response =
-				d->responses[i];
-			void *response_context =
-				d->response_contexts ?
-				d->response_contexts[i] : NULL;
-
-			if (response) {
-				mon_queue_response(result,
-						   response,
-						   d,
-						   response_context);
-			}
+		if (mon_is_fd_driven(d, i))
+			continue;
+		mon_detect(d, i);
+		++n;
+	}
+
+	if (n)
+		mon_record_latency(d, mon_now_usec() - start);
+}
+
+// Consume the pending notification so that poll() blocks
+// until the next change: sysfs attributes must be re-read
+// from offset 0, eventfds must be read to reset the counter.
+STATIC void mon_rearm(struct pollfd *pfd)
+{
+	char buf[256];
+
+	if (pfd->events & POLLPRI) {
+		if (lseek(pfd->fd, 0, SEEK_SET) < 0)
+			return;
+		while (read(pfd->fd, buf, sizeof(buf)) > 0)
+			/* drain */ ;
+	} else if (pfd->revents & POLLIN) {
+		if (read(pfd->fd, buf, sizeof(uint64_t)) < 0)
+			LOG("failed to re-arm fd %d: %s\n",
+			    pfd->fd, strerror(errno));
+	}
+}
+
+STATIC void mon_shard_add(mon_shard *s, fpgad_monitored_device *d)
+{
+	fpgad_monitored_device **trav = &s->devices;
+
+	while (*trav)
+		trav = &(*trav)->shard_next;
+
+	d->shard_next = NULL;
+	*trav = d;
+	++s->num_devices;
+}
+
+// Move all of src's devices to the end of dst.
+STATIC void mon_shard_merge(mon_shard *dst, mon_shard *src)
+{
+	fpgad_monitored_device *d = src->devices;
+	fpgad_monitored_device *next;
+
+	while (d) {
+		next = d->shard_next;
+		mon_shard_add(dst, d);
+		d = next;
+	}
+
+	src->devices = NULL;
+	src->num_devices = 0;
+}
+
+// 0 on success
+STATIC int mon_shard_setup(mon_shard *s)
+{
+	fpgad_monitored_device *d;
+	unsigned count = 0;
+	unsigned i;
+
+	for (d = s->devices ; d ; d = d->shard_next) {
+		if (!d->detections || !d->detection_fds)
+			continue;
+		for (i = 0 ; d->detections[i] ; ++i)
+			if (mon_is_fd_driven(d, i))
+				++count;
+	}
+
+	s->num_pfds = 0;
+	if (!count)
+		return 0;
+
+	s->pfds = opae_calloc(count, sizeof(struct pollfd));
+	s->refs = opae_calloc(count, sizeof(mon_poll_ref));
+	if (!s->pfds || !s->refs) {
+		LOG("calloc failed\n");
+		opae_free(s->pfds);
+		opae_free(s->refs);
+		s->pfds = NULL;
+		s->refs = NULL;
+		return 1;
+	}
+
+	for (d = s->devices ; d ; d = d->shard_next) {
+		if (!d->detections || !d->detection_fds)
+			continue;
+		for (i = 0 ; d->detections[i] ; ++i) {
+			if (!mon_is_fd_driven(d, i))
+				continue;
+			s->pfds[s->num_pfds] = d->detection_fds[i];
+			s->pfds[s->num_pfds].revents = 0;
+			s->refs[s->num_pfds].device = d;
+			s->refs[s->num_pfds].detection = i;
+			++s->num_pfds;
 		}
 	}
+
+	return 0;
+}
+
+STATIC void mon_shard_teardown(mon_shard *s)
+{
+	opae_free(s->pfds);
+	opae_free(s->refs);
+	s->pfds = NULL;
+	s->refs = NULL;
+	s->num_pfds = 0;
+}
+
+// Wait up to timeout_usec for an fd-driven detection to fire,
+// then run the detections whose fds are ready. Returns the
+// number of detections run.
+STATIC unsigned mon_shard_poll(mon_shard *s, uint64_t timeout_usec)
+{
+	struct timespec ts;
+	unsigned i;
+	unsigned fired = 0;
+	int res;
+
+	ts.tv_sec = timeout_usec / 1000000;
+	ts.tv_nsec = (timeout_usec % 1000000) * 1000;
+
+	res = ppoll(s->pfds, s->num_pfds, &ts, NULL);
+	if (res <= 0)
+		return 0;
+
+	for (i = 0 ; i < s->num_pfds ; ++i) {
+		struct pollfd *pfd = &s->pfds[i];
+		mon_poll_ref *ref = &s->refs[i];
+		uint64_t start;
+
+		if (!pfd->revents)
+			continue;
+
+		if (pfd->revents & POLLNVAL) {
+			// Fall back to polling this detection.
+			LOG("fd %d is invalid. Polling detection %u"
+			    " of object_id 0x%" PRIx64 " instead.\n",
+			    pfd->fd, ref->detection,
+			    ref->device->object_id);
+			ref->device->detection_fds[ref->detection].fd = -1;
+			pfd->fd = -1;
+			pfd->revents = 0;
+			continue;
+		}
+
+		start = mon_now_usec();
+		mon_rearm(pfd);
+		mon_detect(ref->device, ref->detection);
+		mon_record_latency(ref->device, mon_now_usec() - start);
+
+		pfd->revents = 0;
+		++fired;
+	}
+
+	return fired;
+}
+
+STATIC void *mon_worker(void *context)
+{
+	mon_shard *s = (mon_shard *)context;
+	uint64_t interval = s->config->global->poll_interval_usec;
+	uint64_t next_tick = mon_now_usec();
+	uint64_t now;
+	fpgad_monitored_device *d;
+
+	while (s->config->global->running) {
+
+		now = mon_now_usec();
+
+		if (now >= next_tick) {
+			for (d = s->devices ; d ; d = d->shard_next)
+				mon_monitor(d);
+
+			next_tick += interval;
+			if (next_tick <= now)
+				next_tick = now + interval;
+			continue;
+		}
+
+		mon_shard_poll(s, next_tick - now);
+	}
+
+	return NULL;
+}
+
+STATIC mon_shard mon_shards[MON_MAX_WORKERS];
+STATIC unsigned mon_num_shards;
+
+// Deal the monitored devices round-robin across the shards.
+STATIC unsigned mon_shard_devices(monitor_thread_config *c)
+{
+	fpgad_monitored_device *d;
+	unsigned num_devices = 0;
+	unsigned num_shards;
+	unsigned i;
+	int err;
+
+	fpgad_mutex_lock(err, &mon_list_lock);
+
+	for (d = monitored_device_list ; d ; d = d->next)
+		++num_devices;
+
+	num_shards = c->num_workers ? c->num_workers : num_devices;
+	if (num_shards > MON_MAX_WORKERS)
+		num_shards = MON_MAX_WORKERS;
+	if (!num_shards)
+		num_shards = 1;
+
+	memset(mon_shards, 0, sizeof(mon_shards));
+	for (i = 0 ; i < num_shards ; ++i)
+		mon_shards[i].config = c;
+
+	for (d = monitored_device_list, i = 0 ; d ; d = d->next, ++i)
+		mon_shard_add(&mon_shards[i % num_shards], d);
+
+	fpgad_mutex_unlock(err, &mon_list_lock);
+
+	return num_shards;
 }
 
 STATIC volatile bool mon_is_ready = (bool)0;
@@ -125,8 +394,7 @@ void *monitor_thread(void *thread_context)
 	struct sched_param sched_param;
 	int policy = 0;
 	int res;
-	int err;
-	fpgad_monitored_device *d;
+	unsigned i;
 
 	LOG("starting\n");
 
@@ -146,20 +414,48 @@ void *monitor_thread(void *thread_context)
 		}
 	}
 
-	mon_is_ready = true;
+	mon_num_shards = mon_shard_devices(c);
 
-	while (c->global->running) {
-		fpgad_mutex_lock(err, &mon_list_lock);
+	// Shard 0 runs on this thread. The workers
+	// inherit this thread's scheduling policy.
+	for (i = 1 ; i < mon_num_shards ; ++i) {
+		if (mon_shard_setup(&mon_shards[i]))
+			LOG("shard %u: polling all detections.\n", i);
 
-		for (d = monitored_device_list ; d ; d = d->next) {
-			mon_monitor(d);
+		res = pthread_create(&mon_shards[i].thread,
+				     NULL,
+				     mon_worker,
+				     &mon_shards[i]);
+		if (res) {
+			LOG("failed to create worker %u: %s."
+			    " Its devices move to shard 0.\n",
+			    i, strerror(res));
+			mon_shard_teardown(&mon_shards[i]);
+			mon_shard_merge(&mon_shards[0], &mon_shards[i]);
+			continue;
 		}
+		mon_shards[i].started = true;
+	}
 
-		fpgad_mutex_unlock(err, &mon_list_lock);
+	// Set up shard 0 last, so that it includes the
+	// devices of any worker that failed to start.
+	if (mon_shard_setup(&mon_shards[0]))
+		LOG("shard 0: polling all detections.\n");
 
-		usleep(c->global->poll_interval_usec);
+	mon_is_ready = true;
+
+	mon_worker(&mon_shards[0]);
+
+	for (i = 1 ; i < mon_num_shards ; ++i) {
+		if (!mon_shards[i].started)
+			continue;
+		pthread_join(mon_shards[i].thread, NULL);
+		mon_shards[i].started = false;
 	}
 
+	for (i = 0 ; i < mon_num_shards ; ++i)
+		mon_shard_teardown(&mon_shards[i]);
+
 	while (evt_dispatcher_is_ready()) {
 		// Wait for the event dispatcher to complete
 		// before we destroy the monitored devices.
@@ -198,6 +494,38 @@ out_unlock:
 	fpgad_mutex_unlock(err, &mon_list_lock);
 }
 
+int mon_get_latency(uint64_t object_id, mon_latency *latency)
+{
+	fpgad_monitored_device *d;
+	int err;
+	int res = 1;
+
+	fpgad_mutex_lock(err, &mon_list_lock);
+
+	for (d = monitored_device_list ; d ; d = d->next) {
+		uint64_t count;
+
+		if (d->object_id != object_id)
+			continue;
+
+		count = __atomic_load_n(&d->detect_count, __ATOMIC_RELAXED);
+		latency->count = count;
+		latency->last_usec = __atomic_load_n(&d->detect_last_usec,
+						     __ATOMIC_RELAXED);
+		latency->max_usec = __atomic_load_n(&d->detect_max_usec,
+						    __ATOMIC_RELAXED);
+		latency->avg_usec = count ?
+			__atomic_load_n(&d->detect_total_usec,
+					__ATOMIC_RELAXED) / count : 0;
+		res = 0;
+		break;
+	}
+
+	fpgad_mutex_unlock(err, &mon_list_lock);
+
+	return res;
+}
+
 void mon_destroy(struct fpgad_config *c)
 {
 	unsigned i;
@@ -212,6 +540,14 @@ void mon_destroy(struct fpgad_config *c)
 
 		d = d->next;
 
+		if (trash->detect_count) {
+			LOG("object_id 0x%" PRIx64 ": %" PRIu64 " detection"
+			    " passes, avg %" PRIu64 " usec, max %" PRIu64
+			    " usec\n", trash->object_id, trash->detect_count,
+			    trash->detect_total_usec / trash->detect_count,
+			    trash->detect_max_usec);
+		}
+
 		if (trash->type == FPGAD_PLUGIN_TYPE_THREAD) {
 
 			if (trash->thread_stop_fn) {
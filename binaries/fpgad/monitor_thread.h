@@ -34,10 +34,41 @@ typedef struct _monitor_thread_config {
 	struct fpgad_config *global;
 	int sched_policy;
 	int sched_priority;
+	unsigned num_workers; // 0 selects one per device, up to MON_MAX_WORKERS
 } monitor_thread_config;
 
 extern monitor_thread_config monitor_config;
 
+#define MON_MAX_WORKERS 4
+
+typedef struct _mon_poll_ref {
+	fpgad_monitored_device *device;
+	unsigned detection;
+} mon_poll_ref;
+
+// A worker's share of the monitored devices.
+// The device list is built before the workers
+// start and is not modified while they run.
+typedef struct _mon_shard {
+	monitor_thread_config *config;
+	fpgad_monitored_device *devices; // linked by shard_next
+	unsigned num_devices;
+
+	struct pollfd *pfds;
+	mon_poll_ref *refs;
+	unsigned num_pfds;
+
+	pthread_t thread;
+	bool started;
+} mon_shard;
+
+typedef struct _mon_latency {
+	uint64_t count;
+	uint64_t last_usec;
+	uint64_t max_usec;
+	uint64_t avg_usec;
+} mon_latency;
+
 void *monitor_thread(void *);
 
 // 0 on success
@@ -47,4 +78,7 @@ void mon_destroy(struct fpgad_config *c);
 
 void mon_monitor_device(fpgad_monitored_device *d);
 
+// 0 on success
+int mon_get_latency(uint64_t object_id, mon_latency *latency);
+
 #endif /* __FPGAD_MONITOR_THREAD_H__ */
@@ -27,6 +27,7 @@
 #ifndef __FPGAD_MONITORED_DEVICE_H__
 #define __FPGAD_MONITORED_DEVICE_H__
 
+#include <poll.h>
 #include "fpgad.h"
 
 typedef enum _fpgad_plugin_type {
@@ -70,6 +71,23 @@ typedef struct _fpgad_monitored_device {
 	fpgad_respond_event_t *responses;
 	void **response_contexts;
 
+	// Optional, parallel to detections. When
+	// detection_fds[i].fd >= 0, detections[i] is run only
+	// when poll() reports detection_fds[i].events on it
+	// (eg POLLPRI for a sysfs attribute, POLLIN for an
+	// eventfd), rather than on every poll interval. The
+	// monitor re-arms the fd after the detection runs.
+	//
+	// No in-tree plugin fills this in yet; it is the hook
+	// for plugins with a wake-up source of their own. The
+	// fpgad-xfpga error detections stay polled: the DFL
+	// error interrupt takes a single eventfd per device,
+	// which an application's FPGA_EVENT_ERROR registration
+	// would silently take over, and clearing an error raises
+	// no interrupt, so a repeat of the same error would be
+	// missed.
+	struct pollfd *detection_fds;
+
 	// }
 
 	// for type FPGAD_PLUGIN_TYPE_THREAD {
@@ -99,6 +117,22 @@ typedef struct _fpgad_monitored_device {
 #define MAX_DEV_SCRATCHPAD 2
 	uint64_t scratchpad[MAX_DEV_SCRATCHPAD];
 
+	// One bit per entry in responses[] (the first 64) that is
+	// currently waiting in the normal-priority event dispatcher
+	// queue. Used to coalesce duplicate (device, response,
+	// response context) events.
+	uint64_t pending_responses;
+
+	// Detection latency, in usec: the time spent in one
+	// pass over the polled detections, or from fd wake-up
+	// to response queued for fd-driven detections.
+	uint64_t detect_count;
+	uint64_t detect_last_usec;
+	uint64_t detect_max_usec;
+	uint64_t detect_total_usec;
+
+	struct _fpgad_monitored_device *shard_next;
+
 	struct _fpgad_monitored_device *next;
 } fpgad_monitored_device;
 
@@ -782,6 +782,32 @@ out:
 	return res;
 }
 
+fpga_result fpga_event_log_json(fpga_token token, uint32_t first, uint32_t last,
+		bool print_sensors)
+{
+	fpga_result res = FPGA_OK;
+	void *dl_handle = NULL;
+
+	fpga_result (*fpga_event_log_json)(fpga_token token, uint32_t first,
+			uint32_t last, bool print_sensors);
+
+	res = load_board_plugin(token, &dl_handle);
+	if (res != FPGA_OK) {
+		OPAE_MSG("Failed to load board plugin: %s\n", dlerror() ? : "unknown");
+		goto out;
+	}
+
+	fpga_event_log_json = dlsym(dl_handle, "fpga_event_log_json");
+	if (fpga_event_log_json) {
+		res = fpga_event_log_json(token, first, last, print_sensors);
+	} else {
+		printf("JSON event output is not supported by this board\n");
+	}
+
+out:
+	return res;
+}
+
 fpga_result fpgainfo_product_name(fpga_token token)
 {
 	fpga_result res          = FPGA_OK;
@@ -56,6 +56,7 @@ void events_help(void)
 	       "                -a,--all               Print all events\n"
 	       "                -s,--sensors           Print sensor data too\n"
 	       "                -i,--bits              Print bit values too\n"
+	       "                -j,--json              Print events as JSON\n"
 	       "                -h,--help           Print this help\n"
 	       "\n");
 }
@@ -82,6 +83,7 @@ fpga_result events_command(fpga_token *tokens, int num_tokens, int argc,
 	bool print_sensors = false;
 	bool print_bits = false;
 	bool print_list = false;
+	bool print_json = false;
 	uint32_t count;
 	int i;
 
@@ -92,12 +94,13 @@ fpga_result events_command(fpga_token *tokens, int num_tokens, int argc,
 		{ "all",     no_argument,       NULL, 'a' },
 		{ "sensors", no_argument,       NULL, 's' },
 		{ "bits",    no_argument,       NULL, 'i' },
+		{ "json",    no_argument,       NULL, 'j' },
 		{ "help",    no_argument,       NULL, 'h' },
 		{ 0 },
 	};
 
 	while (true) {
-		int opt = getopt_long(argc, argv, "lb:c:asih", options, NULL);
+		int opt = getopt_long(argc, argv, "lb:c:asijh", options, NULL);
 		if (opt == -1)
 			break;
 
@@ -133,6 +136,9 @@ fpga_result events_command(fpga_token *tokens, int num_tokens, int argc,
 		case 'i':
 			print_bits = true;
 			break;
+		case 'j':
+			print_json = true;
+			break;
 		case 'h':
 			events_help();
 			return FPGA_OK;
@@ -145,7 +151,10 @@ fpga_result events_command(fpga_token *tokens, int num_tokens, int argc,
 	}
 
 	for (i = 0; i < num_tokens; i++) {
-		res = fpga_event_log(tokens[i], first, last, print_list, print_sensors, print_bits);
+		if (print_json)
+			res = fpga_event_log_json(tokens[i], first, last, print_sensors);
+		else
+			res = fpga_event_log(tokens[i], first, last, print_list, print_sensors, print_bits);
 		if (res != FPGA_OK)
 			break;
 	}
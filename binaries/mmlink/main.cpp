@@ -43,7 +43,7 @@
 #define FPGA_PORT_INDEX_STP               1
 #define FPGA_PORT_STP_DFH_REVBIT         12
 
-#define GETOPT_STRING ":hs:P:Iv"
+#define GETOPT_STRING ":hs:P:Ivb:t:"
 
 struct option longopts[] = {
 	{ "help",        no_argument,       NULL, 'h' },
@@ -51,6 +51,8 @@ struct option longopts[] = {
 	{ "port",        required_argument, NULL, 'P' },
 	{ "ip",          required_argument, NULL, 'I' },
 	{ "version",     no_argument,       NULL, 'v' },
+	{ "sock-buf-size", required_argument, NULL, 'b' },
+	{ "t2h-buf-size",  required_argument, NULL, 't' },
 	{ 0,             0,                 0,    0   }
 };
 
@@ -60,9 +62,11 @@ struct  MMLinkCommandLine
 	int      socket;
 	int      port;
 	char     ip[16];
+	size_t   sock_buf_size;
+	size_t   t2h_buf_size;
 };
 
-struct MMLinkCommandLine mmlinkCmdLine = { -1, 0, { 0, } };
+struct MMLinkCommandLine mmlinkCmdLine = { -1, 0, { 0, }, 0, 0 };
 
 // mmlink Command line input help
 void MMLinkAppShowHelp()
@@ -83,6 +87,10 @@ void MMLinkAppShowHelp()
 		"OR  -P <PORT>\n");
 	printf("<IP ADDRESS>          --ip=<IP ADDRESS>            "
 		"OR  -I <IP ADDRESS>\n");
+	printf("<Socket buffer size>  --sock-buf-size=<BYTES>      "
+		"OR  -b <BYTES>\n");
+	printf("<T2H buffer size>     --t2h-buf-size=<BYTES>       "
+		"OR  -t <BYTES>\n");
 	printf("<Version>             -v,--version Print version and exit\n");
 	printf("\n");
 
@@ -168,6 +176,10 @@ int main( int argc, char** argv )
 	printf(" Socket-id        : %d\n", mmlinkCmdLine.socket);
 	printf(" Port             : %d\n", mmlinkCmdLine.port);
 	printf(" IP address       : %s\n", mmlinkCmdLine.ip);
+	if (mmlinkCmdLine.sock_buf_size)
+		printf(" Socket buffer    : %zu\n", mmlinkCmdLine.sock_buf_size);
+	if (mmlinkCmdLine.t2h_buf_size)
+		printf(" T2H buffer       : %zu\n", mmlinkCmdLine.t2h_buf_size);
 	printf(" ------- Command line Input END   ----\n\n");
 
 	// Signal Handler
@@ -270,7 +282,8 @@ int run_mmlink(fpga_handle  port_handle,
       srv = new legacy_dbg();
       break;
     case MMLINK_STREAMING:
-      srv = new stream_dbg();
+      srv = new stream_dbg(mmlinkCmdLine->sock_buf_size,
+                           mmlinkCmdLine->t2h_buf_size);
       break;
     default:
       PRINT_ERR("revision not supported: %lu\n", value);
@@ -345,6 +358,26 @@ int ParseCmds(struct MMLinkCommandLine *mmlinkCmdLine, int argc, char *argv[])
 			mmlinkCmdLine->ip[15] = '\0';
 			break;
 
+		case 'b':
+			// Data socket buffer size
+			if (!tmp_optarg) {
+				PRINT_ERR("Missing required argument for --sock-buf-size");
+				return -1;
+			}
+			endptr = NULL;
+			mmlinkCmdLine->sock_buf_size = strtoul(tmp_optarg, &endptr, 0);
+			break;
+
+		case 't':
+			// T2H staging buffer size
+			if (!tmp_optarg) {
+				PRINT_ERR("Missing required argument for --t2h-buf-size");
+				return -1;
+			}
+			endptr = NULL;
+			mmlinkCmdLine->t2h_buf_size = strtoul(tmp_optarg, &endptr, 0);
+			break;
+
 		case 'v':
 			// Version
 			printf("mmlink %s %s%s\n",
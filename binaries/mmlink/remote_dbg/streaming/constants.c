@@ -93,3 +93,5 @@ const char *MGMT_RSP_NAGLE_PARAM = "MGMT_RSP_NAGLE";
 const size_t MGMT_RSP_NAGLE_PARAM_LEN = 15;
 const char *MGMT_SUPPORT_PARAM = "MGMT_SUPPORT";
 const size_t MGMT_SUPPORT_PARAM_LEN = 13;
+const char *XFER_STATS_PARAM = "XFER_STATS";
+const size_t XFER_STATS_PARAM_LEN = 11;
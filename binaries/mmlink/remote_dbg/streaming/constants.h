@@ -93,6 +93,8 @@ extern const char *MGMT_RSP_NAGLE_PARAM;
 extern const size_t MGMT_RSP_NAGLE_PARAM_LEN;
 extern const char *MGMT_SUPPORT_PARAM;
 extern const size_t MGMT_SUPPORT_PARAM_LEN;
+extern const char *XFER_STATS_PARAM;
+extern const size_t XFER_STATS_PARAM_LEN;
 
 // Global ST Host params
 #define HOSTNAMES_PARAM "hostnames"
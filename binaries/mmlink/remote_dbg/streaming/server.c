@@ -35,6 +35,14 @@
 #include "packet.h"
 #include "constants.h"
 
+// platform.h (via server.h) defines STI_NOSYS_PROT_PLATFORM.
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#endif
+
 const SERVER_BUFFERS SERVER_BUFFERS_default = {
     .ctrl_rx_buff = NULL,
     .ctrl_rx_buff_sz = 0,
@@ -83,7 +91,13 @@ const SERVER_CONN SERVER_CONN_default = {
     .server_fd = INVALID_SOCKET,
     .t2h_nagle = 0,
     .mgmt_rsp_nagle = 0,
-    .pkt_stats = { 0, 0, 0, 0 }
+    .sock_buff_sz = SERVER_DEFAULT_SOCK_BUFF_SZ,
+    .t2h_stage_sz = SERVER_DEFAULT_T2H_STAGE_SZ,
+    .t2h_stage = NULL,
+    .t2h_stage_head = 0,
+    .t2h_stage_tail = 0,
+    .pkt_stats = { 0, 0, 0, 0 },
+    .xfer_stats = { 0, 0, 0, 0 }
 };
 const SERVER_HW_CALLBACKS SERVER_HW_CALLBACKS_default = {
     .init_driver = NULL,
@@ -101,15 +115,27 @@ const SERVER_HW_CALLBACKS SERVER_HW_CALLBACKS_default = {
     .server_printf = printf
 };
 const SERVER_PKT_STATS SERVER_PKT_STATS_default = { 0, 0, 0, 0 };
+const SERVER_XFER_STATS SERVER_XFER_STATS_default = { 0, 0, 0, 0 };
 const CLIENT_CONN CLIENT_CONN_default = { INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET };
 
 // Global variables
+int terminate;
 #if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_WINDOWS || STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_NIOS_INICHE
 int sizeof_addr = -1;
 #else
 uint32_t sizeof_addr = 0;
 #endif
 
+static unsigned long long get_time_usec(void) {
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long)ts.tv_sec * 1000000ULL) + ((unsigned long long)ts.tv_nsec / 1000ULL);
+#else
+    return 0;
+#endif
+}
+
 void reset_buffers(SERVER_CONN *conn) {
     zero_mem(conn->buff->ctrl_rx_buff, conn->buff->ctrl_rx_buff_sz);
     zero_mem(conn->buff->ctrl_tx_buff, conn->buff->ctrl_tx_buff_sz);
@@ -134,6 +160,30 @@ void print_last_socket_error_b(const char *context_msg, ssize_t bytes_transferre
     }
 }
 
+const char *get_xfer_stats(SERVER_CONN *server_conn) {
+    snprintf(server_conn->buff->ctrl_tx_buff, server_conn->buff->ctrl_tx_buff_sz, "H2T_BYTES=%llu T2H_BYTES=%llu T2H_SENDS=%llu ELAPSED_US=%llu",
+        server_conn->xfer_stats.h2t_bytes,
+        server_conn->xfer_stats.t2h_bytes,
+        server_conn->xfer_stats.t2h_sends,
+        get_time_usec() - server_conn->xfer_stats.start_usec
+    );
+    return server_conn->buff->ctrl_tx_buff;
+}
+
+void print_xfer_stats(SERVER_CONN *server_conn) {
+    const SERVER_XFER_STATS *stats = &(server_conn->xfer_stats);
+    unsigned long long elapsed_usec = get_time_usec() - stats->start_usec;
+    if (elapsed_usec == 0) {
+        return;
+    }
+    // Bytes per microsecond is MB/s
+    server_conn->hw_callbacks.server_printf("Client transfer stats: T2H %llu bytes (%.1f MB/s, %llu sends), H2T %llu bytes (%.1f MB/s) in %.3f s\n",
+        stats->t2h_bytes, (double)stats->t2h_bytes / (double)elapsed_usec, stats->t2h_sends,
+        stats->h2t_bytes, (double)stats->h2t_bytes / (double)elapsed_usec,
+        (double)elapsed_usec / 1000000.0
+    );
+}
+
 void generate_server_welcome_message(char *buff, size_t buff_size, int mgmt_support, SERVER_BUFFERS *serv_buff, int handle) {
     snprintf(buff, buff_size, "Welcome to INTEL_ST_HOST_EP_SERVER: %s=%d %s=%ld %s=%ld %s=%ld HANDLE=%d",
         MGMT_SUPPORT_PARAM,
@@ -233,6 +283,7 @@ RETURN_CODE connect_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
     ssize_t bytes_transferred;
 
     server_conn->pkt_stats = SERVER_PKT_STATS_default;
+    server_conn->xfer_stats = SERVER_XFER_STATS_default;
 
     // Initialize the driver if required.  Initialization occurs here since it is the first thing run per spec,
     // and the welcome message requires querying the driver for MGMT support.
@@ -288,6 +339,14 @@ RETURN_CODE connect_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
     if (result == OK) {
         result = connect_client_socket(server_conn, handle, &(client_conn->t2h_data_fd), T2H_SOCK_NAME, server_conn->t2h_nagle);
     }
+
+    // The data sockets carry the bulk of the traffic, give them room to absorb bursts
+    if ((result == OK) && (server_conn->sock_buff_sz > 0)) {
+        if ((set_socket_buffer_sizes(client_conn->h2t_data_fd, (int)server_conn->sock_buff_sz) < 0) ||
+            (set_socket_buffer_sizes(client_conn->t2h_data_fd, (int)server_conn->sock_buff_sz) < 0)) {
+            print_last_socket_error("Failed to set data socket buffer sizes", server_conn->hw_callbacks.server_printf);
+        }
+    }
     
     if (result != OK) {
         send(client_conn->ctrl_fd, NOT_READY_MSG, NOT_READY_MSG_LEN, 0);
@@ -367,6 +426,8 @@ const char *get_parameter(char *cmd, SERVER_CONN *server_conn) {
     } else if (strncmp(param_name, MGMT_RSP_NAGLE_PARAM, MGMT_RSP_NAGLE_PARAM_LEN) == 0) {
         snprintf(server_conn->buff->ctrl_tx_buff, server_conn->buff->ctrl_tx_buff_sz, "%d", (int)(server_conn->mgmt_rsp_nagle));
         return server_conn->buff->ctrl_tx_buff;
+    } else if (strncmp(param_name, XFER_STATS_PARAM, XFER_STATS_PARAM_LEN) == 0) {
+        return get_xfer_stats(server_conn);
     } else {
         return GET_PARAM_CMD_FAIL_RSP;
     }
@@ -486,6 +547,131 @@ unsigned long buff_len_to_wrap_boundary(char *buff_sa, size_t buff_sz, char *buf
     }
 }
 
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+// Largest packet the ring must be able to take at once: guardband + header + a full
+// DATA_LEN_BYTES payload, plus the slack for copying the payload 64 bits at a time.
+#define T2H_STAGE_MAX_PACKET (SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER + H2T_PACKET_HEADER_MASK_DATA_LEN_BYTES + 1 + 8)
+
+static size_t t2h_stage_free(SERVER_CONN *server_conn) {
+    return server_conn->t2h_stage_sz - (server_conn->t2h_stage_head - server_conn->t2h_stage_tail);
+}
+
+static char t2h_stage_has_room(SERVER_CONN *server_conn, size_t payload_sz) {
+    return t2h_stage_free(server_conn) >= (SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER + payload_sz + 8) ? 1 : 0;
+}
+
+static void t2h_stage_put(SERVER_CONN *server_conn, const char *src, size_t len) {
+    size_t offset = server_conn->t2h_stage_head % server_conn->t2h_stage_sz;
+    size_t first_len = MIN_MACRO(len, server_conn->t2h_stage_sz - offset);
+    memcpy(server_conn->t2h_stage + offset, src, first_len);
+    memcpy(server_conn->t2h_stage, src + first_len, len - first_len);
+    server_conn->t2h_stage_head += len;
+}
+
+static void t2h_stage_put_mmio(SERVER_CONN *server_conn, const char *mmio_src, size_t len) {
+    size_t offset = server_conn->t2h_stage_head % server_conn->t2h_stage_sz;
+    size_t transfers = (len + 7) / 8;
+    volatile uint64_t *mmio_ptr = (uint64_t *)mmio_src;
+
+    if ((server_conn->t2h_stage_sz - offset) >= (transfers * 8)) {
+        // Common case, copy the device memory straight into the ring
+        char *dst = server_conn->t2h_stage + offset;
+        for (size_t i = 0; i < transfers; ++i) {
+            uint64_t val = *mmio_ptr++;
+            memcpy(dst, &val, sizeof(val));
+            dst += sizeof(val);
+        }
+        server_conn->t2h_stage_head += len;
+    } else {
+        // The ring wraps inside this payload, bounce it through local memory
+        static uint64_t bounce_buff[(H2T_PACKET_HEADER_MASK_DATA_LEN_BYTES + 1 + 8) / 8];
+        for (size_t i = 0; i < transfers; ++i) {
+            bounce_buff[i] = *mmio_ptr++;
+        }
+        t2h_stage_put(server_conn, (const char *)bounce_buff, len);
+    }
+}
+
+RETURN_CODE stage_t2h_data(SERVER_CONN *server_conn, char *staged) {
+    H2T_PACKET_HEADER *header = (H2T_PACKET_HEADER *)(server_conn->buff->t2h_header_buff + SIZEOF_PACKET_GUARDBAND);
+    unsigned char *t2h_buff;
+
+    *staged = 0;
+
+    // Drain the T2H FIFO until it is empty or the ring cannot take another full-size packet.
+    // The hardware descriptor is released as soon as the payload is in host memory, the
+    // socket send happens later in flush_t2h_stage.
+    while (t2h_stage_free(server_conn) >= T2H_STAGE_MAX_PACKET) {
+        if (server_conn->hw_callbacks.acquire_t2h_data(header, &t2h_buff) != 0) {
+            server_conn->hw_callbacks.server_printf("Failed to acquire T2H data\n");
+            return FAILURE;
+        }
+
+        size_t payload_bytes = header->DATA_LEN_BYTES;
+        if (payload_bytes == 0) {
+            break;
+        }
+        server_conn->pkt_stats.t2h_cnt++;
+
+        t2h_stage_put(server_conn, server_conn->buff->t2h_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER);
+        size_t first_len;
+        if (server_conn->buff->use_wrapping_data_buffers && ((first_len = buff_len_to_wrap_boundary(server_conn->buff->t2h_tx_buff, server_conn->buff->t2h_tx_buff_sz, (char *)t2h_buff, payload_bytes)) != 0)) {
+            t2h_stage_put_mmio(server_conn, (const char *)t2h_buff, first_len);
+            t2h_stage_put_mmio(server_conn, server_conn->buff->t2h_tx_buff, payload_bytes - first_len);
+        } else {
+            t2h_stage_put_mmio(server_conn, (const char *)t2h_buff, payload_bytes);
+        }
+
+        if (server_conn->hw_callbacks.t2h_data_complete != NULL) {
+            server_conn->hw_callbacks.t2h_data_complete();
+        }
+        *staged = 1;
+    }
+
+    return OK;
+}
+
+RETURN_CODE flush_t2h_stage(CLIENT_CONN *client_conn, SERVER_CONN *server_conn, char *writable) {
+    while (*writable && (server_conn->t2h_stage_head != server_conn->t2h_stage_tail)) {
+        size_t pending = server_conn->t2h_stage_head - server_conn->t2h_stage_tail;
+        size_t offset = server_conn->t2h_stage_tail % server_conn->t2h_stage_sz;
+        size_t first_len = MIN_MACRO(pending, server_conn->t2h_stage_sz - offset);
+
+        // Everything queued goes out in one call, as two pieces when the ring wraps
+        struct iovec iov[2];
+        iov[0].iov_base = server_conn->t2h_stage + offset;
+        iov[0].iov_len = first_len;
+        iov[1].iov_base = server_conn->t2h_stage;
+        iov[1].iov_len = pending - first_len;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (pending > first_len) ? 2 : 1;
+
+        ssize_t bytes_sent = sendmsg(client_conn->t2h_data_fd, &msg, MSG_NOSIGNAL);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                // Socket buffer is full, wait for EPOLLOUT
+                *writable = 0;
+                break;
+            }
+            print_last_socket_error("An error occurred sending T2H data", server_conn->hw_callbacks.server_printf);
+            return FAILURE;
+        }
+
+        server_conn->t2h_stage_tail += (size_t)bytes_sent;
+        server_conn->xfer_stats.t2h_bytes += (unsigned long long)bytes_sent;
+        server_conn->xfer_stats.t2h_sends++;
+    }
+
+    return OK;
+}
+#endif
+
 RETURN_CODE update_curr_h2t_header(CLIENT_CONN *client_conn, SERVER_CONN *server_conn) {
     if (server_conn->h2t_waiting == 0) {
         ssize_t bytes_recvd;
@@ -508,6 +694,12 @@ RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
 
         // Polls to see if there is room for the packet
         char *h2t_buff = ((server_conn->hw_callbacks.get_h2t_buffer != NULL) && (server_conn->loopback_mode == 0)) ? server_conn->hw_callbacks.get_h2t_buffer(bytes_to_transfer) : server_conn->buff->h2t_rx_buff;
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+        // Loopback data is echoed through the T2H staging ring, which also needs room
+        if ((server_conn->loopback_mode == 1) && !t2h_stage_has_room(server_conn, bytes_to_transfer)) {
+            h2t_buff = NULL;
+        }
+#endif
 
         // Recv H2T payload
         if (h2t_buff != NULL) {
@@ -515,12 +707,9 @@ RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
             server_conn->h2t_waiting = 0;
             size_t first_len;
             if (server_conn->buff->use_wrapping_data_buffers && ((first_len = buff_len_to_wrap_boundary(server_conn->buff->h2t_rx_buff, server_conn->buff->h2t_rx_buff_sz, h2t_buff, header->DATA_LEN_BYTES)) != 0)) {
-                // Wrap, 2 recv necessary
+                // Wrap, the payload is split across the end and the start of the buffer
                 size_t second_len = header->DATA_LEN_BYTES - first_len;
-                has_error = socket_recv_accumulate_h2t_data(client_conn->h2t_data_fd, h2t_buff, first_len, 0, &bytes_recvd);
-                if (has_error == OK) {
-                    has_error = socket_recv_accumulate_h2t_data(client_conn->h2t_data_fd, server_conn->buff->h2t_rx_buff, second_len, 0, &bytes_recvd);
-                }
+                has_error = socket_recv_accumulate_h2t_data_wrap(client_conn->h2t_data_fd, h2t_buff, first_len, server_conn->buff->h2t_rx_buff, second_len, 0, &bytes_recvd);
             } else {
                 // No wrap
             	has_error = socket_recv_accumulate_h2t_data(client_conn->h2t_data_fd, h2t_buff, bytes_to_transfer, 0, &bytes_recvd);
@@ -528,10 +717,16 @@ RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
 
             // Push to driver or loopback
             if (has_error == OK) {
+                server_conn->xfer_stats.h2t_bytes += bytes_to_transfer;
                 if (server_conn->loopback_mode == 0) {
                     // Normal operation, push the transaction to HW
                     has_error = (server_conn->hw_callbacks.h2t_data_received != NULL) ? server_conn->hw_callbacks.h2t_data_received(header, (unsigned char *)h2t_buff) : OK;
                 } else {
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+                    // Queue the header and payload, the main loop sends them out
+                    t2h_stage_put(server_conn, server_conn->buff->h2t_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER);
+                    t2h_stage_put_mmio(server_conn, h2t_buff, bytes_to_transfer);
+#else
                     // Send the header
                     if ((has_error = socket_send_all(client_conn->t2h_data_fd, server_conn->buff->h2t_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER, 0, &bytes_recvd)) == OK) {
                         // Send the payload
@@ -541,6 +736,7 @@ RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
                     } else {
                         print_last_socket_error_b("Failed to send loopback T2H header", bytes_recvd, server_conn->hw_callbacks.server_printf);
                     }
+#endif
                 }
             } else {
                 print_last_socket_error_b("Failed to recv H2T data", bytes_recvd, server_conn->hw_callbacks.server_printf);
@@ -647,6 +843,8 @@ RETURN_CODE process_t2h_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
                 has_error = socket_send_all_t2h_data(client_conn->t2h_data_fd, (const char *)t2h_buff, curr_payload_bytes, 0, &bytes_sent);
             }
             if (has_error == OK) {
+                server_conn->xfer_stats.t2h_bytes += SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER + curr_payload_bytes;
+                server_conn->xfer_stats.t2h_sends++;
                 if (server_conn->hw_callbacks.t2h_data_complete != NULL) {
                     server_conn->hw_callbacks.t2h_data_complete();
                 }
@@ -719,6 +917,239 @@ void reject_client(SERVER_CONN *server_conn) {
     }
 }
 
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+void handle_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
+    // Number of idle passes spun with a zero timeout before sleeping between FIFO polls.
+    // The T2H FIFO has no file descriptor, so it is polled; while data is moving the loop
+    // never sleeps, once idle it checks the FIFO every millisecond.
+    enum { NUM_FDS = 6, IDLE_SPIN_PASSES = 64, IDLE_POLL_MS = 1, NO_HW_POLL_MS = 1000 };
+    enum { SERVER_IDX = 0, CTRL_IDX, MGMT_IDX, MGMT_RSP_IDX, H2T_IDX, T2H_IDX };
+    SOCKET all_fds[NUM_FDS];
+    all_fds[SERVER_IDX] = server_conn->server_fd;
+    all_fds[CTRL_IDX] = client_conn->ctrl_fd;
+    all_fds[MGMT_IDX] = client_conn->mgmt_fd;
+    all_fds[MGMT_RSP_IDX] = client_conn->mgmt_rsp_fd;
+    all_fds[H2T_IDX] = client_conn->h2t_data_fd;
+    all_fds[T2H_IDX] = client_conn->t2h_data_fd;
+    const char *all_fd_names[NUM_FDS];
+    all_fd_names[SERVER_IDX] = SERVER_SOCK_NAME;
+    all_fd_names[CTRL_IDX] = CONTROL_SOCK_NAME;
+    all_fd_names[MGMT_IDX] = MANAGEMENT_SOCK_NAME;
+    all_fd_names[MGMT_RSP_IDX] = MANAGEMENT_RSP_SOCK_NAME;
+    all_fd_names[H2T_IDX] = H2T_SOCK_NAME;
+    all_fd_names[T2H_IDX] = T2H_SOCK_NAME;
+
+    // The listening socket stays level triggered so each pending client gets rejected,
+    // the client sockets are edge triggered and drained on every event.
+    uint32_t all_events[NUM_FDS];
+    all_events[SERVER_IDX] = EPOLLIN;
+    all_events[CTRL_IDX] = EPOLLIN | EPOLLET;
+    all_events[MGMT_IDX] = EPOLLIN | EPOLLET;
+    all_events[MGMT_RSP_IDX] = EPOLLET;
+    all_events[H2T_IDX] = EPOLLIN | EPOLLET;
+    all_events[T2H_IDX] = EPOLLOUT | EPOLLET;
+
+    if (server_conn->t2h_stage_sz < SERVER_MIN_T2H_STAGE_SZ) {
+        server_conn->t2h_stage_sz = SERVER_MIN_T2H_STAGE_SZ;
+    }
+    server_conn->t2h_stage = (char *)malloc(server_conn->t2h_stage_sz);
+    server_conn->t2h_stage_head = 0;
+    server_conn->t2h_stage_tail = 0;
+    if (server_conn->t2h_stage == NULL) {
+        server_conn->hw_callbacks.server_printf("Failed to allocate %zu byte T2H staging buffer\n", server_conn->t2h_stage_sz);
+        return;
+    }
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        print_last_socket_error("Failed to create epoll instance", server_conn->hw_callbacks.server_printf);
+        free(server_conn->t2h_stage);
+        server_conn->t2h_stage = NULL;
+        return;
+    }
+
+    char fd_errors = 0;
+    for (int i = 0; i < NUM_FDS; ++i) {
+        struct epoll_event ev;
+        ev.events = all_events[i];
+        ev.data.u32 = (uint32_t)i;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, all_fds[i], &ev) < 0) {
+            print_last_socket_error("Failed to add socket to epoll instance", server_conn->hw_callbacks.server_printf);
+            fd_errors = 1;
+            break;
+        }
+    }
+
+    // T2H is the only socket whose sends must never stall the loop
+    if ((fd_errors == 0) && (set_socket_non_blocking(client_conn->t2h_data_fd, 1) < 0)) {
+        print_last_socket_error("Failed to make T2H socket non-blocking", server_conn->hw_callbacks.server_printf);
+        fd_errors = 1;
+    }
+
+    char ctrl_ready = 0;
+    char mgmt_ready = 0;
+    char h2t_ready = 0;
+    char t2h_writable = 1;
+    unsigned idle_passes = 0;
+
+    server_conn->xfer_stats.start_usec = get_time_usec();
+
+    while (!fd_errors && !terminate) {
+        struct epoll_event events[NUM_FDS];
+        char hw_polled = (server_conn->loopback_mode == 0) &&
+                         ((server_conn->hw_callbacks.acquire_t2h_data != NULL) || (server_conn->hw_callbacks.acquire_mgmt_rsp_data != NULL));
+        // A loopback packet waiting on a full ring only needs to wake up for EPOLLOUT
+        char h2t_stalled = server_conn->h2t_waiting && !((server_conn->loopback_mode == 1) && !t2h_writable);
+        int timeout_ms;
+        if (h2t_stalled || server_conn->mgmt_waiting || (idle_passes < IDLE_SPIN_PASSES)) {
+            timeout_ms = 0;
+        } else {
+            timeout_ms = hw_polled ? IDLE_POLL_MS : NO_HW_POLL_MS;
+        }
+
+        int num_events = epoll_wait(epoll_fd, events, NUM_FDS, timeout_ms);
+        if (num_events < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            print_last_socket_error("epoll_wait failure", server_conn->hw_callbacks.server_printf);
+            break;
+        }
+
+        // First handle exceptional conditions, collect readiness for the rest
+        char disconnect_client = 0;
+        char server_ready = 0;
+        for (int i = 0; i < num_events; ++i) {
+            uint32_t idx = events[i].data.u32;
+            if (events[i].events & EPOLLERR) {
+                server_conn->hw_callbacks.server_printf("Exception found on socket: %s\n", all_fd_names[idx]);
+                disconnect_client = 1;
+                break;
+            }
+            // A hang up shows up as a failed recv on the readable sockets
+            if (events[i].events & (EPOLLIN | EPOLLHUP)) {
+                switch (idx) {
+                case SERVER_IDX: server_ready = 1; break;
+                case CTRL_IDX: ctrl_ready = 1; break;
+                case MGMT_IDX: mgmt_ready = 1; break;
+                case H2T_IDX: h2t_ready = 1; break;
+                default: break;
+                }
+            }
+            if ((idx == T2H_IDX) && (events[i].events & EPOLLOUT)) {
+                t2h_writable = 1;
+            }
+            if ((idx == MGMT_RSP_IDX || idx == T2H_IDX) && (events[i].events & EPOLLHUP)) {
+                server_conn->hw_callbacks.server_printf("Exception found on socket: %s\n", all_fd_names[idx]);
+                disconnect_client = 1;
+                break;
+            }
+        }
+        if (disconnect_client) {
+            break;
+        }
+
+        char moved_data = 0;
+
+        // Check for additional clients attempting to connect,
+        // if so, politely tell them to get lost.
+        if (server_ready) {
+            reject_client(server_conn);
+        }
+
+        // Process every control message already queued
+        while (ctrl_ready) {
+            if (!socket_has_pending_data(client_conn->ctrl_fd)) {
+                ctrl_ready = 0;
+                break;
+            }
+            if (process_control_message(client_conn, server_conn, &disconnect_client) == FAILURE) {
+                disconnect_client = 1;
+            }
+            if (disconnect_client) {
+                break;
+            }
+        }
+        if (disconnect_client) {
+            break;
+        }
+
+        // Then every queued management command, until the driver runs out of room
+        while (mgmt_ready) {
+            if (!server_conn->mgmt_waiting && !socket_has_pending_data(client_conn->mgmt_fd)) {
+                mgmt_ready = 0;
+                break;
+            }
+            if (process_mgmt_data(client_conn, server_conn) == FAILURE) {
+                disconnect_client = 1;
+                break;
+            }
+            if (server_conn->mgmt_waiting) {
+                break;
+            }
+            moved_data = 1;
+        }
+        if (disconnect_client) {
+            break;
+        }
+
+        // Then incoming H2T data, same as above
+        while (h2t_ready) {
+            if (!server_conn->h2t_waiting && !socket_has_pending_data(client_conn->h2t_data_fd)) {
+                h2t_ready = 0;
+                break;
+            }
+            if (process_h2t_data(client_conn, server_conn) == FAILURE) {
+                disconnect_client = 1;
+                break;
+            }
+            if (server_conn->h2t_waiting) {
+                break;
+            }
+            moved_data = 1;
+        }
+        if (disconnect_client) {
+            break;
+        }
+
+        if (server_conn->loopback_mode == 0) {
+            // See if any outbound management data is present, if so send it out
+            if (server_conn->hw_callbacks.acquire_mgmt_rsp_data != NULL) {
+                if (process_mgmt_rsp_data(client_conn, server_conn) == FAILURE) {
+                    break;
+                }
+            }
+
+            // Move whatever the T2H FIFO holds into the staging ring
+            if (server_conn->hw_callbacks.acquire_t2h_data != NULL) {
+                char staged;
+                if (stage_t2h_data(server_conn, &staged) == FAILURE) {
+                    break;
+                }
+                moved_data |= staged;
+            }
+        }
+
+        // Send out everything staged, H2T loopback data included
+        if (flush_t2h_stage(client_conn, server_conn, &t2h_writable) == FAILURE) {
+            break;
+        }
+
+        // A loopback packet blocked on a full ring can proceed once the ring drained
+        if (server_conn->h2t_waiting && (server_conn->loopback_mode == 1)) {
+            h2t_ready = 1;
+        }
+
+        idle_passes = moved_data ? 0 : (idle_passes < IDLE_SPIN_PASSES ? idle_passes + 1 : idle_passes);
+    }
+
+    print_xfer_stats(server_conn);
+
+    close(epoll_fd);
+    free(server_conn->t2h_stage);
+    server_conn->t2h_stage = NULL;
+}
+#else
 void handle_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
     fd_set read_fds;
     fd_set write_fds;
@@ -839,6 +1270,7 @@ void handle_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
         }
     }
 }
+#endif
 
 RETURN_CODE initialize_server(unsigned short port, SERVER_CONN *server_conn, const char *port_filename) {
     if (initialize_sockets_library() == FAILURE) {
@@ -886,7 +1318,6 @@ RETURN_CODE initialize_server(unsigned short port, SERVER_CONN *server_conn, con
     return OK;
 }
 
-int terminate;
 void server_terminate()
 {
 	terminate = 1;
@@ -131,6 +131,18 @@ typedef struct {
     size_t mgmt_rsp_cnt;
 } SERVER_PKT_STATS;
 
+typedef struct {
+    unsigned long long h2t_bytes;   // H2T payload bytes received
+    unsigned long long t2h_bytes;   // T2H bytes (headers + payload) sent
+    unsigned long long t2h_sends;   // socket writes used to send them
+    unsigned long long start_usec;  // when the client connected
+} SERVER_XFER_STATS;
+
+// Defaults for SERVER_CONN.sock_buff_sz and SERVER_CONN.t2h_stage_sz
+#define SERVER_DEFAULT_SOCK_BUFF_SZ (1024 * 1024)
+#define SERVER_DEFAULT_T2H_STAGE_SZ (256 * 1024)
+#define SERVER_MIN_T2H_STAGE_SZ (64 * 1024)
+
 typedef struct {
     // Buffers
     SERVER_BUFFERS *buff;
@@ -147,8 +159,18 @@ typedef struct {
     char t2h_nagle;
     char mgmt_rsp_nagle;
 
+    // Transfer tuning
+    size_t sock_buff_sz;   // SO_SNDBUF/SO_RCVBUF of the H2T and T2H sockets, 0 for the OS default
+    size_t t2h_stage_sz;   // Host memory ring that batches T2H packets on their way to the socket
+
+    // T2H staging ring, allocated per client
+    char *t2h_stage;
+    size_t t2h_stage_head; // Total bytes staged
+    size_t t2h_stage_tail; // Total bytes sent
+
     // Misc
     SERVER_PKT_STATS pkt_stats;
+    SERVER_XFER_STATS xfer_stats;
 } SERVER_CONN;
 
 typedef struct {
@@ -163,6 +185,7 @@ extern const SERVER_BUFFERS SERVER_BUFFERS_default;
 extern const SERVER_CONN SERVER_CONN_default;
 extern const SERVER_HW_CALLBACKS SERVER_HW_CALLBACKS_default;
 extern const SERVER_PKT_STATS SERVER_PKT_STATS_default;
+extern const SERVER_XFER_STATS SERVER_XFER_STATS_default;
 extern const CLIENT_CONN CLIENT_CONN_default;
 
 // Server code
@@ -188,9 +211,15 @@ RETURN_CODE update_curr_mgmt_header(CLIENT_CONN *client_conn, SERVER_CONN *serve
 RETURN_CODE process_mgmt_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn);
 RETURN_CODE process_t2h_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn);
 RETURN_CODE process_mgmt_rsp_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn);
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+RETURN_CODE stage_t2h_data(SERVER_CONN *server_conn, char *staged);
+RETURN_CODE flush_t2h_stage(CLIENT_CONN *client_conn, SERVER_CONN *server_conn, char *writable);
+#endif
 
 // Misc helper
 void reset_buffers(SERVER_CONN *server_conn);
+const char *get_xfer_stats(SERVER_CONN *server_conn);
+void print_xfer_stats(SERVER_CONN *server_conn);
 void generate_server_welcome_message(char *buff, size_t buff_size, int mgmt_support, SERVER_BUFFERS *serv_buff, int handle);
 void print_last_socket_error(const char *context_msg, int(*printf_fp)(printf_format_arg, ...));
 void print_last_socket_error_b(const char *context_msg, ssize_t bytes_transferred, int(*printf_fp)(printf_format_arg, ...));
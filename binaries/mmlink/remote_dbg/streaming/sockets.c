@@ -216,7 +216,32 @@ RETURN_CODE socket_recv_accumulate_h2t_data(SOCKET sock_fd, char *buff, const si
         }
     }
     
-    return OK;
+    return rc;
+}
+
+RETURN_CODE socket_recv_accumulate_h2t_data_wrap(SOCKET sock_fd, char *buff, const size_t len, char *wrap_buff, const size_t wrap_len, int flags, ssize_t *bytes_recvd) {
+    // Recv the whole payload at once, then split it across the wrap boundary
+    RETURN_CODE rc = socket_recv_accumulate(sock_fd, g_socket_recv_buff, len + wrap_len, flags, bytes_recvd);
+
+    if (rc != FAILURE) {
+        volatile uint64_t *mmio_ptr = (uint64_t *)buff;
+        uint64_t *buff64 = (uint64_t *)g_socket_recv_buff;
+        size_t transfers = (len + 7) / 8;
+        for (size_t i = 0; i < transfers; ++i) {
+            *mmio_ptr++ = *buff64++;
+        }
+
+        // The wrapped portion may not start on a 64-bit boundary of the local buffer
+        mmio_ptr = (uint64_t *)wrap_buff;
+        transfers = (wrap_len + 7) / 8;
+        for (size_t i = 0; i < transfers; ++i) {
+            uint64_t val;
+            memcpy(&val, g_socket_recv_buff + len + (i * 8), sizeof(val));
+            *mmio_ptr++ = val;
+        }
+    }
+
+    return rc;
 }
 
 RETURN_CODE initialize_sockets_library() {
@@ -252,6 +277,18 @@ int set_tcp_no_delay(SOCKET socket_fd, int no_delay) {
 #endif
 }
 
+int set_socket_buffer_sizes(SOCKET socket_fd, int buff_sz) {
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_WINDOWS
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, (const char *)&buff_sz, sizeof(buff_sz)) < 0)
+        return -1;
+    return setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, (const char *)&buff_sz, sizeof(buff_sz));
+#else
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, &buff_sz, sizeof(buff_sz)) < 0)
+        return -1;
+    return setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, &buff_sz, sizeof(buff_sz));
+#endif
+}
+
 int set_linger_socket_option(SOCKET socket_fd, int l_onoff, int l_linger) {
     struct linger linger_opt_val;
 #if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_WINDOWS
@@ -273,7 +310,7 @@ int set_socket_non_blocking(SOCKET socket_fd, int non_blocking) {
     int flags;
     if ((flags = fcntl(socket_fd, F_GETFL, 0)) < 0)
         flags = 0;
-    int val = non_blocking ? (flags | O_NONBLOCK) : (flags & !O_NONBLOCK);
+    int val = non_blocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
     return fcntl(socket_fd, F_SETFL, val);
 #endif
 }
@@ -286,6 +323,18 @@ char is_last_socket_error_would_block() {
 #endif
 }
 
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+char socket_has_pending_data(SOCKET socket_fd) {
+    char c;
+    ssize_t res = recv(socket_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    // Data, EOF or an error; let the caller's recv report it
+    return 1;
+}
+#endif
+
 int close_socket_fd(SOCKET socket_fd) {
 #if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_WINDOWS
     return closesocket(socket_fd);
@@ -84,12 +84,17 @@ RETURN_CODE socket_send_all_t2h_data(SOCKET fd, const char *buff, const size_t l
 RETURN_CODE socket_recv_until_null_reached(SOCKET sock_fd, char *buff, const size_t max_len, int flags, ssize_t *bytes_recvd);
 RETURN_CODE socket_recv_accumulate(SOCKET sock_fd, char *buff, const size_t len, int flags, ssize_t *bytes_recvd);
 RETURN_CODE socket_recv_accumulate_h2t_data(SOCKET sock_fd, char *buff, const size_t len, int flags, ssize_t *bytes_recvd);
+RETURN_CODE socket_recv_accumulate_h2t_data_wrap(SOCKET sock_fd, char *buff, const size_t len, char *wrap_buff, const size_t wrap_len, int flags, ssize_t *bytes_recvd);
 RETURN_CODE initialize_sockets_library();
 int set_boolean_socket_option(SOCKET socket_fd, int option, int option_val);
 int set_tcp_no_delay(SOCKET socket_fd, int no_delay);
 int set_linger_socket_option(SOCKET socket_fd, int l_onoff, int l_linger);
+int set_socket_buffer_sizes(SOCKET socket_fd, int buff_sz);
 int set_socket_non_blocking(SOCKET socket_fd, int non_blocking);
 char is_last_socket_error_would_block();
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+char socket_has_pending_data(SOCKET socket_fd);
+#endif
 int close_socket_fd(SOCKET socket_fd);
 void wait_for_read_event(SOCKET socket_fd, long seconds, long useconds);
 int get_last_socket_error();
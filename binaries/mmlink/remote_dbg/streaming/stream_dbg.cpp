@@ -104,6 +104,10 @@ int stream_dbg::run(volatile uint64_t *mmio_ptr, const char *address, int port)
   SERVER_CONN server_conn = SERVER_CONN_default;
   server_conn.buff = &buffers;
   server_conn.hw_callbacks = get_hw_callbacks();
+  if (sock_buff_sz_)
+    server_conn.sock_buff_sz = sock_buff_sz_;
+  if (t2h_buff_sz_)
+    server_conn.t2h_stage_sz = t2h_buff_sz_;
 
   if (initialize_server((unsigned short)port, &server_conn, SERVER_PORT_FILE) == OK) {
     server_main(MULTIPLE_CLIENTS, &server_conn);
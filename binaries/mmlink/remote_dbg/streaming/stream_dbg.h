@@ -29,9 +29,14 @@
 class stream_dbg : public remote_dbg
 {
 public:
-  stream_dbg(){}
+  // Zero keeps the server's default for either size.
+  stream_dbg(size_t sock_buff_sz = 0, size_t t2h_buff_sz = 0)
+    : sock_buff_sz_(sock_buff_sz), t2h_buff_sz_(t2h_buff_sz){}
   virtual ~stream_dbg(){}
   int run(volatile uint64_t *mmio, const char *address, int port) override;
   void terminate() override;
 
+private:
+  size_t sock_buff_sz_;
+  size_t t2h_buff_sz_;
 };
@@ -25,6 +25,20 @@
 ## ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 ## POSSIBILITY OF SUCH DAMAGE.
 
+# ofs_parse.py generates the OFS user mode drivers from their yml
+# descriptions and needs the jsonschema and pyyaml Python modules. Install
+# them from the distribution (python3-jsonschema, python3-pyyaml) or with
+# pip; they are not vendored in the source tree.
+execute_process(
+    COMMAND ${PYTHON_EXECUTABLE} -c "import jsonschema, yaml"
+    RESULT_VARIABLE OFS_PARSE_PYTHON_DEPS
+    OUTPUT_QUIET ERROR_QUIET
+)
+if(NOT OFS_PARSE_PYTHON_DEPS EQUAL 0)
+    message(WARNING "ofs_parse.py requires the Python jsonschema and "
+                    "pyyaml modules; OFS driver generation will fail.")
+endif()
+
 macro(ofs_add_driver yml_file driver)
     add_custom_command(
         OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/${driver}.h
@@ -32,8 +32,13 @@ check_cxx_compiler_flag("-Wno-sign-compare" CXX_SUPPORTS_NO_SIGN_COMPARE)
 set(OPAE_TEST_LIBRARIES test_system fpga_db
     CACHE INTERNAL "OPAE test libs." FORCE)
 
+# Pass BENCHMARK to build SOURCE as an opt-in benchmark: the
+# tests guarded by OPAE_BENCHMARK and named bench_* are compiled
+# in, only they are run, and the ctest entry is labeled
+# "benchmark" and run serially. Such targets should be added
+# only when OPAE_BUILD_BENCHMARKS is ON.
 function(opae_test_add)
-    set(options TEST_FPGAD)
+    set(options TEST_FPGAD BENCHMARK)
     set(oneValueArgs TARGET)
     set(multiValueArgs SOURCE LIBS)
     cmake_parse_arguments(OPAE_TEST_ADD "${options}"
@@ -66,6 +71,11 @@ function(opae_test_add)
         target_compile_options(${OPAE_TEST_ADD_TARGET}
             PRIVATE -Wno-sign-compare)
     endif()
+    if(${OPAE_TEST_ADD_BENCHMARK})
+        target_compile_definitions(${OPAE_TEST_ADD_TARGET}
+            PRIVATE
+                OPAE_BENCHMARK=1)
+    endif(${OPAE_TEST_ADD_BENCHMARK})
 
     target_include_directories(${OPAE_TEST_ADD_TARGET}
         PUBLIC
@@ -96,16 +106,27 @@ function(opae_test_add)
     opae_coverage_build(TARGET ${OPAE_TEST_ADD_TARGET}
         SOURCE ${OPAE_TEST_ADD_SOURCE})
 
+    set(test_args)
     if (OPAE_GTEST_OUTPUT)
-        set(test_args
+        list(APPEND test_args
             "--gtest_output=xml:${OPAE_GTEST_OUTPUT}/${OPAE_TEST_ADD_TARGET}.xml")
     endif (OPAE_GTEST_OUTPUT)
+    if(${OPAE_TEST_ADD_BENCHMARK})
+        list(APPEND test_args "--gtest_filter=*bench_*")
+    endif(${OPAE_TEST_ADD_BENCHMARK})
 
     add_test(
         NAME ${OPAE_TEST_ADD_TARGET}
         COMMAND $<TARGET_FILE:${OPAE_TEST_ADD_TARGET}> ${test_args}
         WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
     )
+
+    if(${OPAE_TEST_ADD_BENCHMARK})
+        set_tests_properties(${OPAE_TEST_ADD_TARGET}
+            PROPERTIES
+                LABELS benchmark
+                RUN_SERIAL TRUE)
+    endif(${OPAE_TEST_ADD_BENCHMARK})
 endfunction()
 
 function(opae_test_add_static_lib)
@@ -45,25 +45,43 @@
     .tv_nsec = _usec*USEC2NSEC-(long)(_usec*USEC2SEC)*SEC2NSEC  \
   }
 
+/*
+ * Wait engine
+ *
+ * The wait macros and functions below poll a condition through an
+ * ofs_wait. Each call to ofs_wait_step() escalates through three stages:
+ *
+ *   1. spin with the pause instruction for OFS_WAIT_SPIN_NSEC,
+ *   2. on CPUs with WAITPKG, nap in tpause for up to OFS_WAIT_NAP_NSEC,
+ *      waking every OFS_WAIT_NAP_SLICE_NSEC to re-check,
+ *   3. nanosleep with exponential backoff, from OFS_WAIT_MIN_SLEEP_NSEC
+ *      up to the caller's sleep interval.
+ *
+ * A sleep interval of 0 never sleeps: the wait stays in stage 1 or 2
+ * until the condition is met or the timeout expires.
+ * Deadlines are kept in ofs_clock_ticks() units (invariant TSC when
+ * available), so each poll costs an rdtsc rather than a clock_gettime.
+ */
+#define OFS_WAIT_SPIN_NSEC       2000
+#define OFS_WAIT_NAP_NSEC        50000
+#define OFS_WAIT_NAP_SLICE_NSEC  1000
+#define OFS_WAIT_MIN_SLEEP_NSEC  1000
+
+struct ofs_wait {
+	uint64_t deadline;       // ticks
+	uint64_t spin_end;       // ticks
+	uint64_t nap_end;        // ticks
+	uint64_t sleep_nsec;     // current backoff
+	uint64_t max_sleep_nsec; // 0: never sleep
+};
+
 #define OFS_WAIT_FOR_EQ(_bit, _value, _timeout_usec, _sleep_usec)           \
 ({                                                                          \
 	int _status = 0;                                                    \
-	OFS_TIMESPEC_USEC(ts, _sleep_usec);                                 \
-	struct timespec begin, now, save, rem;                              \
-	save = ts;                                                          \
-	clock_gettime(CLOCK_MONOTONIC, &begin);                             \
+	struct ofs_wait _w;                                                 \
+	ofs_wait_init(&_w, _timeout_usec, _sleep_usec);                     \
 	while(_bit != _value) {                                             \
-		if (_sleep_usec) {                                          \
-			ts = save;                                          \
-			while ((nanosleep(&ts, &rem) == -1) &&              \
-			       (errno == EINTR))                            \
-				ts = rem;                                   \
-		}                                                           \
-		clock_gettime(CLOCK_MONOTONIC, &now);                       \
-		struct timespec delta;                                      \
-		ofs_diff_timespec(&delta, &now, &begin);                    \
-		uint64_t delta_nsec = delta.tv_nsec + delta.tv_sec*SEC2NSEC;\
-		if (delta_nsec > _timeout_usec*USEC2NSEC) {                 \
+		if (ofs_wait_step(&_w)) {                                   \
 			_status = 1;                                        \
 			break;                                              \
 		}                                                           \
@@ -74,22 +92,10 @@
 #define OFS_WAIT_FOR_NE(_bit, _value, _timeout_usec, _sleep_usec)           \
 ({                                                                          \
 	int _status = 0;                                                    \
-	OFS_TIMESPEC_USEC(ts, _sleep_usec);                                 \
-	struct timespec begin, now, save, rem;                              \
-	save = ts;                                                          \
-	clock_gettime(CLOCK_MONOTONIC, &begin);                             \
+	struct ofs_wait _w;                                                 \
+	ofs_wait_init(&_w, _timeout_usec, _sleep_usec);                     \
 	while(_bit == _value) {                                             \
-		if (_sleep_usec) {                                          \
-			ts = save;                                          \
-			while ((nanosleep(&ts, &rem) == -1) &&              \
-			       (errno == EINTR))                            \
-				ts = rem;                                   \
-		}                                                           \
-		clock_gettime(CLOCK_MONOTONIC, &now);                       \
-		struct timespec delta;                                      \
-		ofs_diff_timespec(&delta, &now, &begin);                    \
-		uint64_t delta_nsec = delta.tv_nsec + delta.tv_sec*SEC2NSEC;\
-		if (delta_nsec > _timeout_usec*USEC2NSEC) {                 \
+		if (ofs_wait_step(&_w)) {                                   \
 			_status = 1;                                        \
 			break;                                              \
 		}                                                           \
@@ -101,6 +107,41 @@
 extern "C" {
 #endif
 
+/**
+ *  Read the wait engine clock
+ *
+ *  @returns The invariant TSC when the CPU has one, otherwise
+ *           CLOCK_MONOTONIC in nanoseconds
+ */
+uint64_t ofs_clock_ticks(void);
+
+/**
+ *  Convert microseconds to ofs_clock_ticks() units
+ *
+ *  @param[in] usec Microseconds
+ *  @returns Number of clock ticks in usec
+ */
+uint64_t ofs_usec_to_ticks(uint64_t usec);
+
+/**
+ *  Start a wait
+ *
+ *  @param[out] w           Wait state
+ *  @param[in] timeout_usec Timeout value in usec
+ *  @param[in] sleep_usec   Longest time (in usec) to sleep between polls,
+ *                          0 to never sleep
+ */
+void ofs_wait_init(struct ofs_wait *w, uint64_t timeout_usec,
+		   uint32_t sleep_usec);
+
+/**
+ *  Back off once between two polls of a wait condition
+ *
+ *  @param[in,out] w Wait state
+ *  @returns 0 if the caller should poll again, 1 if the timeout expired
+ */
+int ofs_wait_step(struct ofs_wait *w);
+
 /**
  *  Get timespec difference
  *
@@ -152,28 +193,16 @@ inline int ofs_diff_timespec(struct timespec *result,
  *  @param[in] var          Pointer to a variable that may change
  *  @param[in] value        Value to compare to var
  *  @param[in] timeout_usec Timeout value in usec
- *  @param[in] sleep_usec   Time (in usec) to sleep while waiting
+ *  @param[in] sleep_usec   Longest time (in usec) to sleep between polls
  *  @returns 0 if variable changed to value while waiting, 1 otherwise
  */
 inline int ofs_wait_for_eq32(volatile uint32_t *var, uint32_t value,
 			     uint64_t timeout_usec, uint32_t sleep_usec)
 {
-	OFS_TIMESPEC_USEC(ts, sleep_usec);
-	struct timespec begin, now, save, rem;
-	save = ts;
-	clock_gettime(CLOCK_MONOTONIC, &begin);
+	struct ofs_wait w;
+	ofs_wait_init(&w, timeout_usec, sleep_usec);
 	while(*var != value) {
-		if (sleep_usec) {
-			ts = save;
-			while((nanosleep(&ts, &rem) == -1) &&
-			      (errno == EINTR))
-				ts = rem;
-		}
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		struct timespec delta;
-		ofs_diff_timespec(&delta, &now, &begin);
-  		uint64_t delta_nsec = delta.tv_nsec + delta.tv_sec*SEC2NSEC;
-		if (delta_nsec > timeout_usec*USEC2NSEC) {
+		if (ofs_wait_step(&w)) {
 			return 1;
 		}
 	}
@@ -190,28 +219,16 @@ inline int ofs_wait_for_eq32(volatile uint32_t *var, uint32_t value,
  *  @param[in] var          Pointer to a variable that may change
  *  @param[in] value        Value to compare to var
  *  @param[in] timeout_usec Timeout value in usec
- *  @param[in] sleep_usec   Time (in usec) to sleep while waiting
+ *  @param[in] sleep_usec   Longest time (in usec) to sleep between polls
  *  @returns 0 if variable changed to value while waiting, 1 otherwise
  */
 inline int ofs_wait_for_eq64(volatile uint64_t *var, uint64_t value,
 			     uint64_t timeout_usec, uint32_t sleep_usec)
 {
-	OFS_TIMESPEC_USEC(ts, sleep_usec);
-	struct timespec begin, now, save, rem;
-	save = ts;
-	clock_gettime(CLOCK_MONOTONIC, &begin);
+	struct ofs_wait w;
+	ofs_wait_init(&w, timeout_usec, sleep_usec);
 	while(*var != value) {
-		if (sleep_usec) {
-			ts = save;
-			while ((nanosleep(&ts, &rem) == -1) &&
-			       (errno == EINTR))
-				ts = rem;
-		}
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		struct timespec delta;
-		ofs_diff_timespec(&delta, &now, &begin);
-  		uint64_t delta_nsec = delta.tv_nsec + delta.tv_sec*SEC2NSEC;
-		if (delta_nsec > timeout_usec*USEC2NSEC) {
+		if (ofs_wait_step(&w)) {
 			return 1;
 		}
 	}
@@ -58,6 +58,13 @@ extern "C" {
  *                          when all associated handles have been closed
  *                          (either explicitly with fpgaClose() or by process
  *                          termination).
+ *                        * FPGA_OPEN_BUFFER_POOL keeps buffers released with
+ *                          fpgaReleaseBuffer() pinned and mapped, and reuses
+ *                          them for later fpgaPrepareBuffer() calls of a
+ *                          similar size. The bytes held idle by the pool are
+ *                          capped by the LIBOPAE_BUF_POOL_MAX environment
+ *                          variable (default 1 GiB). Pooled buffers are
+ *                          released when the handle is closed.
  * @returns             FPGA_OK on success. FPGA_NOT_FOUND if the resource for
  *                      'token' could not be found. FPGA_INVALID_PARAM if
  *                      'token' does not refer to a resource that can be
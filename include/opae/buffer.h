@@ -84,6 +84,10 @@ extern "C" {
  *                        pointed at in '*buf_addr' is already allocated an
  *                        mapped into virtual memory. FPGA_BUF_READ_ONLY
  *                        pins pages with only read access from the FPGA.
+ *                        FPGA_BUF_NO_POOL allocates a fresh buffer, even
+ *                        when the handle was opened with
+ *                        FPGA_OPEN_BUFFER_POOL, and releases it for real
+ *                        in fpgaReleaseBuffer().
  * @returns FPGA_OK on success. FPGA_NO_MEMORY if the requested memory could
  * not be allocated. FPGA_INVALID_PARAM if invalid parameters were provided, or
  * if the parameter combination is not valid. FPGA_EXCEPTION if an internal
@@ -93,6 +97,10 @@ extern "C" {
  * if len == 0 and buf_addr == NULL, then the function returns FPGA_OK if
  * pre-allocated buffers are supported. In this case, a return value other
  * than FPGA_OK indicates that pre-allocated buffers are not supported.
+ *
+ * @note A buffer served from the pool of a handle opened with
+ * FPGA_OPEN_BUFFER_POOL is not cleared; it holds whatever its previous
+ * user left in it.
  */
 fpga_result fpgaPrepareBuffer(fpga_handle handle,
 			      uint64_t len,
@@ -136,6 +136,29 @@ class handle {
    */
   void write_csr512(uint64_t offset, const void *value, uint32_t csr_space = 0);
 
+  /**
+   * @brief Read a batch of CSRs belonging to a resource associated
+   * with a handle.
+   *
+   * @param[inout] vec The batch entries. The value field of each
+   * entry receives the value read.
+   * @param[in] csr_space The CSR space to read from. Default is 0.
+   *
+   */
+  void read_csrs(std::vector<fpga_mmio_vec> &vec,
+                 uint32_t csr_space = 0) const;
+
+  /**
+   * @brief Write a batch of CSRs belonging to a resource associated
+   * with a handle.
+   *
+   * @param[in] vec The batch entries.
+   * @param[in] csr_space The CSR space to write to. Default is 0.
+   *
+   */
+  void write_csrs(const std::vector<fpga_mmio_vec> &vec,
+                  uint32_t csr_space = 0);
+
   /** Retrieve a pointer to the MMIO region.
    * @param[in] offset The byte offset to add to MMIO base.
    * @param[in] csr_space The desired CSR space. Default is 0.
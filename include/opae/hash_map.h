@@ -26,12 +26,17 @@
 
 /**
  * @file opae/hash_map.h
- * @brief A general-purpose hybrid array/list hash map implementation.
+ * @brief A general-purpose open-addressing hash map implementation.
  *
  * Presents a generic interface for mapping key objects to value objects.
  * Both keys and values may be arbitrary data structures. The user supplies
  * the means by which the hash of values is generated and by which the
  * keys are compared to each other.
+ *
+ * Key/value pairs are stored inline in a slot array using Robin Hood
+ * linear probing, so no memory is allocated per item. The slot array has
+ * a prime number of entries and roughly doubles in size whenever it
+ * becomes more than 3/4 full.
  */
 
 #ifndef __OPAE_HASH_MAP_H__
@@ -53,7 +58,7 @@ extern "C" {
  * return a result saying that the keys are equal in value. This is helpful
  * in situations where the key space is guaranteed to produce unique values,
  * for example a memory allocator. When the key space is guaranteed to be
- * unique, opae_hash_map_add() can implement a small performance improvement.
+ * unique, opae_hash_map_add() skips the key comparisons during insertion.
  */
 typedef enum _opae_hash_map_flags {
 	OPAE_HASH_MAP_UNIQUE_KEYSPACE = (1u << 0)
@@ -62,10 +67,8 @@ typedef enum _opae_hash_map_flags {
 /**
  * List link item.
  *
- * This structure provides the association between key and value.
- * When the supplied hash function for keys A and B returns the same
- * bucket index, both A and B can co-exist on the same list rooted
- * at the bucket index.
+ * Retained for source compatibility. The hash map no longer chains
+ * items; see opae_hash_map_slot.
  */
 typedef struct _opae_hash_map_item {
 	void *key;
@@ -73,6 +76,19 @@ typedef struct _opae_hash_map_item {
 	struct _opae_hash_map_item *next;
 } opae_hash_map_item;
 
+/**
+ * Slot array entry.
+ *
+ * This structure provides the association between key and value.
+ * hash caches the home slot index of key, with the most significant
+ * bit set to mark the slot as occupied. An empty slot has a hash of 0.
+ */
+typedef struct _opae_hash_map_slot {
+	void *key;
+	void *value;
+	uint32_t hash;
+} opae_hash_map_slot;
+
 /**
  * Hash map object.
  *
@@ -82,9 +98,9 @@ typedef struct _opae_hash_map_item {
  * which may optionally be NULL.
  */
 typedef struct _opae_hash_map {
-	uint32_t num_buckets;
+	uint32_t num_buckets;	   ///< Size of the slot array (a prime)
 	uint32_t hash_seed;
-	opae_hash_map_item **buckets;
+	opae_hash_map_slot *slots;
 	int flags;
 	void *cleanup_context; ///< Optional second parameter to key_cleanup and value_cleanup
 	uint32_t (*key_hash)(uint32_t num_buckets,	   ///< (required)
@@ -93,19 +109,19 @@ typedef struct _opae_hash_map {
 	int (*key_compare)(void *keya, void *keyb);	   ///< (required)
 	void (*key_cleanup)(void *key, void *context);	   ///< (optional)
 	void (*value_cleanup)(void *value, void *context); ///< (optional)
+	uint32_t num_items;	   ///< Number of occupied slots
 } opae_hash_map;
 
 /**
  * Initialize a hash map
  *
- * Populates the hash map data structure and allocates the buckets
+ * Populates the hash map data structure and allocates the slot
  * array.
  *
  * @param[out] hm            A pointer to the storage for the hash map object.
- * @param[in]  num_buckets   The desired size of the buckets array. Each array
- *                           entry may be empty (NULL), or may contain a list
- *                           of opae_hash_map_item structures for which the given
- *                           key_hash function returned the same key hash value.
+ * @param[in]  num_buckets   The initial size of the slot array. The value is
+ *                           rounded up to a prime. The array grows as
+ *                           needed, so this is only a sizing hint.
  * @param[in]  hash_seed     A seed value used during key hash computation. This
  *                           value will be the hash_seed parameter to the key hash
  *                           function.
@@ -113,6 +129,8 @@ typedef struct _opae_hash_map {
  * @param[in]  key_hash      A pointer to a function that produces the hash value,
  *                           given the number of buckets, the hash seed, and the key.
  *                           Valid values are between 0 and num_buckets - 1, inclusively.
+ *                           The function is called again for each key when the slot
+ *                           array grows.
  * @param[in]  key_compare   A pointer to a function that compares two keys. The return
  *                           value is similar to that of strcmp(), where a negative value
  *                           means that keya < keyb, 0 means that keya == keyb, and a positive
@@ -126,7 +144,7 @@ typedef struct _opae_hash_map {
  *                           be NULL. When supplied, the function is responsible for freeing
  *                           any resources allocated when the value was created.
  * @returns FPGA_OK on success, FPGA_INVALID_PARAM if any of the required parameters are
- *          NULL, or FPGA_NO_MEMORY if the bucket array could not be allocated.
+ *          NULL, or FPGA_NO_MEMORY if the slot array could not be allocated.
  */
 fpga_result opae_hash_map_init(opae_hash_map *hm,
 			       uint32_t num_buckets,
@@ -149,9 +167,9 @@ fpga_result opae_hash_map_init(opae_hash_map *hm,
  * @param[in, out] hm    A pointer to the storage for the hash map object.
  * @param[in]      key   The hash map key.
  * @param[in]      value The hash map value.
- * @returns FPGA_OK on success, FPGA_INVALID_PARAM if hm is NULL, FPGA_NO_MEMORY
- *          if malloc() fails when allocating the list item, or FPGA_INVALID_PARAM
- *          if the key hash produced by key_hash is out of bounds.
+ * @returns FPGA_OK on success, FPGA_INVALID_PARAM if hm is NULL or if the
+ *          key hash produced by key_hash is out of bounds, or FPGA_NO_MEMORY
+ *          if the slot array could not be grown.
  */
 fpga_result opae_hash_map_add(opae_hash_map *hm,
 			      void *key,
@@ -193,7 +211,7 @@ fpga_result opae_hash_map_remove(opae_hash_map *hm,
  * Tear down a hash map
  *
  * Given a hash map that was previously initialized by opae_hash_map_init(),
- * destroy the hash map, releasing all keys, values, and the bucket array.
+ * destroy the hash map, releasing all keys, values, and the slot array.
  *
  * @param[in, out] hm A pointer to the storage for the hash map object.
  * @returns FPGA_OK on success or FPGA_INVALID_PARAM is hm is NULL.
@@ -214,7 +232,8 @@ bool opae_hash_map_is_empty(opae_hash_map *hm);
  *
  * Simply converts the key to a uint64_t and then performs the
  * modulus operation with the configured num_buckets. hash_seed is
- * unused.
+ * unused. Because the slot array has a prime number of entries,
+ * page- and hugepage-aligned addresses still spread across all of it.
  */
 uint32_t opae_u64_key_hash(uint32_t num_buckets,
 			   uint32_t hash_seed,
@@ -44,8 +44,15 @@ extern "C" {
  * Initialize OPAE using the given configuration file path, or
  * perform default initialization if config_file is NULL.
  *
+ * Each loaded plugin's initialization routine has run by the time
+ * fpgaInitialize returns. When the library initializes itself
+ * implicitly (OPAE_EXPLICIT_INITIALIZE is not set), those routines
+ * are instead deferred to the first enumeration, and a plugin that
+ * fails to initialize is only logged.
+ *
  * @param[in]  config_file   Path to OPAE configuration file.
- * @returns        Whether OPAE initialized successfully.
+ * @returns        Whether OPAE initialized successfully. FPGA_EXCEPTION
+ *                 if any plugin's initialization routine failed.
  */
 fpga_result fpgaInitialize(const char *config_file);
 
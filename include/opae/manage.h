@@ -140,6 +140,90 @@ fpga_result fpgaReconfigureSlot(fpga_handle fpga,
 				const uint8_t *bitstream,
 				size_t bitstream_len, int flags);
 
+/**
+ * Reconfigure a slot asynchronously
+ *
+ * Starts the same reconfiguration flow as fpgaReconfigureSlot() on a worker
+ * thread and returns immediately. The returned operation object reports the
+ * current phase and the number of bitstream bytes handed to the driver, and
+ * yields the final result once the reconfiguration has completed.
+ *
+ * The handle `fpga` must remain open and the memory holding `bitstream` must
+ * remain valid until the operation has completed. Other calls on `fpga` that
+ * require the handle lock block while the reconfiguration is in progress.
+ *
+ * @param[in]  fpga           Handle to an FPGA object previously opened
+ * @param[in]  slot           Token identifying the slot to reconfigure
+ * @param[in]  bitstream      Pointer to memory holding the bitstream
+ * @param[in]  bitstream_len  Length of the bitstream in bytes
+ * @param[in]  flags          Flags that control behavior of reconfiguration,
+ *                            as for fpgaReconfigureSlot().
+ * @param[in]  progress       Optional callback invoked on the worker thread
+ *                            as the reconfiguration enters each phase. May be
+ *                            NULL. Plugins that do not track progress report
+ *                            only the PROGRAM and DONE phases, with byte
+ *                            counts of 0.
+ * @param[in]  context        Opaque pointer passed to `progress`.
+ * @param[out] op             Receives the operation object on success.
+ * @returns FPGA_OK if the operation was started. FPGA_INVALID_PARAM if any
+ * of the parameters are not valid. FPGA_NOT_SUPPORTED if the plugin owning
+ * `fpga` does not implement reconfiguration. FPGA_NO_MEMORY or
+ * FPGA_EXCEPTION if the operation could not be started. Errors of the
+ * reconfiguration itself are reported through fpgaReconfigurePoll() and
+ * fpgaReconfigureWait().
+ */
+fpga_result fpgaReconfigureSlotAsync(fpga_handle fpga,
+				     uint32_t slot,
+				     const uint8_t *bitstream,
+				     size_t bitstream_len,
+				     int flags,
+				     fpga_reconf_progress_cb progress,
+				     void *context,
+				     fpga_reconf_op *op);
+
+/**
+ * Query the state of an asynchronous reconfiguration
+ *
+ * @param[in]  op             Operation returned by fpgaReconfigureSlotAsync()
+ * @param[out] phase          Optional, receives the current phase.
+ * @param[out] bytes_written  Optional, receives the number of payload bytes
+ *                            handed to the driver so far.
+ * @param[out] result         Optional, receives the result of the
+ *                            reconfiguration once it has completed.
+ * @returns FPGA_OK if the reconfiguration has completed. FPGA_BUSY if it is
+ * still in progress. FPGA_INVALID_PARAM if `op` is NULL.
+ */
+fpga_result fpgaReconfigurePoll(fpga_reconf_op op,
+				enum fpga_reconf_phase *phase,
+				size_t *bytes_written,
+				fpga_result *result);
+
+/**
+ * Wait for an asynchronous reconfiguration to complete
+ *
+ * @param[in]  op             Operation returned by fpgaReconfigureSlotAsync()
+ * @param[in]  timeout_ms     Maximum time to wait in milliseconds. 0 polls,
+ *                            a negative value waits indefinitely.
+ * @param[out] result         Optional, receives the result of the
+ *                            reconfiguration once it has completed.
+ * @returns FPGA_OK if the reconfiguration has completed. FPGA_BUSY if the
+ * timeout expired first. FPGA_INVALID_PARAM if `op` is NULL.
+ */
+fpga_result fpgaReconfigureWait(fpga_reconf_op op,
+				int timeout_ms,
+				fpga_result *result);
+
+/**
+ * Release an asynchronous reconfiguration
+ *
+ * Waits for the reconfiguration to complete, if necessary, then frees the
+ * operation object and sets *op to NULL.
+ *
+ * @param[in,out] op          Pointer to the operation to destroy
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if `op` or *op is NULL.
+ */
+fpga_result fpgaReconfigureDestroy(fpga_reconf_op *op);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
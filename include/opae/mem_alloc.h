@@ -36,20 +36,51 @@
 * ie released back to the available pool of logical address space for future
 * allocations. The memory backing the allocator's internal data structures
 * is managed by malloc()/free().
+*
+* Free blocks are kept in an address-ordered list and, alongside it, in an
+* AVL tree keyed by address whose nodes also track the largest free block
+* in their subtree. Allocated blocks are kept in a hash map keyed by
+* address. Allocation (first fit, lowest address), free, and coalescing are
+* therefore O(log n) in the number of blocks.
 */
 
 #include <stdint.h>
+#include <opae/hash_map.h>
 
 struct mem_link {
 	uint64_t address;
 	uint64_t size;
 	struct mem_link *prev;
 	struct mem_link *next;
+	struct mem_link *left;  /**< AVL tree links */
+	struct mem_link *right;
+	uint64_t max_size;      /**< Largest size in this subtree */
+	int height;             /**< Height of this subtree */
 };
 
 struct mem_alloc {
 	struct mem_link free;
 	struct mem_link allocated;
+	struct mem_link *free_tree;      /**< Free blocks, by address */
+	opae_hash_map allocated_map;     /**< Allocated blocks, by address */
+	uint64_t free_bytes;
+	uint64_t free_blocks;
+	uint64_t allocated_bytes;
+	uint64_t allocated_blocks;
+};
+
+/**
+ * Allocator fragmentation statistics
+ *
+ * Reported by mem_alloc_get_stats(). The free space is considered
+ * unfragmented when largest_free equals free_bytes.
+ */
+struct mem_alloc_stats {
+	uint64_t free_bytes;       /**< Total bytes available */
+	uint64_t free_blocks;      /**< Number of discontiguous free blocks */
+	uint64_t largest_free;     /**< Size of the largest free block */
+	uint64_t allocated_bytes;  /**< Total bytes allocated */
+	uint64_t allocated_blocks; /**< Number of live allocations */
 };
 
 #ifdef __cplusplus
@@ -134,6 +165,25 @@ int mem_alloc_get(struct mem_alloc *m,
 		  uint64_t *address,
 		  uint64_t size);
 
+/** Allocate memory with an explicit alignment
+ *
+ * Like mem_alloc_get(), but the retrieved address is aligned to
+ * alignment rather than to size. This allows, for example, a 6MB
+ * request to be placed on a 2MB boundary so that it can be mapped
+ * with large IOMMU pages.
+ *
+ * @param[in, out] m         The memory allocator object.
+ * @param[out]     address   The retrieved address for the allocation.
+ * @param[in]      size      The request size in bytes.
+ * @param[in]      alignment The required alignment in bytes. Must be
+ *                           zero (no constraint) or a power of 2.
+ * @returns Non-zero on error. Zero on success.
+ */
+int mem_alloc_get_aligned(struct mem_alloc *m,
+			  uint64_t *address,
+			  uint64_t size,
+			  uint64_t alignment);
+
 /** Free memory
  *
  * Release a previously-allocated memory block.
@@ -169,6 +219,14 @@ int mem_alloc_get(struct mem_alloc *m,
 int mem_alloc_put(struct mem_alloc *m,
 		  uint64_t address);
 
+/** Retrieve fragmentation statistics
+ *
+ * @param[in]  m     The memory allocator object.
+ * @param[out] stats Receives the current statistics.
+ */
+void mem_alloc_get_stats(struct mem_alloc *m,
+			 struct mem_alloc_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
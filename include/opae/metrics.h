@@ -111,6 +111,30 @@ fpga_result fpgaGetMetricsByName(fpga_handle handle,
 				uint64_t num_metric_names,
 				fpga_metric *metrics);
 
+/**
+ * Retrieve the values of all metrics in one pass
+ *
+ * Reads every enumerated metric, in fpgaGetMetricsInfo() order,
+ * and stamps the sample with the CLOCK_MONOTONIC time at which
+ * the pass began. metrics[i].isvalid is false for any metric that
+ * could not be read.
+ *
+ * @param[in] handle Handle to previously opened fpga resource
+ * @param[out] metrics Pointer to array of metric struct, allocated
+ * by the caller. Pass NULL to query the number of metrics.
+ * @param[inout] num_metrics On input, size of the metrics array.
+ * On output, number of entries written (or available, if metrics
+ * is NULL).
+ * @param[out] timestamp_ns Sample time in nanoseconds. May be NULL.
+ *
+ * @returns FPGA_OK on success. FPGA_NOT_FOUND if no metric could
+ * be read. FPGA_NOT_SUPPORTED if the plugin has no snapshot support.
+ *
+ */
+fpga_result fpgaGetMetricsSnapshot(fpga_handle handle,
+				fpga_metric *metrics,
+				uint64_t *num_metrics,
+				uint64_t *timestamp_ns);
 
 /**
  * Retrieve metrics / sendor threshold information and values
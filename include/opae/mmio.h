@@ -138,6 +138,57 @@ fpga_result fpgaWriteMMIO512(fpga_handle handle,
 			    uint32_t mmio_num, uint64_t offset,
 			    const void *value);
 
+/**
+ * Read a batch of values from MMIO space
+ *
+ * This function performs a sequence of 32 or 64 bit reads from MMIO space of
+ * the target object, in array order. The handle is validated and the MMIO
+ * space is resolved once for the whole batch, which makes this cheaper than
+ * issuing the equivalent sequence of fpgaReadMMIO32()/fpgaReadMMIO64() calls.
+ *
+ * All entries are checked before any register is accessed. An entry whose
+ * flags include FPGA_MMIO_FENCE is not issued until all prior accesses in
+ * the batch have completed.
+ *
+ * @param[in]    handle   Handle to previously opened accelerator resource
+ * @param[in]    mmio_num Number of MMIO space to access
+ * @param[inout] vec      Array of batch entries. The offset, width and
+ *                        flags fields are inputs. The value field receives
+ *                        the value read.
+ * @param[in]    count    Number of entries in vec
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters, or any entry of vec, is invalid. FPGA_EXCEPTION if an internal
+ * exception occurred while trying to access the handle.
+ */
+fpga_result fpgaReadMMIOv(fpga_handle handle,
+			  uint32_t mmio_num, fpga_mmio_vec *vec,
+			  uint32_t count);
+
+/**
+ * Write a batch of values to MMIO space
+ *
+ * This function performs a sequence of 32 or 64 bit writes to MMIO space of
+ * the target object, in array order. The handle is validated and the MMIO
+ * space is resolved once for the whole batch, which makes this cheaper than
+ * issuing the equivalent sequence of fpgaWriteMMIO32()/fpgaWriteMMIO64()
+ * calls.
+ *
+ * All entries are checked before any register is accessed. An entry whose
+ * flags include FPGA_MMIO_FENCE is not issued until all prior writes in
+ * the batch have completed.
+ *
+ * @param[in]  handle   Handle to previously opened accelerator resource
+ * @param[in]  mmio_num Number of MMIO space to access
+ * @param[in]  vec      Array of batch entries
+ * @param[in]  count    Number of entries in vec
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters, or any entry of vec, is invalid. FPGA_EXCEPTION if an internal
+ * exception occurred while trying to access the handle.
+ */
+fpga_result fpgaWriteMMIOv(fpga_handle handle,
+			   uint32_t mmio_num, const fpga_mmio_vec *vec,
+			   uint32_t count);
+
 /**
  * Map MMIO space
  *
@@ -188,6 +239,13 @@ fpga_result fpgaMapMMIO(fpga_handle handle,
  * This function will unmap a previously mapped MMIO space of the target object,
  * rendering any pointers to it invalid.
  *
+ * fpgaReadMMIO32(), fpgaWriteMMIO32(), fpgaReadMMIO64(), fpgaWriteMMIO64()
+ * and their batched variants may run concurrently with this call on other
+ * threads: accesses already in progress are allowed to complete before the
+ * space is unmapped, and later accesses map it again on demand. Pointers
+ * returned by fpgaMapMMIO() are not tracked; the application must stop using
+ * them before calling fpgaUnmapMMIO().
+ *
  * @note This call is only supported by hardware targets, not by ASE
  *       simulation.
  *
@@ -194,6 +194,9 @@ fpga_result fpgaObjectGetSize(fpga_object obj, uint32_t *value, int flags);
  * @param[in] flags Flags that control how object is read
  * If FPGA_OBJECT_SYNC is used then object will update its buffered copy before
  * retrieving the data.
+ * If FPGA_OBJECT_RAW is used then only the requested window is read directly
+ * from the underlying attribute, bypassing the buffered copy. This is the
+ * preferred way to access large binary attributes.
  *
  * @return FPGA_OK on success, FPGA_INVALID_PARAM if any of the supplied
  * parameters is invalid
@@ -159,6 +159,26 @@ typedef struct {
  */
 typedef void *fpga_event_handle;
 
+/** Handle to an asynchronous reconfiguration
+ *
+ * Returned by fpgaReconfigureSlotAsync(). The operation can be polled with
+ * fpgaReconfigurePoll() or waited upon with fpgaReconfigureWait(), and must
+ * be released with fpgaReconfigureDestroy().
+ */
+typedef void *fpga_reconf_op;
+
+/** Reconfiguration progress callback
+ *
+ * Called from the worker thread of an fpgaReconfigureSlotAsync() operation
+ * each time it enters a new phase. `bytes_total` is the size of the
+ * bitstream payload (without the GBS header) and is 0 until the bitstream
+ * has been validated. The callback must not destroy the operation.
+ */
+typedef void (*fpga_reconf_progress_cb)(enum fpga_reconf_phase phase,
+					size_t bytes_written,
+					size_t bytes_total,
+					void *context);
+
 /** Information about an error register
  *
  * This data structure captures information about an error register exposed by
@@ -252,6 +272,18 @@ typedef struct metric_threshold {
 	threshold hysteresis;                          // Hysteresis
 } metric_threshold;
 
+/** MMIO batch entry
+ *
+ * Describes one register access within a batch submitted to
+ * fpgaReadMMIOv() or fpgaWriteMMIOv().
+ */
+typedef struct fpga_mmio_vec {
+	uint64_t offset;   // Byte offset into MMIO space
+	uint64_t value;    // Value to write, or value read
+	uint32_t width;    // Access width in bits (32 or 64)
+	uint32_t flags;    // Bitwise OR of enum fpga_mmio_vec_flags
+} fpga_mmio_vec;
+
 /** Internal token type header
  *
  * Each plugin (dfl: libxfpga.so, vfio: libopae-v.so) implements its own
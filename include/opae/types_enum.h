@@ -142,7 +142,8 @@ typedef enum {
 enum fpga_buffer_flags {
 	FPGA_BUF_PREALLOCATED = (1u << 0), /**< Use existing buffer */
 	FPGA_BUF_QUIET = (1u << 1),        /**< Suppress error messages */
-	FPGA_BUF_READ_ONLY = (1u << 2)     /**< Buffer is read-only */
+	FPGA_BUF_READ_ONLY = (1u << 2),    /**< Buffer is read-only */
+	FPGA_BUF_NO_POOL = (1u << 3)       /**< Bypass the handle buffer pool */
 };
 
 /**
@@ -152,7 +153,9 @@ enum fpga_buffer_flags {
  */
 enum fpga_open_flags {
 	/** Open FPGA resource for shared access */
-	FPGA_OPEN_SHARED = (1u << 0)
+	FPGA_OPEN_SHARED = (1u << 0),
+	/** Recycle released DMA buffers through a per-handle pool */
+	FPGA_OPEN_BUFFER_POOL = (1u << 1)
 };
 
 /**
@@ -167,6 +170,25 @@ enum fpga_reconf_flags {
 	FPGA_RECONF_SKIP_USRCLK = (1u << 1)
 };
 
+/**
+ * Reconfiguration phases
+ *
+ * Reported to the progress callback of fpgaReconfigureSlotAsync() and
+ * returned by fpgaReconfigurePoll().
+ */
+enum fpga_reconf_phase {
+	/** Checking the bitstream header and slot usage */
+	FPGA_RECONF_PHASE_VALIDATE = 0,
+	/** Clearing port errors */
+	FPGA_RECONF_PHASE_CLEAR_ERRORS,
+	/** Programming the AFU user clocks from the GBS metadata */
+	FPGA_RECONF_PHASE_USRCLK,
+	/** Sending the bitstream payload to the driver */
+	FPGA_RECONF_PHASE_PROGRAM,
+	/** Reconfiguration finished, successfully or not */
+	FPGA_RECONF_PHASE_DONE
+};
+
 enum fpga_sysobject_flags {
 	FPGA_OBJECT_SYNC = (1u << 0), /**< Synchronize data from driver */
 	FPGA_OBJECT_GLOB = (1u << 1), /**< Treat names as glob expressions */
@@ -188,6 +210,15 @@ enum fpga_sysobject_type {
 			       read/written */
 };
 
+/** MMIO batch entry flags
+ *
+ * Flags for the entries of fpgaReadMMIOv() and fpgaWriteMMIOv().
+ */
+enum fpga_mmio_vec_flags {
+	FPGA_MMIO_FENCE = (1u << 0) /**< Complete all prior accesses in the
+					 batch before this entry */
+};
+
 /** fpga metrics types
 * opae defines power,thermal, performance counter
 * and afu metric types
@@ -137,6 +137,7 @@ struct opae_vfio_buffer {
 	size_t buffer_size;		/**< Buffer size. */
 	uint64_t buffer_iova;		/**< Buffer IOVA address. */
 	int flags;			/**< See opae_vfio_buffer_flags. */
+	size_t requested_size;		/**< Size originally requested. */
 };
 
 /**
@@ -156,6 +157,8 @@ struct opae_vfio {
 	struct opae_vfio_group group;			/**< The VFIO device group. */
 	struct opae_vfio_device device;			/**< The VFIO device. */
 	opae_hash_map cont_buffers;		/**< Map of allocated DMA buffers. */
+	size_t buf_requested;			/**< Bytes requested for cont_buffers. */
+	size_t buf_pinned;			/**< Bytes pinned for cont_buffers. */
 };
 
 #ifdef __cplusplus
@@ -339,6 +342,7 @@ int opae_vfio_buffer_allocate(struct opae_vfio *v,
  */
 enum opae_vfio_buffer_flags {
 	OPAE_VFIO_BUF_PREALLOCATED = 1, /**< Use existing buffer */
+	OPAE_VFIO_BUF_HUGE_MIX = 2,     /**< Back with a mix of 1G/2M pages */
 };
 
 /**
@@ -356,6 +360,13 @@ enum opae_vfio_buffer_flags {
  * greater than 4096, then the request is fulfilled by a 2MB huge
  * page. Else, the request is fulfilled by the non-huge page pool.
  *
+ * With OPAE_VFIO_BUF_HUGE_MIX, a request larger than 4096 bytes is
+ * instead fulfilled by whole 1GB pages for its bulk and by 2MB pages
+ * for the remainder, so that no more than 2MB of huge page memory is
+ * pinned beyond the request. The pages are mapped virtually and IOVA
+ * contiguous. When no 1GB pages are available, 2MB pages are used
+ * throughout.
+ *
  * @param[in, out] v    The open OPAE VFIO device.
  * @param[in, out] size A pointer to the requested size. The size
  *                      may be rounded to the next page size prior
@@ -447,6 +458,25 @@ struct opae_vfio_buffer *opae_vfio_buffer_info(struct opae_vfio *v,
 int opae_vfio_buffer_free(struct opae_vfio *v,
 			  uint8_t *buf);
 
+/**
+ * Report DMA buffer memory usage
+ *
+ * Retrieves the total number of bytes requested for the buffers
+ * currently allocated by opae_vfio_buffer_allocate() and
+ * opae_vfio_buffer_allocate_ex(), and the number of bytes actually
+ * mapped for them after rounding to page sizes.
+ *
+ * @param[in]  v         The open OPAE VFIO device.
+ * @param[out] requested Optional pointer to receive the requested
+ *                       byte count. Pass NULL to ignore.
+ * @param[out] pinned    Optional pointer to receive the pinned
+ *                       byte count. Pass NULL to ignore.
+ * @returns Non-zero on error. Zero on success.
+ */
+int opae_vfio_buffer_stats(struct opae_vfio *v,
+			   size_t *requested,
+			   size_t *pinned);
+
 /**
  * Enable an IRQ
  *
@@ -30,8 +30,11 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include <uuid/uuid.h>
@@ -110,6 +113,52 @@ out_close:
 	return res;
 }
 
+/*
+ * Map the file read-only instead of copying it. Only the pages that are
+ * touched get read from disk: the header and metadata while resolving,
+ * then the RBF as the PR driver consumes it.
+ */
+STATIC fpga_result opae_bitstream_map_file(const char *file,
+					   uint8_t **buf,
+					   size_t *len)
+{
+	struct stat st;
+	void *addr;
+	int fd;
+
+	fd = opae_open(file, O_RDONLY);
+	if (fd < 0) {
+		OPAE_ERR("open failed");
+		return FPGA_EXCEPTION;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		OPAE_ERR("fstat failed");
+		opae_close(fd);
+		return FPGA_EXCEPTION;
+	}
+
+	if (!S_ISREG(st.st_mode) || !st.st_size) {
+		opae_close(fd);
+		return FPGA_NOT_SUPPORTED;
+	}
+
+	addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	opae_close(fd);
+
+	if (addr == MAP_FAILED) {
+		OPAE_DBG("mmap failed: %s", strerror(errno));
+		return FPGA_NOT_SUPPORTED;
+	}
+
+	madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	*buf = (uint8_t *)addr;
+	*len = (size_t)st.st_size;
+
+	return FPGA_OK;
+}
+
 bool opae_is_legacy_bitstream(opae_bitstream_info *info)
 {
 	opae_legacy_bitstream_header *hdr;
@@ -141,32 +190,53 @@ STATIC void opae_resolve_legacy_bitstream(opae_bitstream_info *info)
 	info->rbf_len = info->data_len - sizeof(opae_legacy_bitstream_header);
 }
 
-STATIC void *opae_bitstream_parse_metadata(const char *metadata,
-					   fpga_guid pr_interface_id,
-					   int *version)
+STATIC json_object *opae_bitstream_tokenize_metadata(const char *metadata,
+						     size_t len)
 {
-	json_object *root = NULL;
-	json_object *j_version = NULL;
-	enum json_tokener_error j_err = json_tokener_success;
-	void *parsed = NULL;
+	json_tokener *tok;
+	json_object *root;
+	enum json_tokener_error j_err;
+
+	tok = json_tokener_new();
+	if (!tok) {
+		OPAE_ERR("json_tokener_new failed");
+		return NULL;
+	}
+
+	// Parse in place; the metadata need not be NUL-terminated.
+	root = json_tokener_parse_ex(tok, metadata, (int)len);
+	j_err = json_tokener_get_error(tok);
 
-	root = json_tokener_parse_verbose(metadata, &j_err);
-	if (!root) {
+	if (!root || j_err != json_tokener_success) {
+		if (j_err == json_tokener_continue)
+			j_err = json_tokener_error_parse_eof;
 		OPAE_ERR("invalid JSON metadata: %s",
 			 json_tokener_error_desc(j_err));
-		return NULL;
+		if (root)
+			json_object_put(root);
+		root = NULL;
 	}
 
+	json_tokener_free(tok);
+
+	return root;
+}
+
+STATIC fpga_result opae_bitstream_metadata_version(json_object *root,
+						   int *version)
+{
+	json_object *j_version = NULL;
+
 	if (!json_object_object_get_ex(root,
 				       "version",
 				       &j_version)) {
 		OPAE_ERR("metadata: failed to find \"version\" key");
-		goto out_put;
+		return FPGA_EXCEPTION;
 	}
 
 	if (!json_object_is_type(j_version, json_type_int)) {
 		OPAE_ERR("metadata: \"version\" key not integer");
-		goto out_put;
+		return FPGA_EXCEPTION;
 	}
 
 	*version = json_object_get_int(j_version);
@@ -181,20 +251,98 @@ STATIC void *opae_bitstream_parse_metadata(const char *metadata,
 	case 640:
 		*version = 1; /* FALLTHROUGH */
 	case 1:
-		parsed = opae_bitstream_parse_metadata_v1(root,
-							  pr_interface_id);
-	break;
+		return FPGA_OK;
 
 	default:
 		OPAE_ERR("metadata: unsupported version: %d", *version);
 	}
 
-out_put:
+	return FPGA_EXCEPTION;
+}
+
+STATIC void *opae_bitstream_parse_metadata(const char *metadata,
+					   size_t len,
+					   fpga_guid pr_interface_id,
+					   int *version)
+{
+	json_object *root;
+	void *parsed = NULL;
+
+	root = opae_bitstream_tokenize_metadata(metadata, len);
+	if (!root)
+		return NULL;
+
+	if (opae_bitstream_metadata_version(root, version) == FPGA_OK)
+		parsed = opae_bitstream_parse_metadata_v1(root,
+							  pr_interface_id);
+
 	json_object_put(root);
 
 	return parsed;
 }
 
+/*
+ * Extract only what opae_load_bitstream() callers need up front:
+ * the metadata version and the PR interface ID. The full metadata
+ * structure is built later, on request.
+ */
+STATIC fpga_result opae_bitstream_peek_metadata(const char *metadata,
+						size_t len,
+						fpga_guid pr_interface_id,
+						int *version)
+{
+	json_object *root;
+	json_object *j_afu_image = NULL;
+	json_object *j_field = NULL;
+	fpga_result res;
+
+	root = opae_bitstream_tokenize_metadata(metadata, len);
+	if (!root)
+		return FPGA_EXCEPTION;
+
+	res = opae_bitstream_metadata_version(root, version);
+	if (res != FPGA_OK)
+		goto out_put;
+
+	res = FPGA_EXCEPTION;
+
+	if (!json_object_object_get_ex(root,
+				       "afu-image",
+				       &j_afu_image)) {
+		OPAE_ERR("metadata: failed to find \"afu-image\" key");
+		goto out_put;
+	}
+
+	if (!json_object_object_get_ex(j_afu_image,
+				       "magic-no",
+				       &j_field) ||
+	    !json_object_is_type(j_field, json_type_int) ||
+	    json_object_get_int(j_field) != OPAE_LEGACY_BITSTREAM_MAGIC) {
+		OPAE_ERR("metadata: missing or invalid GBS magic");
+		goto out_put;
+	}
+
+	if (!json_object_object_get_ex(j_afu_image,
+				       "interface-uuid",
+				       &j_field) ||
+	    !json_object_is_type(j_field, json_type_string)) {
+		OPAE_ERR("metadata: failed to find \"interface-uuid\" key");
+		goto out_put;
+	}
+
+	if (uuid_parse(json_object_get_string(j_field), pr_interface_id)) {
+		OPAE_ERR("metadata: uuid_parse failed");
+		goto out_put;
+	}
+
+	res = FPGA_OK;
+
+out_put:
+	json_object_put(root);
+
+	return res;
+}
+
 STATIC fpga_guid valid_GBS_guid = {
 0x58, 0x65, 0x6f, 0x6e,
 0x46, 0x50,
@@ -206,7 +354,6 @@ STATIC fpga_result opae_resolve_bitstream(opae_bitstream_info *info)
 {
 	opae_bitstream_header *hdr;
 	size_t sz;
-	char *buf;
 
 	if (info->data_len < sizeof(opae_bitstream_header)) {
 		OPAE_ERR("file length smaller than bitstream header: "
@@ -235,23 +382,10 @@ STATIC fpga_result opae_resolve_bitstream(opae_bitstream_info *info)
 	info->rbf_data = info->data + sz;
 	info->rbf_len = info->data_len - sz;
 
-	buf = (char *)opae_malloc(hdr->metadata_length + 1);
-	if (!buf) {
-		OPAE_ERR("malloc failed");
-		return FPGA_NO_MEMORY;
-	}
-
-	memcpy(buf, hdr->metadata, hdr->metadata_length);
-	buf[hdr->metadata_length] = '\0';
-
-	info->parsed_metadata =
-		opae_bitstream_parse_metadata(buf,
-					      info->pr_interface_id,
-					      &info->metadata_version);
-
-	opae_free(buf);
-
-	return info->parsed_metadata ? FPGA_OK : FPGA_EXCEPTION;
+	return opae_bitstream_peek_metadata(hdr->metadata,
+					    hdr->metadata_length,
+					    info->pr_interface_id,
+					    &info->metadata_version);
 }
 
 fpga_result opae_load_bitstream(const char *file, opae_bitstream_info *info)
@@ -269,7 +403,16 @@ fpga_result opae_load_bitstream(const char *file, opae_bitstream_info *info)
 
 	memset(info, 0, sizeof(opae_bitstream_info));
 
-	res = opae_bitstream_read_file(file, &info->data, &info->data_len);
+	res = opae_bitstream_map_file(file, &info->data, &info->data_len);
+	if (res == FPGA_OK) {
+		info->data_mapped = true;
+	} else if (res == FPGA_NOT_SUPPORTED) {
+		// Empty files and file systems without mmap support.
+		res = opae_bitstream_read_file(file,
+					       &info->data,
+					       &info->data_len);
+	}
+
 	if (res != FPGA_OK) {
 		OPAE_ERR("error loading \"%s\"", file);
 		return res;
@@ -288,6 +431,60 @@ fpga_result opae_load_bitstream(const char *file, opae_bitstream_info *info)
 	return opae_resolve_bitstream(info);
 }
 
+void *opae_bitstream_get_metadata(opae_bitstream_info *info)
+{
+	opae_bitstream_header *hdr;
+
+	if (!info || !info->data)
+		return NULL;
+
+	if (info->parsed_metadata)
+		return info->parsed_metadata;
+
+	// Legacy bitstreams carry no metadata.
+	if (!info->metadata_version)
+		return NULL;
+
+	// opae_resolve_bitstream() has already validated the header.
+	hdr = (opae_bitstream_header *)info->data;
+
+	info->parsed_metadata =
+		opae_bitstream_parse_metadata(hdr->metadata,
+					      hdr->metadata_length,
+					      info->pr_interface_id,
+					      &info->metadata_version);
+
+	return info->parsed_metadata;
+}
+
+fpga_result opae_bitstream_copy_data(opae_bitstream_info *info)
+{
+	uint8_t *data;
+
+	if (!info)
+		return FPGA_INVALID_PARAM;
+
+	if (!info->data_mapped)
+		return FPGA_OK;
+
+	data = (uint8_t *)opae_malloc(info->data_len);
+	if (!data) {
+		OPAE_ERR("malloc failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	memcpy(data, info->data, info->data_len);
+
+	if (info->rbf_data)
+		info->rbf_data = data + (info->rbf_data - info->data);
+
+	munmap(info->data, info->data_len);
+	info->data = data;
+	info->data_mapped = false;
+
+	return FPGA_OK;
+}
+
 fpga_result opae_unload_bitstream(opae_bitstream_info *info)
 {
 	fpga_result res = FPGA_OK;
@@ -295,8 +492,12 @@ fpga_result opae_unload_bitstream(opae_bitstream_info *info)
 	if (!info)
 		return FPGA_INVALID_PARAM;
 
-	if (info->data)
-		opae_free(info->data);
+	if (info->data) {
+		if (info->data_mapped)
+			munmap(info->data, info->data_len);
+		else
+			opae_free(info->data);
+	}
 
 	if (info->parsed_metadata) {
 
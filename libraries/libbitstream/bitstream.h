@@ -29,8 +29,8 @@
  * @brief API for manipulating Green Bitstreams (GBS)
  *
  * GBS files store the AFU logic as well as versioned metadata.
- * These routines parse a disk-resident GBS file, expanding its
- * metadata and loading the GBS logic into memory.
+ * These routines map a disk-resident GBS file into memory and
+ * expand its metadata on demand.
  *
  */
 
@@ -72,10 +72,15 @@ typedef struct _opae_bitstream_header {
  * Memory-resident GBS format.
  *
  * `metadata_version` begins at 1 and increments upward.
- * `parsed_metadata` is the expanded metadata structure.
+ * `parsed_metadata` is the expanded metadata structure. It is
+ * NULL until requested with `opae_bitstream_get_metadata`.
  *
  * If `metadata_version` is 1, then `parsed_metadata`
  * can be safely typecasted to an `opae_bitstream_metadata_v1 *`.
+ *
+ * `data` is normally a read-only mapping of the file, so the
+ * file must not be truncated while the bitstream is loaded, unless
+ * `opae_bitstream_copy_data` has replaced the mapping with a copy.
  */
 typedef struct _opae_bitstream_info {
 	const char *filename;		/**< location of the file on disk */
@@ -86,10 +91,11 @@ typedef struct _opae_bitstream_info {
 	fpga_guid pr_interface_id;	/**< identifies GBS compatibility */
 	int metadata_version;		/**< identifies metadata format */
 	void *parsed_metadata;		/**< the expanded metadata */
+	bool data_mapped;		/**< data is mmap'd, not allocated */
 } opae_bitstream_info;
 
 #define OPAE_BITSTREAM_INFO_INITIALIZER \
-{ NULL, NULL, 0, NULL, 0, { 0, }, 0, NULL }
+{ NULL, NULL, 0, NULL, 0, { 0, }, 0, NULL, false }
 
 #ifdef __cplusplus
 extern "C" {
@@ -99,6 +105,9 @@ extern "C" {
  * Load a GBS file from disk into memory
  *
  * Used to validate and load a GBS file into its memory-resident format.
+ * The file is mapped rather than read, and only the metadata version
+ * and PR interface ID are extracted; see `opae_bitstream_get_metadata`
+ * for the rest of the metadata.
  *
  * @param[in] file Location of the GBS file on disk.
  * @param[out] info Storage for the loaded GBS file contents
@@ -117,6 +126,36 @@ fpga_result opae_load_bitstream(const char *file, opae_bitstream_info *info);
  */
 bool opae_is_legacy_bitstream(opae_bitstream_info *info);
 
+/**
+ * Expand the metadata of a loaded GBS
+ *
+ * Parses the full metadata the first time it is called and caches the
+ * result in `info->parsed_metadata`, which is released by
+ * `opae_unload_bitstream`.
+ *
+ * @param[in] info A GBS loaded by `opae_load_bitstream`.
+ *
+ * @returns The expanded metadata, to be interpreted according to
+ * `info->metadata_version`. NULL for legacy bitstreams or when the
+ * metadata cannot be parsed.
+ */
+void *opae_bitstream_get_metadata(opae_bitstream_info *info);
+
+/**
+ * Replace the mapping of a loaded GBS with a private copy
+ *
+ * For callers that keep a GBS loaded for the life of the process:
+ * once copied, truncating or replacing the file on disk no longer
+ * affects `info->data`. Does nothing if the data is not mapped.
+ *
+ * @param[in,out] info A GBS loaded by `opae_load_bitstream`.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if info is NULL.
+ * FPGA_NO_MEMORY if the copy cannot be allocated, in which case
+ * `info` still holds the mapping.
+ */
+fpga_result opae_bitstream_copy_data(opae_bitstream_info *info);
+
 /**
  * Unload a memory-resident GBS
  *
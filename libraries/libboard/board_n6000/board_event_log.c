@@ -26,7 +26,13 @@
 
 #include <endian.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <json-c/json.h>
 #include <ofs/ofs_defs.h>
 #include <opae/fpga.h>
 
@@ -38,6 +44,11 @@
 #define BEL_PTR_SIZE       4
 #define BEL_LABEL_FMT      "%-*s : "
 
+/* Decoding is split across threads only when there is enough of it */
+#define BEL_PARALLEL_MIN_EVENTS   16
+#define BEL_EVENTS_PER_THREAD     8
+#define BEL_MAX_THREADS           8
+
 #define ARRAY_SIZE(a) (sizeof(a)/sizeof(*a))
 
 enum bel_magic {
@@ -189,11 +200,19 @@ static struct pwron_status pwron_status_info[] = {
 	{.value = 0xb, .str = "Repower cycle failed" }
 };
 
+/* Per-thread output stream for the decoders; NULL means stdout */
+static __thread FILE *bel_stream;
+
+static FILE *bel_out(void)
+{
+	return bel_stream ? bel_stream : stdout;
+}
+
 static void bel_print_bool(const char *label, uint32_t value, size_t offset, const char *one, const char *zero)
 {
 	bool bit = (value >> offset) & 0x1;
 
-	printf("      " BEL_LABEL_FMT "%s\n", 46, label, bit ? one : zero);
+	fprintf(bel_out(), "      " BEL_LABEL_FMT "%s\n", 46, label, bit ? one : zero);
 }
 
 static void bel_print_bit(const char *label, uint32_t value, size_t offset)
@@ -216,7 +235,7 @@ static void bel_print_field(const char *label, uint32_t value, size_t first, siz
 	uint32_t mask = UINT_MAX >> (32 - (last - first));
 	uint32_t field = (value >> first) & mask;
 
-	printf("      " BEL_LABEL_FMT "0x%x\n", 46, label, field);
+	fprintf(bel_out(), "      " BEL_LABEL_FMT "0x%x\n", 46, label, field);
 }
 
 static void bel_print_pwr_on_sts(const char *label, uint32_t value, size_t first, size_t last)
@@ -226,26 +245,27 @@ static void bel_print_pwr_on_sts(const char *label, uint32_t value, size_t first
 	size_t i = 0;
 	for (i = 0; i < ARRAY_SIZE(pwron_status_info); i++) {
 		if (pwron_status_info[i].value == field) {
-			printf("      " BEL_LABEL_FMT "%s(0x%x)\n", 46, label, pwron_status_info[i].str, field);
+			fprintf(bel_out(), "      " BEL_LABEL_FMT "%s(0x%x)\n", 46, label, pwron_status_info[i].str, field);
 			return;
 		}
 	}
-	printf("      " BEL_LABEL_FMT "(%s)0x%x\n", 46, label, "reserved", field);
+	fprintf(bel_out(), "      " BEL_LABEL_FMT "(%s)0x%x\n", 46, label, "reserved", field);
 }
 
 static void bel_print_value(const char *label, uint32_t value)
 {
-	printf("    " BEL_LABEL_FMT "0x%08x\n", 48, label, value);
+	fprintf(bel_out(), "    " BEL_LABEL_FMT "0x%08x\n", 48, label, value);
 }
 
-static void bel_print_timeofday(const char *label, struct bel_timeof_day *time_of_day)
+static uint64_t bel_header_msec(struct bel_header *header)
 {
-	char time_str[26] = { 0 };
-	time_t time_sec = 0;
+	return ((uint64_t)header->timespamp_high << 32) | header->timestamp_low;
+}
 
+static uint64_t bel_timeofday_msec(struct bel_timeof_day *time_of_day)
+{
 	// Timestamps are 64-bit milliseconds:
-	uint64_t correct_time = ((uint64_t)time_of_day->header.timespamp_high << 32) +
-		time_of_day->header.timestamp_low;
+	uint64_t correct_time = bel_header_msec(&time_of_day->header);
 
 	if (time_of_day->header.timespamp_high == 0) {
 		uint64_t offset = ((uint64_t)time_of_day->timeofday_offset_high << 32) +
@@ -253,20 +273,27 @@ static void bel_print_timeofday(const char *label, struct bel_timeof_day *time_o
 		correct_time += offset;
 	}
 
+	return correct_time;
+}
+
+static void bel_print_timeofday(const char *label, struct bel_timeof_day *time_of_day)
+{
+	char time_str[26] = { 0 };
+
 	// Convert milliseconds to seconds; no rounding up from 500 milliseconds!
-	time_sec = correct_time / 1000UL;
+	time_t time_sec = bel_timeofday_msec(time_of_day) / 1000UL;
 
 	if (ctime_r(&time_sec, time_str) == NULL) {
 		OPAE_ERR("Failed to format time: %s", strerror(errno));
 		return;
 	}
-	printf("  " BEL_LABEL_FMT "%s", 50, label, time_str);
+	fprintf(bel_out(), "  " BEL_LABEL_FMT "%s", 50, label, time_str);
 }
 
 static void bel_print_header(const char *label, struct bel_header *header)
 {
 	// Convert milliseconds to seconds;
-	time_t time_sec = (((uint64_t)header->timespamp_high << 32) | header->timestamp_low) / 1000UL;
+	time_t time_sec = bel_header_msec(header) / 1000UL;
 	char time_str[26] = { 0 };
 
 	if (ctime_r(&time_sec, time_str) == NULL) {
@@ -274,7 +301,7 @@ static void bel_print_header(const char *label, struct bel_header *header)
 		return;
 	}
 
-	printf("  " BEL_LABEL_FMT "%s", 50, label, time_str);
+	fprintf(bel_out(), "  " BEL_LABEL_FMT "%s", 50, label, time_str);
 }
 
 static void reserved_field(const char *label, uint32_t value, size_t first, size_t last)
@@ -285,7 +312,7 @@ static void reserved_field(const char *label, uint32_t value, size_t first, size
 		label = "Reserved";
 
 	if (field != 0)
-		printf("      " BEL_LABEL_FMT "*** RESERVED FIELD [%lu:%lu] IS NOT ZERO: 0x%X\n", 46, label, last - 1, first, field);
+		fprintf(bel_out(), "      " BEL_LABEL_FMT "*** RESERVED FIELD [%lu:%lu] IS NOT ZERO: 0x%X\n", 46, label, last - 1, first, field);
 }
 
 static void reserved_bit(const char *label, uint32_t value, size_t offset)
@@ -295,7 +322,7 @@ static void reserved_bit(const char *label, uint32_t value, size_t offset)
 		label = "Reserved";
 
 	if (bit)
-		printf("      " BEL_LABEL_FMT "*** RESERVED BIT [%lu] IS NOT ZERO: %d\n", 46, label, offset, bit);
+		fprintf(bel_out(), "      " BEL_LABEL_FMT "*** RESERVED BIT [%lu] IS NOT ZERO: %d\n", 46, label, offset, bit);
 }
 
 static void bel_print_power_on_status(struct bel_power_on_status *status, struct bel_timeof_day *timeof_day, bool print_bits)
@@ -626,11 +653,11 @@ static size_t bel_print_sensor(struct bel_sensor_state *state, size_t last)
 
 	if (info->id == 0)
 		return last;
-	printf("    " BEL_LABEL_FMT, 48, info->label);
+	fprintf(bel_out(), "    " BEL_LABEL_FMT, 48, info->label);
 	if (state->reading != INT_MAX)
-		printf("%6u %s\n", state->reading / info->resolution, info->unit);
+		fprintf(bel_out(), "%6u %s\n", state->reading / info->resolution, info->unit);
 	else
-		printf("%9s\n", "N/A");
+		fprintf(bel_out(), "%9s\n", "N/A");
 
 	return next;
 }
@@ -675,7 +702,7 @@ static void bel_print_sensors_status_ext(const char *label, struct bel_ext_statu
 	bel_print_bit("Vout", status->word, 15);
 
 	for (i = 0; i < 4; i++) {
-		printf("    " BEL_LABEL_FMT "%7u %s\n", 48, info->label, status->data[i + 1], info->unit);
+		fprintf(bel_out(), "    " BEL_LABEL_FMT "%7u %s\n", 48, info->label, status->data[i + 1], info->unit);
 		info++;
 	}
 
@@ -831,6 +858,67 @@ fpga_result bel_read(fpga_object fpga_object, uint32_t ptr, struct bel_event *ev
 	return res;
 }
 
+/* Copy blocks [lo..hi] out of one contiguous read, newest (hi) first */
+static fpga_result bel_read_window(fpga_object fpga_object, uint32_t lo, uint32_t hi,
+				   struct bel_event *events)
+{
+	size_t len = (hi - lo) * BEL_BLOCK_SIZE + sizeof(*events);
+	size_t count = sizeof(*events) / sizeof(uint32_t);
+	fpga_result res;
+	uint8_t *buf;
+	uint32_t i;
+	size_t j;
+
+	buf = malloc(len);
+	if (!buf) {
+		OPAE_ERR("Failed to allocate %zu bytes for event log", len);
+		return FPGA_NO_MEMORY;
+	}
+
+	res = fpgaObjectRead(fpga_object, buf, lo * BEL_BLOCK_SIZE, len, FPGA_OBJECT_RAW);
+	if (res != FPGA_OK)
+		goto out_free;
+
+	for (i = 0; i <= hi - lo; i++) {
+		struct bel_event *event = &events[i];
+
+		memcpy(event, buf + (hi - lo - i) * BEL_BLOCK_SIZE, sizeof(*event));
+
+		for (j = 1; j < count; j++)
+			event->data[j] = le32toh(event->data[j]);
+	}
+
+out_free:
+	free(buf);
+	return res;
+}
+
+fpga_result bel_read_many(fpga_object fpga_object, uint32_t ptr, uint32_t count,
+			  struct bel_event *events)
+{
+	uint32_t head;
+	fpga_result res;
+
+	if (ptr >= BEL_BLOCK_COUNT || count > BEL_BLOCK_COUNT)
+		return FPGA_INVALID_PARAM;
+
+	if (!count)
+		return FPGA_OK;
+
+	/*
+	 * Walking backwards from ptr touches at most two contiguous
+	 * runs of blocks: [..ptr] and, after wrapping, [..BEL_BLOCK_COUNT-1].
+	 */
+	head = (count > ptr + 1) ? ptr + 1 : count;
+
+	res = bel_read_window(fpga_object, ptr + 1 - head, ptr, events);
+	if (res != FPGA_OK || head == count)
+		return res;
+
+	return bel_read_window(fpga_object, BEL_BLOCK_COUNT - (count - head),
+			       BEL_BLOCK_COUNT - 1, events + head);
+}
+
 void bel_print(struct bel_event *event, bool print_sensors, bool print_bits)
 {
 	bel_print_power_on_status(&event->power_on_status, &event->timeof_day, print_bits);
@@ -864,18 +952,8 @@ void bel_timespan(struct bel_event *event, uint32_t idx)
 	if (event->timeof_day.header.magic != BEL_TIMEOF_DAY_STATUS)
 		return;
 
-	// Timestamps are 64-bit milliseconds:
-	uint64_t correct_time = ((uint64_t)event->timeof_day.header.timespamp_high << 32) +
-		event->timeof_day.header.timestamp_low;
-
-	if (event->timeof_day.header.timespamp_high == 0) {
-		uint64_t offset = ((uint64_t)event->timeof_day.timeofday_offset_high << 32) +
-			event->timeof_day.timeofday_offset_low;
-		correct_time += offset;
-	}
-
 	// Convert milliseconds to seconds; no rounding up from 500 milliseconds!
-	on_sec = correct_time / 1000UL;
+	on_sec = bel_timeofday_msec(&event->timeof_day) / 1000UL;
 
 	if (ctime_r(&on_sec, on_str) == NULL) {
 		OPAE_ERR("Failed to format time: %s", strerror(errno));
@@ -894,11 +972,11 @@ void bel_timespan(struct bel_event *event, uint32_t idx)
 	}
 
 	if (idx == 0) {
-		printf("%-15s : %-25s : %-25s\n", "Boot Index", "Power-ON Timestamp", "Power-OFF Timestamp");
-		printf("-------------------------------------------------------------------------\n");
-		printf("%-15s - %-20s  - %-20s\n", "Current Boot", on_str, off_str);
+		fprintf(bel_out(), "%-15s : %-25s : %-25s\n", "Boot Index", "Power-ON Timestamp", "Power-OFF Timestamp");
+		fprintf(bel_out(), "-------------------------------------------------------------------------\n");
+		fprintf(bel_out(), "%-15s - %-20s  - %-20s\n", "Current Boot", on_str, off_str);
 	} else {
-		printf("Boot %-10u - %-20s  - %-20s\n", idx, on_str, off_str);
+		fprintf(bel_out(), "Boot %-10u - %-20s  - %-20s\n", idx, on_str, off_str);
 	}
 
 }
@@ -907,3 +985,335 @@ bool bel_empty(struct bel_event *event)
 {
 	return event->power_on_status.header.magic == UINT_MAX;
 }
+
+static void bel_print_event(struct bel_event *event, uint32_t idx,
+			    bool print_list, bool print_sensors, bool print_bits)
+{
+	if (print_list) {
+		bel_timespan(event, idx);
+	} else if (bel_empty(event)) {
+		if (idx == 0)
+			fprintf(bel_out(), "Current Boot / Boot %u: Empty\n", idx);
+		else
+			fprintf(bel_out(), "Boot %u: Empty\n", idx);
+	} else {
+		if (idx == 0)
+			fprintf(bel_out(), "Current Boot / Boot %u\n", idx);
+		else
+			fprintf(bel_out(), "Boot %u\n", idx);
+		bel_print(event, print_sensors, print_bits);
+	}
+}
+
+/* Register names for each record, in the order they follow the header */
+static const char * const bel_power_on_regs[] = {
+	"status", "fpga_status", "fpga_config_status",
+	"sequencer_status_1", "sequencer_status_2", "power_good_status"
+};
+
+static const char * const bel_timeof_day_regs[] = {
+	"timeofday_offset_low", "timeofday_offset_high"
+};
+
+static const char * const bel_max10_seu_regs[] = { "max10_seu" };
+
+static const char * const bel_fpga_seu_regs[] = { "fpga_seu" };
+
+static const char * const bel_pci_error_regs[] = {
+	"pcie_link_status", "pcie_uncorr_err"
+};
+
+static const char * const bel_power_off_regs[] = {
+	"fpga_status", "fpga_config_status", "record_1", "record_2",
+	"general_purpose_input_status", "sensor_failed",
+	"sensor_alert_1", "sensor_alert_2", "sensor_alert_3"
+};
+
+static const char * const bel_sensors_status_regs[] = {
+	"ina3221_1_mask_enable", "ina3221_2_mask_enable", "ina3221_3_mask_enable",
+	"ir38062_word", "ir38062_vout", "ir38062_iout",
+	"ir38062_input", "ir38062_temp", "ir38062_cml",
+	"ir38063_word", "ir38063_vout", "ir38063_iout",
+	"ir38063_input", "ir38063_temp", "ir38063_cml",
+	"isl68220_word", "isl68220_vout", "isl68220_iout",
+	"isl68220_input", "isl68220_temp", "isl68220_cml",
+	"ed8401_status"
+};
+
+static void bel_json_record(struct json_object *obj, const char *key,
+			    struct bel_header *header, uint32_t magic,
+			    const char * const *names, size_t count)
+{
+	const uint32_t *regs = (const uint32_t *)(header + 1);
+	struct json_object *record;
+	size_t i;
+
+	if (header->magic != magic)
+		return;
+
+	record = json_object_new_object();
+	json_object_object_add(record, "timestamp_ms",
+		json_object_new_int64((int64_t)bel_header_msec(header)));
+
+	for (i = 0; i < count; i++)
+		json_object_object_add(record, names[i], json_object_new_int64(regs[i]));
+
+	json_object_object_add(obj, key, record);
+}
+
+static struct json_object *bel_json_sensors(struct bel_sensors_state *state)
+{
+	struct json_object *sensors = json_object_new_array();
+	struct bel_sensor_info *info;
+	size_t i, k;
+
+	for (i = 0; i < ARRAY_SIZE(state->sensor_state); i++) {
+		struct bel_sensor_state *s = &state->sensor_state[i];
+		struct json_object *sensor;
+
+		for (k = 0; k < ARRAY_SIZE(bel_sensor_info); k++)
+			if (bel_sensor_info[k].id == s->id)
+				break;
+
+		if (k == ARRAY_SIZE(bel_sensor_info) || s->id == 0)
+			continue;
+
+		info = &bel_sensor_info[k];
+		sensor = json_object_new_object();
+		json_object_object_add(sensor, "label", json_object_new_string(info->label));
+		if (s->reading != INT_MAX)
+			json_object_object_add(sensor, "value",
+				json_object_new_int64(s->reading / info->resolution));
+		else
+			json_object_object_add(sensor, "value", NULL);
+		json_object_object_add(sensor, "unit", json_object_new_string(info->unit));
+		json_object_array_add(sensors, sensor);
+	}
+
+	return sensors;
+}
+
+static struct json_object *bel_json_event(struct bel_event *event, uint32_t idx,
+					  bool print_sensors)
+{
+	struct json_object *obj = json_object_new_object();
+
+	json_object_object_add(obj, "boot", json_object_new_int64(idx));
+	json_object_object_add(obj, "empty", json_object_new_boolean(bel_empty(event)));
+	if (bel_empty(event))
+		return obj;
+
+	if (event->timeof_day.header.magic == BEL_TIMEOF_DAY_STATUS)
+		json_object_object_add(obj, "power_on_time_ms",
+			json_object_new_int64((int64_t)bel_timeofday_msec(&event->timeof_day)));
+
+	if (event->power_off_status.header.magic == BEL_POWER_OFF_STATUS)
+		json_object_object_add(obj, "power_off_time_ms",
+			json_object_new_int64((int64_t)bel_header_msec(&event->power_off_status.header)));
+
+	bel_json_record(obj, "power_on_status", &event->power_on_status.header,
+		BEL_POWER_ON_STATUS, bel_power_on_regs, ARRAY_SIZE(bel_power_on_regs));
+	bel_json_record(obj, "timeof_day", &event->timeof_day.header,
+		BEL_TIMEOF_DAY_STATUS, bel_timeof_day_regs, ARRAY_SIZE(bel_timeof_day_regs));
+	bel_json_record(obj, "max10_seu", &event->max10_seu.header,
+		BEL_MAX10_SEU_STATUS, bel_max10_seu_regs, ARRAY_SIZE(bel_max10_seu_regs));
+	bel_json_record(obj, "fpga_seu", &event->fpga_seu.header,
+		BEL_FPGA_SEU_STATUS, bel_fpga_seu_regs, ARRAY_SIZE(bel_fpga_seu_regs));
+	bel_json_record(obj, "pci_error_status", &event->pci_error_status.header,
+		BEL_PCI_ERROR_STATUS, bel_pci_error_regs, ARRAY_SIZE(bel_pci_error_regs));
+	bel_json_record(obj, "power_off_status", &event->power_off_status.header,
+		BEL_POWER_OFF_STATUS, bel_power_off_regs, ARRAY_SIZE(bel_power_off_regs));
+
+	if (!print_sensors)
+		return obj;
+
+	if (event->sensors_state.header.magic == BEL_SENSORS_STATE) {
+		struct json_object *state = json_object_new_object();
+
+		json_object_object_add(state, "timestamp_ms",
+			json_object_new_int64((int64_t)bel_header_msec(&event->sensors_state.header)));
+		json_object_object_add(state, "sensors", bel_json_sensors(&event->sensors_state));
+		json_object_object_add(obj, "sensors_state", state);
+	}
+
+	bel_json_record(obj, "sensors_status", &event->sensors_status.header,
+		BEL_SENSORS_STATUS, bel_sensors_status_regs,
+		ARRAY_SIZE(bel_sensors_status_regs));
+
+	return obj;
+}
+
+/* One contiguous run of events decoded by a single thread */
+struct bel_slice {
+	struct bel_event *events;
+	uint32_t first_idx;
+	uint32_t begin;
+	uint32_t end;
+	bool print_list;
+	bool print_sensors;
+	bool print_bits;
+	char *text;
+	size_t text_len;
+	struct json_object **json;
+	void (*decode)(struct bel_slice *slice);
+};
+
+static void bel_slice_text(struct bel_slice *slice)
+{
+	FILE *stream = open_memstream(&slice->text, &slice->text_len);
+	uint32_t i;
+
+	if (!stream) {
+		/* Caller falls back to printing this slice directly */
+		slice->text = NULL;
+		return;
+	}
+
+	bel_stream = stream;
+	for (i = slice->begin; i < slice->end; i++)
+		bel_print_event(&slice->events[i], slice->first_idx + i,
+				slice->print_list, slice->print_sensors,
+				slice->print_bits);
+	bel_stream = NULL;
+
+	fclose(stream);
+}
+
+static void bel_slice_json(struct bel_slice *slice)
+{
+	uint32_t i;
+
+	for (i = slice->begin; i < slice->end; i++)
+		slice->json[i] = bel_json_event(&slice->events[i],
+						slice->first_idx + i,
+						slice->print_sensors);
+}
+
+static void *bel_slice_thread(void *arg)
+{
+	struct bel_slice *slice = (struct bel_slice *)arg;
+
+	slice->decode(slice);
+	return NULL;
+}
+
+static uint32_t bel_thread_count(uint32_t count)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t threads = count / BEL_EVENTS_PER_THREAD;
+
+	if (count < BEL_PARALLEL_MIN_EVENTS || cpus <= 1)
+		return 1;
+
+	if (threads > (uint32_t)cpus)
+		threads = (uint32_t)cpus;
+	if (threads > BEL_MAX_THREADS)
+		threads = BEL_MAX_THREADS;
+
+	return threads;
+}
+
+/*
+ * Split [0, count) into contiguous slices and decode them concurrently.
+ * Slice 0 runs on the calling thread; a slice whose thread could not be
+ * started is decoded inline, so the result never depends on the split.
+ */
+static void bel_decode(struct bel_slice *tmpl, uint32_t count,
+		       struct bel_slice *slices, uint32_t threads)
+{
+	pthread_t tid[BEL_MAX_THREADS];
+	bool started[BEL_MAX_THREADS] = { false };
+	uint32_t per = (count + threads - 1) / threads;
+	uint32_t t;
+
+	for (t = 0; t < threads; t++) {
+		slices[t] = *tmpl;
+		slices[t].begin = t * per < count ? t * per : count;
+		slices[t].end = (t + 1) * per < count ? (t + 1) * per : count;
+	}
+
+	for (t = 1; t < threads; t++)
+		started[t] = !pthread_create(&tid[t], NULL,
+					     bel_slice_thread, &slices[t]);
+
+	slices[0].decode(&slices[0]);
+
+	for (t = 1; t < threads; t++) {
+		if (started[t])
+			pthread_join(tid[t], NULL);
+		else
+			slices[t].decode(&slices[t]);
+	}
+}
+
+void bel_print_events(struct bel_event *events, uint32_t first_idx, uint32_t count,
+		      bool print_list, bool print_sensors, bool print_bits)
+{
+	struct bel_slice slices[BEL_MAX_THREADS];
+	uint32_t threads = bel_thread_count(count);
+	struct bel_slice tmpl = {
+		.events = events,
+		.first_idx = first_idx,
+		.print_list = print_list,
+		.print_sensors = print_sensors,
+		.print_bits = print_bits,
+		.decode = bel_slice_text,
+	};
+	uint32_t i, t;
+
+	if (threads == 1) {
+		for (i = 0; i < count; i++)
+			bel_print_event(&events[i], first_idx + i,
+					print_list, print_sensors, print_bits);
+		return;
+	}
+
+	bel_decode(&tmpl, count, slices, threads);
+
+	for (t = 0; t < threads; t++) {
+		if (slices[t].text) {
+			fwrite(slices[t].text, 1, slices[t].text_len, stdout);
+			free(slices[t].text);
+			continue;
+		}
+
+		for (i = slices[t].begin; i < slices[t].end; i++)
+			bel_print_event(&events[i], first_idx + i,
+					print_list, print_sensors, print_bits);
+	}
+}
+
+struct json_object *bel_json_events(struct bel_event *events, uint32_t first_idx,
+				    uint32_t count, bool print_sensors)
+{
+	struct bel_slice slices[BEL_MAX_THREADS];
+	struct json_object *array;
+	struct json_object **json;
+	struct bel_slice tmpl = {
+		.events = events,
+		.first_idx = first_idx,
+		.print_sensors = print_sensors,
+		.decode = bel_slice_json,
+	};
+	uint32_t i;
+
+	array = json_object_new_array();
+	if (!array || !count)
+		return array;
+
+	json = calloc(count, sizeof(*json));
+	if (!json) {
+		OPAE_ERR("Failed to allocate event list");
+		json_object_put(array);
+		return NULL;
+	}
+
+	tmpl.json = json;
+	bel_decode(&tmpl, count, slices, bel_thread_count(count));
+
+	for (i = 0; i < count; i++)
+		json_object_array_add(array, json[i]);
+
+	free(json);
+	return array;
+}
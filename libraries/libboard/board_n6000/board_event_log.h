@@ -31,6 +31,8 @@
 
 #define BEL_SENSOR_COUNT 83
 
+struct json_object;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -204,6 +206,51 @@ fpga_result bel_ptr(fpga_object fpga_object, uint32_t *ptr);
  */
 fpga_result bel_read(fpga_object fpga_object, uint32_t ptr, struct bel_event *event);
 
+/**
+ * Read consecutive event entries from log on flash
+ *
+ * Walks the log backwards from ptr the same way bel_ptr_next() does,
+ * but fetches the blocks with at most two bulk reads instead of one
+ * read per event.
+ *
+ * @param[in] fpga_object  Sysfs node to read from
+ * @param[in] ptr          Offset in log of the first (newest) event
+ * @param[in] count        Number of events to read, up to bel_ptr_count()
+ * @param[out] events      Array of count event structures to read into
+ *
+ * @return FPGA_OK on success
+ */
+fpga_result bel_read_many(fpga_object fpga_object, uint32_t ptr, uint32_t count,
+			  struct bel_event *events);
+
+/**
+ * Print human readable info for consecutive boots
+ *
+ * Large dumps are decoded on several threads; output order is unchanged.
+ *
+ * @param[in] events         Events as returned by bel_read_many()
+ * @param[in] first_idx      Boot counter for events[0]
+ * @param[in] count          Number of events
+ * @param[in] print_list     Print power-on and power-off time span only
+ * @param[in] print_sensors  Flag to enable printing of the many sensors
+ * @param[in] print_bits     Flag to enable printing of the many field bits
+ */
+void bel_print_events(struct bel_event *events, uint32_t first_idx, uint32_t count,
+		      bool print_list, bool print_sensors, bool print_bits);
+
+/**
+ * Decode consecutive boots into a JSON array
+ *
+ * @param[in] events         Events as returned by bel_read_many()
+ * @param[in] first_idx      Boot counter for events[0]
+ * @param[in] count          Number of events
+ * @param[in] print_sensors  Include sensor state and status records
+ *
+ * @return New JSON array owned by the caller, or NULL on allocation failure
+ */
+struct json_object *bel_json_events(struct bel_event *events, uint32_t first_idx,
+				    uint32_t count, bool print_sensors);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -31,6 +31,8 @@
 #include <errno.h>
 #include <string.h>
 #include <regex.h>
+#include <stdlib.h>
+#include <json-c/json.h>
 #include <opae/properties.h>
 #include <opae/utils.h>
 #include <opae/fpga.h>
@@ -791,17 +793,11 @@ fpga_result fpga_image_info(fpga_token token)
 	return res;
 }
 
-fpga_result fpga_event_log(fpga_token token, uint32_t first, uint32_t last,
-	bool print_list, bool print_sensors, bool print_bits)
+/* Validate the requested boot range and open the event log node */
+static fpga_result open_event_log(fpga_token token, uint32_t first, uint32_t last,
+	fpga_object *fpga_object)
 {
-	fpga_object fpga_object;
-	struct bel_event event;
-	uint32_t count = last;
-	uint32_t i = first;
 	fpga_result res;
-	uint32_t ptr;
-
-	memset(&event, 0, sizeof(event));
 
 	if (first > bel_ptr_count()) {
 		fprintf(stderr, "invalid --boot value: %u\n", first);
@@ -814,61 +810,122 @@ fpga_result fpga_event_log(fpga_token token, uint32_t first, uint32_t last,
 	}
 
 	res = fpgaTokenGetObject(token, DFL_SYSFS_EVENT_LOG_GLOB,
-			&fpga_object, FPGA_OBJECT_GLOB);
-	if (res != FPGA_OK) {
+			fpga_object, FPGA_OBJECT_GLOB);
+	if (res != FPGA_OK)
 		OPAE_MSG("Failed to get token Object");
-		return res;
-	}
+
+	return res;
+}
+
+/* Read the boots selected by first/last into a newly allocated array */
+static fpga_result read_event_log(fpga_object fpga_object, uint32_t first,
+	uint32_t last, struct bel_event **events, uint32_t *idx, uint32_t *count)
+{
+	fpga_result res;
+	uint32_t ptr;
+
+	*events = NULL;
+	*idx = first;
+	*count = last;
 
 	/* Special case when all events requested */
 	if (first == last) {
-		count = bel_ptr_count();
-		i = 0;
+		*count = bel_ptr_count();
+		*idx = 0;
 	}
 
+	*count -= *idx;
+
 	/* Get index to latest log event in flash */
 	res = bel_ptr(fpga_object, &ptr);
 	if (res != FPGA_OK) {
 		OPAE_MSG("Failed to read log pointer");
-		goto out;
+		return res;
 	}
 
 	/* Fast forward to the requested event */
 	while (first--)
 		ptr = bel_ptr_next(ptr);
 
-	/* Read and print the requested number of events */
-	while (i++ < count) {
-		res = bel_read(fpga_object, ptr, &event);
-		if (res != FPGA_OK)
-			goto out;
-
-		if (print_list) {
-			bel_timespan(&event, i - 1);
-		} else if (bel_empty(&event)) {
-			if ((i - 1) == 0)
-				printf("Current Boot / Boot %i: Empty\n", i - 1);
-			else
-				printf("Boot %i: Empty\n", i - 1);
-
-		} else {
-			if ((i - 1) == 0)
-				printf("Current Boot / Boot %i\n", i - 1);
-			else
-				printf("Boot %i\n", i - 1);
-			bel_print(&event, print_sensors, print_bits);
-		}
+	*events = calloc(*count ? *count : 1, sizeof(**events));
+	if (!*events) {
+		OPAE_ERR("Failed to allocate event log");
+		return FPGA_NO_MEMORY;
+	}
 
-		ptr = bel_ptr_next(ptr);
+	/* Read the requested number of events in bulk */
+	res = bel_read_many(fpga_object, ptr, *count, *events);
+	if (res != FPGA_OK) {
+		OPAE_MSG("Failed to read event log");
+		free(*events);
+		*events = NULL;
+	}
+
+	return res;
+}
+
+fpga_result fpga_event_log(fpga_token token, uint32_t first, uint32_t last,
+	bool print_list, bool print_sensors, bool print_bits)
+{
+	struct bel_event *events = NULL;
+	fpga_object fpga_object;
+	uint32_t count = 0;
+	uint32_t idx = 0;
+	fpga_result res;
+
+	res = open_event_log(token, first, last, &fpga_object);
+	if (res != FPGA_OK)
+		return res;
+
+	res = read_event_log(fpga_object, first, last, &events, &idx, &count);
+	if (res == FPGA_OK) {
+		bel_print_events(events, idx, count, print_list,
+				 print_sensors, print_bits);
+		free(events);
 	}
 
-out:
 	if (fpgaDestroyObject(&fpga_object) != FPGA_OK)
 		OPAE_ERR("Failed to Destroy Object");
 
 	return FPGA_OK;
 }
 
+fpga_result fpga_event_log_json(fpga_token token, uint32_t first, uint32_t last,
+	bool print_sensors)
+{
+	struct bel_event *events = NULL;
+	struct json_object *root = NULL;
+	fpga_object fpga_object;
+	uint32_t count = 0;
+	uint32_t idx = 0;
+	fpga_result res;
+
+	res = open_event_log(token, first, last, &fpga_object);
+	if (res != FPGA_OK)
+		return res;
+
+	res = read_event_log(fpga_object, first, last, &events, &idx, &count);
+	if (res != FPGA_OK)
+		goto out;
+
+	root = bel_json_events(events, idx, count, print_sensors);
+	free(events);
+
+	if (!root) {
+		res = FPGA_NO_MEMORY;
+		goto out;
+	}
+
+	printf("%s\n", json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY));
+	json_object_put(root);
+
+out:
+	if (fpgaDestroyObject(&fpga_object) != FPGA_OK)
+		OPAE_ERR("Failed to Destroy Object");
+
+	return res;
+}
+
 fpga_result print_hssi_port_status(uint8_t *uio_ptr)
 {
 	uint32_t i                     = 0;
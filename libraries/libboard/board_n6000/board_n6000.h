@@ -144,6 +144,18 @@ fpga_result fpga_image_info(fpga_token token);
 fpga_result fpga_event_log(fpga_token token, uint32_t first, uint32_t last,
 	bool print_list, bool print_sensors, bool print_bits);
 
+/**
+* Prints fpga event log as JSON.
+*
+* @param[in] token           fpga_token object for device (FPGA_DEVICE type)
+* @param[in] first           first boot index to print
+* @param[in] last            (one past) last boot index to print
+* @param[in] print_sensors   include sensor data too
+* @returns FPGA_OK on success, or FPGA_NOT_FOUND if the sysfs node is not found.
+*/
+fpga_result fpga_event_log_json(fpga_token token, uint32_t first, uint32_t last,
+	bool print_sensors);
+
 /**
 * Prints hssi port status.
 *
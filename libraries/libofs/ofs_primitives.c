@@ -28,3 +28,179 @@
 #endif // HAVE_CONFIG_H
 
 #include <ofs/ofs_primitives.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define OFS_HAVE_TSC 1
+#endif
+
+/*
+ * Wait engine clock. When the CPU has an invariant TSC, ticks are TSC
+ * cycles; otherwise they are CLOCK_MONOTONIC nanoseconds. Calibration
+ * runs once, the first time a wait is started.
+ */
+static struct {
+	bool tsc;
+	bool waitpkg;
+	uint64_t ticks_per_usec;
+} ofs_clock = {
+	.tsc = false,
+	.waitpkg = false,
+	.ticks_per_usec = 1000,
+};
+static pthread_once_t ofs_clock_once = PTHREAD_ONCE_INIT;
+
+static inline uint64_t ofs_monotonic_nsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * SEC2NSEC + ts.tv_nsec;
+}
+
+static inline void ofs_cpu_relax(void)
+{
+#ifdef OFS_HAVE_TSC
+	__builtin_ia32_pause();
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+#ifdef OFS_HAVE_TSC
+/* Nap in the C0.1 state until the TSC reaches deadline. Emitted as
+ * bytes so that no -mwaitpkg is needed to build. */
+static inline void ofs_tpause(uint64_t deadline)
+{
+	__asm__ __volatile__(".byte 0x66, 0x0f, 0xae, 0xf1" /* tpause ecx */
+			     :
+			     : "c"(1), "a"((uint32_t)deadline),
+			       "d"((uint32_t)(deadline >> 32))
+			     : "cc", "memory");
+}
+#endif
+
+static void ofs_clock_calibrate(void)
+{
+#ifdef OFS_HAVE_TSC
+	unsigned int eax, ebx, ecx, edx;
+	uint64_t ns0, ns1, tsc0, tsc1;
+
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		ofs_clock.waitpkg = (ecx >> 5) & 1;
+
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+	    !((edx >> 8) & 1))
+		return; /* no invariant TSC */
+
+	/* Prefer the TSC frequency the CPU reports... */
+	if (__get_cpuid(0x15, &eax, &ebx, &ecx, &edx) && eax && ebx && ecx) {
+		ofs_clock.ticks_per_usec =
+			((uint64_t)ecx * ebx / eax + 500000) / 1000000;
+		ofs_clock.tsc = ofs_clock.ticks_per_usec != 0;
+		if (ofs_clock.tsc)
+			return;
+	}
+
+	/* ...otherwise measure it against CLOCK_MONOTONIC. */
+	ns0 = ofs_monotonic_nsec();
+	tsc0 = __builtin_ia32_rdtsc();
+	do {
+		ofs_cpu_relax();
+		ns1 = ofs_monotonic_nsec();
+	} while (ns1 - ns0 < 200000);
+	tsc1 = __builtin_ia32_rdtsc();
+
+	ofs_clock.ticks_per_usec = ((tsc1 - tsc0) * 1000 +
+				    (ns1 - ns0) / 2) / (ns1 - ns0);
+	ofs_clock.tsc = ofs_clock.ticks_per_usec != 0;
+	if (!ofs_clock.tsc)
+		ofs_clock.ticks_per_usec = 1000;
+#endif // OFS_HAVE_TSC
+}
+
+uint64_t ofs_clock_ticks(void)
+{
+	pthread_once(&ofs_clock_once, ofs_clock_calibrate);
+#ifdef OFS_HAVE_TSC
+	if (ofs_clock.tsc)
+		return __builtin_ia32_rdtsc();
+#endif
+	return ofs_monotonic_nsec();
+}
+
+uint64_t ofs_usec_to_ticks(uint64_t usec)
+{
+	pthread_once(&ofs_clock_once, ofs_clock_calibrate);
+	if (usec > UINT64_MAX / ofs_clock.ticks_per_usec)
+		return UINT64_MAX;
+	return usec * ofs_clock.ticks_per_usec;
+}
+
+void ofs_wait_init(struct ofs_wait *w, uint64_t timeout_usec,
+		   uint32_t sleep_usec)
+{
+	uint64_t now;
+
+	now = ofs_clock_ticks();
+
+	// Saturate: a huge timeout means wait forever.
+	if (timeout_usec > (UINT64_MAX - now) / ofs_clock.ticks_per_usec)
+		w->deadline = UINT64_MAX;
+	else
+		w->deadline = now + timeout_usec * ofs_clock.ticks_per_usec;
+	w->spin_end = now +
+		OFS_WAIT_SPIN_NSEC * ofs_clock.ticks_per_usec / USEC2NSEC;
+	w->nap_end = ofs_clock.waitpkg ? w->spin_end +
+		OFS_WAIT_NAP_NSEC * ofs_clock.ticks_per_usec / USEC2NSEC :
+		w->spin_end;
+	w->sleep_nsec = OFS_WAIT_MIN_SLEEP_NSEC;
+	w->max_sleep_nsec = (uint64_t)sleep_usec * USEC2NSEC;
+	if (w->sleep_nsec > w->max_sleep_nsec)
+		w->sleep_nsec = w->max_sleep_nsec;
+}
+
+int ofs_wait_step(struct ofs_wait *w)
+{
+	uint64_t now = ofs_clock_ticks();
+	struct timespec ts, rem;
+	uint64_t nsec;
+
+	if (now >= w->deadline)
+		return 1;
+
+	if (now < w->spin_end || (!w->max_sleep_nsec && !ofs_clock.waitpkg)) {
+		ofs_cpu_relax();
+		return 0;
+	}
+
+#ifdef OFS_HAVE_TSC
+	if (ofs_clock.waitpkg && (now < w->nap_end || !w->max_sleep_nsec)) {
+		uint64_t until = now + OFS_WAIT_NAP_SLICE_NSEC *
+				ofs_clock.ticks_per_usec / USEC2NSEC;
+		ofs_tpause(until < w->deadline ? until : w->deadline);
+		return 0;
+	}
+#endif
+
+	/* Sleep, but not past the deadline. */
+	nsec = w->deadline - now;
+	if (nsec < UINT64_MAX / USEC2NSEC)
+		nsec = nsec * USEC2NSEC / ofs_clock.ticks_per_usec;
+	if (nsec > w->sleep_nsec)
+		nsec = w->sleep_nsec;
+	ts.tv_sec = nsec / SEC2NSEC;
+	ts.tv_nsec = nsec % SEC2NSEC;
+	while ((nanosleep(&ts, &rem) == -1) && (errno == EINTR))
+		ts = rem;
+
+	if (w->sleep_nsec < w->max_sleep_nsec) {
+		w->sleep_nsec <<= 1;
+		if (w->sleep_nsec > w->max_sleep_nsec)
+			w->sleep_nsec = w->max_sleep_nsec;
+	}
+
+	return 0;
+}
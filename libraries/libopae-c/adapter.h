@@ -33,6 +33,7 @@
 typedef struct _opae_plugin {
 	char *path;      // location on file system
 	void *dl_handle; // handle to the loaded library instance
+	int init_state;  // whether initialize() has run, see pluginmgr.c
 } opae_plugin;
 
 typedef struct _opae_api_adapter_table {
@@ -76,6 +77,13 @@ typedef struct _opae_api_adapter_table {
 
 	fpga_result (*fpgaUnmapMMIO)(fpga_handle handle, uint32_t mmio_num);
 
+	fpga_result (*fpgaReadMMIOv)(fpga_handle handle, uint32_t mmio_num,
+				     fpga_mmio_vec *vec, uint32_t count);
+
+	fpga_result (*fpgaWriteMMIOv)(fpga_handle handle, uint32_t mmio_num,
+				      const fpga_mmio_vec *vec,
+				      uint32_t count);
+
 	fpga_result (*fpgaEnumerate)(const fpga_properties *filters,
 				     uint32_t num_filters, fpga_token *tokens,
 				     uint32_t max_tokens,
@@ -158,6 +166,14 @@ typedef struct _opae_api_adapter_table {
 					   const uint8_t *bitstream,
 					   size_t bitstream_len, int flags);
 
+	fpga_result (*fpgaReconfigureSlotProgress)(fpga_handle fpga,
+						   uint32_t slot,
+						   const uint8_t *bitstream,
+						   size_t bitstream_len,
+						   int flags,
+						   fpga_reconf_progress_cb progress,
+						   void *context);
+
 	fpga_result (*fpgaTokenGetObject)(fpga_token token, const char *name,
 					  fpga_object *object, int flags);
 
@@ -209,6 +225,11 @@ typedef struct _opae_api_adapter_table {
 					uint64_t num_metric_names,
 					fpga_metric *metrics);
 
+	fpga_result (*fpgaGetMetricsSnapshot)(fpga_handle handle,
+					fpga_metric *metrics,
+					uint64_t *num_metrics,
+					uint64_t *timestamp_ns);
+
 	fpga_result(*fpgaGetMetricsThresholdInfo)(fpga_handle handle,
 		metric_threshold *metric_thresholds,
 		uint32_t *num_thresholds);
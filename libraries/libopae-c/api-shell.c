@@ -33,6 +33,10 @@
 #endif // _GNU_SOURCE
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
 
 #include <opae/properties.h>
 #include <opae/types_enum.h>
@@ -73,12 +77,70 @@ __OPAE_API__ fpgaErrStr(fpga_result e)
 	}
 }
 
-STATIC pthread_mutex_t token_list_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
-STATIC opae_wrapped_token token_list_head = {
-	.prev = &token_list_head,
-	.next = &token_list_head,
+/*
+ * Wrapped token reference counts are atomic, so uprefs and downrefs
+ * (fpgaOpen, fpgaClose, fpgaCloneToken, fpgaDestroyToken) don't
+ * serialize across threads. Live tokens are additionally kept in a
+ * registry, which opae_get_parent_token() walks. The registry is only
+ * touched when a token is created or destroyed, and it is sharded by
+ * token address to keep those operations from contending.
+ */
+#define OPAE_TOKEN_REGISTRY_SHARDS 16
+
+typedef struct _opae_token_shard {
+	pthread_mutex_t lock;
+	opae_wrapped_token *head;
+} opae_token_shard;
+
+STATIC opae_token_shard token_registry[OPAE_TOKEN_REGISTRY_SHARDS] = {
+	[0 ... OPAE_TOKEN_REGISTRY_SHARDS - 1] = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.head = NULL,
+	},
 };
 
+STATIC opae_token_shard *opae_token_shard_for(opae_wrapped_token *wt)
+{
+	uintptr_t p = (uintptr_t)wt;
+
+	p ^= p >> 12;
+	return &token_registry[(p >> 4) % OPAE_TOKEN_REGISTRY_SHARDS];
+}
+
+STATIC void opae_register_wrapped_token(opae_wrapped_token *wt)
+{
+	int res;
+	opae_token_shard *shard = opae_token_shard_for(wt);
+
+	opae_mutex_lock(res, &shard->lock);
+
+	wt->prev = NULL;
+	wt->next = shard->head;
+	if (shard->head)
+		shard->head->prev = wt;
+	shard->head = wt;
+
+	opae_mutex_unlock(res, &shard->lock);
+}
+
+STATIC void opae_unregister_wrapped_token(opae_wrapped_token *wt)
+{
+	int res;
+	opae_token_shard *shard = opae_token_shard_for(wt);
+
+	opae_mutex_lock(res, &shard->lock);
+
+	if (wt->prev)
+		wt->prev->next = wt->next;
+	else
+		shard->head = wt->next;
+	if (wt->next)
+		wt->next->prev = wt->prev;
+	wt->prev = wt->next = NULL;
+
+	opae_mutex_unlock(res, &shard->lock);
+}
+
 opae_wrapped_token *
 opae_allocate_wrapped_token(fpga_token token,
 			    const opae_api_adapter_table *adapter)
@@ -89,11 +151,12 @@ opae_allocate_wrapped_token(fpga_token token,
 	if (wtok) {
 		wtok->magic = OPAE_WRAPPED_TOKEN_MAGIC;
 		wtok->opae_token = token;
-		wtok->ref_count = 0;
+		wtok->ref_count = 1;
 		wtok->prev = wtok->next = NULL;
 		wtok->adapter_table = (opae_api_adapter_table *)adapter;
 
-		opae_upref_wrapped_token(wtok);
+		OPAE_DBG("token ref count begin %p", wtok);
+		opae_register_wrapped_token(wtok);
 	}
 
 	return wtok;
@@ -101,39 +164,44 @@ opae_allocate_wrapped_token(fpga_token token,
 
 void opae_upref_wrapped_token(opae_wrapped_token *wt)
 {
-	int res;
-
-	opae_mutex_lock(res, &token_list_lock);
+#ifdef LIBOPAE_DEBUG
+	uint32_t count =
+#endif // LIBOPAE_DEBUG
+	__atomic_add_fetch(&wt->ref_count, 1, __ATOMIC_RELAXED);
 
-	++wt->ref_count;
-	if (wt->ref_count == 1) {
-		OPAE_DBG("token ref count begin %p", wt);
-		wt->prev = &token_list_head;
-		wt->next = token_list_head.next;
-		token_list_head.next->prev = wt;
-		token_list_head.next = wt;
-	}
 #ifdef LIBOPAE_DEBUG
-	else {
-		OPAE_DBG("token ref count up %p, %u", wt, wt->ref_count);
-	}
+	OPAE_DBG("token ref count up %p, %u", wt, count);
 #endif // LIBOPAE_DEBUG
+}
+
+/*
+ * Take a reference only if the token is still live. Used when the
+ * caller found wt through the registry rather than owning a reference.
+ */
+STATIC bool opae_tryref_wrapped_token(opae_wrapped_token *wt)
+{
+	uint32_t count = __atomic_load_n(&wt->ref_count, __ATOMIC_RELAXED);
+
+	do {
+		if (!count)
+			return false;
+	} while (!__atomic_compare_exchange_n(&wt->ref_count, &count,
+					      count + 1, true,
+					      __ATOMIC_ACQUIRE,
+					      __ATOMIC_RELAXED));
 
-	opae_mutex_unlock(res, &token_list_lock);
+	return true;
 }
 
 fpga_result opae_downref_wrapped_token(opae_wrapped_token *wt)
 {
-	int res;
+	uint32_t count;
 	fpga_result fres = FPGA_OK;
 
-	opae_mutex_lock(res, &token_list_lock);
-
-	--wt->ref_count;
-	if (wt->ref_count == 0) {
+	count = __atomic_sub_fetch(&wt->ref_count, 1, __ATOMIC_ACQ_REL);
+	if (count == 0) {
 		OPAE_DBG("token ref count end %p", wt);
-		wt->prev->next = wt->next;
-		wt->next->prev = wt->prev;
+		opae_unregister_wrapped_token(wt);
 		wt->magic = 0;
 
 		if (wt->adapter_table->fpgaDestroyToken)
@@ -143,21 +211,13 @@ fpga_result opae_downref_wrapped_token(opae_wrapped_token *wt)
 			fres = FPGA_NOT_SUPPORTED;
 
 		opae_free(wt);
-
-#ifdef LIBOPAE_DEBUG
-		if ((token_list_head.prev == &token_list_head) &&
-		    (token_list_head.next == &token_list_head)) {
-			OPAE_DBG("token ref count CLEAN HERE");
-		}
-#endif // LIBOPAE_DEBUG
 	}
 #ifdef LIBOPAE_DEBUG
 	else {
-		OPAE_DBG("token ref count down %p, %u", wt, wt->ref_count);
+		OPAE_DBG("token ref count down %p, %u", wt, count);
 	}
 #endif // LIBOPAE_DEBUG
 
-	opae_mutex_unlock(res, &token_list_lock);
 	return fres;
 }
 
@@ -167,18 +227,23 @@ uint32_t opae_wrapped_tokens_in_use(void)
 	int res;
 	uint32_t count = 0;
 	opae_wrapped_token *wt;
+	size_t i;
+
+	for (i = 0 ; i < OPAE_TOKEN_REGISTRY_SHARDS ; ++i) {
+		opae_token_shard *shard = &token_registry[i];
 
-	opae_mutex_lock(res, &token_list_lock);
+		opae_mutex_lock(res, &shard->lock);
+
+		for (wt = shard->head ; wt ; wt = wt->next) {
+			++count;
+			OPAE_DBG("token ref count %p, %u LEAKED",
+				 wt, __atomic_load_n(&wt->ref_count,
+						     __ATOMIC_RELAXED));
+		}
 
-	for (wt = token_list_head.next ;
-		wt != &token_list_head ;
-		    wt = wt->next) {
-		++count;
-		OPAE_DBG("token ref count %p, %u LEAKED",
-			 wt, wt->ref_count);
+		opae_mutex_unlock(res, &shard->lock);
 	}
 
-	opae_mutex_unlock(res, &token_list_lock);
 	return count;
 }
 #endif // LIBOPAE_DEBUG
@@ -195,6 +260,7 @@ opae_allocate_wrapped_handle(opae_wrapped_token *wt, fpga_handle opae_handle,
 		whan->wrapped_token = wt;
 		whan->opae_handle = opae_handle;
 		whan->adapter_table = adapter;
+		whan->buf_pool = NULL;
 
 		opae_upref_wrapped_token(wt);
 	}
@@ -270,6 +336,175 @@ fpga_result __OPAE_API__ fpgaFinalize(void)
 					      : FPGA_OK;
 }
 
+STATIC opae_buf_pool *opae_buf_pool_create(void)
+{
+	opae_buf_pool *pool;
+	char *s;
+
+	pool = (opae_buf_pool *)opae_calloc(1, sizeof(opae_buf_pool));
+	if (!pool)
+		return NULL;
+
+	if (pthread_mutex_init(&pool->lock, NULL)) {
+		OPAE_ERR("pthread_mutex_init() failed");
+		opae_free(pool);
+		return NULL;
+	}
+
+	pool->high_water = OPAE_BUF_POOL_DEFAULT_MAX;
+
+	s = getenv("LIBOPAE_BUF_POOL_MAX");
+	if (s) {
+		char *endptr = NULL;
+		uint64_t max = strtoull(s, &endptr, 0);
+
+		if (endptr && *endptr == '\0')
+			pool->high_water = max;
+		else
+			OPAE_ERR("invalid LIBOPAE_BUF_POOL_MAX: %s", s);
+	}
+
+	return pool;
+}
+
+STATIC void opae_buf_pool_destroy(opae_wrapped_handle *wh)
+{
+	opae_buf_pool *pool = wh->buf_pool;
+	opae_buf_pool_entry *e;
+	opae_buf_pool_entry *next;
+	uint32_t i;
+
+	for (i = 0 ; i < OPAE_BUF_POOL_CLASSES ; ++i) {
+		for (e = pool->free[i] ; e ; e = next) {
+			next = e->next;
+			if (wh->adapter_table->fpgaReleaseBuffer(
+				wh->opae_handle, e->wsid) != FPGA_OK)
+				OPAE_ERR("failed to release pooled buffer");
+			opae_free(e);
+		}
+	}
+
+	// Buffers still in use are released by the plugin's fpgaClose.
+	for (e = pool->busy ; e ; e = next) {
+		next = e->next;
+		opae_free(e);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	opae_free(pool);
+	wh->buf_pool = NULL;
+}
+
+STATIC uint32_t opae_buf_pool_class(uint64_t len)
+{
+	return 63 - __builtin_clzll(len);
+}
+
+STATIC uint64_t opae_buf_pool_len(uint64_t len)
+{
+	uint64_t pg_size = (uint64_t)sysconf(_SC_PAGE_SIZE);
+
+	return (len + pg_size - 1) & ~(pg_size - 1);
+}
+
+/*
+ * Take an idle buffer of at least len bytes with matching access
+ * flags from the pool, moving it to the busy list.
+ */
+STATIC bool opae_buf_pool_get(opae_buf_pool *pool, uint64_t len,
+			      int flags, void **buf_addr, uint64_t *wsid)
+{
+	opae_buf_pool_entry **pe;
+	opae_buf_pool_entry *e = NULL;
+	int err;
+
+	len = opae_buf_pool_len(len);
+
+	opae_mutex_lock(err, &pool->lock);
+
+	for (pe = &pool->free[opae_buf_pool_class(len)] ; *pe ;
+	     pe = &(*pe)->next) {
+		if (((*pe)->flags & FPGA_BUF_READ_ONLY) ==
+		    (flags & FPGA_BUF_READ_ONLY) &&
+		    (*pe)->len >= len) {
+			e = *pe;
+			*pe = e->next;
+			pool->cached -= e->len;
+			e->next = pool->busy;
+			pool->busy = e;
+			*buf_addr = e->addr;
+			*wsid = e->wsid;
+			break;
+		}
+	}
+
+	opae_mutex_unlock(err, &pool->lock);
+
+	return e != NULL;
+}
+
+STATIC void opae_buf_pool_track(opae_buf_pool *pool, uint64_t len,
+				int flags, void *buf_addr, uint64_t wsid)
+{
+	opae_buf_pool_entry *e;
+	int err;
+
+	// On failure the buffer simply bypasses the pool.
+	e = (opae_buf_pool_entry *)opae_malloc(sizeof(opae_buf_pool_entry));
+	if (!e)
+		return;
+
+	e->wsid = wsid;
+	e->addr = buf_addr;
+	e->len = opae_buf_pool_len(len);
+	e->flags = flags;
+
+	opae_mutex_lock(err, &pool->lock);
+	e->next = pool->busy;
+	pool->busy = e;
+	opae_mutex_unlock(err, &pool->lock);
+}
+
+/*
+ * Return a buffer to its free list, keeping it pinned and mapped.
+ * Returns false when the buffer is not tracked by the pool or the
+ * pool is at its high-water mark; the caller releases it then.
+ */
+STATIC bool opae_buf_pool_put(opae_buf_pool *pool, uint64_t wsid)
+{
+	opae_buf_pool_entry **pe;
+	opae_buf_pool_entry *e = NULL;
+	bool kept = false;
+	int err;
+
+	opae_mutex_lock(err, &pool->lock);
+
+	for (pe = &pool->busy ; *pe ; pe = &(*pe)->next) {
+		if ((*pe)->wsid == wsid) {
+			e = *pe;
+			*pe = e->next;
+			break;
+		}
+	}
+
+	if (e) {
+		if (pool->cached + e->len <= pool->high_water) {
+			uint32_t c = opae_buf_pool_class(e->len);
+
+			e->next = pool->free[c];
+			pool->free[c] = e;
+			pool->cached += e->len;
+			kept = true;
+		} else {
+			opae_free(e);
+		}
+	}
+
+	opae_mutex_unlock(err, &pool->lock);
+
+	return kept;
+}
+
 fpga_result __OPAE_API__ fpgaOpen(fpga_token token, fpga_handle *handle,
 				  int flags)
 {
@@ -289,7 +524,7 @@ fpga_result __OPAE_API__ fpgaOpen(fpga_token token, fpga_handle *handle,
 			       FPGA_NOT_SUPPORTED);
 
 	res = wrapped_token->adapter_table->fpgaOpen(wrapped_token->opae_token,
-						     &opae_handle, flags);
+					&opae_handle, flags & ~FPGA_OPEN_BUFFER_POOL);
 
 	ASSERT_RESULT(res);
 
@@ -300,6 +535,16 @@ fpga_result __OPAE_API__ fpgaOpen(fpga_token token, fpga_handle *handle,
 		OPAE_ERR("malloc failed");
 		res = FPGA_NO_MEMORY;
 		cres = wrapped_token->adapter_table->fpgaClose(opae_handle);
+	} else if (flags & FPGA_OPEN_BUFFER_POOL) {
+		wrapped_handle->buf_pool = opae_buf_pool_create();
+		if (!wrapped_handle->buf_pool) {
+			OPAE_ERR("failed to create buffer pool");
+			res = FPGA_NO_MEMORY;
+			cres = wrapped_token->adapter_table->fpgaClose(
+					opae_handle);
+			opae_destroy_wrapped_handle(wrapped_handle);
+			wrapped_handle = NULL;
+		}
 	}
 
 	*handle = wrapped_handle;
@@ -317,6 +562,9 @@ fpga_result __OPAE_API__ fpgaClose(fpga_handle handle)
 	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaClose,
 			       FPGA_NOT_SUPPORTED);
 
+	if (wrapped_handle->buf_pool)
+		opae_buf_pool_destroy(wrapped_handle);
+
 	res = wrapped_handle->adapter_table->fpgaClose(
 		wrapped_handle->opae_handle);
 
@@ -346,26 +594,29 @@ opae_get_parent_token(opae_wrapped_token *child)
 	opae_wrapped_token *parent = NULL;
 	fpga_token_header *child_hdr;
 	fpga_token_header *parent_hdr;
+	size_t i;
 
 	child_hdr = (fpga_token_header *)child->opae_token;
 
-	if (opae_mutex_lock(mres, &token_list_lock))
-		return NULL;
+	for (i = 0 ; !parent && i < OPAE_TOKEN_REGISTRY_SHARDS ; ++i) {
+		opae_token_shard *shard = &token_registry[i];
 
-	for (p = token_list_head.next ;
-		p != &token_list_head ;
-		    p = p->next) {
+		if (opae_mutex_lock(mres, &shard->lock))
+			return NULL;
 
-		parent_hdr = (fpga_token_header *)p->opae_token;
+		for (p = shard->head ; p ; p = p->next) {
 
-		if (fpga_is_parent_child(parent_hdr, child_hdr)) {
-			parent = p;
-			opae_upref_wrapped_token(parent);
-			break;
+			parent_hdr = (fpga_token_header *)p->opae_token;
+
+			if (fpga_is_parent_child(parent_hdr, child_hdr) &&
+			    opae_tryref_wrapped_token(p)) {
+				parent = p;
+				break;
+			}
 		}
-	}
 
-	opae_mutex_unlock(mres, &token_list_lock);
+		opae_mutex_unlock(mres, &shard->lock);
+	}
 
 	return parent;
 }
@@ -602,6 +853,118 @@ fpga_result __OPAE_API__ fpgaUnmapMMIO(fpga_handle handle, uint32_t mmio_num)
 		wrapped_handle->opae_handle, mmio_num);
 }
 
+STATIC fpga_result opae_check_mmio_vec(const fpga_mmio_vec *vec,
+				       uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0 ; i < count ; ++i) {
+		if ((vec[i].width != 32) && (vec[i].width != 64)) {
+			OPAE_ERR("invalid MMIO width %u in entry %u",
+				 vec[i].width, i);
+			return FPGA_INVALID_PARAM;
+		}
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result __OPAE_API__ fpgaReadMMIOv(fpga_handle handle, uint32_t mmio_num,
+				       fpga_mmio_vec *vec, uint32_t count)
+{
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(handle);
+	opae_api_adapter_table *adapter;
+	fpga_result res;
+	uint32_t value32;
+	uint32_t i;
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	ASSERT_NOT_NULL(vec);
+
+	adapter = wrapped_handle->adapter_table;
+
+	if (adapter->fpgaReadMMIOv)
+		return adapter->fpgaReadMMIOv(wrapped_handle->opae_handle,
+					      mmio_num, vec, count);
+
+	// The plugin has no batch entry point, so issue single accesses.
+	ASSERT_NOT_NULL_RESULT(adapter->fpgaReadMMIO32, FPGA_NOT_SUPPORTED);
+	ASSERT_NOT_NULL_RESULT(adapter->fpgaReadMMIO64, FPGA_NOT_SUPPORTED);
+
+	res = opae_check_mmio_vec(vec, count);
+	if (res)
+		return res;
+
+	for (i = 0 ; i < count ; ++i) {
+		if (vec[i].flags & FPGA_MMIO_FENCE)
+			__sync_synchronize();
+
+		if (vec[i].width == 32) {
+			res = adapter->fpgaReadMMIO32(
+				wrapped_handle->opae_handle, mmio_num,
+				vec[i].offset, &value32);
+			vec[i].value = value32;
+		} else {
+			res = adapter->fpgaReadMMIO64(
+				wrapped_handle->opae_handle, mmio_num,
+				vec[i].offset, &vec[i].value);
+		}
+
+		if (res)
+			return res;
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result __OPAE_API__ fpgaWriteMMIOv(fpga_handle handle, uint32_t mmio_num,
+					const fpga_mmio_vec *vec,
+					uint32_t count)
+{
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(handle);
+	opae_api_adapter_table *adapter;
+	fpga_result res;
+	uint32_t i;
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	ASSERT_NOT_NULL(vec);
+
+	adapter = wrapped_handle->adapter_table;
+
+	if (adapter->fpgaWriteMMIOv)
+		return adapter->fpgaWriteMMIOv(wrapped_handle->opae_handle,
+					       mmio_num, vec, count);
+
+	// The plugin has no batch entry point, so issue single accesses.
+	ASSERT_NOT_NULL_RESULT(adapter->fpgaWriteMMIO32, FPGA_NOT_SUPPORTED);
+	ASSERT_NOT_NULL_RESULT(adapter->fpgaWriteMMIO64, FPGA_NOT_SUPPORTED);
+
+	res = opae_check_mmio_vec(vec, count);
+	if (res)
+		return res;
+
+	for (i = 0 ; i < count ; ++i) {
+		if (vec[i].flags & FPGA_MMIO_FENCE)
+			__sync_synchronize();
+
+		if (vec[i].width == 32)
+			res = adapter->fpgaWriteMMIO32(
+				wrapped_handle->opae_handle, mmio_num,
+				vec[i].offset, (uint32_t)vec[i].value);
+		else
+			res = adapter->fpgaWriteMMIO64(
+				wrapped_handle->opae_handle, mmio_num,
+				vec[i].offset, vec[i].value);
+
+		if (res)
+			return res;
+	}
+
+	return FPGA_OK;
+}
+
 typedef struct _opae_enumeration_context {
 	// <verbatim from fpgaEnumerate>
 	const fpga_properties *filters;
@@ -907,6 +1270,8 @@ fpga_result __OPAE_API__ fpgaPrepareBuffer(fpga_handle handle,
 {
 	opae_wrapped_handle *wrapped_handle =
 		opae_validate_wrapped_handle(handle);
+	bool pooled;
+	fpga_result res;
 
 	// A special case: allow each plugin to respond FPGA_OK
 	// when !buf_addr and !len as an indication that
@@ -921,8 +1286,22 @@ fpga_result __OPAE_API__ fpgaPrepareBuffer(fpga_handle handle,
 	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaPrepareBuffer,
 			       FPGA_NOT_SUPPORTED);
 
-	return wrapped_handle->adapter_table->fpgaPrepareBuffer(
-		wrapped_handle->opae_handle, len, buf_addr, wsid, flags);
+	pooled = wrapped_handle->buf_pool && (len > 0) &&
+		 !(flags & (FPGA_BUF_PREALLOCATED | FPGA_BUF_NO_POOL));
+
+	if (pooled && opae_buf_pool_get(wrapped_handle->buf_pool,
+					len, flags, buf_addr, wsid))
+		return FPGA_OK;
+
+	res = wrapped_handle->adapter_table->fpgaPrepareBuffer(
+		wrapped_handle->opae_handle, len, buf_addr, wsid,
+		flags & ~FPGA_BUF_NO_POOL);
+
+	if (pooled && (res == FPGA_OK))
+		opae_buf_pool_track(wrapped_handle->buf_pool,
+				    len, flags, *buf_addr, *wsid);
+
+	return res;
 }
 
 fpga_result __OPAE_API__ fpgaReleaseBuffer(fpga_handle handle, uint64_t wsid)
@@ -934,6 +1313,10 @@ fpga_result __OPAE_API__ fpgaReleaseBuffer(fpga_handle handle, uint64_t wsid)
 	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaReleaseBuffer,
 			       FPGA_NOT_SUPPORTED);
 
+	if (wrapped_handle->buf_pool &&
+	    opae_buf_pool_put(wrapped_handle->buf_pool, wsid))
+		return FPGA_OK;
+
 	return wrapped_handle->adapter_table->fpgaReleaseBuffer(
 		wrapped_handle->opae_handle, wsid);
 }
@@ -1327,6 +1710,251 @@ fpga_result __OPAE_API__ fpgaReconfigureSlot(fpga_handle fpga, uint32_t slot,
 		flags);
 }
 
+//                              o c e r
+#define OPAE_RECONF_OP_MAGIC 0x6f636572
+
+/*
+ * An asynchronous reconfiguration runs the plugin's reconfigure entry
+ * point on its own thread. The worker publishes the current phase and
+ * byte counts under op->lock; op->done is set, and op->cond broadcast,
+ * only after the final progress callback has returned, so a caller
+ * that has waited for completion may safely release its context.
+ */
+typedef struct _opae_reconf_op {
+	uint32_t magic;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	opae_wrapped_handle *wrapped_handle;
+	uint32_t slot;
+	const uint8_t *bitstream;
+	size_t bitstream_len;
+	int flags;
+	fpga_reconf_progress_cb progress;
+	void *context;
+	enum fpga_reconf_phase phase;
+	size_t bytes_written;
+	size_t bytes_total;
+	fpga_result result;
+	bool done;
+} opae_reconf_op;
+
+STATIC opae_reconf_op *opae_validate_reconf_op(fpga_reconf_op op)
+{
+	opae_reconf_op *rop;
+	if (!op)
+		return NULL;
+	rop = (opae_reconf_op *)op;
+	return (rop->magic == OPAE_RECONF_OP_MAGIC) ? rop : NULL;
+}
+
+STATIC void opae_reconf_progress(enum fpga_reconf_phase phase,
+				 size_t bytes_written,
+				 size_t bytes_total,
+				 void *context)
+{
+	opae_reconf_op *op = (opae_reconf_op *)context;
+	int res;
+
+	opae_mutex_lock(res, &op->lock);
+	op->phase = phase;
+	op->bytes_written = bytes_written;
+	op->bytes_total = bytes_total;
+	opae_mutex_unlock(res, &op->lock);
+
+	if (op->progress)
+		op->progress(phase, bytes_written, bytes_total, op->context);
+}
+
+STATIC void *opae_reconf_worker(void *arg)
+{
+	opae_reconf_op *op = (opae_reconf_op *)arg;
+	opae_api_adapter_table *adapter = op->wrapped_handle->adapter_table;
+	fpga_result result;
+	size_t written;
+	size_t total;
+	int res;
+
+	if (adapter->fpgaReconfigureSlotProgress) {
+		result = adapter->fpgaReconfigureSlotProgress(
+			op->wrapped_handle->opae_handle, op->slot,
+			op->bitstream, op->bitstream_len, op->flags,
+			opae_reconf_progress, op);
+	} else {
+		// The plugin reports no phases of its own.
+		opae_reconf_progress(FPGA_RECONF_PHASE_PROGRAM, 0, 0, op);
+		result = adapter->fpgaReconfigureSlot(
+			op->wrapped_handle->opae_handle, op->slot,
+			op->bitstream, op->bitstream_len, op->flags);
+	}
+
+	opae_mutex_lock(res, &op->lock);
+	op->result = result;
+	written = op->bytes_written;
+	total = op->bytes_total;
+	opae_mutex_unlock(res, &op->lock);
+
+	opae_reconf_progress(FPGA_RECONF_PHASE_DONE, written, total, op);
+
+	opae_mutex_lock(res, &op->lock);
+	op->done = true;
+	pthread_cond_broadcast(&op->cond);
+	opae_mutex_unlock(res, &op->lock);
+
+	return NULL;
+}
+
+fpga_result __OPAE_API__
+fpgaReconfigureSlotAsync(fpga_handle fpga,
+			 uint32_t slot,
+			 const uint8_t *bitstream,
+			 size_t bitstream_len,
+			 int flags,
+			 fpga_reconf_progress_cb progress,
+			 void *context,
+			 fpga_reconf_op *op)
+{
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(fpga);
+	pthread_condattr_t attr;
+	opae_reconf_op *rop;
+	int res;
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	ASSERT_NOT_NULL(bitstream);
+	ASSERT_NOT_NULL(op);
+	ASSERT_NOT_NULL_RESULT(
+		wrapped_handle->adapter_table->fpgaReconfigureSlot,
+		FPGA_NOT_SUPPORTED);
+
+	rop = (opae_reconf_op *)opae_calloc(1, sizeof(opae_reconf_op));
+	if (!rop) {
+		OPAE_ERR("calloc failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	rop->magic = OPAE_RECONF_OP_MAGIC;
+	rop->wrapped_handle = wrapped_handle;
+	rop->slot = slot;
+	rop->bitstream = bitstream;
+	rop->bitstream_len = bitstream_len;
+	rop->flags = flags;
+	rop->progress = progress;
+	rop->context = context;
+	rop->phase = FPGA_RECONF_PHASE_VALIDATE;
+	rop->result = FPGA_OK;
+
+	pthread_mutex_init(&rop->lock, NULL);
+
+	// Time out against the monotonic clock, so that fpgaReconfigureWait()
+	// is not affected by changes to the wall clock.
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&rop->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	res = pthread_create(&rop->thread, NULL, opae_reconf_worker, rop);
+	if (res) {
+		OPAE_ERR("pthread_create() failed: %s", strerror(res));
+		pthread_cond_destroy(&rop->cond);
+		pthread_mutex_destroy(&rop->lock);
+		opae_free(rop);
+		return FPGA_EXCEPTION;
+	}
+
+	*op = rop;
+	return FPGA_OK;
+}
+
+fpga_result __OPAE_API__ fpgaReconfigurePoll(fpga_reconf_op op,
+					     enum fpga_reconf_phase *phase,
+					     size_t *bytes_written,
+					     fpga_result *result)
+{
+	opae_reconf_op *rop = opae_validate_reconf_op(op);
+	bool done;
+	int res;
+
+	ASSERT_NOT_NULL(rop);
+
+	opae_mutex_lock(res, &rop->lock);
+
+	done = rop->done;
+	if (phase)
+		*phase = rop->phase;
+	if (bytes_written)
+		*bytes_written = rop->bytes_written;
+	if (result && done)
+		*result = rop->result;
+
+	opae_mutex_unlock(res, &rop->lock);
+
+	return done ? FPGA_OK : FPGA_BUSY;
+}
+
+fpga_result __OPAE_API__ fpgaReconfigureWait(fpga_reconf_op op,
+					     int timeout_ms,
+					     fpga_result *result)
+{
+	opae_reconf_op *rop = opae_validate_reconf_op(op);
+	struct timespec deadline;
+	bool done;
+	int res;
+
+	ASSERT_NOT_NULL(rop);
+
+	if (timeout_ms > 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout_ms / 1000;
+		deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			++deadline.tv_sec;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+
+	opae_mutex_lock(res, &rop->lock);
+
+	while (!rop->done && timeout_ms) {
+		if (timeout_ms < 0) {
+			pthread_cond_wait(&rop->cond, &rop->lock);
+		} else if (pthread_cond_timedwait(&rop->cond, &rop->lock,
+						  &deadline) == ETIMEDOUT) {
+			break;
+		}
+	}
+
+	done = rop->done;
+	if (result && done)
+		*result = rop->result;
+
+	opae_mutex_unlock(res, &rop->lock);
+
+	return done ? FPGA_OK : FPGA_BUSY;
+}
+
+fpga_result __OPAE_API__ fpgaReconfigureDestroy(fpga_reconf_op *op)
+{
+	opae_reconf_op *rop;
+	int res;
+
+	ASSERT_NOT_NULL(op);
+	rop = opae_validate_reconf_op(*op);
+	ASSERT_NOT_NULL(rop);
+
+	res = pthread_join(rop->thread, NULL);
+	if (res)
+		OPAE_ERR("pthread_join() failed: %s", strerror(res));
+
+	rop->magic = 0;
+	pthread_cond_destroy(&rop->cond);
+	pthread_mutex_destroy(&rop->lock);
+	opae_free(rop);
+
+	*op = NULL;
+	return FPGA_OK;
+}
+
 fpga_result __OPAE_API__ fpgaTokenGetObject(fpga_token token, const char *name,
 			       fpga_object *object, int flags)
 {
@@ -1668,6 +2296,24 @@ fpga_result __OPAE_API__ fpgaGetMetricsByName(fpga_handle handle,
 		wrapped_handle->opae_handle, metrics_names, num_metric_names, metrics);
 }
 
+fpga_result __OPAE_API__ fpgaGetMetricsSnapshot(fpga_handle handle,
+				fpga_metric *metrics,
+				uint64_t *num_metrics,
+				uint64_t *timestamp_ns)
+{
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(handle);
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	ASSERT_NOT_NULL(num_metrics);
+
+	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaGetMetricsSnapshot,
+			   FPGA_NOT_SUPPORTED);
+
+	return wrapped_handle->adapter_table->fpgaGetMetricsSnapshot(
+		wrapped_handle->opae_handle, metrics, num_metrics, timestamp_ns);
+}
+
 fpga_result __OPAE_API__ fpgaGetMetricsThresholdInfo(fpga_handle handle,
 	metric_threshold *metric_thresholds,
 	uint32_t *num_thresholds)
@@ -30,6 +30,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <pwd.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <linux/limits.h>
 #include <opae/log.h>
 #include "opae_int.h"
@@ -363,6 +365,219 @@ void opae_free_libopae_config(libopae_config_data *cfg)
 	opae_free(base);
 }
 
+/*
+ * Binary libopae config cache
+ *
+ * header, config file path, one record per table entry, string blob.
+ * The cache is valid only while the config file's path, size, inode
+ * and mtime match the ones recorded in the header.
+ */
+#define OPAE_CFG_CACHE_MAGIC   0x6366636f // ocfc
+#define OPAE_CFG_CACHE_VERSION 1
+
+typedef struct _opae_cfg_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t cfg_size;
+	uint64_t cfg_ino;
+	int64_t cfg_mtime_sec;
+	int64_t cfg_mtime_nsec;
+	uint32_t path_len;
+	uint32_t num_entries;
+	uint32_t strings_len;
+	uint32_t reserved;
+} opae_cfg_cache_header;
+
+typedef struct _opae_cfg_cache_entry {
+	uint16_t vendor_id;
+	uint16_t device_id;
+	uint16_t subsystem_vendor_id;
+	uint16_t subsystem_device_id;
+	uint32_t module_library;
+	uint32_t config_json;
+} opae_cfg_cache_entry;
+
+STATIC int opae_cfg_cache_stamp(const char *cfgfile,
+				opae_cfg_cache_header *hdr)
+{
+	struct stat st;
+
+	if (opae_stat(cfgfile, &st))
+		return 1;
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = OPAE_CFG_CACHE_MAGIC;
+	hdr->version = OPAE_CFG_CACHE_VERSION;
+	hdr->cfg_size = st.st_size;
+	hdr->cfg_ino = st.st_ino;
+	hdr->cfg_mtime_sec = st.st_mtim.tv_sec;
+	hdr->cfg_mtime_nsec = st.st_mtim.tv_nsec;
+	hdr->path_len = strlen(cfgfile);
+
+	return 0;
+}
+
+libopae_config_data *
+opae_load_libopae_config_cache(const char *cache_file, const char *cfgfile)
+{
+	FILE *fp;
+	opae_cfg_cache_header expect;
+	opae_cfg_cache_header hdr;
+	opae_cfg_cache_entry *entries = NULL;
+	char *path = NULL;
+	char *strings = NULL;
+	libopae_config_data *cfg = NULL;
+	uint32_t i;
+
+	if (opae_cfg_cache_stamp(cfgfile, &expect))
+		return NULL;
+
+	fp = opae_fopen(cache_file, "rb");
+	if (!fp)
+		return NULL;
+
+	if ((fread(&hdr, sizeof(hdr), 1, fp) != 1) ||
+	    (hdr.magic != expect.magic) ||
+	    (hdr.version != expect.version) ||
+	    (hdr.cfg_size != expect.cfg_size) ||
+	    (hdr.cfg_ino != expect.cfg_ino) ||
+	    (hdr.cfg_mtime_sec != expect.cfg_mtime_sec) ||
+	    (hdr.cfg_mtime_nsec != expect.cfg_mtime_nsec) ||
+	    (hdr.path_len != expect.path_len) ||
+	    !hdr.strings_len)
+		goto out_close;
+
+	path = opae_malloc(hdr.path_len + 1);
+	entries = opae_calloc(hdr.num_entries + 1, sizeof(*entries));
+	strings = opae_malloc(hdr.strings_len);
+	if (!path || !entries || !strings)
+		goto out_free;
+
+	if ((fread(path, 1, hdr.path_len, fp) != hdr.path_len) ||
+	    memcmp(path, cfgfile, hdr.path_len) ||
+	    (fread(entries, sizeof(*entries), hdr.num_entries, fp) !=
+		hdr.num_entries) ||
+	    (fread(strings, 1, hdr.strings_len, fp) != hdr.strings_len) ||
+	    strings[hdr.strings_len - 1])
+		goto out_free;
+
+	cfg = opae_calloc(hdr.num_entries + 1, sizeof(libopae_config_data));
+	if (!cfg)
+		goto out_free;
+
+	for (i = 0 ; i < hdr.num_entries ; ++i) {
+		if ((entries[i].module_library >= hdr.strings_len) ||
+		    (entries[i].config_json >= hdr.strings_len))
+			goto out_corrupt;
+
+		cfg[i].vendor_id = entries[i].vendor_id;
+		cfg[i].device_id = entries[i].device_id;
+		cfg[i].subsystem_vendor_id = entries[i].subsystem_vendor_id;
+		cfg[i].subsystem_device_id = entries[i].subsystem_device_id;
+		cfg[i].module_library =
+			opae_strdup(strings + entries[i].module_library);
+		cfg[i].config_json =
+			opae_strdup(strings + entries[i].config_json);
+
+		if (!cfg[i].module_library || !cfg[i].config_json)
+			goto out_corrupt;
+	}
+
+	goto out_free;
+
+out_corrupt:
+	opae_free_libopae_config(cfg);
+	cfg = NULL;
+out_free:
+	opae_free(strings);
+	opae_free(entries);
+	opae_free(path);
+out_close:
+	opae_fclose(fp);
+	return cfg;
+}
+
+int opae_save_libopae_config_cache(const char *cache_file,
+				   const char *cfgfile,
+				   const libopae_config_data *cfg)
+{
+	char tmp_file[PATH_MAX];
+	opae_cfg_cache_header hdr;
+	opae_cfg_cache_entry entry;
+	const libopae_config_data *c;
+	uint32_t offset = 0;
+	FILE *fp;
+	int res = 1;
+
+	// The built-in table is what a failed parse returns;
+	// don't let a cache pin it.
+	if (cfg == default_libopae_config_table)
+		return 1;
+
+	if (opae_cfg_cache_stamp(cfgfile, &hdr))
+		return 1;
+
+	for (c = cfg ; c->module_library ; ++c) {
+		hdr.strings_len += strlen(c->module_library) + 1 +
+				   strlen(c->config_json) + 1;
+		++hdr.num_entries;
+	}
+
+	if (!hdr.num_entries)
+		return 1;
+
+	// Write a private file, then rename it into place, so that
+	// concurrent readers never see a partial cache.
+	if (snprintf(tmp_file, sizeof(tmp_file), "%s.%d",
+		     cache_file, (int)getpid()) >= (int)sizeof(tmp_file))
+		return 1;
+
+	fp = opae_fopen(tmp_file, "wb");
+	if (!fp)
+		return 1;
+
+	if ((fwrite(&hdr, sizeof(hdr), 1, fp) != 1) ||
+	    (fwrite(cfgfile, 1, hdr.path_len, fp) != hdr.path_len))
+		goto out_close;
+
+	for (c = cfg ; c->module_library ; ++c) {
+		entry.vendor_id = c->vendor_id;
+		entry.device_id = c->device_id;
+		entry.subsystem_vendor_id = c->subsystem_vendor_id;
+		entry.subsystem_device_id = c->subsystem_device_id;
+		entry.module_library = offset;
+		offset += strlen(c->module_library) + 1;
+		entry.config_json = offset;
+		offset += strlen(c->config_json) + 1;
+
+		if (fwrite(&entry, sizeof(entry), 1, fp) != 1)
+			goto out_close;
+	}
+
+	for (c = cfg ; c->module_library ; ++c) {
+		if ((fwrite(c->module_library, 1,
+			    strlen(c->module_library) + 1, fp) !=
+				strlen(c->module_library) + 1) ||
+		    (fwrite(c->config_json, 1,
+			    strlen(c->config_json) + 1, fp) !=
+				strlen(c->config_json) + 1))
+			goto out_close;
+	}
+
+	res = 0;
+
+out_close:
+	if (opae_fclose(fp))
+		res = 1;
+	if (!res && rename(tmp_file, cache_file))
+		res = 1;
+	if (res) {
+		OPAE_DBG("failed to write config cache %s", cache_file);
+		unlink(tmp_file);
+	}
+	return res;
+}
+
 
 STATIC fpgainfo_config_data default_fpgainfo_config_table[] = {
 	{ 0x8086, 0x09c4, 0x8086, 0x0, OPAE_FEATURE_ID_ANY, "libboard_a10gx.so", NULL,
@@ -87,6 +87,20 @@ void opae_print_libopae_config(libopae_config_data *cfg);
 
 void opae_free_libopae_config(libopae_config_data *cfg);
 
+// Load a config table previously written by opae_save_libopae_config_cache()
+// for cfgfile. Returns NULL if the cache is missing, corrupt, or stale
+// (cfgfile changed since the cache was written). Free the result with
+// opae_free_libopae_config().
+libopae_config_data *
+opae_load_libopae_config_cache(const char *cache_file, const char *cfgfile);
+
+// Write cfg, parsed from cfgfile, to cache_file in binary form.
+// The built-in default table is never cached.
+// return: non-zero on failure.
+int opae_save_libopae_config_cache(const char *cache_file,
+				   const char *cfgfile,
+				   const libopae_config_data *cfg);
+
 
 #define OPAE_FEATURE_ID_ANY -1
 typedef struct _fpgainfo_config_data {
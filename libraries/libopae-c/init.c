@@ -45,6 +45,7 @@
 #include <opae/utils.h>
 #include "pluginmgr.h"
 #include "opae_int.h"
+#include "log-async.h"
 #include "mock/opae_std.h"
 
 /* global loglevel */
@@ -77,6 +78,12 @@ void opae_print(int loglevel, const char *fmt, ...)
 	if (loglevel > g_loglevel)
 		return;
 
+	va_start(argp, fmt);
+	err = opae_log_async_vprint(loglevel, fmt, argp);
+	va_end(argp);
+	if (!err)
+		return;
+
 	if (loglevel == OPAE_LOG_ERROR)
 		fp = stderr;
 	else
@@ -215,6 +222,30 @@ __attribute__((constructor(1000))) STATIC void opae_init(void)
 	if (g_logfile == NULL)
 		g_logfile = stdout;
 
+	s = getenv("LIBOPAE_LOG_MODE");
+	if (s && strcmp(s, "sync")) {
+		int format = -1;
+		uint32_t ratelimit = OPAE_LOG_RL_BURST;
+
+		if (!strcmp(s, "async"))
+			format = OPAE_LOG_FORMAT_TEXT;
+		else if (!strcmp(s, "binary"))
+			format = OPAE_LOG_FORMAT_BINARY;
+		else
+			fprintf(stderr,
+				"WARNING: unknown LIBOPAE_LOG_MODE \"%s\". "
+				"Using sync.\n", s);
+
+		s = getenv("LIBOPAE_LOG_RATELIMIT");
+		if (s)
+			ratelimit = (uint32_t)strtoul(s, NULL, 0);
+
+		if ((format >= 0) &&
+		    opae_log_async_start(format, g_logfile, stderr, ratelimit))
+			fprintf(stderr, "WARNING: failed to start async "
+				"logging. Using sync.\n");
+	}
+
 	with_ase = getenv("WITH_ASE");
 	if (with_ase) {
 		cfg_path = find_ase_cfg();
@@ -224,7 +255,10 @@ __attribute__((constructor(1000))) STATIC void opae_init(void)
 			return;
 		}
 
-		res = fpgaInitialize(cfg_path);
+		// Plugin initialize() routines run on first use; see
+		// opae_plugin_mgr_initialize_deferred().
+		res = opae_plugin_mgr_initialize_deferred(cfg_path) ?
+			FPGA_EXCEPTION : FPGA_OK;
 		if (res != FPGA_OK)
 			OPAE_ERR("fpgaInitialize: %s", fpgaErrStr(res));
 
@@ -233,7 +267,7 @@ __attribute__((constructor(1000))) STATIC void opae_init(void)
 	// If the environment hasn't requested explicit initialization,
 	// perform the initialization implicitly here.
 	else if (getenv("OPAE_EXPLICIT_INITIALIZE") == NULL)
-		fpgaInitialize(NULL);
+		opae_plugin_mgr_initialize_deferred(NULL);
 }
 
 __attribute__((destructor)) STATIC void opae_release(void)
@@ -246,6 +280,8 @@ __attribute__((destructor)) STATIC void opae_release(void)
 	if (res != FPGA_OK)
 		OPAE_ERR("fpgaFinalize: %s", fpgaErrStr(res));
 
+	opae_log_async_stop();
+
 	if (g_logfile != NULL && g_logfile != stdout) {
 		opae_fclose(g_logfile);
 	}
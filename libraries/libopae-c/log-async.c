@@ -0,0 +1,441 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "opae_int.h"
+#include "log-async.h"
+
+#define OPAE_LOG_FLUSH_MIN_NSEC 100000   // 100 usec
+#define OPAE_LOG_FLUSH_MAX_NSEC 10000000 // 10 msec
+
+typedef struct _opae_log_slot {
+	uint64_t timestamp;
+	uint32_t tid;
+	uint16_t level;
+	uint16_t length;
+	char text[OPAE_LOG_MSG_MAX];
+} opae_log_slot;
+
+typedef struct _opae_log_ratelimit {
+	const char *fmt;
+	uint64_t window_start;
+	uint32_t count;
+	uint32_t suppressed;
+	int level;
+} opae_log_ratelimit;
+
+/*
+ * One single-producer/single-consumer ring per logging thread.
+ * The owning thread advances head, the flusher advances tail.
+ * Rings are never freed: when a thread exits its ring is released
+ * (owner = 0) for the next new thread to claim, so the list is
+ * only ever pushed to, and the flusher can walk it without a lock.
+ */
+typedef struct _opae_log_ring {
+	struct _opae_log_ring *next;
+	uint32_t owner;
+	uint64_t head;
+	uint64_t tail;
+	uint64_t dropped;
+	opae_log_ratelimit rl[OPAE_LOG_RL_ENTRIES];
+	opae_log_slot slots[OPAE_LOG_RING_SLOTS];
+} opae_log_ring;
+
+STATIC opae_log_ring *log_rings;
+static __thread opae_log_ring *log_tls_ring;
+static pthread_key_t log_ring_key;
+static pthread_once_t log_ring_key_once = PTHREAD_ONCE_INIT;
+
+STATIC int log_running;
+static int log_stopping;
+static pthread_t log_flusher;
+static int log_format;
+static FILE *log_out;
+static FILE *log_err;
+static uint32_t log_ratelimit;
+static pthread_once_t log_atfork_once = PTHREAD_ONCE_INIT;
+
+static inline uint64_t opae_log_nsec(clockid_t clk)
+{
+	struct timespec ts;
+	clock_gettime(clk, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void opae_log_release_ring(void *arg)
+{
+	opae_log_ring *ring = (opae_log_ring *)arg;
+	__atomic_store_n(&ring->owner, 0, __ATOMIC_RELEASE);
+}
+
+static void opae_log_make_key(void)
+{
+	pthread_key_create(&log_ring_key, opae_log_release_ring);
+}
+
+STATIC opae_log_ring *opae_log_claim_ring(void)
+{
+	opae_log_ring *ring;
+	uint32_t tid = (uint32_t)syscall(SYS_gettid);
+	uint32_t unowned;
+
+	pthread_once(&log_ring_key_once, opae_log_make_key);
+
+	for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE) ;
+	     ring ; ring = ring->next) {
+		unowned = 0;
+		if (__atomic_compare_exchange_n(&ring->owner, &unowned, tid,
+						false, __ATOMIC_ACQ_REL,
+						__ATOMIC_RELAXED)) {
+			memset(ring->rl, 0, sizeof(ring->rl));
+			goto out_set;
+		}
+	}
+
+	ring = opae_calloc(1, sizeof(opae_log_ring));
+	if (!ring)
+		return NULL;
+
+	ring->owner = tid;
+	ring->next = __atomic_load_n(&log_rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&log_rings, &ring->next, ring,
+					    true, __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+		;
+
+out_set:
+	pthread_setspecific(log_ring_key, ring);
+	log_tls_ring = ring;
+	return ring;
+}
+
+// Length of a vsnprintf() result clamped to text, which holds
+// OPAE_LOG_MSG_MAX bytes. A message that did not fit is marked.
+static uint16_t opae_log_fit(char *text, int len)
+{
+	if (len < 0)
+		return 0;
+	if (len < OPAE_LOG_MSG_MAX)
+		return (uint16_t)len;
+	memcpy(text + OPAE_LOG_MSG_MAX - sizeof(OPAE_LOG_TRUNCATED),
+	       OPAE_LOG_TRUNCATED, sizeof(OPAE_LOG_TRUNCATED));
+	return OPAE_LOG_MSG_MAX - 1;
+}
+
+STATIC void opae_log_enqueue(opae_log_ring *ring, int loglevel,
+			     const char *fmt, va_list argp)
+{
+	uint64_t head = ring->head;
+	uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	opae_log_slot *slot;
+	int len;
+
+	if (head - tail >= OPAE_LOG_RING_SLOTS) {
+		__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	slot = &ring->slots[head % OPAE_LOG_RING_SLOTS];
+
+	len = vsnprintf(slot->text, sizeof(slot->text), fmt, argp);
+	slot->length = opae_log_fit(slot->text, len);
+	slot->level = (uint16_t)loglevel;
+	slot->tid = __atomic_load_n(&ring->owner, __ATOMIC_RELAXED);
+	slot->timestamp = opae_log_nsec(CLOCK_REALTIME);
+
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void opae_log_enqueue_fmt(opae_log_ring *ring, int loglevel,
+				 const char *fmt, ...)
+{
+	va_list argp;
+	va_start(argp, fmt);
+	opae_log_enqueue(ring, loglevel, fmt, argp);
+	va_end(argp);
+}
+
+static inline int opae_log_fmt_len(const char *fmt)
+{
+	size_t len = strlen(fmt);
+	if (len && fmt[len - 1] == '\n')
+		--len;
+	return len > 128 ? 128 : (int)len;
+}
+
+// Returns true when this message should be suppressed.
+STATIC bool opae_log_ratelimited(opae_log_ring *ring, int loglevel,
+				 const char *fmt)
+{
+	opae_log_ratelimit *rl;
+	uint64_t now;
+
+	if (!log_ratelimit || loglevel == OPAE_LOG_DEBUG)
+		return false;
+
+	// Call sites are identified by their format string.
+	rl = &ring->rl[((uintptr_t)fmt >> 3) % OPAE_LOG_RL_ENTRIES];
+	now = opae_log_nsec(CLOCK_MONOTONIC);
+
+	if ((rl->fmt != fmt) ||
+	    (now - rl->window_start >= OPAE_LOG_RL_WINDOW_NSEC)) {
+		// Report at the level of the messages suppressed,
+		// not that of the one evicting them.
+		if (rl->suppressed)
+			opae_log_enqueue_fmt(ring, rl->level,
+				"opae_print: suppressed %u message(s) like \"%.*s\"\n",
+				rl->suppressed,
+				opae_log_fmt_len(rl->fmt), rl->fmt);
+		rl->fmt = fmt;
+		rl->level = loglevel;
+		rl->window_start = now;
+		rl->count = 0;
+		rl->suppressed = 0;
+	}
+
+	if (++rl->count > log_ratelimit) {
+		++rl->suppressed;
+		return true;
+	}
+
+	return false;
+}
+
+int opae_log_async_vprint(int loglevel, const char *fmt, va_list argp)
+{
+	opae_log_ring *ring;
+
+	if (!__atomic_load_n(&log_running, __ATOMIC_ACQUIRE))
+		return 1;
+
+	ring = log_tls_ring;
+	if (!ring) {
+		ring = opae_log_claim_ring();
+		if (!ring)
+			return 1;
+	}
+
+	if (!opae_log_ratelimited(ring, loglevel, fmt))
+		opae_log_enqueue(ring, loglevel, fmt, argp);
+
+	return 0;
+}
+
+static void opae_log_write_slot(const opae_log_slot *slot)
+{
+	opae_log_record rec;
+
+	if (log_format == OPAE_LOG_FORMAT_BINARY) {
+		rec.magic = OPAE_LOG_RECORD_MAGIC;
+		rec.level = slot->level;
+		rec.length = slot->length;
+		rec.timestamp = slot->timestamp;
+		rec.tid = slot->tid;
+		rec.reserved = 0;
+		fwrite(&rec, sizeof(rec), 1, log_out);
+		fwrite(slot->text, 1, slot->length, log_out);
+	} else {
+		fwrite(slot->text, 1, slot->length,
+		       slot->level == OPAE_LOG_ERROR ? log_err : log_out);
+	}
+}
+
+static void opae_log_write_note(int loglevel, const char *fmt, ...)
+{
+	opae_log_slot slot;
+	va_list argp;
+	int len;
+
+	va_start(argp, fmt);
+	len = vsnprintf(slot.text, sizeof(slot.text), fmt, argp);
+	va_end(argp);
+
+	slot.length = opae_log_fit(slot.text, len);
+	slot.level = (uint16_t)loglevel;
+	slot.tid = (uint32_t)syscall(SYS_gettid);
+	slot.timestamp = opae_log_nsec(CLOCK_REALTIME);
+
+	opae_log_write_slot(&slot);
+}
+
+// Write everything queued so far. Returns the number of messages written.
+STATIC uint64_t opae_log_drain(void)
+{
+	opae_log_ring *ring;
+	uint64_t written = 0;
+
+	for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE) ;
+	     ring ; ring = ring->next) {
+		uint64_t tail = ring->tail;
+		uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint64_t dropped;
+
+		while (tail != head) {
+			opae_log_write_slot(&ring->slots[tail % OPAE_LOG_RING_SLOTS]);
+			++tail;
+			++written;
+		}
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+		dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+		if (dropped) {
+			opae_log_write_note(OPAE_LOG_ERROR,
+					    "opae_print: dropped %lu message(s)\n",
+					    (unsigned long)dropped);
+			++written;
+		}
+	}
+
+	if (written) {
+		fflush(log_out);
+		if (log_err != log_out)
+			fflush(log_err);
+	}
+
+	return written;
+}
+
+static void *opae_log_flusher(void *arg)
+{
+	struct timespec ts;
+	uint64_t nap = OPAE_LOG_FLUSH_MIN_NSEC;
+
+	UNUSED_PARAM(arg);
+
+	while (!__atomic_load_n(&log_stopping, __ATOMIC_ACQUIRE)) {
+		// Back off while the rings are idle.
+		if (opae_log_drain())
+			nap = OPAE_LOG_FLUSH_MIN_NSEC;
+		else if (nap < OPAE_LOG_FLUSH_MAX_NSEC)
+			nap <<= 1;
+
+		ts.tv_sec = 0;
+		ts.tv_nsec = nap;
+		nanosleep(&ts, NULL);
+	}
+
+	return NULL;
+}
+
+/*
+ * fork() copies the rings and log_running into the child, but not the
+ * flusher thread, so give the child a flusher of its own. The parent's
+ * queued messages are the parent's to write: the child starts with
+ * empty rings. If the flusher can't be created, the child logs
+ * synchronously. (glibc resets the stdio stream locks in the child,
+ * so a stream the parent's flusher held at fork() is usable here.)
+ */
+STATIC void opae_log_atfork_child(void)
+{
+	opae_log_ring *ring;
+
+	if (!log_running)
+		return;
+
+	// Only the forking thread survives. Its ring stays claimed,
+	// the rest are free for the child's new threads.
+	for (ring = log_rings ; ring ; ring = ring->next) {
+		ring->tail = ring->head;
+		ring->dropped = 0;
+		memset(ring->rl, 0, sizeof(ring->rl));
+		ring->owner = (ring == log_tls_ring) ?
+			(uint32_t)syscall(SYS_gettid) : 0;
+	}
+
+	log_stopping = 0;
+	if (pthread_create(&log_flusher, NULL, opae_log_flusher, NULL))
+		log_running = 0;
+}
+
+static void opae_log_register_atfork(void)
+{
+	pthread_atfork(NULL, NULL, opae_log_atfork_child);
+}
+
+int opae_log_async_start(int format, FILE *out, FILE *err, uint32_t ratelimit)
+{
+	if (__atomic_load_n(&log_running, __ATOMIC_ACQUIRE))
+		return 0;
+
+	pthread_once(&log_atfork_once, opae_log_register_atfork);
+
+	log_format = format;
+	log_out = out;
+	log_err = (format == OPAE_LOG_FORMAT_BINARY) ? out : err;
+	log_ratelimit = ratelimit;
+	log_stopping = 0;
+
+	if (pthread_create(&log_flusher, NULL, opae_log_flusher, NULL))
+		return 1;
+
+	__atomic_store_n(&log_running, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+void opae_log_async_stop(void)
+{
+	opae_log_ring *ring;
+	int i;
+
+	if (!__atomic_load_n(&log_running, __ATOMIC_ACQUIRE))
+		return;
+
+	// New messages go the synchronous route from here on. A message
+	// racing with this store stays queued until the next start.
+	__atomic_store_n(&log_running, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&log_stopping, 1, __ATOMIC_RELEASE);
+	pthread_join(log_flusher, NULL);
+
+	opae_log_drain();
+
+	for (ring = log_rings ; ring ; ring = ring->next) {
+		for (i = 0 ; i < OPAE_LOG_RL_ENTRIES ; ++i) {
+			opae_log_ratelimit *rl = &ring->rl[i];
+			if (rl->suppressed)
+				opae_log_write_note(rl->level,
+					"opae_print: suppressed %u message(s) like \"%.*s\"\n",
+					rl->suppressed,
+					opae_log_fmt_len(rl->fmt), rl->fmt);
+			rl->suppressed = 0;
+		}
+	}
+
+	fflush(log_out);
+	if (log_err != log_out)
+		fflush(log_err);
+}
@@ -0,0 +1,95 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef __OPAE_LOG_ASYNC_H__
+#define __OPAE_LOG_ASYNC_H__
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+/*
+ * Asynchronous backend for opae_print().
+ *
+ * Selected by LIBOPAE_LOG_MODE:
+ *   sync   - (default) format and write under a mutex on the caller's thread.
+ *   async  - each thread formats into its own lock-free ring; a background
+ *            thread writes the rings to the log streams.
+ *   binary - as async, but the log file receives opae_log_record's.
+ *
+ * In the async modes, LIBOPAE_LOG_RATELIMIT=<n> allows each call site
+ * n messages per second per thread (default OPAE_LOG_RL_BURST, 0 disables).
+ * Debug messages are never rate limited.
+ */
+
+#define OPAE_LOG_FORMAT_TEXT   0
+#define OPAE_LOG_FORMAT_BINARY 1
+
+#define OPAE_LOG_RECORD_MAGIC 0x676f6c6f // olog
+
+// Binary log record header, followed by length bytes of message text.
+typedef struct _opae_log_record {
+	uint32_t magic;
+	uint16_t level;     // enum opae_loglevel
+	uint16_t length;    // bytes of text following this header
+	uint64_t timestamp; // CLOCK_REALTIME, nsec
+	uint32_t tid;       // Linux thread ID of the logging thread
+	uint32_t reserved;
+} opae_log_record;
+
+#define OPAE_LOG_RING_SLOTS     64
+#define OPAE_LOG_MSG_MAX        480
+// Ends a message that was cut to fit in OPAE_LOG_MSG_MAX bytes.
+#define OPAE_LOG_TRUNCATED      "...(truncated)\n"
+#define OPAE_LOG_RL_ENTRIES     16
+#define OPAE_LOG_RL_BURST       10
+#define OPAE_LOG_RL_WINDOW_NSEC 1000000000ULL
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Start the background flusher. Messages at OPAE_LOG_ERROR go to err,
+// everything else to out. In OPAE_LOG_FORMAT_BINARY, all records go to out.
+// ratelimit is the per call site burst per second, 0 for unlimited.
+// A child created by fork() gets its own flusher and starts with empty
+// rings; it falls back to synchronous logging if that thread can't start.
+// return: non-zero on failure, in which case logging stays synchronous.
+int opae_log_async_start(int format, FILE *out, FILE *err, uint32_t ratelimit);
+
+// Write out everything queued so far, report any rate-limited or dropped
+// messages, and stop the flusher. Subsequent messages are synchronous.
+void opae_log_async_stop(void);
+
+// Queue a message. Never blocks: if the calling thread's ring is full,
+// the message is dropped and counted.
+// return: non-zero, without consuming argp, if the async backend is
+// not running.
+int opae_log_async_vprint(int loglevel, const char *fmt, va_list argp);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __OPAE_LOG_ASYNC_H__
@@ -104,8 +104,8 @@ typedef struct _opae_api_adapter_table opae_api_adapter_table;
 typedef struct _opae_wrapped_token {
 	uint32_t magic;
 	fpga_token opae_token;
-	uint32_t ref_count;
-	struct _opae_wrapped_token *prev;
+	uint32_t ref_count; // atomic
+	struct _opae_wrapped_token *prev; // token registry shard links
 	struct _opae_wrapped_token *next;
 	opae_api_adapter_table *adapter_table;
 } opae_wrapped_token;
@@ -139,6 +139,26 @@ uint32_t opae_wrapped_tokens_in_use(void);
 
 #endif // LIBOPAE_DEBUG
 
+typedef struct _opae_buf_pool_entry {
+	uint64_t wsid;
+	void *addr;
+	uint64_t len;
+	int flags;
+	struct _opae_buf_pool_entry *next;
+} opae_buf_pool_entry;
+
+// One free list per power-of-two size class.
+#define OPAE_BUF_POOL_CLASSES 64
+#define OPAE_BUF_POOL_DEFAULT_MAX (1024UL * 1024 * 1024)
+
+typedef struct _opae_buf_pool {
+	pthread_mutex_t lock;
+	uint64_t high_water;   // max bytes held on the free lists
+	uint64_t cached;       // bytes currently on the free lists
+	opae_buf_pool_entry *busy;
+	opae_buf_pool_entry *free[OPAE_BUF_POOL_CLASSES];
+} opae_buf_pool;
+
 //                                   n a h w
 #define OPAE_WRAPPED_HANDLE_MAGIC 0x6e616877
 
@@ -147,6 +167,7 @@ typedef struct _opae_wrapped_handle {
 	opae_wrapped_token *wrapped_token;
 	fpga_handle opae_handle;
 	opae_api_adapter_table *adapter_table;
+	opae_buf_pool *buf_pool; // NULL unless FPGA_OPEN_BUFFER_POOL
 } opae_wrapped_handle;
 
 opae_wrapped_handle *
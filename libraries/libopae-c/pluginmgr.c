@@ -38,6 +38,7 @@
 #include <linux/limits.h>
 #include <pthread.h>
 #include <pwd.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "pluginmgr.h"
@@ -48,6 +49,38 @@
 #define OPAE_PLUGIN_CONFIGURE "opae_plugin_configure"
 typedef int (*opae_plugin_configure_t)(opae_api_adapter_table *, const char *);
 
+// opae_plugin.init_state
+#define OPAE_PLUGIN_INIT_PENDING 0 // loaded, initialize() not yet run
+#define OPAE_PLUGIN_INIT_DONE    1
+#define OPAE_PLUGIN_INIT_FAILED  2
+#define OPAE_PLUGIN_INIT_RUNNING 3 // claimed by opae_plugin_mgr_initialize_all()
+
+/*
+ * The library constructor loads and configures plugins with
+ * opae_plugin_mgr_initialize_deferred(), which leaves their initialize()
+ * routines to the first call that needs the adapters
+ * (opae_plugin_mgr_for_each_adapter(), i.e. the first enumeration).
+ * Processes that never enumerate never pay for them, and when several
+ * plugins are pending they are initialized in parallel. An explicit
+ * fpgaInitialize() runs them immediately and reports their failures.
+ */
+STATIC struct {
+	double find_cfg_ms;
+	double load_cfg_ms;
+	double detect_ms;
+	double load_plugins_ms;
+	double init_plugins_ms;
+	bool cfg_cached;
+} startup_times;
+
+static inline double opae_plugin_mgr_elapsed_ms(struct timespec *begin)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - begin->tv_sec) * 1E3 +
+		(now.tv_nsec - begin->tv_nsec) * 1E-6;
+}
+
 static libopae_config_data *platform_data_table;
 
 int initialized;
@@ -57,6 +90,13 @@ STATIC opae_api_adapter_table *adapter_list = (void *)0;
 static pthread_mutex_t adapter_list_lock =
 	PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
+// Serializes opae_plugin_mgr_initialize_all(). Lock order is
+// adapter_init_lock, then adapter_list_lock.
+static pthread_mutex_t adapter_init_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Set while this thread is running a plugin's initialize().
+static __thread int adapter_init_thread;
+
 STATIC void *opae_plugin_mgr_find_plugin(const char *lib_path)
 {
 	char plugin_path[PATH_MAX];
@@ -149,24 +189,121 @@ STATIC int opae_plugin_mgr_configure_plugin(opae_api_adapter_table *adapter,
 	return cfg(adapter, config);
 }
 
+STATIC void *opae_plugin_mgr_initialize_adapter(void *arg)
+{
+	opae_api_adapter_table *aptr = (opae_api_adapter_table *)arg;
+
+	int res = 0;
+
+	adapter_init_thread = 1;
+	if (aptr->initialize)
+		res = aptr->initialize();
+	adapter_init_thread = 0;
+
+	if (res) {
+		OPAE_MSG("\"%s\" initialize() routine failed",
+			 aptr->plugin.path);
+		aptr->plugin.init_state = OPAE_PLUGIN_INIT_FAILED;
+		return (void *)1;
+	}
+
+	aptr->plugin.init_state = OPAE_PLUGIN_INIT_DONE;
+	return NULL;
+}
+
+#define OPAE_PLUGIN_MAX_INIT_THREADS 16
+
+// Initialize any adapters whose initialize() has not yet run.
+// adapter_list_lock is held only while the pending adapters are
+// claimed, so a plugin's initialize() may call back into the OPAE
+// API. Such a nested call does not wait for initialization to
+// finish; every other caller blocks on adapter_init_lock until the
+// adapters it will see have been initialized.
+// Returns the number of initialize() routines that failed.
 STATIC int opae_plugin_mgr_initialize_all(void)
 {
 	int res;
 	opae_api_adapter_table *aptr;
+	opae_api_adapter_table **pending = NULL;
+	pthread_t threads[OPAE_PLUGIN_MAX_INIT_THREADS];
+	int num_threads = 0;
+	int num_pending = 0;
 	int errors = 0;
+	int i;
+	struct timespec begin;
+	double elapsed;
+
+	if (adapter_init_thread)
+		return 0;
+
+	opae_mutex_lock(res, &adapter_init_lock);
+	opae_mutex_lock(res, &adapter_list_lock);
 
 	for (aptr = adapter_list; aptr; aptr = aptr->next) {
+		if (aptr->plugin.init_state == OPAE_PLUGIN_INIT_PENDING)
+			++num_pending;
+	}
 
-		if (aptr->initialize) {
-			res = aptr->initialize();
-			if (res) {
-				OPAE_MSG("\"%s\" initialize() routine failed",
-					 aptr->plugin.path);
-				++errors;
+	if (num_pending) {
+		pending = opae_calloc(num_pending, sizeof(*pending));
+		if (!pending) {
+			OPAE_ERR("out of memory");
+			opae_mutex_unlock(res, &adapter_list_lock);
+			opae_mutex_unlock(res, &adapter_init_lock);
+			return num_pending;
+		}
+
+		i = 0;
+		for (aptr = adapter_list; aptr; aptr = aptr->next) {
+			if (aptr->plugin.init_state ==
+			    OPAE_PLUGIN_INIT_PENDING) {
+				aptr->plugin.init_state =
+					OPAE_PLUGIN_INIT_RUNNING;
+				pending[i++] = aptr;
 			}
 		}
 	}
 
+	opae_mutex_unlock(res, &adapter_list_lock);
+
+	if (!num_pending) {
+		opae_mutex_unlock(res, &adapter_init_lock);
+		return 0;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	// Run the first pending adapter on this thread and the
+	// rest on their own threads.
+	for (i = 1 ; i < num_pending ; ++i) {
+		if ((num_threads < OPAE_PLUGIN_MAX_INIT_THREADS) &&
+		    !pthread_create(&threads[num_threads], NULL,
+				    opae_plugin_mgr_initialize_adapter,
+				    pending[i])) {
+			++num_threads;
+		} else if (opae_plugin_mgr_initialize_adapter(pending[i])) {
+			++errors;
+		}
+	}
+
+	if (opae_plugin_mgr_initialize_adapter(pending[0]))
+		++errors;
+
+	for (i = 0 ; i < num_threads ; ++i) {
+		void *thr_res = NULL;
+		pthread_join(threads[i], &thr_res);
+		if (thr_res)
+			++errors;
+	}
+
+	elapsed = opae_plugin_mgr_elapsed_ms(&begin);
+	startup_times.init_plugins_ms += elapsed;
+	OPAE_MSG("initialized %d plugin(s) in %.3f ms (%d failed)",
+		 num_pending, elapsed, errors);
+
+	opae_free(pending);
+	opae_mutex_unlock(res, &adapter_init_lock);
+
 	return errors;
 }
 
@@ -177,10 +314,13 @@ int opae_plugin_mgr_finalize_all(void)
 	int errors = 0;
 	libopae_config_data *cfg;
 
+	// Don't tear down adapters that are being initialized.
+	opae_mutex_lock(res, &adapter_init_lock);
 	opae_mutex_lock(res, &adapter_list_lock);
 
 	if (finalizing) {
 		opae_mutex_unlock(res, &adapter_list_lock);
+		opae_mutex_unlock(res, &adapter_init_lock);
 		return 0;
 	}
 
@@ -189,7 +329,9 @@ int opae_plugin_mgr_finalize_all(void)
 	for (aptr = adapter_list; aptr;) {
 		opae_api_adapter_table *trash;
 
-		if (aptr->finalize) {
+		// Adapters that were never initialized have nothing to tear down.
+		if (aptr->finalize &&
+		    (aptr->plugin.init_state != OPAE_PLUGIN_INIT_PENDING)) {
 			res = aptr->finalize();
 			if (res) {
 				OPAE_MSG("\"%s\" finalize() routine failed",
@@ -219,6 +361,7 @@ int opae_plugin_mgr_finalize_all(void)
 	initialized = 0;
 	finalizing = 0;
 	opae_mutex_unlock(res, &adapter_list_lock);
+	opae_mutex_unlock(res, &adapter_init_lock);
 
 	return errors;
 }
@@ -466,11 +609,16 @@ STATIC int opae_plugin_mgr_load_plugins(int *platforms_detected)
 	int res = 0;
 	opae_api_adapter_table *adapter = NULL;
 	int errors;
+	struct timespec begin;
 
+	clock_gettime(CLOCK_MONOTONIC, &begin);
 	errors = opae_plugin_mgr_detect_platforms(getenv("WITH_ASE") != NULL);
+	startup_times.detect_ms = opae_plugin_mgr_elapsed_ms(&begin);
 	if (errors)
 		return errors;
 
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
 	// Load each of the plugins that were detected.
 	*platforms_detected = 0;
 
@@ -526,16 +674,20 @@ STATIC int opae_plugin_mgr_load_plugins(int *platforms_detected)
 		platform_data_table[i].flags |= OPAE_PLATFORM_DATA_LOADED;
 	}
 
+	startup_times.load_plugins_ms = opae_plugin_mgr_elapsed_ms(&begin);
+
 	return errors;
 }
 
-int opae_plugin_mgr_initialize(const char *cfg_file)
+int opae_plugin_mgr_initialize_deferred(const char *cfg_file)
 {
 	int res;
 	bool free_config = false;
 	char *raw_config = NULL;
 	int platforms_detected = 0;
 	int errors = 0;
+	const char *cache_file;
+	struct timespec begin;
 
 	opae_mutex_lock(res, &adapter_list_lock);
 
@@ -545,6 +697,8 @@ int opae_plugin_mgr_initialize(const char *cfg_file)
 	}
 	initialized = 1;
 
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
 	// If we were given a path to a cfg_file, then assume the
 	// caller will free() it. Otherwise, when we search for
 	// one with opae_find_cfg_file(), the path will be allocated,
@@ -555,29 +709,62 @@ int opae_plugin_mgr_initialize(const char *cfg_file)
 			free_config = true;
 	}
 
-	if (cfg_file) {
-		raw_config = opae_read_cfg_file(cfg_file);
+	startup_times.find_cfg_ms = opae_plugin_mgr_elapsed_ms(&begin);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	// LIBOPAE_CFG_CACHE names a binary snapshot of the parsed
+	// config table, which is reused for as long as it matches
+	// the config file it was built from.
+	cache_file = getenv("LIBOPAE_CFG_CACHE");
+	startup_times.cfg_cached = false;
+	if (cache_file && cfg_file) {
+		platform_data_table =
+			opae_load_libopae_config_cache(cache_file, cfg_file);
+		startup_times.cfg_cached = (platform_data_table != NULL);
+	}
+
+	if (!platform_data_table) {
+		if (cfg_file) {
+			raw_config = opae_read_cfg_file(cfg_file);
+		}
+
+		// Parse the config file content, allocating and initializing
+		// our configuration table. If raw_config is non-NULL, then
+		// this function will delete it.
+		platform_data_table =
+			opae_parse_libopae_config(cfg_file, raw_config);
+
+		if (cache_file && cfg_file)
+			opae_save_libopae_config_cache(cache_file, cfg_file,
+						       platform_data_table);
 	}
 
-	// Parse the config file content, allocating and initializing
-	// our configuration table. If raw_config is non-NULL, then
-	// this function will delete it.
-	platform_data_table = opae_parse_libopae_config(cfg_file, raw_config);
+	startup_times.load_cfg_ms = opae_plugin_mgr_elapsed_ms(&begin);
 
 	// Print the config table for debug builds.
 	opae_print_libopae_config(platform_data_table);
 
 	errors = opae_plugin_mgr_load_plugins(&platforms_detected);
+
+	OPAE_MSG("startup: find cfg %.3f ms, %s cfg %.3f ms, "
+		 "detect %.3f ms, load plugins %.3f ms",
+		 startup_times.find_cfg_ms,
+		 startup_times.cfg_cached ? "cached" : "parse",
+		 startup_times.load_cfg_ms,
+		 startup_times.detect_ms,
+		 startup_times.load_plugins_ms);
+
 	if (errors) {
 		initialized = 0;
 		goto out_unlock;
 	}
 
-	// Call each plugin's initialization routine.
-	errors += opae_plugin_mgr_initialize_all();
+	// Each plugin's initialization routine is deferred to the
+	// first opae_plugin_mgr_initialize_all().
 
 	initialized = 0;
-	if (!errors && platforms_detected)
+	if (platforms_detected)
 		initialized = 1;
 
 out_unlock:
@@ -592,6 +779,18 @@ out_unlock:
 	return errors;
 }
 
+int opae_plugin_mgr_initialize(const char *cfg_file)
+{
+	int errors;
+
+	errors = opae_plugin_mgr_initialize_deferred(cfg_file);
+	if (errors)
+		return errors;
+
+	// Call each plugin's initialization routine.
+	return opae_plugin_mgr_initialize_all();
+}
+
 int opae_plugin_mgr_for_each_adapter
 	(int (*callback)(const opae_api_adapter_table *, void *), void *context)
 {
@@ -604,6 +803,12 @@ int opae_plugin_mgr_for_each_adapter
 		return OPAE_ENUM_STOP;
 	}
 
+	// Run any deferred plugin initialize() routines. An adapter
+	// whose initialize() failed is still visited, as it was
+	// when initialization happened up front. The failure was
+	// logged, and fpgaInitialize() reports it to explicit callers.
+	opae_plugin_mgr_initialize_all();
+
 	opae_mutex_lock(res, &adapter_list_lock);
 
 	for (aptr = adapter_list; aptr; aptr = aptr->next) {
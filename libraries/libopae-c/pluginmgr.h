@@ -29,9 +29,15 @@
 
 #include "adapter.h"
 
-// non-zero on failure.
+// Load and initialize the plugins.
+// non-zero on failure, including failure of any plugin's initialize().
 int opae_plugin_mgr_initialize(const char *cfg_file);
 
+// Load the plugins, deferring their initialize() routines to the
+// first opae_plugin_mgr_for_each_adapter().
+// non-zero on failure.
+int opae_plugin_mgr_initialize_deferred(const char *cfg_file);
+
 // non-zero on failure.
 int opae_plugin_mgr_finalize_all(void);
 
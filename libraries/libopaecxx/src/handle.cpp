@@ -114,6 +114,18 @@ void handle::write_csr512(uint64_t offset, const void *value,
   ASSERT_FPGA_OK(fpgaWriteMMIO512(handle_, csr_space, offset, value));
 }
 
+void handle::read_csrs(std::vector<fpga_mmio_vec> &vec,
+                       uint32_t csr_space) const {
+  ASSERT_FPGA_OK(fpgaReadMMIOv(handle_, csr_space, vec.data(),
+                               static_cast<uint32_t>(vec.size())));
+}
+
+void handle::write_csrs(const std::vector<fpga_mmio_vec> &vec,
+                        uint32_t csr_space) {
+  ASSERT_FPGA_OK(fpgaWriteMMIOv(handle_, csr_space, vec.data(),
+                                static_cast<uint32_t>(vec.size())));
+}
+
 uint8_t *handle::mmio_ptr(uint64_t offset, uint32_t csr_space) const {
   uint8_t *base = nullptr;
 
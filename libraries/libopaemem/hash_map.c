@@ -52,6 +52,163 @@
 fprintf(stderr, "%s:%u:%s() **ERROR** [%s] : " format, \
 	__SHORT_FILE__, __LINE__, __func__, strerror(errno), ##__VA_ARGS__)
 
+#define OPAE_HASH_MAP_OCCUPIED 0x80000000u
+
+// Slot array sizes: the first prime above each power of 2. A prime
+// modulus gives evenly spaced keys, such as page- and hugepage-aligned
+// buffer addresses, distinct home slots, so lookups of those keys
+// rarely probe past the home slot.
+STATIC const uint32_t opae_hash_map_primes[] = {
+	17, 37, 67, 131, 257, 521, 1031, 2053, 4099, 8209, 16411,
+	32771, 65537, 131101, 262147, 524309, 1048583, 2097169,
+	4194319, 8388617, 16777259, 33554467, 67108879, 134217757,
+	268435459, 536870923, 1073741827
+};
+
+#define OPAE_HASH_MAP_NUM_PRIMES \
+	(sizeof(opae_hash_map_primes) / sizeof(opae_hash_map_primes[0]))
+
+// Distance of slot __i from home slot __home.
+#define OPAE_HASH_MAP_DIST(__size, __i, __home) \
+	((__i) >= (__home) ? (__i) - (__home) : (__i) + (__size) - (__home))
+
+STATIC uint32_t opae_hash_map_slots_for(uint32_t n)
+{
+	size_t i;
+
+	for (i = 0 ; i < OPAE_HASH_MAP_NUM_PRIMES - 1 ; ++i) {
+		if (opae_hash_map_primes[i] >= n)
+			break;
+	}
+
+	return opae_hash_map_primes[i];
+}
+
+// Find the home slot of key in a slot array of num_slots entries.
+static inline fpga_result opae_hash_map_home(opae_hash_map *hm,
+					     void *key,
+					     uint32_t num_slots,
+					     uint32_t *home)
+{
+	uint32_t h;
+
+	if (hm->key_hash == opae_u64_key_hash)
+		h = (uint32_t)((uint64_t)key % num_slots);
+	else
+		h = hm->key_hash(num_slots, hm->hash_seed, key);
+
+	if (h >= num_slots) {
+		ERR("key hash returned %u which is "
+		    "greater or equal num_buckets(%u)\n",
+		    h, num_slots);
+		return FPGA_INVALID_PARAM;
+	}
+
+	*home = h;
+	return FPGA_OK;
+}
+
+static inline opae_hash_map_slot *
+opae_hash_map_lookup(opae_hash_map *hm, void *key, uint32_t home)
+{
+	uint32_t size = hm->num_buckets;
+	uint32_t tag = home | OPAE_HASH_MAP_OCCUPIED;
+	uint32_t i = home;
+	uint32_t dist = 0;
+
+	while (1) {
+		opae_hash_map_slot *slot = &hm->slots[i];
+		int res;
+
+		if (slot->hash == tag) {
+			if (hm->key_compare == opae_u64_key_compare)
+				res = opae_u64_key_compare(key, slot->key);
+			else
+				res = hm->key_compare(key, slot->key);
+
+			if (!res)
+				return slot;
+		}
+
+		// Robin Hood invariant: once we reach an empty slot or one
+		// that is closer to its home than we are to ours, the key
+		// cannot be further along the probe sequence.
+		if (!slot->hash ||
+		    (OPAE_HASH_MAP_DIST(size, i,
+			slot->hash & ~OPAE_HASH_MAP_OCCUPIED) < dist))
+			return NULL;
+
+		if (++i == size)
+			i = 0;
+		++dist;
+	}
+}
+
+static inline void opae_hash_map_place(opae_hash_map_slot *slots,
+				uint32_t size,
+				opae_hash_map_slot item)
+{
+	uint32_t i = item.hash & ~OPAE_HASH_MAP_OCCUPIED;
+	uint32_t dist = 0;
+
+	while (slots[i].hash) {
+		uint32_t d = OPAE_HASH_MAP_DIST(size, i,
+				slots[i].hash & ~OPAE_HASH_MAP_OCCUPIED);
+
+		if (d < dist) {
+			// Take from the rich: the resident is closer to its
+			// home slot than we are, so it moves on instead.
+			opae_hash_map_slot tmp = slots[i];
+			slots[i] = item;
+			item = tmp;
+			dist = d;
+		}
+
+		if (++i == size)
+			i = 0;
+		++dist;
+	}
+
+	slots[i] = item;
+}
+
+STATIC fpga_result opae_hash_map_resize(opae_hash_map *hm,
+					uint32_t num_slots)
+{
+	opae_hash_map_slot *slots;
+	uint32_t i;
+
+	slots = (opae_hash_map_slot *)
+		opae_calloc(num_slots, sizeof(opae_hash_map_slot));
+	if (!slots) {
+		ERR("calloc() failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	for (i = 0 ; i < hm->num_buckets ; ++i) {
+		opae_hash_map_slot item = hm->slots[i];
+		uint32_t home;
+
+		if (!item.hash)
+			continue;
+
+		// Home slots depend on the array size.
+		if (opae_hash_map_home(hm, item.key, num_slots, &home)) {
+			opae_free(slots);
+			return FPGA_INVALID_PARAM;
+		}
+
+		item.hash = home | OPAE_HASH_MAP_OCCUPIED;
+		opae_hash_map_place(slots, num_slots, item);
+	}
+
+	opae_free(hm->slots);
+	hm->slots = slots;
+	hm->num_buckets = num_slots;
+
+	return FPGA_OK;
+}
+
 fpga_result opae_hash_map_init(opae_hash_map *hm,
 			       uint32_t num_buckets,
 			       uint32_t hash_seed,
@@ -70,10 +227,12 @@ fpga_result opae_hash_map_init(opae_hash_map *hm,
 
 	memset(hm, 0, sizeof(*hm));
 
-	hm->buckets = (opae_hash_map_item **)
+	num_buckets = opae_hash_map_slots_for(num_buckets);
+
+	hm->slots = (opae_hash_map_slot *)
 			opae_calloc(num_buckets,
-				    sizeof(opae_hash_map_item *));
-	if (!hm->buckets) {
+				    sizeof(opae_hash_map_slot));
+	if (!hm->slots) {
 		ERR("calloc() failed");
 		return FPGA_NO_MEMORY;
 	}
@@ -89,93 +248,64 @@ fpga_result opae_hash_map_init(opae_hash_map *hm,
 	return FPGA_OK;
 }
 
-STATIC opae_hash_map_item *
-opae_hash_map_alloc_item(void *key, void *value)
-{
-	opae_hash_map_item *item;
-	item = (opae_hash_map_item *)
-		opae_malloc(sizeof(opae_hash_map_item));
-	if (item) {
-		item->key = key;
-		item->value = value;
-		item->next = NULL;
-	}
-	return item;
-}
-
 fpga_result opae_hash_map_add(opae_hash_map *hm,
 			      void *key,
 			      void *value)
 {
-	uint32_t key_hash;
-	opae_hash_map_item *item;
-	opae_hash_map_item *list;
-	opae_hash_map_item *prev;
+	uint32_t home;
+	opae_hash_map_slot item;
+	opae_hash_map_slot *slot;
+	fpga_result res;
 
 	if (!hm) {
 		ERR("NULL pointer");
 		return FPGA_INVALID_PARAM;
 	}
 
-	key_hash = hm->key_hash(hm->num_buckets,
-				hm->hash_seed,
-				key);
-
-	if (key_hash >= hm->num_buckets) {
-		ERR("key hash returned %u which is "
-		    "greater or equal num_buckets(%u)\n",
-		    key_hash, hm->num_buckets);
-		return FPGA_INVALID_PARAM;
-	}
-
-	item = opae_hash_map_alloc_item(key, value);
-	if (!item) {
-		ERR("malloc() failed");
-		return FPGA_NO_MEMORY;
-	}
+	// When the user has guaranteed us a unique keyspace, no key
+	// collisions will occur on add, so skip the lookup.
+	if (!(hm->flags & OPAE_HASH_MAP_UNIQUE_KEYSPACE)) {
+		res = opae_hash_map_home(hm, key, hm->num_buckets, &home);
+		if (res)
+			return res;
 
-	list = hm->buckets[key_hash];
-	if (!list) {
-		// Bucket was empty. Fill it.
-		hm->buckets[key_hash] = item;
-		return FPGA_OK;
+		slot = opae_hash_map_lookup(hm, key, home);
+		if (slot) {
+			// Key collision.
+			if (hm->value_cleanup)
+				hm->value_cleanup(slot->value,
+						  hm->cleanup_context);
+			slot->value = value; // Replace value only.
+			return FPGA_OK;
+		}
 	}
 
-	if (hm->flags & OPAE_HASH_MAP_UNIQUE_KEYSPACE) {
-		// The user has guaranteed us a unique keyspace.
-		// In this case, we are sure that no key collisions
-		// will occur on add. As an optimization, just add new
-		// entries to the head of the list.
-		item->next = hm->buckets[key_hash];
-		hm->buckets[key_hash] = item;
-	} else {
-		// Bucket not empty. Do we have a key collision?
-		prev = NULL;
-		while (list) {
-			int res;
+	// Keep the load factor at or below 3/4.
+	if ((uint64_t)(hm->num_items + 1) * 4 >
+	    (uint64_t)hm->num_buckets * 3) {
+		uint32_t num_slots =
+			opae_hash_map_slots_for(hm->num_buckets + 1);
 
-			if (hm->key_compare == opae_u64_key_compare)
-				res = opae_u64_key_compare(key, list->key);
-			else
-				res = hm->key_compare(key, list->key);
-
-			if (!res) {
-				// Key collision.
-				opae_free(item);
-				if (hm->value_cleanup)
-					hm->value_cleanup(list->value,
-							  hm->cleanup_context);
-				list->value = value; // Replace value only.
-				return FPGA_OK;
-			}
-			prev = list;
-			list = list->next;
+		if (num_slots <= hm->num_buckets) {
+			ERR("hash map is full");
+			return FPGA_NO_MEMORY;
 		}
 
-		// No key collision. Add item to the end of list.
-		prev->next = item;
+		res = opae_hash_map_resize(hm, num_slots);
+		if (res)
+			return res;
 	}
 
+	res = opae_hash_map_home(hm, key, hm->num_buckets, &home);
+	if (res)
+		return res;
+
+	item.key = key;
+	item.value = value;
+	item.hash = home | OPAE_HASH_MAP_OCCUPIED;
+	opae_hash_map_place(hm->slots, hm->num_buckets, item);
+	++hm->num_items;
+
 	return FPGA_OK;
 }
 
@@ -183,102 +313,67 @@ fpga_result opae_hash_map_find(opae_hash_map *hm,
 			       void *key,
 			       void **value)
 {
-	uint32_t key_hash;
-	opae_hash_map_item *list;
+	opae_hash_map_slot *slot;
+	uint32_t home;
 
 	if (!hm) {
 		ERR("NULL pointer");
 		return FPGA_INVALID_PARAM;
 	}
 
-	key_hash = hm->key_hash(hm->num_buckets,
-				hm->hash_seed,
-				key);
-
-	if (key_hash >= hm->num_buckets) {
-		ERR("key hash returned %u which is "
-		    "greater or equal num_buckets(%u)\n",
-		    key_hash, hm->num_buckets);
+	if (opae_hash_map_home(hm, key, hm->num_buckets, &home))
 		return FPGA_INVALID_PARAM;
-	}
-
-	list = hm->buckets[key_hash];
 
-	while (list) {
-		int res;
+	slot = opae_hash_map_lookup(hm, key, home);
+	if (!slot)
+		return FPGA_NOT_FOUND;
 
-		if (hm->key_compare == opae_u64_key_compare)
-			res = opae_u64_key_compare(key, list->key);
-		else
-			res = hm->key_compare(key, list->key);
+	if (value)
+		*value = slot->value;
 
-		if (!res) {
-			if (value)
-				*value = list->value;
-			return FPGA_OK;
-		}
-		list = list->next;
-	}
-
-	return FPGA_NOT_FOUND;
+	return FPGA_OK;
 }
 
 fpga_result opae_hash_map_remove(opae_hash_map *hm,
 				 void *key)
 {
-	uint32_t key_hash;
-	opae_hash_map_item *prev = NULL;
-	opae_hash_map_item *list;
+	opae_hash_map_slot *slot;
+	uint32_t home;
+	uint32_t size;
+	uint32_t i;
+	uint32_t j;
 
 	if (!hm) {
 		ERR("NULL pointer");
 		return FPGA_INVALID_PARAM;
 	}
 
-	key_hash = hm->key_hash(hm->num_buckets,
-				hm->hash_seed,
-				key);
-
-	if (key_hash >= hm->num_buckets) {
-		ERR("key hash returned %u which is "
-		    "greater or equal num_buckets(%u)\n",
-		    key_hash, hm->num_buckets);
+	if (opae_hash_map_home(hm, key, hm->num_buckets, &home))
 		return FPGA_INVALID_PARAM;
-	}
 
-	list = hm->buckets[key_hash];
-	if (!list)
+	slot = opae_hash_map_lookup(hm, key, home);
+	if (!slot)
 		return FPGA_NOT_FOUND;
 
-	while (list) {
-		int res;
-
-		if (hm->key_compare == opae_u64_key_compare)
-			res = opae_u64_key_compare(key, list->key);
-		else
-			res = hm->key_compare(key, list->key);
-
-		if (!res)
-			break;
-		prev = list;
-		list = list->next;
-	}
-
-	if (!list)
-		return FPGA_NOT_FOUND;
-
-	if (!prev) {
-		// Key found at head of list.
-		hm->buckets[key_hash] = list->next;
-	} else {
-		prev->next = list->next;
-	}
-
 	if (hm->key_cleanup)
-		hm->key_cleanup(list->key, hm->cleanup_context);
+		hm->key_cleanup(slot->key, hm->cleanup_context);
 	if (hm->value_cleanup)
-		hm->value_cleanup(list->value, hm->cleanup_context);
-	opae_free(list);
+		hm->value_cleanup(slot->value, hm->cleanup_context);
+
+	// Backward-shift deletion: pull each following displaced item
+	// one slot closer to its home, so that no tombstones are needed.
+	size = hm->num_buckets;
+	i = (uint32_t)(slot - hm->slots);
+	j = (i + 1 == size) ? 0 : i + 1;
+	while (hm->slots[j].hash &&
+	       (hm->slots[j].hash != (j | OPAE_HASH_MAP_OCCUPIED))) {
+		hm->slots[i] = hm->slots[j];
+		i = j;
+		if (++j == size)
+			j = 0;
+	}
+	memset(&hm->slots[i], 0, sizeof(opae_hash_map_slot));
+	--hm->num_items;
 
 	return FPGA_OK;
 }
@@ -293,21 +388,16 @@ fpga_result opae_hash_map_destroy(opae_hash_map *hm)
 	}
 
 	for (i = 0 ; i < hm->num_buckets ; ++i) {
-		opae_hash_map_item *item;
-		item = hm->buckets[i];
-		while (item) {
-			opae_hash_map_item *trash;
-			trash = item;
-			item = item->next;
-			if (hm->key_cleanup)
-				hm->key_cleanup(trash->key, hm->cleanup_context);
-			if (hm->value_cleanup)
-				hm->value_cleanup(trash->value, hm->cleanup_context);
-			opae_free(trash);
-		}
+		opae_hash_map_slot *slot = &hm->slots[i];
+		if (!slot->hash)
+			continue;
+		if (hm->key_cleanup)
+			hm->key_cleanup(slot->key, hm->cleanup_context);
+		if (hm->value_cleanup)
+			hm->value_cleanup(slot->value, hm->cleanup_context);
 	}
 
-	opae_free(hm->buckets);
+	opae_free(hm->slots);
 	memset(hm, 0, sizeof(*hm));
 
 	return FPGA_OK;
@@ -315,14 +405,7 @@ fpga_result opae_hash_map_destroy(opae_hash_map *hm)
 
 bool opae_hash_map_is_empty(opae_hash_map *hm)
 {
-	uint32_t i;
-
-	for (i = 0 ; i < hm->num_buckets ; ++i) {
-		if (hm->buckets[i])
-			return false;
-	}
-
-	return true;
+	return !hm->num_items;
 }
 
 uint32_t opae_u64_key_hash(uint32_t num_buckets,
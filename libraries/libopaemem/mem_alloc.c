@@ -55,6 +55,273 @@ fprintf(stderr, "%s:%u:%s() **ERROR** [%s] : " format, \
 
 #define ALIGNED(__addr, __size) ((__addr + __size - 1) & ~(__size - 1))
 
+// Initial size of the allocated block map. It grows as needed.
+#define MEM_ALLOC_MAP_SLOTS 64
+
+static inline int mem_tree_height(struct mem_link *n)
+{
+	return n ? n->height : 0;
+}
+
+static inline uint64_t mem_tree_max(struct mem_link *n)
+{
+	return n ? n->max_size : 0;
+}
+
+// Recompute the height and largest block size of the subtree at n
+// from its children.
+static inline void mem_tree_fix(struct mem_link *n)
+{
+	int hl = mem_tree_height(n->left);
+	int hr = mem_tree_height(n->right);
+	uint64_t ml = mem_tree_max(n->left);
+	uint64_t mr = mem_tree_max(n->right);
+
+	n->height = 1 + (hl > hr ? hl : hr);
+	n->max_size = n->size;
+	if (ml > n->max_size)
+		n->max_size = ml;
+	if (mr > n->max_size)
+		n->max_size = mr;
+}
+
+static struct mem_link *mem_tree_rotate_right(struct mem_link *n)
+{
+	struct mem_link *l = n->left;
+	n->left = l->right;
+	l->right = n;
+	mem_tree_fix(n);
+	mem_tree_fix(l);
+	return l;
+}
+
+static struct mem_link *mem_tree_rotate_left(struct mem_link *n)
+{
+	struct mem_link *r = n->right;
+	n->right = r->left;
+	r->left = n;
+	mem_tree_fix(n);
+	mem_tree_fix(r);
+	return r;
+}
+
+static struct mem_link *mem_tree_balance(struct mem_link *n)
+{
+	int bf;
+
+	mem_tree_fix(n);
+	bf = mem_tree_height(n->left) - mem_tree_height(n->right);
+
+	if (bf > 1) {
+		if (mem_tree_height(n->left->left) <
+		    mem_tree_height(n->left->right))
+			n->left = mem_tree_rotate_left(n->left);
+		return mem_tree_rotate_right(n);
+	}
+
+	if (bf < -1) {
+		if (mem_tree_height(n->right->right) <
+		    mem_tree_height(n->right->left))
+			n->right = mem_tree_rotate_right(n->right);
+		return mem_tree_rotate_left(n);
+	}
+
+	return n;
+}
+
+STATIC struct mem_link *mem_tree_insert(struct mem_link *root,
+					struct mem_link *n)
+{
+	if (!root) {
+		n->left = NULL;
+		n->right = NULL;
+		n->height = 1;
+		n->max_size = n->size;
+		return n;
+	}
+
+	if (n->address < root->address)
+		root->left = mem_tree_insert(root->left, n);
+	else
+		root->right = mem_tree_insert(root->right, n);
+
+	return mem_tree_balance(root);
+}
+
+static struct mem_link *mem_tree_remove_min(struct mem_link *root,
+					    struct mem_link **min)
+{
+	if (!root->left) {
+		*min = root;
+		return root->right;
+	}
+
+	root->left = mem_tree_remove_min(root->left, min);
+	return mem_tree_balance(root);
+}
+
+STATIC struct mem_link *mem_tree_remove(struct mem_link *root,
+					uint64_t address)
+{
+	if (!root)
+		return NULL;
+
+	if (address < root->address) {
+		root->left = mem_tree_remove(root->left, address);
+	} else if (address > root->address) {
+		root->right = mem_tree_remove(root->right, address);
+	} else {
+		struct mem_link *l = root->left;
+		struct mem_link *r = root->right;
+		struct mem_link *min = NULL;
+
+		if (!r)
+			return l;
+
+		r = mem_tree_remove_min(r, &min);
+		min->left = l;
+		min->right = r;
+		return mem_tree_balance(min);
+	}
+
+	return mem_tree_balance(root);
+}
+
+// The size of the node at address changed in place.
+// Refresh max_size along the path to it.
+static void mem_tree_refresh(struct mem_link *root, uint64_t address)
+{
+	if (!root)
+		return;
+
+	if (address < root->address)
+		mem_tree_refresh(root->left, address);
+	else if (address > root->address)
+		mem_tree_refresh(root->right, address);
+
+	mem_tree_fix(root);
+}
+
+// Find the node with the greatest address <= address.
+STATIC struct mem_link *mem_tree_floor(struct mem_link *root,
+				       uint64_t address)
+{
+	struct mem_link *floor = NULL;
+
+	while (root) {
+		if (address < root->address) {
+			root = root->left;
+		} else {
+			floor = root;
+			root = root->right;
+		}
+	}
+	return floor;
+}
+
+// Whether size bytes at the given alignment fit in [lo, hi).
+static inline int mem_aligned_fit(uint64_t lo,
+				  uint64_t hi,
+				  uint64_t size,
+				  uint64_t alignment,
+				  uint64_t *aligned_addr)
+{
+	uint64_t addr = ALIGNED(lo, alignment);
+
+	if ((addr < lo) || (addr > hi) || (size > hi - addr))
+		return 0;
+
+	*aligned_addr = addr;
+	return 1;
+}
+
+// Find the lowest-addressed free block that can hold size bytes
+// at the given alignment. Every block in the subtree at root lies
+// within [lo, hi), the gap left by its ancestors. A subtree is
+// skipped when its largest block is smaller than size, or when
+// no aligned range of size bytes fits in [lo, hi) at all.
+STATIC struct mem_link *mem_tree_first_fit(struct mem_link *root,
+					   uint64_t lo,
+					   uint64_t hi,
+					   uint64_t size,
+					   uint64_t alignment,
+					   uint64_t *aligned_addr)
+{
+	struct mem_link *fit;
+
+	while (root && (root->max_size >= size) &&
+	       mem_aligned_fit(lo, hi, size, alignment, aligned_addr)) {
+
+		fit = mem_tree_first_fit(root->left, lo, root->address,
+					 size, alignment, aligned_addr);
+		if (fit)
+			return fit;
+
+		if ((root->size >= size) &&
+		    mem_aligned_fit(root->address,
+				    root->address + root->size,
+				    size, alignment, aligned_addr))
+			return root;
+
+		lo = root->address + root->size;
+		root = root->right;
+	}
+
+	return NULL;
+}
+
+static inline void mem_free_insert(struct mem_alloc *m, struct mem_link *n)
+{
+	m->free_tree = mem_tree_insert(m->free_tree, n);
+	m->free_bytes += n->size;
+	++m->free_blocks;
+}
+
+static inline void mem_free_remove(struct mem_alloc *m, struct mem_link *n)
+{
+	m->free_tree = mem_tree_remove(m->free_tree, n->address);
+	m->free_bytes -= n->size;
+	--m->free_blocks;
+}
+
+STATIC int mem_allocated_insert(struct mem_alloc *m, struct mem_link *n)
+{
+	fpga_result res;
+
+	if (!m->allocated_map.slots) {
+		res = opae_hash_map_init(&m->allocated_map,
+					 MEM_ALLOC_MAP_SLOTS,
+					 0,
+					 OPAE_HASH_MAP_UNIQUE_KEYSPACE,
+					 opae_u64_key_hash,
+					 opae_u64_key_compare,
+					 NULL,
+					 NULL);
+		if (res) {
+			ERR("opae_hash_map_init() failed\n");
+			return 1;
+		}
+	}
+
+	res = opae_hash_map_add(&m->allocated_map, (void *)n->address, n);
+	if (res) {
+		ERR("opae_hash_map_add() failed\n");
+		return 1;
+	}
+
+	m->allocated_bytes += n->size;
+	++m->allocated_blocks;
+	return 0;
+}
+
+static inline void mem_allocated_remove(struct mem_alloc *m,
+					struct mem_link *n)
+{
+	opae_hash_map_remove(&m->allocated_map, (void *)n->address);
+	m->allocated_bytes -= n->size;
+	--m->allocated_blocks;
+}
+
 void mem_alloc_init(struct mem_alloc *m)
 {
 	m->free.address = 0;
@@ -65,6 +332,12 @@ void mem_alloc_init(struct mem_alloc *m)
 	m->allocated.size = 0;
 	m->allocated.prev = &m->allocated;
 	m->allocated.next = &m->allocated;
+	m->free_tree = NULL;
+	memset(&m->allocated_map, 0, sizeof(m->allocated_map));
+	m->free_bytes = 0;
+	m->free_blocks = 0;
+	m->allocated_bytes = 0;
+	m->allocated_blocks = 0;
 }
 
 void mem_alloc_destroy(struct mem_alloc *m)
@@ -84,6 +357,9 @@ void mem_alloc_destroy(struct mem_alloc *m)
 		opae_free(trash);
 	}
 
+	if (m->allocated_map.slots)
+		opae_hash_map_destroy(&m->allocated_map);
+
 	mem_alloc_init(m);
 }
 
@@ -96,6 +372,10 @@ STATIC struct mem_link *mem_link_alloc(uint64_t address, uint64_t size)
 		m->size = size;
 		m->prev = m;
 		m->next = m;
+		m->left = NULL;
+		m->right = NULL;
+		m->max_size = size;
+		m->height = 1;
 	}
 	return m;
 }
@@ -154,37 +434,57 @@ STATIC void mem_alloc_coalesce(struct mem_link *head,
 int mem_alloc_add_free(struct mem_alloc *m, uint64_t address, uint64_t size)
 {
 	struct mem_link *node;
-	struct mem_link *p;
+	struct mem_link *prev;
+	struct mem_link *next;
 
-	node = mem_link_alloc(address, size);
-	if (!node) {
-		ERR("malloc() failed\n");
-		return 1;
+	prev = mem_tree_floor(m->free_tree, address);
+	if (prev && (address < prev->address + prev->size)) {
+		ERR("double free detected 0x%lx\n", address);
+		return 2;
 	}
 
-	for (p = m->free.next ; p != &m->free ; p = p->next) {
-		if (address < p->address) {
-			link_before(node, p);
-			mem_alloc_coalesce(&m->free, node);
-			return 0;
-		} else if (address == p->address) {
-			// double free
-			opae_free(node);
-			ERR("double free detected 0x%lx\n", address);
-			return 2;
-		} else {
-			// address > p->address
-			break;
+	next = prev ? prev->next : m->free.next;
+	if ((next != &m->free) && (address + size > next->address)) {
+		ERR("double free detected 0x%lx\n", address);
+		return 2;
+	}
+
+	if ((next != &m->free) && (address + size == next->address)) {
+		// Grow next down over the range. Its place in the address
+		// order is unchanged, so it stays in the tree. If that
+		// closes the gap to prev, prev leaves the tree and is
+		// coalesced into next.
+		next->address = address;
+		next->size += size;
+		m->free_bytes += size;
+
+		if (prev && (prev->address + prev->size == address)) {
+			m->free_tree = mem_tree_remove(m->free_tree,
+						       prev->address);
+			--m->free_blocks;
+			mem_alloc_coalesce(&m->free, prev);
 		}
 
+		mem_tree_refresh(m->free_tree, next->address);
+		return 0;
 	}
 
-	while ((address > p->address) && (p != &m->free)) {
-		p = p->next;
+	if (prev && (prev->address + prev->size == address)) {
+		// Grow prev up over the range, in place.
+		prev->size += size;
+		m->free_bytes += size;
+		mem_tree_refresh(m->free_tree, prev->address);
+		return 0;
+	}
+
+	node = mem_link_alloc(address, size);
+	if (!node) {
+		ERR("malloc() failed\n");
+		return 1;
 	}
 
-	link_before(node, p);
-	mem_alloc_coalesce(&m->free, node);
+	link_before(node, next);
+	mem_free_insert(m, node);
 
 	return 0;
 }
@@ -198,6 +498,9 @@ STATIC int mem_alloc_allocate_node(struct mem_alloc *m,
 
 	if (node->size == size) {
 		// If we have an exact fit, recycle the node struct.
+		if (mem_allocated_insert(m, node))
+			return 1;
+		mem_free_remove(m, node);
 		link_unlink(node);
 		link_before(node, &m->allocated);
 		*address = node->address;
@@ -212,8 +515,17 @@ STATIC int mem_alloc_allocate_node(struct mem_alloc *m,
 		return 1;
 	}
 
+	if (mem_allocated_insert(m, p)) {
+		opae_free(p);
+		return 1;
+	}
+
+	// Shrinking node from the front keeps its place in the
+	// address order, so it can stay in the tree.
 	node->address += size;
 	node->size -= size;
+	m->free_bytes -= size;
+	mem_tree_refresh(m->free_tree, node->address);
 
 	link_before(p, &m->allocated);
 	*address = p->address;
@@ -241,10 +553,17 @@ STATIC int mem_alloc_allocate_split_node(struct mem_alloc *m,
 			return 1;
 		}
 
+		if (mem_allocated_insert(m, p)) {
+			opae_free(p);
+			return 1;
+		}
+
 		link_before(p, &m->allocated);
 		*address = p->address;
 
 		node->size -= size;
+		m->free_bytes -= size;
+		mem_tree_refresh(m->free_tree, node->address);
 
 		return 0;
 	}
@@ -273,39 +592,69 @@ STATIC int mem_alloc_allocate_split_node(struct mem_alloc *m,
 		return 3;
 	}
 
+	if (mem_allocated_insert(m, p)) {
+		opae_free(p2);
+		opae_free(p);
+		return 4;
+	}
+
 	node->size = first_size;
+	m->free_bytes -= size + second_size;
+	mem_tree_refresh(m->free_tree, node->address);
 
 	link_before(p, &m->allocated);
 	*address = p->address;
 
 	link_after(p2, node);
+	mem_free_insert(m, p2);
 
 	return 0;
 }
 
-int mem_alloc_get(struct mem_alloc *m, uint64_t *address, uint64_t size)
+STATIC int mem_alloc_get_fit(struct mem_alloc *m,
+			     uint64_t *address,
+			     uint64_t size,
+			     uint64_t alignment)
 {
 	struct mem_link *p;
+	uint64_t aligned_addr = 0;
 
-	for (p = m->free.next ; p != &m->free ; p = p->next) {
-		uint64_t aligned_addr = ALIGNED(p->address, size);
-		if ((aligned_addr + size) <= (p->address + p->size)) { // First fit.
-			if (aligned_addr == p->address)
-				return mem_alloc_allocate_node(m,
-							       p,
-							       address,
-							       size);
-			else
-				return mem_alloc_allocate_split_node(m,
-								     p,
-								     aligned_addr,
-								     address,
-								     size);
-		}
+	p = mem_tree_first_fit(m->free_tree, 0, UINT64_MAX,
+			       size, alignment, &aligned_addr);
+	if (!p) {
+		ERR("no free block of sufficient size found\n");
+		return 1; // Out of memory.
 	}
 
-	ERR("no free block of sufficient size found\n");
-	return 1; // Out of memory.
+	if (aligned_addr == p->address)
+		return mem_alloc_allocate_node(m, p, address, size);
+
+	return mem_alloc_allocate_split_node(m,
+					     p,
+					     aligned_addr,
+					     address,
+					     size);
+}
+
+int mem_alloc_get(struct mem_alloc *m, uint64_t *address, uint64_t size)
+{
+	return mem_alloc_get_fit(m, address, size, size);
+}
+
+int mem_alloc_get_aligned(struct mem_alloc *m,
+			  uint64_t *address,
+			  uint64_t size,
+			  uint64_t alignment)
+{
+	if (!alignment)
+		alignment = 1;
+
+	if (alignment & (alignment - 1)) {
+		ERR("alignment 0x%lx is not a power of 2\n", alignment);
+		return 1;
+	}
+
+	return mem_alloc_get_fit(m, address, size, alignment);
 }
 
 STATIC int mem_alloc_free_node(struct mem_alloc *m,
@@ -317,6 +666,7 @@ STATIC int mem_alloc_free_node(struct mem_alloc *m,
 	address = node->address;
 	size = node->size;
 
+	mem_allocated_remove(m, node);
 	link_unlink(node);
 	opae_free(node);
 
@@ -325,14 +675,22 @@ STATIC int mem_alloc_free_node(struct mem_alloc *m,
 
 int mem_alloc_put(struct mem_alloc *m, uint64_t address)
 {
-	struct mem_link *p;
+	void *p;
 
-	for (p = m->allocated.next ; p != &m->allocated ; p = p->next) {
-		if (address == p->address) {
-			return mem_alloc_free_node(m, p);
-		}
-	}
+	if (m->allocated_map.slots &&
+	    !opae_hash_map_find(&m->allocated_map, (void *)address, &p))
+		return mem_alloc_free_node(m, (struct mem_link *)p);
 
 	ERR("attempt to free non-allocated 0x%lx\n", address);
 	return 1; // Address not found.
 }
+
+void mem_alloc_get_stats(struct mem_alloc *m,
+			 struct mem_alloc_stats *stats)
+{
+	stats->free_bytes = m->free_bytes;
+	stats->free_blocks = m->free_blocks;
+	stats->largest_free = mem_tree_max(m->free_tree);
+	stats->allocated_bytes = m->allocated_bytes;
+	stats->allocated_blocks = m->allocated_blocks;
+}
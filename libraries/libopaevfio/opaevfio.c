@@ -60,8 +60,12 @@
 #define ERR(format, ...)                               \
 fprintf(stderr, "%s:%u:%s() **ERROR** [%s] : " format, \
 	__SHORT_FILE__, __LINE__, __func__, strerror(errno), ##__VA_ARGS__)
+#define DBG(format, ...)                               \
+fprintf(stderr, "%s:%u:%s() **DEBUG** : " format,      \
+	__SHORT_FILE__, __LINE__, __func__, ##__VA_ARGS__)
 #else
 #define ERR(format, ...) do { } while (0)
+#define DBG(format, ...) do { } while (0)
 #endif
 
 STATIC struct opae_vfio_sparse_info *
@@ -601,25 +605,41 @@ out_free:
 	return iova_list;
 }
 
+#define SIZE_4K (4096UL)
+#define SIZE_2M (2UL * 1024 * 1024)
+#define SIZE_1G (1024UL * 1024 * 1024)
+
 STATIC int opae_vfio_iova_reserve(struct opae_vfio *v,
 				  uint64_t *size,
 				  uint64_t *iova)
 {
 	uint64_t page_size;
+	uint64_t alignment;
 
 	page_size = sysconf(_SC_PAGE_SIZE);
 	*size = page_size + ((*size - 1) & ~(page_size - 1));
 
-	return mem_alloc_get(&v->iova_alloc,
-			     iova,
-			     *size);
+	// Align to the largest IOMMU page size that the buffer can use,
+	// rather than to the buffer size, to limit fragmentation.
+	if (*size >= SIZE_1G)
+		alignment = SIZE_1G;
+	else if (*size >= SIZE_2M)
+		alignment = SIZE_2M;
+	else
+		alignment = page_size;
+
+	return mem_alloc_get_aligned(&v->iova_alloc,
+				     iova,
+				     *size,
+				     alignment);
 }
 
 STATIC struct opae_vfio_buffer *
 opae_vfio_create_buffer(uint8_t *vaddr,
 			size_t size,
 			uint64_t iova,
-			int flags)
+			int flags,
+			size_t requested_size)
 {
 	struct opae_vfio_buffer *b;
 	b = opae_malloc(sizeof(*b));
@@ -628,6 +648,7 @@ opae_vfio_create_buffer(uint8_t *vaddr,
 		b->buffer_size = size;
 		b->buffer_iova = iova;
 		b->flags = flags;
+		b->requested_size = requested_size;
 	}
 	return b;
 }
@@ -656,6 +677,9 @@ opae_vfio_destroy_buffer(struct opae_vfio *v,
 		ERR("mem_alloc_put(..., 0x%lx) failed\n",
 		    b->buffer_iova);
 
+	v->buf_requested -= b->requested_size;
+	v->buf_pinned -= b->buffer_size;
+
 	opae_free(b);
 }
 
@@ -679,6 +703,70 @@ opae_vfio_destroy_buffer(struct opae_vfio *v,
 #define FLAGS_1G (FLAGS_4K|MAP_1G_HUGEPAGE|MAP_HUGETLB)
 #endif
 
+/*
+ * Size a OPAE_VFIO_BUF_HUGE_MIX request: whole 1GB pages for the
+ * bulk of the request and 2MB pages for the remainder. On return,
+ * *len_1g holds the number of bytes to be backed by 1GB pages.
+ */
+STATIC size_t opae_vfio_huge_mix_size(size_t len, size_t *len_1g)
+{
+	size_t bulk = len & ~(SIZE_1G - 1);
+	size_t rem = (len - bulk + SIZE_2M - 1) & ~(SIZE_2M - 1);
+
+	if (rem == SIZE_1G) {
+		// Same footprint, fewer pages.
+		bulk += SIZE_1G;
+		rem = 0;
+	}
+
+	*len_1g = bulk;
+	return bulk + rem;
+}
+
+/*
+ * Map size bytes of virtually-contiguous hugepage memory, the first
+ * len_1g bytes of which are 1GB pages and the rest 2MB pages. The
+ * window is reserved up front so that the individual hugepage
+ * mappings can be placed back-to-back with MAP_FIXED. When the 1GB
+ * pool is exhausted, the bulk falls back to 2MB pages.
+ */
+STATIC uint8_t *opae_vfio_huge_mix_mmap(size_t size, size_t len_1g)
+{
+	size_t align = len_1g ? SIZE_1G : SIZE_2M;
+	uint8_t *resv;
+	uint8_t *vaddr;
+	size_t head;
+
+	resv = mmap(NULL, size + align, PROT_NONE,
+		    MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	if (resv == MAP_FAILED)
+		return MAP_FAILED;
+
+	vaddr = (uint8_t *)(((uint64_t)resv + align - 1) & ~(align - 1));
+	head = vaddr - resv;
+
+	if (head)
+		munmap(resv, head);
+	munmap(vaddr + size, align - head);
+
+	if (len_1g &&
+	    mmap(vaddr, len_1g, PROT_READ|PROT_WRITE,
+		 FLAGS_1G|MAP_FIXED, -1, 0) == MAP_FAILED) {
+		DBG("no 1GB huge pages, using 2MB pages for %lu bytes\n",
+		    len_1g);
+		len_1g = 0;
+	}
+
+	if ((size > len_1g) &&
+	    mmap(vaddr + len_1g, size - len_1g, PROT_READ|PROT_WRITE,
+		 FLAGS_2M|MAP_FIXED, -1, 0) == MAP_FAILED) {
+		munmap(vaddr, size);
+		return MAP_FAILED;
+	}
+
+	return vaddr;
+}
+
 STATIC int
 opae_vfio_buffer_mmap(struct opae_vfio *v,
 		      size_t *size,
@@ -692,6 +780,15 @@ opae_vfio_buffer_mmap(struct opae_vfio *v,
 	int res;
 	struct vfio_iommu_type1_dma_map dma_map;
 	struct vfio_iommu_type1_dma_unmap dma_unmap;
+	size_t len_1g = 0;
+	size_t requested_size = *size;
+
+	if ((flags & OPAE_VFIO_BUF_HUGE_MIX) &&
+	    !(flags & OPAE_VFIO_BUF_PREALLOCATED) &&
+	    (*size > SIZE_4K))
+		*size = opae_vfio_huge_mix_size(*size, &len_1g);
+	else
+		flags &= ~OPAE_VFIO_BUF_HUGE_MIX;
 
 	if (opae_vfio_iova_reserve(v, size, &ioaddr)) {
 		return 1;
@@ -699,7 +796,9 @@ opae_vfio_buffer_mmap(struct opae_vfio *v,
 
 	if (!(flags & OPAE_VFIO_BUF_PREALLOCATED)) {
 
-		if (*size > (2 * 1024 * 1024))
+		if (flags & OPAE_VFIO_BUF_HUGE_MIX)
+			vaddr = opae_vfio_huge_mix_mmap(*size, len_1g);
+		else if (*size > (2 * 1024 * 1024))
 			vaddr = mmap(ADDR, *size, PROT_READ|PROT_WRITE,
 				     FLAGS_1G, 0, 0);
 		else if (*size > 4096)
@@ -738,7 +837,8 @@ opae_vfio_buffer_mmap(struct opae_vfio *v,
 		goto out_munmap;
 	}
 
-	*node = opae_vfio_create_buffer(vaddr, *size, ioaddr, flags);
+	*node = opae_vfio_create_buffer(vaddr, *size, ioaddr, flags,
+					requested_size);
 	if (!*node) {
 		ERR("malloc failed\n");
 		mem_alloc_put(&v->iova_alloc, ioaddr);
@@ -803,6 +903,9 @@ int opae_vfio_buffer_allocate_ex(struct opae_vfio *v,
 	if (opae_hash_map_add(&v->cont_buffers, *buf, node)) {
 		ERR("opae_hash_map_add() failed\n");
 		res = 5;
+	} else {
+		v->buf_requested += node->requested_size;
+		v->buf_pinned += node->buffer_size;
 	}
 
 	if (pthread_mutex_unlock(&v->lock))
@@ -875,6 +978,31 @@ int opae_vfio_buffer_free(struct opae_vfio *v,
 	return res;
 }
 
+int opae_vfio_buffer_stats(struct opae_vfio *v,
+			   size_t *requested,
+			   size_t *pinned)
+{
+	if (!v) {
+		ERR("NULL param\n");
+		return 1;
+	}
+
+	if (pthread_mutex_lock(&v->lock)) {
+		ERR("pthread_mutex_lock() failed\n");
+		return 2;
+	}
+
+	if (requested)
+		*requested = v->buf_requested;
+	if (pinned)
+		*pinned = v->buf_pinned;
+
+	if (pthread_mutex_unlock(&v->lock))
+		ERR("pthread_mutex_unlock() failed\n");
+
+	return 0;
+}
+
 STATIC int
 opae_vfio_device_set_irqs(struct opae_vfio *v,
 			  uint32_t index,
@@ -1145,7 +1273,7 @@ STATIC int opae_vfio_init(struct opae_vfio *v,
 	mem_alloc_init(&v->iova_alloc);
 
 	result = opae_hash_map_init(&v->cont_buffers,
-				    19441, // num_buckets
+				    1024,  // num_buckets (grows as needed)
 				    0,     // hash_seed
 				    OPAE_HASH_MAP_UNIQUE_KEYSPACE,
 				    opae_u64_key_hash,
@@ -31,6 +31,7 @@
 #include <byteswap.h>
 #include <linux/limits.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <glob.h>
 #include <regex.h>
 #include <stdint.h>
@@ -539,20 +540,79 @@ static fpga_result vfio_reset(const pci_device_t *p, volatile uint8_t *port_base
 	return FPGA_OK;
 }
 
-int vfio_walk(pci_device_t *p)
+STATIC uint32_t vfio_irq_count(struct opae_vfio *device)
+{
+	struct opae_vfio_device_irq *irq =
+		device->device.irqs;
+
+	while (irq) {
+		if (irq->index == VFIO_PCI_MSIX_IRQ_INDEX)
+			return irq->count;
+		irq = irq->next;
+	}
+
+	return 0;
+}
+
+/*
+ * The VFIO group character device admits a single opener, so a bare
+ * open()/close() tells whether anyone (this process included) holds
+ * the group, without creating a container or programming the IOMMU.
+ */
+STATIC bool vfio_group_available(const char *addr)
+{
+	char group[64];
+	char path[PATH_MAX];
+	int fd;
+
+	memset(group, 0, sizeof(group));
+	if (read_pci_link(addr, "iommu_group", group, sizeof(group) - 1))
+		return false;
+
+	snprintf(path, sizeof(path), "/dev/vfio/%s", group);
+	fd = open(path, O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	close(fd);
+	return true;
+}
+
+/*
+ * An accelerator is unassigned when open_vfio_pair() would succeed:
+ * its group, and that of a vfio-pci bound physfn, are free.
+ */
+STATIC fpga_accelerator_state vfio_afu_state(const pci_device_t *p)
+{
+	char phys_device[PCIADDR_MAX];
+	char phys_driver[PATH_MAX];
+
+	if (!vfio_group_available(p->addr))
+		return FPGA_ACCELERATOR_ASSIGNED;
+
+	memset(phys_device, 0, sizeof(phys_device));
+	memset(phys_driver, 0, sizeof(phys_driver));
+	if (!read_pci_link(p->addr, "physfn", phys_device, PCIADDR_MAX-1) &&
+	    !read_pci_link(phys_device, "driver", phys_driver,
+				PATH_MAX-1) &&
+	    strstr(phys_driver, "vfio-pci") &&
+	    !vfio_group_available(phys_device))
+		return FPGA_ACCELERATOR_ASSIGNED;
+
+	return FPGA_ACCELERATOR_UNASSIGNED;
+}
+
+/*
+ * Walk the DFL of p through the already-open device v, refreshing
+ * p->tokens in place, and cache the result.
+ */
+STATIC int vfio_walk_device(pci_device_t *p, struct opae_vfio *v)
 {
 	int res = 0;
 
 	volatile uint8_t *mmio;
 	size_t size;
-	vfio_pair_t *pair = NULL;
 
-	res = open_vfio_pair(p->addr, &pair);
-	if (res) {
-		OPAE_DBG("error opening vfio device: %s", p->addr);
-		return res;
-	}
-	struct opae_vfio *v = pair->device;
 	// TODO: check PCIe capabilities (VSEC?) for hints to DFLs
 
 
@@ -607,6 +667,35 @@ int vfio_walk(pci_device_t *p)
 	// only check BAR 0 for an FPGA_ACCELERATOR, skip other BARs
 
 close:
+	if (!res) {
+		p->num_irqs = vfio_irq_count(v);
+		p->walked = true;
+	}
+	return res;
+}
+
+/*
+ * The DFL walk and IRQ count are cached after the first success.
+ * The DFL can only change (PR, port reset) while someone holds the
+ * device, so the cache is dropped whenever a holder is seen or a
+ * handle closes, and is refreshed by every vfio_fpgaOpen().
+ */
+int vfio_walk(pci_device_t *p)
+{
+	int res;
+	vfio_pair_t *pair = NULL;
+
+	if (p->walked)
+		return 0;
+
+	res = open_vfio_pair(p->addr, &pair);
+	if (res) {
+		OPAE_DBG("error opening vfio device: %s", p->addr);
+		return res;
+	}
+
+	res = vfio_walk_device(p, pair->device);
+
 	close_vfio_pair(&pair);
 	return res;
 }
@@ -658,6 +747,20 @@ fpga_result vfio_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 		OPAE_DBG("error opening vfio device");
 		goto out_attr_destroy;
 	}
+
+	// The cached walk may predate a PR or reset by an
+	// earlier holder of the device. Refresh it while we
+	// hold the device, and pick up the current AFU GUID.
+	if (vfio_walk_device(_token->device,
+			     _handle->vfio_pair->device)) {
+		OPAE_DBG("error walking vfio device");
+	} else if (_token->hdr.objtype == FPGA_ACCELERATOR) {
+		vfio_token *t = find_token(_token->device, _token->region);
+
+		if (t && _handle->token)
+			memcpy(_handle->token->hdr.guid, t->hdr.guid,
+			       sizeof(fpga_guid));
+	}
 	uint8_t *mmio = NULL;
 	size_t size;
 
@@ -701,11 +804,23 @@ fpga_result vfio_fpgaClose(fpga_handle handle)
 
 	ASSERT_NOT_NULL(h);
 
-	if (token_check(h->token))
+	if (token_check(h->token)) {
+		// The DFL may have changed while we held the device.
+		h->token->device->walked = false;
 		free(h->token);
-	else
+	} else
 		OPAE_MSG("invalid token in handle");
 
+	if (h->vfio_pair) {
+		size_t requested = 0;
+		size_t pinned = 0;
+
+		if (!opae_vfio_buffer_stats(h->vfio_pair->device,
+					    &requested, &pinned) && pinned)
+			OPAE_DBG("buffers requested %lu bytes, "
+				 "pinned %lu bytes", requested, pinned);
+	}
+
 	close_vfio_pair(&h->vfio_pair);
 	if (pthread_mutex_unlock(&h->lock) ||
 	    pthread_mutex_destroy(&h->lock)) {
@@ -797,9 +912,6 @@ fpga_result vfio_fpgaUpdateProperties(fpga_token token, fpga_properties prop)
 	SET_FIELD_VALID(_prop, FPGA_PROPERTY_INTERFACE);
 
 	if (t->hdr.objtype == FPGA_ACCELERATOR) {
-		vfio_pair_t *pair = NULL;
-		fpga_result res;
-
 		_prop->parent = NULL;
 		CLEAR_FIELD_VALID(_prop, FPGA_PROPERTY_PARENT);
 
@@ -813,15 +925,8 @@ fpga_result vfio_fpgaUpdateProperties(fpga_token token, fpga_properties prop)
 		SET_FIELD_VALID(_prop, FPGA_PROPERTY_NUM_INTERRUPTS);
 
 		SET_FIELD_VALID(_prop, FPGA_PROPERTY_ACCELERATOR_STATE);
-		res = open_vfio_pair(t->device->addr, &pair);
-		if (res == FPGA_OK) {
-			close_vfio_pair(&pair);
-			_prop->u.accelerator.state =
-				t->afu_state = FPGA_ACCELERATOR_UNASSIGNED;
-		} else {
-			_prop->u.accelerator.state =
-				t->afu_state = FPGA_ACCELERATOR_ASSIGNED;
-		}
+		_prop->u.accelerator.state =
+			t->afu_state = vfio_afu_state(t->device);
 
 	} else {
 		memcpy(_prop->guid, t->compat_id, sizeof(fpga_guid));
@@ -1041,6 +1146,115 @@ fpga_result vfio_fpgaWriteMMIO512(fpga_handle handle,
 	return FPGA_OK;
 }
 
+STATIC fpga_result vfio_check_mmio_vec(const fpga_mmio_vec *vec,
+				       uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0 ; i < count ; ++i) {
+		if ((vec[i].width != 32) && (vec[i].width != 64)) {
+			OPAE_MSG("Invalid MMIO width %u", vec[i].width);
+			return FPGA_INVALID_PARAM;
+		}
+		if (vec[i].offset % (vec[i].width / 8) != 0) {
+			OPAE_MSG("Misaligned MMIO access");
+			return FPGA_INVALID_PARAM;
+		}
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result vfio_fpgaReadMMIOv(fpga_handle handle,
+			       uint32_t mmio_num,
+			       fpga_mmio_vec *vec,
+			       uint32_t count)
+{
+	vfio_handle *h = handle_check(handle);
+	volatile uint8_t *ptr;
+	fpga_result res;
+	uint32_t i;
+
+	ASSERT_NOT_NULL(h);
+	ASSERT_NOT_NULL(vec);
+
+	vfio_token *t = h->token;
+
+	if (t->hdr.objtype == FPGA_DEVICE)
+		return FPGA_NOT_SUPPORTED;
+	if (mmio_num > t->user_mmio_count)
+		return FPGA_INVALID_PARAM;
+
+	res = vfio_check_mmio_vec(vec, count);
+	if (res)
+		return res;
+
+	if (pthread_mutex_lock(&h->lock)) {
+		OPAE_MSG("error locking handle mutex");
+		return FPGA_EXCEPTION;
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		ptr = get_user_offset(h, mmio_num, vec[i].offset);
+
+		if (vec[i].flags & FPGA_MMIO_FENCE)
+			__sync_synchronize();
+
+		if (vec[i].width == 32)
+			vec[i].value = *((volatile uint32_t *)ptr);
+		else
+			vec[i].value = *((volatile uint64_t *)ptr);
+	}
+
+	pthread_mutex_unlock(&h->lock);
+	return FPGA_OK;
+}
+
+fpga_result vfio_fpgaWriteMMIOv(fpga_handle handle,
+				uint32_t mmio_num,
+				const fpga_mmio_vec *vec,
+				uint32_t count)
+{
+	vfio_handle *h = handle_check(handle);
+	volatile uint8_t *ptr;
+	fpga_result res;
+	uint32_t i;
+
+	ASSERT_NOT_NULL(h);
+	ASSERT_NOT_NULL(vec);
+
+	vfio_token *t = h->token;
+
+	if (t->hdr.objtype == FPGA_DEVICE)
+		return FPGA_NOT_SUPPORTED;
+	if (mmio_num > t->user_mmio_count)
+		return FPGA_INVALID_PARAM;
+
+	res = vfio_check_mmio_vec(vec, count);
+	if (res)
+		return res;
+
+	if (pthread_mutex_lock(&h->lock)) {
+		OPAE_MSG("error locking handle mutex");
+		return FPGA_EXCEPTION;
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		ptr = get_user_offset(h, mmio_num, vec[i].offset);
+
+		if (vec[i].flags & FPGA_MMIO_FENCE)
+			__sync_synchronize();
+
+		if (vec[i].width == 32)
+			*((volatile uint32_t *)ptr) = (uint32_t)vec[i].value;
+		else
+			*((volatile uint64_t *)ptr) = vec[i].value;
+	}
+
+	pthread_mutex_unlock(&h->lock);
+	return FPGA_OK;
+}
+
 fpga_result vfio_fpgaMapMMIO(fpga_handle handle,
 			     uint32_t mmio_num,
 			     uint64_t **mmio_ptr)
@@ -1261,20 +1475,6 @@ dfh *next_feature(dfh *h)
 	return NULL;
 }
 
-STATIC uint32_t vfio_irq_count(struct opae_vfio *device)
-{
-	struct opae_vfio_device_irq *irq =
-		device->device.irqs;
-
-	while (irq) {
-		if (irq->index == VFIO_PCI_MSIX_IRQ_INDEX)
-			return irq->count;
-		irq = irq->next;
-	}
-
-	return 0;
-}
-
 fpga_result vfio_fpgaEnumerate(const fpga_properties *filters,
 			       uint32_t num_filters, fpga_token *tokens,
 			       uint32_t max_tokens, uint32_t *num_matches)
@@ -1284,13 +1484,16 @@ fpga_result vfio_fpgaEnumerate(const fpga_properties *filters,
 
 	while (dev) {
 		if (pci_matches_filters(filters, num_filters, dev)) {
+			fpga_accelerator_state state = vfio_afu_state(dev);
+
+			// Whoever holds the device may change its DFL.
+			if (state == FPGA_ACCELERATOR_ASSIGNED)
+				dev->walked = false;
+
 			vfio_walk(dev);
 			vfio_token *ptr = dev->tokens;
 
 			while (ptr) {
-				vfio_pair_t *pair = NULL;
-				fpga_result res;
-
 				ptr->hdr.vendor_id = (uint16_t)ptr->device->vendor;
 				ptr->hdr.device_id = (uint16_t)ptr->device->device;
 				ptr->hdr.subsystem_vendor_id = ptr->device->subsystem_vendor;
@@ -1305,15 +1508,8 @@ fpga_result vfio_fpgaEnumerate(const fpga_properties *filters,
 				if (ptr->hdr.objtype == FPGA_DEVICE)
 					memcpy(ptr->hdr.guid, ptr->compat_id, sizeof(fpga_guid));
 
-				res = open_vfio_pair(ptr->device->addr, &pair);
-				if (res == FPGA_OK) {
-					ptr->num_afu_irqs = vfio_irq_count(pair->device);
-
-					close_vfio_pair(&pair);
-					ptr->afu_state = FPGA_ACCELERATOR_UNASSIGNED;
-				} else {
-					ptr->afu_state = FPGA_ACCELERATOR_ASSIGNED;
-				}
+				ptr->num_afu_irqs = dev->num_irqs;
+				ptr->afu_state = state;
 
 				if (matches_filters(filters, num_filters, ptr)) {
 					if (matches < max_tokens) {
@@ -1409,13 +1605,21 @@ fpga_result vfio_fpgaPrepareBuffer(fpga_handle handle, uint64_t len,
 	struct opae_vfio *v = h->vfio_pair->device;
 	uint64_t iova = 0;
 	size_t sz;
-	if (len > HUGE_2M)
-		sz = ROUND_UP(len, HUGE_1G);
-	else if (len > 4096)
-		sz = ROUND_UP(len, HUGE_2M);
-	else
-		sz = 4096;
-	if (opae_vfio_buffer_allocate_ex(v, &sz, &virt, &iova, flags)) {
+	int vflags;
+	if (flags & FPGA_BUF_PREALLOCATED) {
+		vflags = OPAE_VFIO_BUF_PREALLOCATED;
+		if (len > HUGE_2M)
+			sz = ROUND_UP(len, HUGE_1G);
+		else if (len > 4096)
+			sz = ROUND_UP(len, HUGE_2M);
+		else
+			sz = 4096;
+	} else {
+		// libopaevfio sizes the 1G/2M page mix.
+		vflags = OPAE_VFIO_BUF_HUGE_MIX;
+		sz = len ? len : 4096;
+	}
+	if (opae_vfio_buffer_allocate_ex(v, &sz, &virt, &iova, vflags)) {
 		OPAE_DBG("could not allocate buffer");
 		return FPGA_EXCEPTION;
 	}
@@ -1430,6 +1634,9 @@ fpga_result vfio_fpgaPrepareBuffer(fpga_handle handle, uint64_t len,
 		goto out_free;
 	}
 
+	OPAE_DBG("buffer requested %lu bytes, pinned %lu bytes",
+		 len, binfo->buffer_size);
+
 	*buf_addr = virt;
 	*wsid = (uint64_t)binfo;
 
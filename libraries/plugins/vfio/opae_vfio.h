@@ -25,6 +25,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #ifndef _OPAE_VFIO_PLUGIN_H
 #define _OPAE_VFIO_PLUGIN_H
+#include <stdbool.h>
 #include <opae/vfio.h>
 #include <opae/fpga.h>
 
@@ -90,6 +91,8 @@ typedef struct _pci_device {
 	uint16_t subsystem_vendor;
 	uint16_t subsystem_device;
 	struct _vfio_token *tokens;
+	bool walked;       // tokens and num_irqs hold the DFL walk results
+	uint32_t num_irqs; // MSI-X vector count
 	struct _pci_device *next;
 } pci_device_t;
 
@@ -148,6 +151,7 @@ int pci_discover(void);
 int features_discover(void);
 pci_device_t *get_pci_device(char addr[PCIADDR_MAX]);
 void free_device_list(void);
+vfio_token *find_token(const pci_device_t *p, uint32_t region);
 vfio_token *get_token(pci_device_t *p, uint32_t region, int type);
 fpga_result get_guid(uint64_t *h, fpga_guid guid);
 #endif
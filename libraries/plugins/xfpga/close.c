@@ -50,6 +50,7 @@ fpga_result __XFPGA_API__ xfpga_fpgaClose(fpga_handle handle)
 {
 	struct _fpga_handle *_handle = (struct _fpga_handle *)handle;
 	fpga_result result = FPGA_OK;
+	uint32_t i;
 	int err = 0;
 
 	result = handle_check_and_lock(_handle);
@@ -66,6 +67,11 @@ fpga_result __XFPGA_API__ xfpga_fpgaClose(fpga_handle handle)
 	}
 
 	wsid_tracker_cleanup(_handle->wsid_root, NULL);
+
+	// No lock-free MMIO access may still be using a region once
+	// it is unmapped below.
+	for (i = 0 ; i < XFPGA_MAX_MMIO_REGIONS ; ++i)
+		mmio_withdraw_region(_handle, i);
 	wsid_tracker_cleanup(_handle->mmio_root, unmap_mmio_region);
 	free_umsg_buffer(handle);
 
@@ -88,4 +88,7 @@ fpga_result prop_check_and_lock(struct _fpga_properties *prop);
 fpga_result handle_check_and_lock(struct _fpga_handle *handle);
 fpga_result event_handle_check_and_lock(struct _fpga_event_handle *eh);
 
+/* Unpublish an MMIO region and wait out its lock-free readers */
+void mmio_withdraw_region(struct _fpga_handle *_handle, uint32_t mmio_num);
+
 #endif // ___FPGA_COMMON_INT_H__
@@ -170,6 +170,38 @@ fpga_result get_afu_metric_value(fpga_handle handle,
 	return result;
 }
 
+// Reads the value of one enumerated AFU metric
+fpga_result get_afu_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric)
+{
+	fpga_result result                           = FPGA_OK;
+	struct metric_bbb_value metric_csr;
+
+	if (handle == NULL ||
+		_fpga_enum_metric == NULL ||
+		fpga_metric == NULL) {
+		OPAE_ERR("Invalid Input Paramters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	memset(&metric_csr, 0, sizeof(metric_csr));
+
+	fpga_metric->metric_num = _fpga_enum_metric->metric_num;
+	fpga_metric->isvalid = false;
+
+	result = xfpga_fpgaReadMMIO64(handle, 0, _fpga_enum_metric->mmio_offset, &metric_csr.csr);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to get metric");
+		return result;
+	}
+
+	fpga_metric->value.ivalue = metric_csr.value;
+	fpga_metric->isvalid = true;
+
+	return result;
+}
+
 fpga_result add_afu_metrics_vector(fpga_metric_vector *vector,
 				  uint64_t *metric_id,
 				  uint64_t group_value,
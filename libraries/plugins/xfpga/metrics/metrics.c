@@ -33,6 +33,8 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <time.h>
+
 #include "opae/access.h"
 #include "opae/utils.h"
 #include "common_int.h"
@@ -345,8 +347,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaGetMetricsByName(fpga_handle handle,
 	if (objtype == FPGA_ACCELERATOR) {
 		// get AFU metrics
 		for (i = 0; i < num_metric_names; i++) {
-			result = parse_metric_num_name(metrics_names[i],
-							&(_handle->fpga_enum_metric_vector),
+			result = find_metric_num_by_name(_handle,
+							metrics_names[i],
 							&metric_num);
 			if (result != FPGA_OK) {
 				OPAE_MSG("Invalid input metrics string= %s", metrics_names[i]);
@@ -377,8 +379,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaGetMetricsByName(fpga_handle handle,
 		// get FME metrics
 		for (i = 0; i < num_metric_names; i++) {
 
-			result = parse_metric_num_name(metrics_names[i],
-							&(_handle->fpga_enum_metric_vector),
+			result = find_metric_num_by_name(_handle,
+							metrics_names[i],
 							&metric_num);
 			if (result != FPGA_OK) {
 				OPAE_ERR("Invalid input metrics string= %s", metrics_names[i]);
@@ -420,3 +422,112 @@ out_unlock:
 	}
 	return result;
 }
+
+fpga_result __XFPGA_API__ xfpga_fpgaGetMetricsSnapshot(fpga_handle handle,
+						fpga_metric *metrics,
+						uint64_t *num_metrics,
+						uint64_t *timestamp_ns)
+{
+	fpga_result result                          = FPGA_OK;
+	struct _fpga_handle *_handle                = (struct _fpga_handle *)handle;
+	struct _fpga_enum_metric *_fpga_enum_metric = NULL;
+	int err                                     = 0;
+	uint64_t i                                  = 0;
+	uint64_t num_enun_metrics                   = 0;
+	uint64_t found                              = 0;
+	struct timespec ts;
+	fpga_objtype objtype;
+
+	if (_handle == NULL) {
+		OPAE_ERR("NULL fpga handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	result = handle_check_and_lock(_handle);
+	if (result)
+		return result;
+
+	if (_handle->fddev < 0) {
+		OPAE_ERR("Invalid handle file descriptor");
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	if (num_metrics == NULL) {
+		OPAE_ERR("Invalid Input parameters");
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	result = enum_fpga_metrics(handle);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to Discover Metrics");
+		result = FPGA_NOT_FOUND;
+		goto out_unlock;
+	}
+
+	result = fpga_vector_total(&(_handle->fpga_enum_metric_vector), &num_enun_metrics);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to get metric total");
+		goto out_unlock;
+	}
+
+	// Size query
+	if (metrics == NULL) {
+		*num_metrics = num_enun_metrics;
+		result = num_enun_metrics ? FPGA_OK : FPGA_NOT_FOUND;
+		goto out_unlock;
+	}
+
+	result = get_fpga_object_type(handle, &objtype);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to get object type");
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	if (*num_metrics > num_enun_metrics)
+		*num_metrics = num_enun_metrics;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	if (timestamp_ns)
+		*timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+	// One pass over the enumerated metrics. For BMC metrics the
+	// first read fills the sensor cache and the rest are served
+	// from it, so all values come from the same sample.
+	for (i = 0; i < *num_metrics; i++) {
+
+		_fpga_enum_metric = (struct _fpga_enum_metric *)
+			fpga_vector_get(&(_handle->fpga_enum_metric_vector), i);
+
+		memset(&metrics[i], 0, sizeof(metrics[i]));
+		metrics[i].metric_num = _fpga_enum_metric->metric_num;
+
+		if (objtype == FPGA_ACCELERATOR)
+			result = get_afu_enum_metric_value(handle,
+							   _fpga_enum_metric,
+							   &metrics[i]);
+		else if (objtype == FPGA_DEVICE)
+			result = get_fme_enum_metric_value(handle,
+							   _fpga_enum_metric,
+							   &metrics[i]);
+		else
+			result = FPGA_INVALID_PARAM;
+
+		if (result == FPGA_OK)
+			found++;
+	}
+
+	result = found ? FPGA_OK : FPGA_NOT_FOUND;
+
+out_unlock:
+
+	clear_cached_values(_handle);
+
+	err = pthread_mutex_unlock(&_handle->lock);
+	if (err) {
+		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+	}
+	return result;
+}
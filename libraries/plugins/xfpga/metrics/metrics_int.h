@@ -202,6 +202,21 @@ fpga_result parse_metric_num_name(const char *search_string,
 				fpga_metric_vector *fpga_enum_metrics_vector,
 				uint64_t *metric_num);
 
+fpga_result build_metric_name_index(struct _fpga_handle *_handle);
+
+void free_metric_name_index(struct _fpga_handle *_handle);
+
+fpga_result find_metric_num_by_name(struct _fpga_handle *_handle,
+				const char *search_string,
+				uint64_t *metric_num);
+
+struct _fpga_enum_metric *find_enum_metric(fpga_metric_vector *enum_vector,
+					uint64_t metric_num);
+
+fpga_result get_fme_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric);
+
 fpga_result enum_bmc_metrics_info(struct _fpga_handle *_handle,
 				fpga_metric_vector *vector,
 				uint64_t *metric_id,
@@ -233,6 +248,10 @@ fpga_result get_afu_metric_value(fpga_handle handle,
 				uint64_t metric_num,
 				struct fpga_metric *fpga_metric);
 
+fpga_result get_afu_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric);
+
 fpga_result add_afu_metrics_vector(fpga_metric_vector *vector,
 				uint64_t *metric_id,
 				uint64_t group_value,
@@ -67,6 +67,79 @@
 #define VOLTAMP_HIGH_LIMIT             500.00
 #define VOLTAMP_LOW_LIMIT              0.00
 
+// Resolve the valid value range of a max10 metric from its name.
+// Returns false when the metric has no limits.
+STATIC bool max10_metric_limits(const char *metric_name,
+				double *low, double *high)
+{
+	if (strstr(metric_name, DFL_POWER)) {
+		*low = POWER_LOW_LIMIT;
+		*high = POWER_HIGH_LIMIT;
+	} else if (strstr(metric_name, DFL_VOLTAGE) ||
+		   strstr(metric_name, DFL_CURRENT)) {
+		*low = VOLTAMP_LOW_LIMIT;
+		*high = VOLTAMP_HIGH_LIMIT;
+	} else if (strstr(metric_name, DFL_TEMPERATURE)) {
+		*low = THERMAL_LOW_LIMIT;
+		*high = THERMAL_HIGH_LIMIT;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// Read metric_sysfs through a descriptor that stays open
+// for the life of the enumerated metric.
+STATIC fpga_result max10_read_u64(struct _fpga_enum_metric *_fpga_enum_metric,
+				  uint64_t *value)
+{
+	char buf[64];
+	char *endptr = NULL;
+	ssize_t res;
+
+	if (!_fpga_enum_metric->value_fd_valid) {
+		_fpga_enum_metric->value_fd =
+			opae_open(_fpga_enum_metric->metric_sysfs, O_RDONLY);
+		if (_fpga_enum_metric->value_fd < 0) {
+			OPAE_MSG("open(%s) failed",
+				 _fpga_enum_metric->metric_sysfs);
+			return FPGA_NOT_FOUND;
+		}
+		_fpga_enum_metric->value_fd_valid = true;
+	}
+
+	do {
+		res = pread(_fpga_enum_metric->value_fd,
+			    buf, sizeof(buf) - 1, 0);
+	} while (res < 0 && errno == EINTR);
+
+	if (res <= 0) {
+		OPAE_MSG("Read from %s failed",
+			 _fpga_enum_metric->metric_sysfs);
+		opae_close(_fpga_enum_metric->value_fd);
+		_fpga_enum_metric->value_fd_valid = false;
+		return FPGA_EXCEPTION;
+	}
+	buf[res] = '\0';
+
+	*value = strtoull(buf, &endptr, 0);
+	if (endptr == buf) {
+		OPAE_MSG("Invalid value in %s",
+			 _fpga_enum_metric->metric_sysfs);
+		return FPGA_EXCEPTION;
+	}
+
+	return FPGA_OK;
+}
+
+void max10_close_metric(struct _fpga_enum_metric *_fpga_enum_metric)
+{
+	if (_fpga_enum_metric->value_fd_valid) {
+		opae_close(_fpga_enum_metric->value_fd);
+		_fpga_enum_metric->value_fd_valid = false;
+	}
+}
+
 
 fpga_result read_sensor_sysfs_file(const char *sysfs, const char *file,
 			void **buf, uint32_t *tot_bytes_ret)
@@ -347,6 +420,18 @@ fpga_result  dfl_enum_max10_metrics_info(struct _fpga_handle *_handle,
 			goto out;
 		}
 
+		// Resolve the limits now rather than on every read.
+		if (vector->total) {
+			struct _fpga_enum_metric *added =
+				(struct _fpga_enum_metric *)
+				fpga_vector_get(vector, vector->total - 1);
+
+			added->has_limits =
+				max10_metric_limits(added->metric_name,
+						    &added->low_limit,
+						    &added->high_limit);
+		}
+
 		*metric_num = *metric_num + 1;
 
 	} // end for loop
@@ -362,6 +447,9 @@ fpga_result read_max10_value(struct _fpga_enum_metric *_fpga_enum_metric,
 {
 	fpga_result result     = FPGA_OK;
 	uint64_t value         = 0;
+	double low;
+	double high;
+	bool has_limits;
 
 	if (_fpga_enum_metric == NULL ||
 		dvalue == NULL) {
@@ -369,7 +457,7 @@ fpga_result read_max10_value(struct _fpga_enum_metric *_fpga_enum_metric,
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = sysfs_read_u64(_fpga_enum_metric->metric_sysfs, &value);
+	result = max10_read_u64(_fpga_enum_metric, &value);
 	if (result != FPGA_OK) {
 		OPAE_MSG("Failed to read Metrics values");
 		return result;
@@ -378,27 +466,17 @@ fpga_result read_max10_value(struct _fpga_enum_metric *_fpga_enum_metric,
 	*dvalue = ((double)value / MILLI);
 
 	// Check for limits
-	if (strstr(_fpga_enum_metric->metric_name, DFL_POWER)) {
-
-		if (*dvalue  < POWER_LOW_LIMIT || *dvalue  > POWER_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	} else if (strstr(_fpga_enum_metric->metric_name, DFL_VOLTAGE)) {
-
-		if (*dvalue < VOLTAMP_LOW_LIMIT || *dvalue > VOLTAMP_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	} else if (strstr(_fpga_enum_metric->metric_name, DFL_CURRENT)) {
-
-		if (*dvalue < VOLTAMP_LOW_LIMIT || *dvalue > VOLTAMP_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	} else if (strstr(_fpga_enum_metric->metric_name, DFL_TEMPERATURE)) {
-
-		if (*dvalue < THERMAL_LOW_LIMIT || *dvalue > THERMAL_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
+	if (_fpga_enum_metric->has_limits) {
+		has_limits = true;
+		low = _fpga_enum_metric->low_limit;
+		high = _fpga_enum_metric->high_limit;
+	} else {
+		has_limits = max10_metric_limits(_fpga_enum_metric->metric_name,
+						 &low, &high);
 	}
 
+	if (has_limits && (*dvalue < low || *dvalue > high))
+		result = FPGA_EXCEPTION;
+
 	return result;
 }
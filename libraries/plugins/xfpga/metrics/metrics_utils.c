@@ -34,6 +34,7 @@
 #endif // HAVE_CONFIG_H
 
 #include <string.h>
+#include <ctype.h>
 #include <glob.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -156,6 +157,11 @@ fpga_result add_metric_vector(fpga_metric_vector *vector,
 	fpga_enum_metric->hw_type = hw_type;
 	fpga_enum_metric->metric_num = metric_num;
 	fpga_enum_metric->mmio_offset = mmio_offset;
+	fpga_enum_metric->has_limits = false;
+	fpga_enum_metric->low_limit = 0.0;
+	fpga_enum_metric->high_limit = 0.0;
+	fpga_enum_metric->value_fd_valid = false;
+	fpga_enum_metric->value_fd = -1;
 
 	fpga_vector_push(vector, fpga_enum_metric);
 
@@ -386,6 +392,146 @@ fpga_result  enum_bmc_metrics_info(struct _fpga_handle *_handle,
 	return result;
 }
 
+// Case-insensitive FNV-1a, to match the strcasecmp() lookups.
+STATIC uint64_t metric_name_hash(const char *name)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	while (*name) {
+		h ^= (uint64_t)tolower((unsigned char)*name++);
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+void free_metric_name_index(struct _fpga_handle *_handle)
+{
+	if (_handle->metric_name_index) {
+		opae_free(_handle->metric_name_index);
+		_handle->metric_name_index = NULL;
+	}
+	_handle->metric_name_index_size = 0;
+}
+
+// Build an open-addressed index from metric_name to vector index.
+// When names repeat, the first metric keeps the slot, as with the
+// linear search in parse_metric_num_name().
+fpga_result build_metric_name_index(struct _fpga_handle *_handle)
+{
+	uint64_t num_enun_metrics = 0;
+	uint32_t size = 16;
+	uint64_t i;
+
+	free_metric_name_index(_handle);
+
+	if (fpga_vector_total(&(_handle->fpga_enum_metric_vector),
+			      &num_enun_metrics) != FPGA_OK ||
+	    !num_enun_metrics)
+		return FPGA_OK;
+
+	if (num_enun_metrics >= UINT32_MAX / 2)
+		return FPGA_NOT_SUPPORTED;
+
+	// Keep the load factor at or below 1/2.
+	while (size < 2 * num_enun_metrics)
+		size <<= 1;
+
+	_handle->metric_name_index = opae_calloc(size, sizeof(uint32_t));
+	if (!_handle->metric_name_index) {
+		OPAE_ERR("Failed to allocate memory");
+		return FPGA_NO_MEMORY;
+	}
+	_handle->metric_name_index_size = size;
+
+	for (i = 0; i < num_enun_metrics; i++) {
+		struct _fpga_enum_metric *m = (struct _fpga_enum_metric *)
+			fpga_vector_get(&(_handle->fpga_enum_metric_vector), i);
+		uint32_t slot;
+
+		if (!m)
+			continue;
+
+		slot = (uint32_t)metric_name_hash(m->metric_name) & (size - 1);
+		while (_handle->metric_name_index[slot]) {
+			struct _fpga_enum_metric *other =
+				(struct _fpga_enum_metric *)
+				fpga_vector_get(&(_handle->fpga_enum_metric_vector),
+					_handle->metric_name_index[slot] - 1);
+			if (!strcasecmp(other->metric_name, m->metric_name))
+				break;
+			slot = (slot + 1) & (size - 1);
+		}
+
+		if (!_handle->metric_name_index[slot])
+			_handle->metric_name_index[slot] = (uint32_t)(i + 1);
+	}
+
+	return FPGA_OK;
+}
+
+// Looks up a metric by name, through the hash index when one was built.
+fpga_result find_metric_num_by_name(struct _fpga_handle *_handle,
+				const char *search_string,
+				uint64_t *metric_num)
+{
+	uint32_t size = _handle->metric_name_index_size;
+	uint32_t slot;
+
+	if (search_string == NULL || metric_num == NULL) {
+		OPAE_ERR("Invalid Input Paramters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (!_handle->metric_name_index)
+		return parse_metric_num_name(search_string,
+					     &(_handle->fpga_enum_metric_vector),
+					     metric_num);
+
+	slot = (uint32_t)metric_name_hash(search_string) & (size - 1);
+	while (_handle->metric_name_index[slot]) {
+		struct _fpga_enum_metric *m = (struct _fpga_enum_metric *)
+			fpga_vector_get(&(_handle->fpga_enum_metric_vector),
+					_handle->metric_name_index[slot] - 1);
+
+		if (m && !strcasecmp(m->metric_name, search_string)) {
+			*metric_num = m->metric_num;
+			return FPGA_OK;
+		}
+		slot = (slot + 1) & (size - 1);
+	}
+
+	return FPGA_NOT_FOUND;
+}
+
+// Metrics are numbered in enumeration order, so metric_num is
+// normally its own vector index. Fall back to a search otherwise.
+struct _fpga_enum_metric *find_enum_metric(fpga_metric_vector *enum_vector,
+					   uint64_t metric_num)
+{
+	struct _fpga_enum_metric *m;
+	uint64_t num_enun_metrics = 0;
+	uint64_t i;
+
+	if (fpga_vector_total(enum_vector, &num_enun_metrics) != FPGA_OK)
+		return NULL;
+
+	if (metric_num < num_enun_metrics) {
+		m = (struct _fpga_enum_metric *)
+			fpga_vector_get(enum_vector, metric_num);
+		if (m && m->metric_num == metric_num)
+			return m;
+	}
+
+	for (i = 0; i < num_enun_metrics; i++) {
+		m = (struct _fpga_enum_metric *)fpga_vector_get(enum_vector, i);
+		if (m && m->metric_num == metric_num)
+			return m;
+	}
+
+	return NULL;
+}
+
 // frees metrics info vector
 fpga_result free_fpga_enum_metrics_vector(struct _fpga_handle *_handle)
 {
@@ -409,10 +555,19 @@ fpga_result free_fpga_enum_metrics_vector(struct _fpga_handle *_handle)
 		return FPGA_INVALID_PARAM;
 	}
 
+	for (i = 0; i < num_enun_metrics; i++) {
+		struct _fpga_enum_metric *m = (struct _fpga_enum_metric *)
+			fpga_vector_get(&(_handle->fpga_enum_metric_vector), i);
+		if (m)
+			max10_close_metric(m);
+	}
+
 	for (i = 0; i < num_enun_metrics; i++) {
 		fpga_vector_delete(&(_handle->fpga_enum_metric_vector), i);
 	}
 
+	free_metric_name_index(_handle);
+
 	fpga_vector_free(&(_handle->fpga_enum_metric_vector));
 
 	if (_handle->bmc_handle) {
@@ -604,6 +759,8 @@ fpga_result enum_fpga_metrics(fpga_handle handle)
 
 	if (result != FPGA_OK)
 		free_fpga_enum_metrics_vector(_handle);
+	else if (build_metric_name_index(_handle) != FPGA_OK)
+		OPAE_MSG("Failed to index metric names");
 
 	_handle->metric_enum_status = true;
 
@@ -778,81 +935,80 @@ fpga_result get_pwr_thermal_max10_value(const char *sysfs_path,
 
 
 
-// Reads fme metric value
-fpga_result  get_fme_metric_value(fpga_handle handle,
-					fpga_metric_vector *enum_vector,
-					uint64_t metric_num,
-					struct fpga_metric *fpga_metric)
+// Reads the value of one enumerated fme metric
+fpga_result get_fme_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric)
 {
-	fpga_result result                          = FPGA_OK;
-	uint64_t index                              = 0;
-	struct _fpga_enum_metric *_fpga_enum_metric = NULL;
-	uint64_t num_enun_metrics                  = 0;
+	fpga_result result = FPGA_NOT_FOUND;
 	metric_value value = {0};
 
-	if (enum_vector == NULL ||
+	if (_fpga_enum_metric == NULL ||
 		fpga_metric == NULL) {
 		OPAE_ERR("Invalid Input Paramters");
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = fpga_vector_total(enum_vector, &num_enun_metrics);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to get metric total");
-		return FPGA_NOT_FOUND;
-	}
-
 	fpga_metric->isvalid = false;
-	result = FPGA_NOT_FOUND;
-	for (index = 0; index < num_enun_metrics ; index++) {
-
-		_fpga_enum_metric = (struct _fpga_enum_metric *)	fpga_vector_get(enum_vector, index);
 
-		if (metric_num == _fpga_enum_metric->metric_num) {
+	// DCP Power & Thermal
+	if ((_fpga_enum_metric->hw_type == FPGA_HW_DCP_RC) &&
+		((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
+		(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
 
-			// Found Metic
-			memset(&value, 0, sizeof(value));
+		result  = get_bmc_metrics_values(handle, _fpga_enum_metric, fpga_metric);
+		if (result != FPGA_OK) {
+			OPAE_MSG("Failed to get BMC metric value");
+		} else {
+			fpga_metric->isvalid = true;
+		}
+		fpga_metric->metric_num = _fpga_enum_metric->metric_num;
 
-			// DCP Power & Thermal
-			if ((_fpga_enum_metric->hw_type == FPGA_HW_DCP_RC) &&
-				((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
-				(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
+	}
 
+	// Read power theraml values from Max10
+	if (((_fpga_enum_metric->hw_type == FPGA_HW_DCP_N3000) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_DCP_D5005) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_DCP_N5010)) &&
+		((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
+		(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
 
-				result  = get_bmc_metrics_values(handle, _fpga_enum_metric, fpga_metric);
-				if (result != FPGA_OK) {
-					OPAE_MSG("Failed to get BMC metric value");
-				} else {
-					fpga_metric->isvalid = true;
-				}
-				fpga_metric->metric_num = metric_num;
+		result = read_max10_value(_fpga_enum_metric, &value.dvalue);
+		if (result != FPGA_OK) {
+			OPAE_MSG("Failed to get Max10 metric value");
+		} else {
+			fpga_metric->isvalid = true;
+		}
+		fpga_metric->value = value;
+		fpga_metric->metric_num = _fpga_enum_metric->metric_num;
 
-			 }
+	}
 
+	return result;
+}
 
-			// Read power theraml values from Max10
-			if (((_fpga_enum_metric->hw_type == FPGA_HW_DCP_N3000) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_DCP_D5005) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_DCP_N5010)) &&
-				((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
-				(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
+// Reads fme metric value
+fpga_result  get_fme_metric_value(fpga_handle handle,
+					fpga_metric_vector *enum_vector,
+					uint64_t metric_num,
+					struct fpga_metric *fpga_metric)
+{
+	struct _fpga_enum_metric *_fpga_enum_metric = NULL;
 
-				result = read_max10_value(_fpga_enum_metric, &value.dvalue);
-				if (result != FPGA_OK) {
-					OPAE_MSG("Failed to get Max10 metric value");
-				} else {
-					fpga_metric->isvalid = true;
-				}
-				fpga_metric->value = value;
-				fpga_metric->metric_num = metric_num;
+	if (enum_vector == NULL ||
+		fpga_metric == NULL) {
+		OPAE_ERR("Invalid Input Paramters");
+		return FPGA_INVALID_PARAM;
+	}
 
-			}
+	fpga_metric->isvalid = false;
 
-			break;
-		}
-	}
+	_fpga_enum_metric = find_enum_metric(enum_vector, metric_num);
+	if (!_fpga_enum_metric)
+		return FPGA_NOT_FOUND;
 
-	return result;
+	return get_fme_enum_metric_value(handle, _fpga_enum_metric,
+					 fpga_metric);
 }
 
 
@@ -38,6 +38,7 @@
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -133,6 +134,14 @@ STATIC fpga_result map_mmio_region(fpga_handle handle, uint32_t mmio_num)
 		}
 	}
 
+	if (mmio_num < XFPGA_MAX_MMIO_REGIONS) {
+		struct _fpga_mmio_region *region =
+			&_handle->mmio_regions[mmio_num];
+		region->len = rinfo.size;
+		__atomic_store_n(&region->base, (uint8_t *)addr,
+				 __ATOMIC_RELEASE);
+	}
+
 	return FPGA_OK;
 }
 
@@ -162,44 +171,160 @@ STATIC fpga_result find_or_map_wm(fpga_handle handle, uint32_t mmio_num,
 	return FPGA_OK;
 }
 
-fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO32(fpga_handle handle,
-					 uint32_t mmio_num,
-					 uint64_t offset,
-					 uint32_t value)
+/*
+ * Pin an MMIO region for the duration of one access or batch. A region
+ * published by map_mmio_region() is pinned without taking any lock, by
+ * counting the caller as a reader of it; xfpga_fpgaUnmapMMIO() waits for
+ * the reader count to drain before it unmaps the region. Regions that are
+ * not yet published, or that have no slot in mmio_regions, are accessed
+ * with the handle lock held. Each successful pin must be paired with
+ * mmio_unpin_region(), passing back *locked.
+ */
+STATIC fpga_result mmio_pin_region(struct _fpga_handle *_handle,
+				   uint32_t mmio_num,
+				   uint8_t **base,
+				   uint64_t *len,
+				   bool *locked)
 {
-
-	int err;
-	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
 	struct wsid_map *wm = NULL;
 	fpga_result result = FPGA_OK;
+	int err;
 
-	if (offset % sizeof(uint32_t) != 0) {
-		OPAE_MSG("Misaligned MMIO access");
+	ASSERT_NOT_NULL(_handle);
+
+	if (_handle->magic != FPGA_HANDLE_MAGIC) {
+		OPAE_MSG("Invalid handle object");
 		return FPGA_INVALID_PARAM;
 	}
 
+	if (mmio_num < XFPGA_MAX_MMIO_REGIONS) {
+		struct _fpga_mmio_region *region =
+			&_handle->mmio_regions[mmio_num];
+		// Pairs with the store/load order in xfpga_fpgaUnmapMMIO():
+		// either we see the withdrawn base, or unmap sees our count.
+		__atomic_add_fetch(&region->readers, 1, __ATOMIC_SEQ_CST);
+		*base = __atomic_load_n(&region->base, __ATOMIC_SEQ_CST);
+		if (*base) {
+			*len = region->len;
+			*locked = false;
+			return FPGA_OK;
+		}
+		__atomic_sub_fetch(&region->readers, 1, __ATOMIC_RELEASE);
+	}
+
 	result = handle_check_and_lock(_handle);
 	if (result)
 		return result;
 
-	result = find_or_map_wm(handle, mmio_num, &wm);
+	result = find_or_map_wm(_handle, mmio_num, &wm);
+	if (result) {
+		err = pthread_mutex_unlock(&_handle->lock);
+		if (err) {
+			OPAE_ERR("pthread_mutex_unlock() failed: %s",
+				 strerror(err));
+		}
+		return result;
+	}
+
+	*base = (uint8_t *)wm->offset;
+	*len = wm->len;
+	*locked = true;
+	return FPGA_OK;
+}
+
+/*
+ * Withdraw a region from the lock-free MMIO path, then wait for
+ * accesses that pinned it before the withdrawal to finish. New
+ * accesses see a NULL base and queue on the handle lock, which the
+ * caller must hold. Must be called before the region is unmapped.
+ */
+void mmio_withdraw_region(struct _fpga_handle *_handle, uint32_t mmio_num)
+{
+	struct _fpga_mmio_region *region;
+
+	if (mmio_num >= XFPGA_MAX_MMIO_REGIONS)
+		return;
+
+	region = &_handle->mmio_regions[mmio_num];
+	__atomic_store_n(&region->base, NULL, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&region->readers, __ATOMIC_SEQ_CST))
+		sched_yield();
+}
+
+/* Release a region pinned by mmio_pin_region(). */
+STATIC void mmio_unpin_region(struct _fpga_handle *_handle,
+			      uint32_t mmio_num,
+			      bool locked)
+{
+	int err;
+
+	if (locked) {
+		err = pthread_mutex_unlock(&_handle->lock);
+		if (err) {
+			OPAE_ERR("pthread_mutex_unlock() failed: %s",
+				 strerror(err));
+		}
+		return;
+	}
+
+	__atomic_sub_fetch(&_handle->mmio_regions[mmio_num].readers, 1,
+			   __ATOMIC_RELEASE);
+}
+
+/*
+ * Pin the region and resolve the address of a single MMIO access of the
+ * given width. On success the caller must mmio_unpin_region() after the
+ * access.
+ */
+STATIC fpga_result mmio_access_ptr(struct _fpga_handle *_handle,
+				   uint32_t mmio_num,
+				   uint64_t offset,
+				   uint64_t width,
+				   uint8_t **ptr,
+				   bool *locked)
+{
+	uint8_t *base = NULL;
+	uint64_t len = 0;
+	fpga_result result;
+
+	result = mmio_pin_region(_handle, mmio_num, &base, &len, locked);
 	if (result)
-		goto out_unlock;
+		return result;
 
-	if (offset > wm->len) {
+	if ((width > len) || (offset > len - width)) {
 		OPAE_MSG("offset out of bounds");
-		result = FPGA_INVALID_PARAM;
-		goto out_unlock;
+		mmio_unpin_region(_handle, mmio_num, *locked);
+		return FPGA_INVALID_PARAM;
 	}
 
-	*((volatile uint32_t *) ((uint8_t *)wm->offset + offset)) = value;
+	*ptr = base + offset;
+	return FPGA_OK;
+}
 
-out_unlock:
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO32(fpga_handle handle,
+					 uint32_t mmio_num,
+					 uint64_t offset,
+					 uint32_t value)
+{
+	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
+	uint8_t *ptr = NULL;
+	bool locked = false;
+	fpga_result result = FPGA_OK;
+
+	if (offset % sizeof(uint32_t) != 0) {
+		OPAE_MSG("Misaligned MMIO access");
+		return FPGA_INVALID_PARAM;
 	}
-	return result;
+
+	result = mmio_access_ptr(_handle, mmio_num, offset,
+				 sizeof(uint32_t), &ptr, &locked);
+	if (result)
+		return result;
+
+	*((volatile uint32_t *)ptr) = value;
+
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
 }
 
 fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO32(fpga_handle handle,
@@ -207,9 +332,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO32(fpga_handle handle,
 					uint64_t offset,
 					uint32_t *value)
 {
-	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
-	struct wsid_map *wm = NULL;
+	uint8_t *ptr = NULL;
+	bool locked = false;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint32_t) != 0) {
@@ -217,28 +342,15 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO32(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = handle_check_and_lock(_handle);
+	result = mmio_access_ptr(_handle, mmio_num, offset,
+				 sizeof(uint32_t), &ptr, &locked);
 	if (result)
 		return result;
 
-	result = find_or_map_wm(handle, mmio_num, &wm);
-	if (result)
-		goto out_unlock;
-
-	if (offset > wm->len) {
-		OPAE_MSG("offset out of bounds");
-		result = FPGA_INVALID_PARAM;
-		goto out_unlock;
-	}
-
-	*value = *((volatile uint32_t *) ((uint8_t *)wm->offset + offset));
+	*value = *((volatile uint32_t *)ptr);
 
-out_unlock:
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
-	}
-	return result;
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
 }
 
 fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO64(fpga_handle handle,
@@ -246,9 +358,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO64(fpga_handle handle,
 					 uint64_t offset,
 					 uint64_t value)
 {
-	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
-	struct wsid_map *wm = NULL;
+	uint8_t *ptr = NULL;
+	bool locked = false;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint64_t) != 0) {
@@ -256,28 +368,15 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO64(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = handle_check_and_lock(_handle);
+	result = mmio_access_ptr(_handle, mmio_num, offset,
+				 sizeof(uint64_t), &ptr, &locked);
 	if (result)
 		return result;
 
-	result = find_or_map_wm(handle, mmio_num, &wm);
-	if (result)
-		goto out_unlock;
-
-	if (offset > wm->len) {
-		OPAE_MSG("offset out of bounds");
-		result = FPGA_INVALID_PARAM;
-		goto out_unlock;
-	}
-
-	*((volatile uint64_t *) ((uint8_t *)wm->offset + offset)) = value;
+	*((volatile uint64_t *)ptr) = value;
 
-out_unlock:
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
-	}
-	return result;
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
 }
 
 fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO64(fpga_handle handle,
@@ -285,9 +384,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO64(fpga_handle handle,
 					uint64_t offset,
 					uint64_t *value)
 {
-	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
-	struct wsid_map *wm = NULL;
+	uint8_t *ptr = NULL;
+	bool locked = false;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint64_t) != 0) {
@@ -295,28 +394,125 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO64(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = handle_check_and_lock(_handle);
+	result = mmio_access_ptr(_handle, mmio_num, offset,
+				 sizeof(uint64_t), &ptr, &locked);
 	if (result)
 		return result;
 
-	result = find_or_map_wm(handle, mmio_num, &wm);
+	*value = *((volatile uint64_t *)ptr);
+
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
+}
+
+/* Check every entry of an MMIO batch against a region of length len. */
+STATIC fpga_result mmio_check_vec(const fpga_mmio_vec *vec,
+				  uint32_t count,
+				  uint64_t len)
+{
+	uint64_t width;
+	uint32_t i;
+
+	for (i = 0 ; i < count ; ++i) {
+		if ((vec[i].width != 32) && (vec[i].width != 64)) {
+			OPAE_MSG("Invalid MMIO width %u", vec[i].width);
+			return FPGA_INVALID_PARAM;
+		}
+
+		width = vec[i].width / 8;
+
+		if (vec[i].offset % width != 0) {
+			OPAE_MSG("Misaligned MMIO access");
+			return FPGA_INVALID_PARAM;
+		}
+
+		if ((width > len) || (vec[i].offset > len - width)) {
+			OPAE_MSG("offset out of bounds");
+			return FPGA_INVALID_PARAM;
+		}
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result __XFPGA_API__ xfpga_fpgaReadMMIOv(fpga_handle handle,
+					uint32_t mmio_num,
+					fpga_mmio_vec *vec,
+					uint32_t count)
+{
+	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
+	uint8_t *base = NULL;
+	uint64_t len = 0;
+	bool locked = false;
+	fpga_result result = FPGA_OK;
+	uint32_t i;
+
+	ASSERT_NOT_NULL(vec);
+
+	result = mmio_pin_region(_handle, mmio_num, &base, &len, &locked);
 	if (result)
-		goto out_unlock;
+		return result;
 
-	if (offset > wm->len) {
-		OPAE_MSG("offset out of bounds");
-		result = FPGA_INVALID_PARAM;
-		goto out_unlock;
+	result = mmio_check_vec(vec, count, len);
+	if (result) {
+		mmio_unpin_region(_handle, mmio_num, locked);
+		return result;
 	}
 
-	*value = *((volatile uint64_t *) ((uint8_t *)wm->offset + offset));
+	for (i = 0 ; i < count ; ++i) {
+		volatile uint8_t *ptr = base + vec[i].offset;
 
-out_unlock:
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+		if (vec[i].flags & FPGA_MMIO_FENCE)
+			__sync_synchronize();
+
+		if (vec[i].width == 32)
+			vec[i].value = *((volatile uint32_t *)ptr);
+		else
+			vec[i].value = *((volatile uint64_t *)ptr);
 	}
-	return result;
+
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
+}
+
+fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIOv(fpga_handle handle,
+					 uint32_t mmio_num,
+					 const fpga_mmio_vec *vec,
+					 uint32_t count)
+{
+	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
+	uint8_t *base = NULL;
+	uint64_t len = 0;
+	bool locked = false;
+	fpga_result result = FPGA_OK;
+	uint32_t i;
+
+	ASSERT_NOT_NULL(vec);
+
+	result = mmio_pin_region(_handle, mmio_num, &base, &len, &locked);
+	if (result)
+		return result;
+
+	result = mmio_check_vec(vec, count, len);
+	if (result) {
+		mmio_unpin_region(_handle, mmio_num, locked);
+		return result;
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		volatile uint8_t *ptr = base + vec[i].offset;
+
+		if (vec[i].flags & FPGA_MMIO_FENCE)
+			__sync_synchronize();
+
+		if (vec[i].width == 32)
+			*((volatile uint32_t *)ptr) = (uint32_t)vec[i].value;
+		else
+			*((volatile uint64_t *)ptr) = vec[i].value;
+	}
+
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
 }
 
 #if (defined(__i386__) || defined(__x86_64__) || defined(__ia64__)) && GCC_VERSION >= 40900
@@ -340,9 +536,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO512(fpga_handle handle,
 					 uint64_t offset,
 					 const void *value)
 {
-	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
-	struct wsid_map *wm = NULL;
+	uint8_t *ptr = NULL;
+	bool locked = false;
 	fpga_result result = FPGA_OK;
 
 	if (offset % 64 != 0) {
@@ -350,33 +546,19 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO512(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = handle_check_and_lock(_handle);
-	if (result)
-		return result;
+	ASSERT_NOT_NULL(_handle);
 
-	if (!(_handle->flags & OPAE_FLAG_HAS_MMX512)) {
-		result = FPGA_NOT_SUPPORTED;
-		goto out_unlock;
-	}
+	if (!(_handle->flags & OPAE_FLAG_HAS_MMX512))
+		return FPGA_NOT_SUPPORTED;
 
-	result = find_or_map_wm(handle, mmio_num, &wm);
+	result = mmio_access_ptr(_handle, mmio_num, offset, 64, &ptr, &locked);
 	if (result)
-		goto out_unlock;
-
-	if (offset > wm->len) {
-		OPAE_MSG("offset out of bounds");
-		result = FPGA_INVALID_PARAM;
-		goto out_unlock;
-	}
+		return result;
 
-	copy512(value, (uint8_t *)wm->offset + offset);
+	copy512(value, ptr);
 
-out_unlock:
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
-	}
-	return result;
+	mmio_unpin_region(_handle, mmio_num, locked);
+	return FPGA_OK;
 }
 
 fpga_result __XFPGA_API__ xfpga_fpgaMapMMIO(fpga_handle handle,
@@ -428,6 +610,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaUnmapMMIO(fpga_handle handle,
 		goto out_unlock;
 	}
 
+	mmio_withdraw_region(_handle, mmio_num);
+
 	/* Unmap UAFU MMIO */
 	mmio_ptr = (void *) wm->offset;
 	if (munmap((void *) mmio_ptr, wm->len)) {
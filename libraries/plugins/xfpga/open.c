@@ -93,8 +93,8 @@ xfpga_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 		goto out_free1;
 	}
 
-	// Init workspace table
-	_handle->wsid_root = wsid_tracker_init(16384);
+	// Init workspace table (grows on demand)
+	_handle->wsid_root = wsid_tracker_init(1024);
 	if (NULL == _handle->wsid_root) {
 		result = FPGA_NO_MEMORY;
 		goto out_free2;
@@ -104,6 +104,8 @@ xfpga_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 	_handle->metric_enum_status = false;
 	_handle->bmc_handle = NULL;
 	_handle->_bmc_metric_cache_value = NULL;
+	_handle->metric_name_index = NULL;
+	_handle->metric_name_index_size = 0;
 
 	// Open resources in exclusive mode unless FPGA_OPEN_SHARED is given
 	open_flags = O_RDWR | ((flags & FPGA_OPEN_SHARED) ? 0 : O_EXCL);
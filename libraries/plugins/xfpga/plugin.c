@@ -82,6 +82,10 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReadMMIO32");
 	adapter->fpgaWriteMMIO512 =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaWriteMMIO512");
+	adapter->fpgaReadMMIOv =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReadMMIOv");
+	adapter->fpgaWriteMMIOv =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaWriteMMIOv");
 	adapter->fpgaMapMMIO =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaMapMMIO");
 	adapter->fpgaUnmapMMIO =
@@ -141,6 +145,8 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		adapter->plugin.dl_handle, "xfpga_fpgaReleaseFromInterface");
 	adapter->fpgaReconfigureSlot =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReconfigureSlot");
+	adapter->fpgaReconfigureSlotProgress = dlsym(
+		adapter->plugin.dl_handle, "xfpga_fpgaReconfigureSlotProgress");
 	adapter->fpgaTokenGetObject =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaTokenGetObject");
 	adapter->fpgaHandleGetObject =
@@ -178,6 +184,9 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 	adapter->fpgaGetMetricsByName =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaGetMetricsByName");
 
+	adapter->fpgaGetMetricsSnapshot =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaGetMetricsSnapshot");
+
 	adapter->fpgaGetMetricsThresholdInfo =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaGetMetricsThresholdInfo");
 
@@ -256,11 +256,33 @@ fpga_result set_afu_userclock(fpga_handle handle,
 }
 
 
+STATIC void reconf_report(fpga_reconf_progress_cb progress, void *context,
+			  enum fpga_reconf_phase phase,
+			  size_t bytes_written, size_t bytes_total)
+{
+	if (progress)
+		progress(phase, bytes_written, bytes_total, context);
+}
+
 fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 						uint32_t slot,
 						const uint8_t *bitstream,
 						size_t bitstream_len,
 						int flags)
+{
+	return xfpga_fpgaReconfigureSlotProgress(fpga, slot, bitstream,
+						 bitstream_len, flags,
+						 NULL, NULL);
+}
+
+fpga_result __XFPGA_API__
+xfpga_fpgaReconfigureSlotProgress(fpga_handle fpga,
+				  uint32_t slot,
+				  const uint8_t *bitstream,
+				  size_t bitstream_len,
+				  int flags,
+				  fpga_reconf_progress_cb progress,
+				  void *context)
 {
 	struct _fpga_handle *_handle    = (struct _fpga_handle *)fpga;
 	fpga_result result              = FPGA_OK;
@@ -269,6 +291,7 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 	int bitstream_header_len        = 0;
 	int err                         = 0;
 	fpga_handle accel               = NULL;
+	size_t payload_len              = 0;
 
 	result = handle_check_and_lock(_handle);
 	if (result)
@@ -280,6 +303,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 		goto out_unlock;
 	}
 
+	reconf_report(progress, context, FPGA_RECONF_PHASE_VALIDATE, 0, 0);
+
 	if (validate_bitstream(fpga, bitstream, bitstream_len,
 				&bitstream_header_len) != FPGA_OK) {
 		OPAE_MSG("Invalid bitstream");
@@ -287,6 +312,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 		goto out_unlock;
 	}
 
+	payload_len = bitstream_len - bitstream_header_len;
+
 	// error out if "force" flag is NOT indicated
 	// and the resource is in use
 	if (!(flags & FPGA_RECONF_FORCE)) {
@@ -298,6 +325,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 	}
 
 	// Clear port errors
+	reconf_report(progress, context, FPGA_RECONF_PHASE_CLEAR_ERRORS,
+		      0, payload_len);
 	result = clear_port_errors(fpga);
 	if (result != FPGA_OK) {
 		OPAE_ERR("Failed to clear port errors.");
@@ -336,6 +365,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 		if (!(flags & FPGA_RECONF_SKIP_USRCLK)) {
 			if (metadata.afu_image.clock_frequency_high > 0 ||
 			    metadata.afu_image.clock_frequency_low > 0) {
+				reconf_report(progress, context,
+					      FPGA_RECONF_PHASE_USRCLK,
+					      0, payload_len);
 				result = set_afu_userclock(fpga,
 						metadata.afu_image.clock_frequency_high,
 						metadata.afu_image.clock_frequency_low);
@@ -350,8 +382,13 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 
 	}
 
+	// The driver consumes the whole payload in a single ioctl, so
+	// progress is reported before and after it.
+	reconf_report(progress, context, FPGA_RECONF_PHASE_PROGRAM,
+		      0, payload_len);
+
 	result = opae_fme_port_pr(
-		_handle->fddev, 0, slot, bitstream_len - bitstream_header_len,
+		_handle->fddev, 0, slot, payload_len,
 		(uint64_t)bitstream + bitstream_header_len, &error.csr);
 	if (result != 0) {
 		OPAE_ERR("Failed to reconfigure bitstream: %s",
@@ -362,6 +399,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlot(fpga_handle fpga,
 		} else {
 			result = FPGA_EXCEPTION;
 		}
+	} else {
+		reconf_report(progress, context, FPGA_RECONF_PHASE_PROGRAM,
+			      payload_len, payload_len);
 	}
 
 	if (error.reconf_operation_error == 0x1) {
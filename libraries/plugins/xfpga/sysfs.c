@@ -39,6 +39,8 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 #include <regex.h>
 #undef _GNU_SOURCE
 
@@ -148,6 +150,19 @@ pthread_mutex_t _sysfs_device_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 #define SYSFS_MAX_DEVICES 128
 static sysfs_fpga_device _devices[SYSFS_MAX_DEVICES];
 
+/*
+ * The device topology discovered by sysfs_initialize() is kept until a
+ * kernel uevent (or a vanished region directory) tells us that it may have
+ * changed. sysfs itself does not generate inotify events for device add and
+ * remove, so the kobject uevent netlink socket is used instead.
+ */
+#define SYSFS_UEVENT_GROUP 1
+#define SYSFS_UEVENT_BUF_SIZE 4096
+STATIC int _sysfs_uevent_fd = -1;
+static bool _sysfs_devices_valid;
+// Number of times sysfs_foreach_device() had to rebuild the device list.
+STATIC uint64_t _sysfs_rescans;
+
 #define PCIE_PATH_PATTERN "([0-9a-fA-F]{4}):([0-9a-fA-F]{2}):([0-9a-fA-F]{2})\\.([0-9])/fpga"
 #define PCIE_PATH_PATTERN_GROUPS 5
 
@@ -572,6 +587,102 @@ int sysfs_device_count(void)
 	return count;
 }
 
+STATIC int sysfs_uevent_open(void)
+{
+	struct sockaddr_nl addr;
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+		    NETLINK_KOBJECT_UEVENT);
+	if (fd < 0) {
+		OPAE_DBG("uevent socket unavailable: %s", strerror(errno));
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = SYSFS_UEVENT_GROUP;
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		OPAE_DBG("uevent bind failed: %s", strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * @brief Drain pending kernel uevents
+ *
+ * @return true if any uevent other than "change" was queued, or if
+ *         the socket overflowed and events may have been lost.
+ */
+STATIC bool sysfs_uevent_pending(int fd)
+{
+	char buf[SYSFS_UEVENT_BUF_SIZE];
+	bool pending = false;
+	ssize_t len;
+
+	while (1) {
+		len = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS)
+				pending = true;
+			break;
+		}
+		buf[len] = '\0';
+		// The header of each kernel uevent is ACTION@DEVPATH.
+		if (strncmp(buf, "change@", 7))
+			pending = true;
+	}
+
+	return pending;
+}
+
+STATIC bool sysfs_region_exists(const sysfs_fpga_region *region)
+{
+	return !region || !opae_access(region->sysfs_path, F_OK);
+}
+
+/**
+ * @brief Determine whether the cached device topology is still current
+ *
+ * @note Must be called with _sysfs_device_lock held.
+ */
+STATIC bool sysfs_devices_current(void)
+{
+	uint32_t i;
+
+	if (!_sysfs_devices_valid || _sysfs_uevent_fd < 0)
+		return false;
+
+	if (sysfs_uevent_pending(_sysfs_uevent_fd))
+		return false;
+
+	for (i = 0; i < _sysfs_device_count; ++i) {
+		if (!sysfs_region_exists(_devices[i].fme) ||
+		    !sysfs_region_exists(_devices[i].port))
+			return false;
+	}
+
+	return true;
+}
+
+STATIC void sysfs_release_devices(void)
+{
+	uint32_t i = 0;
+
+	for (; i < _sysfs_device_count; ++i) {
+		sysfs_device_destroy(&_devices[i]);
+	}
+	_sysfs_device_count = 0;
+	_sysfs_format_ptr = NULL;
+	_sysfs_devices_valid = false;
+}
+
 fpga_result sysfs_foreach_device(device_cb cb, void *context)
 {
 	uint32_t i = 0;
@@ -581,14 +692,15 @@ fpga_result sysfs_foreach_device(device_cb cb, void *context)
 		return FPGA_EXCEPTION;
 	}
 
-	result = sysfs_finalize();
-	if (result) {
-		goto out_unlock;
-	}
-	result = sysfs_initialize();
-	if (result) {
-		goto out_unlock;
+	if (!sysfs_devices_current()) {
+		++_sysfs_rescans;
+		sysfs_release_devices();
+		result = sysfs_initialize();
+		if (result) {
+			goto out_unlock;
+		}
 	}
+
 	for (; i < _sysfs_device_count; ++i) {
 		result = cb(&_devices[i], context);
 		if (result) {
@@ -615,6 +727,13 @@ int sysfs_initialize(void)
 
 	memset(&_devices, 0, sizeof(_devices));
 	_sysfs_device_count = 0;
+	_sysfs_devices_valid = false;
+
+	// Start listening before the scan so that no change is missed.
+	if (_sysfs_uevent_fd < 0)
+		_sysfs_uevent_fd = sysfs_uevent_open();
+	else
+		sysfs_uevent_pending(_sysfs_uevent_fd);
 
 	for (i = 0; i < OPAE_KERNEL_DRIVERS; ++i) {
 		errno = 0;
@@ -681,6 +800,8 @@ int sysfs_initialize(void)
 	if (!_sysfs_device_count) {
 		OPAE_DBG("Error discovering fpga devices");
 		res = FPGA_NO_DRIVER;
+	} else {
+		_sysfs_devices_valid = true;
 	}
 out_free:
 	if (dir)
@@ -690,17 +811,16 @@ out_free:
 
 int sysfs_finalize(void)
 {
-	uint32_t i = 0;
 	int res = 0;
 	if (opae_mutex_lock(res, &_sysfs_device_lock)) {
 		OPAE_ERR("Error locking mutex");
 		return FPGA_EXCEPTION;
 	}
-	for (; i < _sysfs_device_count; ++i) {
-		sysfs_device_destroy(&_devices[i]);
+	sysfs_release_devices();
+	if (_sysfs_uevent_fd >= 0) {
+		close(_sysfs_uevent_fd);
+		_sysfs_uevent_fd = -1;
 	}
-	_sysfs_device_count = 0;
-	_sysfs_format_ptr = NULL;
 	if (opae_mutex_unlock(res, &_sysfs_device_lock)) {
 		OPAE_ERR("Error unlocking mutex");
 		return FPGA_EXCEPTION;
@@ -1912,6 +2032,27 @@ ssize_t eintr_read(int fd, void *buf, size_t count)
 	return total_read;
 }
 
+ssize_t eintr_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	ssize_t bytes_read = 0, total_read = 0;
+	char *ptr = buf;
+	while ((size_t)total_read < count) {
+		bytes_read = pread(fd, ptr + total_read, count - total_read,
+				   offset + total_read);
+		if (bytes_read < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return bytes_read;
+		} else if (bytes_read == 0) {
+			break;
+		} else {
+			total_read += bytes_read;
+		}
+	}
+	return total_read;
+}
+
 ssize_t eintr_write(int fd, void *buf, size_t count)
 {
 	ssize_t bytes_written = 0, total_written = 0;
@@ -2015,6 +2156,8 @@ struct _fpga_object *alloc_fpga_object(const char *sysfspath, const char *name)
 		obj->path = opae_strdup(sysfspath);
 		obj->name = opae_strdup(name);
 		obj->perm = 0;
+		obj->fd = -1;
+		obj->file_size = 0;
 		obj->size = 0;
 		obj->max_size = 0;
 		obj->buffer = NULL;
@@ -2032,6 +2175,10 @@ out_err:
 fpga_result destroy_fpga_object(struct _fpga_object *obj)
 {
 	fpga_result res = FPGA_OK;
+	if (obj->fd >= 0) {
+		opae_close(obj->fd);
+		obj->fd = -1;
+	}
 	FREE_IF(obj->path);
 	FREE_IF(obj->name);
 	FREE_IF(obj->buffer);
@@ -2144,12 +2291,11 @@ static ssize_t find_eof(int fd)
 	char buffer[pg_size];
 	ssize_t bytes_read = 0, total_read = 0;
 	while (total_read <= MAX_SYSOBJECT_FILESIZE) {
-		bytes_read = opae_read(fd, buffer, pg_size);
+		bytes_read = pread(fd, buffer, pg_size, total_read);
 		if (bytes_read < 0) {
 			if (errno == EINTR) {
 				continue;
 			}
-			lseek(fd, 0, SEEK_SET);
 			return bytes_read;
 		} else if (bytes_read == 0) {
 			break;
@@ -2157,15 +2303,39 @@ static ssize_t find_eof(int fd)
 			total_read += bytes_read;
 		}
 	}
-	lseek(fd, 0, SEEK_SET);
 	return total_read;
 }
 
+// Open the object's attribute once and keep the fd for the lifetime of
+// the object. The kernel regenerates sysfs attribute contents on a read
+// at offset 0, so repeated syncs only need a pread() on the same fd.
+STATIC int sync_object_fd(struct _fpga_object *_obj)
+{
+	struct stat st;
+
+	if (_obj->fd >= 0)
+		return _obj->fd;
+
+	_obj->fd = opae_open(_obj->path, _obj->perm | O_CLOEXEC);
+	if (_obj->fd < 0) {
+		OPAE_ERR("Error opening %s: %s", _obj->path, strerror(errno));
+		return -1;
+	}
+
+	if (!fstat(_obj->fd, &st) && S_ISREG(st.st_mode))
+		_obj->file_size = (size_t)st.st_size;
+
+	return _obj->fd;
+}
+
 static fpga_result sync_object_size(struct _fpga_object *_obj, int fd)
 {
 	off_t size;
 	uint8_t *buffer;
-	size = find_eof(fd);
+	if (_obj->file_size)
+		size = (off_t)_obj->file_size;
+	else
+		size = find_eof(fd);
 	if (size < MIN_SYSOBJECT_FILESIZE)
 		size = MIN_SYSOBJECT_FILESIZE;
 	if (size > 0) {
@@ -2187,28 +2357,79 @@ fpga_result sync_object(fpga_object obj)
 	ssize_t bytes_read = 0;
 	ASSERT_NOT_NULL(obj);
 	_obj = (struct _fpga_object *)obj;
-	fd = opae_open(_obj->path, _obj->perm);
-	if (fd < 0) {
-		OPAE_ERR("Error opening %s: %s", _obj->path, strerror(errno));
+	if (pthread_mutex_lock(&_obj->lock)) {
+		OPAE_ERR("pthread_mutex_lock() failed");
 		return FPGA_EXCEPTION;
 	}
 
-	if (_obj->max_size <= MIN_SYSOBJECT_FILESIZE) {
+	fd = sync_object_fd(_obj);
+	if (fd < 0) {
+		res = FPGA_EXCEPTION;
+		goto out_unlock;
+	}
+
+	if (_obj->max_size <= MIN_SYSOBJECT_FILESIZE ||
+	    _obj->max_size < _obj->file_size) {
 		res = sync_object_size(_obj, fd);
-		if (res != FPGA_OK) {
-			opae_close(fd);
-			return res;
-		}
+		if (res != FPGA_OK)
+			goto out_unlock;
 	}
 
-	bytes_read = eintr_read(fd, _obj->buffer, _obj->max_size);
+	bytes_read = eintr_pread(fd, _obj->buffer, _obj->max_size, 0);
 	if (bytes_read < 0) {
-		opae_close(fd);
-		return FPGA_EXCEPTION;
+		res = FPGA_EXCEPTION;
+		goto out_unlock;
 	}
 	_obj->size = bytes_read;
-	opae_close(fd);
-	return FPGA_OK;
+
+out_unlock:
+	if (pthread_mutex_unlock(&_obj->lock)) {
+		OPAE_ERR("pthread_mutex_unlock() failed");
+	}
+	return res;
+}
+
+fpga_result read_object_window(fpga_object obj, uint8_t *buffer,
+			       size_t offset, size_t len)
+{
+	struct _fpga_object *_obj;
+	int fd = -1;
+	fpga_result res = FPGA_OK;
+	ssize_t bytes_read = 0;
+	ASSERT_NOT_NULL(obj);
+	ASSERT_NOT_NULL(buffer);
+	_obj = (struct _fpga_object *)obj;
+	if (pthread_mutex_lock(&_obj->lock)) {
+		OPAE_ERR("pthread_mutex_lock() failed");
+		return FPGA_EXCEPTION;
+	}
+
+	fd = sync_object_fd(_obj);
+	if (fd < 0) {
+		res = FPGA_EXCEPTION;
+		goto out_unlock;
+	}
+
+	if (_obj->file_size && offset + len > _obj->file_size) {
+		OPAE_ERR("Bytes requested exceed object size");
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	bytes_read = eintr_pread(fd, buffer, len, (off_t)offset);
+	if (bytes_read < 0) {
+		OPAE_ERR("Error reading %s: %s", _obj->path, strerror(errno));
+		res = FPGA_EXCEPTION;
+	} else if ((size_t)bytes_read != len) {
+		OPAE_ERR("Bytes requested exceed object size");
+		res = FPGA_INVALID_PARAM;
+	}
+
+out_unlock:
+	if (pthread_mutex_unlock(&_obj->lock)) {
+		OPAE_ERR("pthread_mutex_unlock() failed");
+	}
+	return res;
 }
 
 fpga_result make_sysfs_group(char *sysfspath, const char *name,
@@ -124,6 +124,7 @@ fpga_result sysfs_deviceid_from_path(const char *sysfspath,
 fpga_result sysfs_objectid_from_path(const char *sysfspath,
 				     uint64_t *object_id);
 ssize_t eintr_read(int fd, void *buf, size_t count);
+ssize_t eintr_pread(int fd, void *buf, size_t count, off_t offset);
 ssize_t eintr_write(int fd, void *buf, size_t count);
 fpga_result cat_token_sysfs_path(char *dest, fpga_token token,
 				 const char *path);
@@ -133,6 +134,8 @@ fpga_result cat_handle_sysfs_path(char *dest, fpga_handle handle,
 struct _fpga_object *alloc_fpga_object(const char *sysfspath, const char *name);
 fpga_result destroy_fpga_object(struct _fpga_object *obj);
 fpga_result sync_object(fpga_object object);
+fpga_result read_object_window(fpga_object object, uint8_t *buffer,
+			       size_t offset, size_t len);
 fpga_result make_sysfs_group(char *sysfspath, const char *name,
 			     fpga_object *object, int flags, fpga_handle handle);
 fpga_result make_sysfs_object(char *sysfspath, const char *name,
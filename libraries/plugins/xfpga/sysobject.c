@@ -134,6 +134,7 @@ xfpga_fpgaCloneObject(fpga_object src, fpga_object *dst)
 	_dst->size = _src->size;
 	_dst->type = _src->type;
 	_dst->max_size = _src->max_size;
+	_dst->file_size = _src->file_size;
 	if (_src->type == FPGA_SYSFS_FILE) {
 		_dst->buffer = opae_calloc(_dst->max_size, sizeof(uint8_t));
 		memcpy(_dst->buffer, _src->buffer, _src->max_size);
@@ -260,6 +261,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaObjectRead(fpga_object obj,
 	if (_obj->type != FPGA_SYSFS_FILE) {
 		return FPGA_INVALID_PARAM;
 	}
+	if (flags & FPGA_OBJECT_RAW) {
+		return read_object_window(obj, buffer, offset, len);
+	}
 	if (offset + len > _obj->size) {
 		return FPGA_INVALID_PARAM;
 	}
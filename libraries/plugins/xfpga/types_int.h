@@ -139,6 +139,13 @@ struct _fpga_enum_metric {
 
 	uint64_t mmio_offset;                            // AFU Metric BBS mmio offset
 
+	bool has_limits;                                 // Value range resolved at enum
+	double low_limit;                                // Lowest valid value
+	double high_limit;                               // Highest valid value
+
+	bool value_fd_valid;                             // value_fd is open
+	int value_fd;                                    // Cached fd for metric_sysfs
+
 };
 
 
@@ -149,6 +156,20 @@ struct _fpga_bmc_metric {
 	struct fpga_metric fpga_metric;             // Metric value
 };
 
+/*
+ * MMIO region published for lock-free access. base is written with
+ * release semantics only after the region is mapped and len is set.
+ * readers counts the lock-free accesses in flight; mmio_withdraw_region()
+ * clears base and waits for readers to drop to zero, and both
+ * xfpga_fpgaUnmapMMIO() and xfpga_fpgaClose() call it before munmap().
+ */
+#define XFPGA_MAX_MMIO_REGIONS 8
+struct _fpga_mmio_region {
+	uint8_t *base;
+	uint64_t len;
+	uint32_t readers;
+};
+
 /** Process-wide unique FPGA handle */
 struct _fpga_handle {
 	pthread_mutex_t lock;
@@ -161,6 +182,7 @@ struct _fpga_handle {
 	uint32_t irq_set;               // bitmask of irqs set
 	struct wsid_tracker *wsid_root; // wsid information (list)
 	struct wsid_tracker *mmio_root; // MMIO information (list)
+	struct _fpga_mmio_region mmio_regions[XFPGA_MAX_MMIO_REGIONS];
 	void *umsg_virt;	        // umsg Virtual Memory pointer
 	uint64_t umsg_size;	        // umsg Virtual Memory Size
 	uint64_t *umsg_iova;	        // umsg IOVA from driver
@@ -171,6 +193,8 @@ struct _fpga_handle {
 	void *bmc_handle;                                    // bmc module handle
 	struct _fpga_bmc_metric *_bmc_metric_cache_value;    // bmc cache values
 	uint64_t num_bmc_metric;                             // num of bmc values
+	uint32_t *metric_name_index;                         // metric_name hash -> vector index + 1
+	uint32_t metric_name_index_size;                     // slots in metric_name_index (power of 2)
 #define OPAE_FLAG_HAS_MMX512 (1u << 0)
 	uint32_t flags;
 };
@@ -198,15 +222,35 @@ struct wsid_map {
 	uint64_t offset;
 	uint32_t index;
 	int flags;
-	struct wsid_map *next;
+	struct wsid_map *next;        // free list link (unused entries)
+	struct wsid_map *index_next;  // entries sharing the same index
+	struct wsid_map *index_prev;
+};
+
+/*
+ * wsid_maps are carved out of fixed-size chunks, so that entries are
+ * contiguous in memory and their addresses stay stable as the tracker
+ * grows.
+ */
+#define WSID_CHUNK_ENTRIES 64
+struct wsid_map_chunk {
+	struct wsid_map_chunk *next;
+	struct wsid_map entries[WSID_CHUNK_ENTRIES];
 };
 
 /*
- * Hash table to store wsid_maps
+ * Open-addressed hash table to store wsid_maps, plus a direct
+ * index -> entry array for small indices (MMIO region numbers).
  */
+#define WSID_MAX_DIRECT_INDEX 4096
 struct wsid_tracker {
-	uint64_t          n_hash_buckets;
-	struct wsid_map **table;
+	uint64_t          n_hash_buckets;  // size of table (a power of 2)
+	struct wsid_map **table;           // NULL marks an empty slot
+	uint64_t          n_entries;
+	struct wsid_map **by_index;        // heads of per-index entry lists
+	uint32_t          n_by_index;
+	struct wsid_map  *free_list;
+	struct wsid_map_chunk *chunks;
 };
 
 /*
@@ -232,6 +276,8 @@ struct _fpga_object {
 	char *path;
 	char *name;
 	int perm;
+	int fd;            // persistent fd for FPGA_SYSFS_FILE, or -1
+	size_t file_size;  // st_size reported by the kernel, 0 if unknown
 	size_t size;
 	size_t max_size;
 	uint8_t *buffer;
@@ -32,7 +32,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <glob.h>
+#include <time.h>
 #include <opae/uio.h>
 
 #include "fpga_user_clk.h"
@@ -127,13 +129,17 @@
 
 #define IOPLL_MEASURE_LOW             0
 #define IOPLL_MEASURE_HIGH            1
-#define IOPLL_MEASURE_DELAY_MS        4000
-#define IOPLL_RESET_DELAY_MS          1000
-#define IOPLL_CAL_DELAY_MS            1000
+#define IOPLL_MEASURE_DELAY_US        4000 /* Frequency measurement window */
+#define IOPLL_RESET_DELAY_US          1000 /* Reset hold time */
+#define IOPLL_CAL_DELAY_US            1000 /* Calibration settle time */
 
+#define IOPLL_WRITE_POLL_SPIN_US      20 /* Busy-poll before sleeping */
 #define IOPLL_WRITE_POLL_INVL_US      10 /* Write poll interval */
 #define IOPLL_WRITE_POLL_TIMEOUT_US   1000000 /* Write poll timeout */
 
+#define IOPLL_LOCK_POLL_INVL_US       10 /* Lock poll interval */
+#define IOPLL_LOCK_TIMEOUT_US         100000 /* Lock poll timeout */
+
 #define USRCLK_FEATURE_ID             0x14
 
  // DFHv0
@@ -155,10 +161,50 @@ struct dfh {
 
 static int using_iopll(char *sysfs_usrpath, const char *sysfs_path);
 
+STATIC uint64_t usrclk_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Poll IOPLL_FREQ_STS0 until (STS0 & mask) == value. The IOPLL normally
+ * responds within a few microseconds, so the register is busy-polled for
+ * spin_us before falling back to sleeping interval_us between reads.
+ * Returns FPGA_BUSY if timeout_us elapses first.
+ */
+STATIC fpga_result usrclk_poll_sts0(uint8_t *uio_ptr,
+	uint64_t mask, uint64_t value,
+	uint32_t spin_us, uint32_t interval_us,
+	uint32_t timeout_us, uint64_t *sts)
+{
+	uint64_t start = usrclk_now_us();
+	uint64_t elapsed = 0;
+	uint64_t v = 0;
+
+	while (1) {
+		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
+		if ((v & mask) == value)
+			break;
+
+		elapsed = usrclk_now_us() - start;
+		if (elapsed >= timeout_us)
+			return FPGA_BUSY;
+
+		if (elapsed >= spin_us)
+			usleep(interval_us);
+	}
+
+	if (sts)
+		*sts = v;
+	return FPGA_OK;
+}
+
 fpga_result usrclk_reset(uint8_t *uio_ptr)
 {
 	uint64_t v      = 0;
-	fpga_result res = FPGA_OK;
 
 	if (uio_ptr == NULL) {
 		OPAE_ERR("Invalid Input parameters");
@@ -169,27 +215,37 @@ fpga_result usrclk_reset(uint8_t *uio_ptr)
 	v = IOPLL_MGMT_RESET | IOPLL_RESET;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	usleep(IOPLL_RESET_DELAY_MS);
+	usleep(IOPLL_RESET_DELAY_US);
 
 	/* De-assert the iopll reset only */
 	v = IOPLL_MGMT_RESET;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	usleep(IOPLL_RESET_DELAY_MS);
+	usleep(IOPLL_RESET_DELAY_US);
 
 	/* De-assert the remaining resets */
 	v = IOPLL_AVMM_RESET_N;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	usleep(IOPLL_RESET_DELAY_MS);
+	return FPGA_OK;
+}
 
-	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-	if (!(v & IOPLL_LOCKED)) {
-		OPAE_ERR("IOPLL NOT locked after reset");;
-		res = FPGA_BUSY;
+fpga_result usrclk_wait_lock(uint8_t *uio_ptr)
+{
+	if (uio_ptr == NULL) {
+		OPAE_ERR("Invalid Input parameters");
+		return FPGA_INVALID_PARAM;
 	}
 
-	return res;
+	/* The lock bit is clear while the IOPLL is held in reset */
+	if (usrclk_poll_sts0(uio_ptr, IOPLL_LOCKED, IOPLL_LOCKED,
+			     0, IOPLL_LOCK_POLL_INVL_US,
+			     IOPLL_LOCK_TIMEOUT_US, NULL)) {
+		OPAE_ERR("IOPLL NOT locked after reset");
+		return FPGA_BUSY;
+	}
+
+	return FPGA_OK;
 }
 
 fpga_result usrclk_read_freq(uint8_t *uio_ptr,
@@ -211,7 +267,7 @@ fpga_result usrclk_read_freq(uint8_t *uio_ptr,
 	v = FIELD_PREP(IOPLL_CLK_MEASURE, clock_sel);
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD1)) = v;
 
-	usleep(IOPLL_MEASURE_DELAY_MS);
+	usleep(IOPLL_MEASURE_DELAY_US);
 
 	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS1));
 
@@ -223,9 +279,7 @@ fpga_result usrclk_read_freq(uint8_t *uio_ptr,
 fpga_result usrclk_write(uint8_t *uio_ptr, uint16_t address,
 	uint32_t data, uint8_t seq)
 {
-	fpga_result res   = FPGA_OK;
 	uint64_t v        = 0;
-	uint32_t timeout  = IOPLL_WRITE_POLL_TIMEOUT_US;
 
 	if (uio_ptr == NULL) {
 		OPAE_ERR("Invalid input parameters");
@@ -240,26 +294,21 @@ fpga_result usrclk_write(uint8_t *uio_ptr, uint16_t address,
 	v |= IOPLL_AVMM_RESET_N;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-
-	while (!(FIELD_GET(IOPLL_SEQ, v) == seq)) {
-		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-		usleep(IOPLL_WRITE_POLL_INVL_US);
-		if (--timeout == 0) {
-			OPAE_ERR("Timeout on IOPLL write");
-			res = FPGA_EXCEPTION;
-			break;
-		}
+	if (usrclk_poll_sts0(uio_ptr, IOPLL_SEQ, FIELD_PREP(IOPLL_SEQ, seq),
+			     IOPLL_WRITE_POLL_SPIN_US,
+			     IOPLL_WRITE_POLL_INVL_US,
+			     IOPLL_WRITE_POLL_TIMEOUT_US, NULL)) {
+		OPAE_ERR("Timeout on IOPLL write");
+		return FPGA_EXCEPTION;
 	}
 
-	return res;
+	return FPGA_OK;
 }
 
 fpga_result usrclk_read(uint8_t *uio_ptr, uint16_t address,
 	uint32_t *data, uint8_t seq)
 {
 	uint64_t v       = 0;
-	uint32_t timeout = IOPLL_WRITE_POLL_TIMEOUT_US;
 
 	if (uio_ptr == NULL) {
 		OPAE_ERR("Invalid input parameters");
@@ -272,15 +321,12 @@ fpga_result usrclk_read(uint8_t *uio_ptr, uint16_t address,
 	v |= IOPLL_AVMM_RESET_N;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-
-	while (!(FIELD_GET(IOPLL_SEQ, v) == seq)) {
-		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-		usleep(IOPLL_WRITE_POLL_INVL_US);
-		if (--timeout == 0) {
-			OPAE_ERR("Timeout on IOPLL write");
-			return FPGA_EXCEPTION;
-		}
+	if (usrclk_poll_sts0(uio_ptr, IOPLL_SEQ, FIELD_PREP(IOPLL_SEQ, seq),
+			     IOPLL_WRITE_POLL_SPIN_US,
+			     IOPLL_WRITE_POLL_INVL_US,
+			     IOPLL_WRITE_POLL_TIMEOUT_US, &v)) {
+		OPAE_ERR("Timeout on IOPLL read");
+		return FPGA_EXCEPTION;
 	}
 
 	*data = FIELD_GET(IOPLL_DATA, v);
@@ -495,10 +541,71 @@ fpga_result usrclk_calibrate(uint8_t *uio_ptr, uint8_t *seq)
 	/* Enable calibration interface */
 	res = usrclk_write(uio_ptr, PLL_ENABLE_CAL_ADDR, PLL_ENABLE_CALIBRATION,
 		(*seq)++);
-	usleep(IOPLL_CAL_DELAY_MS);
+	usleep(IOPLL_CAL_DELAY_US);
 	return res;
 }
 
+fpga_result usrclk_program(uint8_t *uio_ptr,
+	struct pll_config *c, struct usrclk_timing *timing)
+{
+	fpga_result res = FPGA_OK;
+	uint8_t seq     = 1;
+	uint64_t t0, t1 = 0;
+
+	if ((uio_ptr == NULL) ||
+		(c == NULL) ||
+		(timing == NULL)) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	memset(timing, 0, sizeof(*timing));
+
+	t0 = usrclk_now_us();
+	res = usrclk_set_freq(uio_ptr, c, &seq);
+	t1 = usrclk_now_us();
+	timing->config_us = t1 - t0;
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to set user clock");
+		return res;
+	}
+
+	t0 = t1;
+	res = usrclk_reset(uio_ptr);
+	t1 = usrclk_now_us();
+	timing->reset_us = t1 - t0;
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to reset user clock");
+		return res;
+	}
+
+	t0 = t1;
+	res = usrclk_wait_lock(uio_ptr);
+	t1 = usrclk_now_us();
+	timing->lock_us = t1 - t0;
+	if (res != FPGA_OK) {
+		OPAE_ERR("User clock failed to lock");
+		return res;
+	}
+
+	t0 = t1;
+	res = usrclk_calibrate(uio_ptr, &seq);
+	t1 = usrclk_now_us();
+	timing->calibrate_us = t1 - t0;
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to calibrate user clock");
+		return res;
+	}
+
+	OPAE_DBG("user clock programmed: config %" PRIu64 " us, "
+		 "reset %" PRIu64 " us, lock %" PRIu64 " us, "
+		 "calibrate %" PRIu64 " us",
+		 timing->config_us, timing->reset_us,
+		 timing->lock_us, timing->calibrate_us);
+
+	return FPGA_OK;
+}
+
 fpga_result get_usrclk_uio(const char *sysfs_path,
 	uint32_t feature_id,
 	struct opae_uio *uio,
@@ -654,10 +761,10 @@ fpga_result set_userclock(const char *sysfs_path,
 	char *bufp                         = NULL;
 	ssize_t cnt                        = 0;
 	uint64_t revision                  = 0;
-	uint8_t seq                        = 1;
 	uint8_t *uio_ptr                   = NULL;
 	fpga_result result                 = FPGA_OK;
 	ssize_t bytes_written              = 0;
+	struct usrclk_timing timing;
 	struct opae_uio uio;
 
 	memset(&uio, 0, sizeof(uio));
@@ -733,25 +840,8 @@ fpga_result set_userclock(const char *sysfs_path,
 		return result;
 	}
 
-	result = usrclk_set_freq(uio_ptr, iopll_config, &seq);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to set user clock");
-		goto uio_close;
-	}
-
-	result = usrclk_reset(uio_ptr);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to reset user clock");
-		goto uio_close;
-	}
-
-	result = usrclk_calibrate(uio_ptr, &seq);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to calibrate user clock");
-		goto uio_close;
-	}
+	result = usrclk_program(uio_ptr, iopll_config, &timing);
 
-uio_close:
 	opae_uio_close(&uio);
 	return result;
 }
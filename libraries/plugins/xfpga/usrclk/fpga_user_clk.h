@@ -65,6 +65,28 @@ struct pll_config {
 	unsigned int pll_rc;
 };
 
+/*
+ * Time spent in each phase of programming the IOPLL, in microseconds.
+ */
+struct usrclk_timing {
+	uint64_t config_us;     /* M/N/C0/C1 and loop filter writes */
+	uint64_t reset_us;      /* reset assertion and hold */
+	uint64_t lock_us;       /* waiting for IOPLL_LOCKED after reset */
+	uint64_t calibrate_us;  /* calibration request and settle */
+};
+
+/**
+ * @brief Program the IOPLL through its CSR interface
+ *
+ * @param uio_ptr  mapped user clock feature
+ * @param c        PLL settings for the requested frequency
+ * @param timing   receives the time spent in each phase
+ *
+ * @return error code
+ */
+fpga_result usrclk_program(uint8_t *uio_ptr, struct pll_config *c,
+			   struct usrclk_timing *timing);
+
 fpga_result get_userclk_revision(const char *sysfs_path,
 		uint64_t *revision);
 
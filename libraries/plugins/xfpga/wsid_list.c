@@ -30,6 +30,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include "wsid_list_int.h"
 #include "mock/opae_std.h"
@@ -37,25 +38,39 @@
 /*
  * The code here assumes the caller handles any required mutexes.
  * The logic here is not thread safe on its own.
+ *
+ * The tracker is an open-addressed hash table (linear probing) whose
+ * slots point into chunk-allocated wsid_map entries. The table doubles
+ * once it is half full. Deletion re-seats the rest of the probe run, so
+ * no tombstones are needed and lookups stay short after churn.
+ * Entries are also threaded onto per-index lists so that
+ * wsid_find_by_index() is a direct array lookup.
  */
 
+#define WSID_MIN_BUCKETS 8
+
 /**
  * @brief Initialize a wsid tracker hash table
- * @param n_hash_buckets
+ * @param n_hash_buckets initial capacity hint; the table grows on demand
  *
  * @return
  */
 struct wsid_tracker *wsid_tracker_init(uint32_t n_hash_buckets)
 {
+	uint64_t n = WSID_MIN_BUCKETS;
+
 	if (!n_hash_buckets || (n_hash_buckets > 16384))
 		return NULL;
 
-	struct wsid_tracker *root = opae_malloc(sizeof(struct wsid_tracker));
+	while (n < n_hash_buckets)
+		n <<= 1;
+
+	struct wsid_tracker *root = opae_calloc(1, sizeof(struct wsid_tracker));
 	if (!root)
 		return NULL;
 
-	root->n_hash_buckets = n_hash_buckets;
-	root->table = opae_calloc(n_hash_buckets, sizeof(struct wsid_map *));
+	root->n_hash_buckets = n;
+	root->table = opae_calloc(n, sizeof(struct wsid_map *));
 	if (!root->table) {
 		opae_free(root);
 		return NULL;
@@ -71,16 +86,159 @@ struct wsid_tracker *wsid_tracker_init(uint32_t n_hash_buckets)
  *
  * @return bucket index
  */
-static inline uint32_t wsid_hash(struct wsid_tracker *root, uint64_t wsid)
+static inline uint64_t wsid_hash(struct wsid_tracker *root, uint64_t wsid)
 {
-	uint64_t h = wsid % 17659;
-	return h % root->n_hash_buckets;
+	/* MurmurHash3 finalizer: workspace ids are often sequential
+	 * or share low-order bits, so mix before masking. */
+	wsid ^= wsid >> 33;
+	wsid *= 0xff51afd7ed558ccdULL;
+	wsid ^= wsid >> 33;
+	wsid *= 0xc4ceb9fe1a85ec53ULL;
+	wsid ^= wsid >> 33;
+	return wsid & (root->n_hash_buckets - 1);
 }
 
+/**
+ * @brief Find the table slot holding wsid
+ * @param root
+ * @param wsid
+ *
+ * @return slot number, or root->n_hash_buckets when not found
+ */
+static inline uint64_t wsid_slot(struct wsid_tracker *root, uint64_t wsid)
+{
+	uint64_t mask = root->n_hash_buckets - 1;
+	uint64_t i = wsid_hash(root, wsid);
+	struct wsid_map *tmp;
+
+	while ((tmp = root->table[i])) {
+		if (tmp->wsid == wsid)
+			return i;
+		i = (i + 1) & mask;
+	}
+
+	return root->n_hash_buckets;
+}
+
+/**
+ * @brief Place an entry into the first free slot of its probe run
+ * @param root
+ * @param wm
+ */
+static inline void wsid_place(struct wsid_tracker *root, struct wsid_map *wm)
+{
+	uint64_t mask = root->n_hash_buckets - 1;
+	uint64_t i = wsid_hash(root, wm->wsid);
+
+	while (root->table[i])
+		i = (i + 1) & mask;
+
+	root->table[i] = wm;
+}
+
+/**
+ * @brief Double the hash table and re-seat all entries
+ * @param root
+ *
+ * @return true if success, false otherwise
+ */
+STATIC bool wsid_grow_table(struct wsid_tracker *root)
+{
+	uint64_t old_n = root->n_hash_buckets;
+	struct wsid_map **old_table = root->table;
+	struct wsid_map **table;
+	uint64_t i;
+
+	table = opae_calloc(old_n << 1, sizeof(struct wsid_map *));
+	if (!table)
+		return false;
+
+	root->table = table;
+	root->n_hash_buckets = old_n << 1;
+
+	for (i = 0; i < old_n; ++i) {
+		if (old_table[i])
+			wsid_place(root, old_table[i]);
+	}
+
+	opae_free(old_table);
+	return true;
+}
+
+/**
+ * @brief Make sure by_index can hold the given index
+ * @param root
+ * @param index
+ *
+ * @return true if index is tracked in by_index, false if it is too large
+ *         or the array could not be grown
+ */
+STATIC bool wsid_reserve_index(struct wsid_tracker *root, uint64_t index)
+{
+	struct wsid_map **by_index;
+	uint32_t n;
+
+	if (index < root->n_by_index)
+		return true;
+
+	if (index >= WSID_MAX_DIRECT_INDEX)
+		return false;
+
+	n = root->n_by_index ? root->n_by_index : WSID_MIN_BUCKETS;
+	while (n <= index)
+		n <<= 1;
+
+	by_index = opae_calloc(n, sizeof(struct wsid_map *));
+	if (!by_index)
+		return false;
+
+	if (root->by_index) {
+		memcpy(by_index, root->by_index,
+		       root->n_by_index * sizeof(struct wsid_map *));
+		opae_free(root->by_index);
+	}
+
+	root->by_index = by_index;
+	root->n_by_index = n;
+	return true;
+}
+
+/**
+ * @brief Take an entry from the free list, allocating a chunk if needed
+ * @param root
+ *
+ * @return the entry, or NULL on allocation failure
+ */
+STATIC struct wsid_map *wsid_alloc_entry(struct wsid_tracker *root)
+{
+	struct wsid_map *wm;
+
+	if (!root->free_list) {
+		struct wsid_map_chunk *chunk;
+		int i;
+
+		chunk = opae_malloc(sizeof(struct wsid_map_chunk));
+		if (!chunk)
+			return NULL;
+
+		for (i = WSID_CHUNK_ENTRIES - 1 ; i >= 0 ; --i) {
+			chunk->entries[i].next = root->free_list;
+			root->free_list = &chunk->entries[i];
+		}
+
+		chunk->next = root->chunks;
+		root->chunks = chunk;
+	}
+
+	wm = root->free_list;
+	root->free_list = wm->next;
+	wm->next = NULL;
+	return wm;
+}
 
 /**
  * @brief Add entry to WSID tracker
- *        Will allocate memory (which is freed by wsid_del() or
+ *        Entry memory is owned by the tracker (and is released by
  *        wsid_tracker_cleanup())
  * @param root
  * @param wsid
@@ -100,22 +258,36 @@ bool wsid_add(struct wsid_tracker *root,
 	      uint64_t index,
 	      int flags)
 {
-	uint32_t idx = wsid_hash(root, wsid);
-	struct wsid_map *tmp = opae_malloc(sizeof(struct wsid_map));
+	struct wsid_map *tmp;
+
+	/* Keep the load factor at or below 1/2. */
+	if (((root->n_entries + 1) << 1) > root->n_hash_buckets &&
+	    !wsid_grow_table(root))
+		return false;
 
+	tmp = wsid_alloc_entry(root);
 	if (!tmp)
 		return false;
 
-	tmp->wsid   = wsid;
-	tmp->addr   = addr;
-	tmp->phys   = phys;
-	tmp->len    = len;
-	tmp->offset = offset;
-	tmp->index  = index;
-	tmp->flags  = flags;
-	tmp->next   = root->table[idx];
+	tmp->wsid       = wsid;
+	tmp->addr       = addr;
+	tmp->phys       = phys;
+	tmp->len        = len;
+	tmp->offset     = offset;
+	tmp->index      = index;
+	tmp->flags      = flags;
+	tmp->index_prev = NULL;
+	tmp->index_next = NULL;
+
+	if (wsid_reserve_index(root, tmp->index)) {
+		tmp->index_next = root->by_index[tmp->index];
+		if (tmp->index_next)
+			tmp->index_next->index_prev = tmp;
+		root->by_index[tmp->index] = tmp;
+	}
 
-	root->table[idx] = tmp;
+	wsid_place(root, tmp);
+	++root->n_entries;
 	return true;
 }
 
@@ -129,34 +301,54 @@ bool wsid_add(struct wsid_tracker *root,
  */
 bool wsid_del(struct wsid_tracker *root, uint64_t wsid)
 {
-	uint32_t idx = wsid_hash(root, wsid);
-	struct wsid_map *tmp = root->table[idx];
+	uint64_t mask = root->n_hash_buckets - 1;
+	uint64_t i = wsid_slot(root, wsid);
+	uint64_t j;
+	struct wsid_map *tmp;
 
-	if (!tmp)
-		return false; /* empty list */
-
-	if (tmp->wsid == wsid) { /* first entry */
-		root->table[idx] = root->table[idx]->next;
-		opae_free(tmp);
-		return true;
-	}
+	if (i == root->n_hash_buckets)
+		return false; /* not found */
 
-	while (tmp->next && tmp->next->wsid != wsid) { /* find */
-		tmp = tmp->next;
+	tmp = root->table[i];
+
+	/* unlink from the index list */
+	if (tmp->index_prev)
+		tmp->index_prev->index_next = tmp->index_next;
+	else if (tmp->index < root->n_by_index &&
+		 root->by_index[tmp->index] == tmp)
+		root->by_index[tmp->index] = tmp->index_next;
+	if (tmp->index_next)
+		tmp->index_next->index_prev = tmp->index_prev;
+
+	/* Close the hole: move back any later entry in the run whose
+	 * home slot does not lie cyclically in (i, j]. */
+	root->table[i] = NULL;
+	j = i;
+	for (;;) {
+		uint64_t k;
+
+		j = (j + 1) & mask;
+		if (!root->table[j])
+			break;
+
+		k = wsid_hash(root, root->table[j]->wsid);
+		if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+			continue;
+
+		root->table[i] = root->table[j];
+		root->table[j] = NULL;
+		i = j;
 	}
 
-	if (!tmp->next)
-		return false; /* not found */
-
-	struct wsid_map *tmp2 = tmp->next;
-	tmp->next = tmp->next->next;
-	opae_free(tmp2);
+	tmp->next = root->free_list;
+	root->free_list = tmp;
+	--root->n_entries;
 
 	return true;
 }
 
 /**
- * @brief Clean up remaining entries in linked list
+ * @brief Clean up remaining entries in the tracker
  *        Will delete all remaining entries
  *
  * @param root
@@ -164,7 +356,8 @@ bool wsid_del(struct wsid_tracker *root, uint64_t wsid)
 void wsid_tracker_cleanup(struct wsid_tracker *root,
 			  void (*clean)(struct wsid_map *))
 {
-	uint32_t idx;
+	uint64_t idx;
+	struct wsid_map_chunk *chunk;
 
 	if (!root)
 		return;
@@ -172,21 +365,24 @@ void wsid_tracker_cleanup(struct wsid_tracker *root,
 	for (idx = 0; idx < root->n_hash_buckets; idx += 1) {
 		struct wsid_map *tmp = root->table[idx];
 
-		while (tmp) {
-			struct wsid_map *tmp2 = tmp->next;
-			if (clean)
-				clean(tmp);
-			opae_free(tmp);
-			tmp = tmp2;
-		}
+		if (tmp && clean)
+			clean(tmp);
+	}
+
+	chunk = root->chunks;
+	while (chunk) {
+		struct wsid_map_chunk *next = chunk->next;
+		opae_free(chunk);
+		chunk = next;
 	}
 
+	opae_free(root->by_index);
 	opae_free(root->table);
 	opae_free(root);
 }
 
 /**
- * @ brief Find entry in linked list
+ * @ brief Find entry in tracker
  *
  * @param root
  * @param wsid
@@ -195,40 +391,37 @@ void wsid_tracker_cleanup(struct wsid_tracker *root,
  */
 struct wsid_map *wsid_find(struct wsid_tracker *root, uint64_t wsid)
 {
-	uint32_t idx = wsid_hash(root, wsid);
-	struct wsid_map *tmp = root->table[idx];
-
-	while (tmp && tmp->wsid != wsid)
-		tmp = tmp->next;
+	uint64_t i = wsid_slot(root, wsid);
 
-	return tmp;
+	return (i == root->n_hash_buckets) ? NULL : root->table[i];
 }
 
 /**
- * @ brief Find entry in linked list
+ * @ brief Find entry in tracker
  *
  * @param root
  * @param index
  *
- * @return
+ * @return the most recently added entry with the given index
  */
 struct wsid_map *wsid_find_by_index(struct wsid_tracker *root, uint32_t index)
 {
-    /*
-     * The hash table isn't set up for finding by index, but this search is
-     * used only for MMIO spaces, which should have a small number of entries.
-     */
-	uint32_t idx;
+	uint64_t idx;
+
+	if (index < root->n_by_index)
+		return root->by_index[index];
+
+	if (index < WSID_MAX_DIRECT_INDEX)
+		return NULL; /* never added */
+
+	/* Indices beyond the direct array are not expected in practice
+	 * (they are MMIO region numbers); fall back to a table scan. */
 	for (idx = 0; idx < root->n_hash_buckets; idx += 1) {
 		struct wsid_map *tmp = root->table[idx];
 
-		while (tmp && tmp->index != index)
-			tmp = tmp->next;
-
-		if (tmp)
+		if (tmp && tmp->index == index)
 			return tmp;
 	}
 
 	return NULL;
 }
-
@@ -52,6 +52,10 @@ fpga_result xfpga_fpgaReadMMIO32(fpga_handle handle, uint32_t mmio_num,
 				 uint64_t offset, uint32_t *value);
 fpga_result xfpga_fpgaWriteMMIO512(fpga_handle handle, uint32_t mmio_num,
 				  uint64_t offset, const void *value);
+fpga_result xfpga_fpgaReadMMIOv(fpga_handle handle, uint32_t mmio_num,
+				fpga_mmio_vec *vec, uint32_t count);
+fpga_result xfpga_fpgaWriteMMIOv(fpga_handle handle, uint32_t mmio_num,
+				 const fpga_mmio_vec *vec, uint32_t count);
 fpga_result xfpga_fpgaMapMMIO(fpga_handle handle, uint32_t mmio_num,
 			      uint64_t **mmio_ptr);
 fpga_result xfpga_fpgaUnmapMMIO(fpga_handle handle, uint32_t mmio_num);
@@ -100,6 +104,11 @@ fpga_result xfpga_fpgaReleaseFromInterface(fpga_handle fpga,
 fpga_result xfpga_fpgaReconfigureSlot(fpga_handle fpga, uint32_t slot,
 				      const uint8_t *bitstream,
 				      size_t bitstream_len, int flags);
+fpga_result xfpga_fpgaReconfigureSlotProgress(fpga_handle fpga, uint32_t slot,
+					      const uint8_t *bitstream,
+					      size_t bitstream_len, int flags,
+					      fpga_reconf_progress_cb progress,
+					      void *context);
 fpga_result xfpga_fpgaTokenGetObject(fpga_token token, const char *name,
 				     fpga_object *object, int flags);
 fpga_result xfpga_fpgaHandleGetObject(fpga_token handle, const char *name,
@@ -141,6 +150,11 @@ fpga_result xfpga_fpgaGetMetricsByName(fpga_handle handle,
 				    uint64_t num_metric_names,
 				    fpga_metric *metrics);
 
+fpga_result xfpga_fpgaGetMetricsSnapshot(fpga_handle handle,
+				    fpga_metric *metrics,
+				    uint64_t *num_metrics,
+				    uint64_t *timestamp_ns);
+
 fpga_result xfpga_fpgaGetMetricsThresholdInfo(fpga_handle handle,
 			metric_threshold *metric_threshold,
 			uint32_t *num_thresholds);
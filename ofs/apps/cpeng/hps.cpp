@@ -25,9 +25,13 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include "afu_test.h"
 #include "ofs_cpeng.h"
@@ -66,6 +70,8 @@ public:
     , timeout_usec_(default_timeout_usec.count())
     , chunk_(pg_size)
     , data_request_limit_(512)
+    , buffers_(2)
+    , poll_usec_(0)
     , soft_reset_(false)
     , skip_ssbl_verify_(false)
     , skip_kernel_verify_(false)
@@ -106,6 +112,14 @@ public:
       ->check(CLI::IsMember(limits));
     app->add_option("-c,--chunk", chunk_, "Chunk size. 0 indicates no chunks")
       ->default_str(std::to_string(chunk_));
+    app->add_option("-b,--buffers", buffers_,
+                    "Number of chunk buffers. With more than one, the next "
+                    "chunks are read while the current one is copied")
+      ->default_str(std::to_string(buffers_))
+      ->check(CLI::Range(1, 64));
+    app->add_option("--poll-interval", poll_usec_,
+                    "DMA status poll interval in usec. 0 busy-polls")
+      ->default_str(std::to_string(poll_usec_));
     app->add_flag("--soft-reset", soft_reset_, "Issue soft reset only");
     app->add_flag("--skip-ssbl-verify", skip_ssbl_verify_, "Do not wait for ssbl verify");
     app->add_flag("--skip-kernel-verify", skip_kernel_verify_, "Do not wait for kernel verify");
@@ -136,85 +150,176 @@ public:
       return 2;
     }
 
-    // Open file, get the size
-    std::ifstream inp(filename_, std::ios::binary | std::ios::ate);
-    size_t sz = inp.tellg();
-    inp.seekg(0, std::ios::beg);
+    // Map the image file. Chunks are copied out of the mapping into the
+    // DMA buffers as the copy progresses.
+    int fd = open(filename_.c_str(), O_RDONLY);
+    if (fd < 0) {
+      log_->error("could not open {}: {}", filename_, strerror(errno));
+      return 3;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || !st.st_size) {
+      log_->error("could not get size of {}", filename_);
+      close(fd);
+      return 3;
+    }
+    size_t sz = st.st_size;
+    void *image = mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+      log_->error("could not map {}: {}", filename_, strerror(errno));
+      return 3;
+    }
+    madvise(image, sz, MADV_SEQUENTIAL);
+
+    int res = copy_image(afu, &cpeng,
+                         reinterpret_cast<const uint8_t*>(image), sz);
+    munmap(image, sz);
+    if (res) {
+      return res;
+    }
+    ofs_cpeng_image_complete(&cpeng);
+
+    // wait for both ssbl and kernel verify (if not skipped)
+    if (!skip_ssbl_verify_) {
+      wait_for_verify("ssbl", &cpeng, ofs_cpeng_hps_ssbl_verify);
+    }
+    if (!skip_kernel_verify_) {
+      wait_for_verify("kernel", &cpeng, ofs_cpeng_hps_kernel_verify);
+    }
+
+    return 0;
+  }
+
 
+private:
+  // Copy the image to HPS DDR through a ring of buffers_ DMA buffers.
+  // A reader thread fills buffer k+1.. while buffer k is being copied,
+  // so reading the file overlaps the DMA. With one buffer this is the
+  // plain read-then-copy loop.
+  int copy_image(opae::afu_test::afu *afu, ofs_cpeng *cpeng,
+                 const uint8_t *image, size_t sz)
+  {
     // if chunk_ CLI arg is 0, use the file size
     // otherwise, use the smaller of chunk_ and file size
     size_t chunk = chunk_ ? std::min(static_cast<size_t>(chunk_), sz) : sz;
-    shared_buffer::ptr_t buffer(0);
     // make sure we align our buffer size to data request limit
+    size_t buffer_sz = aligned(chunk, data_request_limit_);
+    std::vector<shared_buffer::ptr_t> buffers;
     try {
-      buffer = shared_buffer::allocate(afu->handle(),
-                                       aligned(chunk, data_request_limit_));
+      for (uint32_t i = 0; i < buffers_; ++i) {
+        buffers.push_back(shared_buffer::allocate(afu->handle(), buffer_sz));
+      }
     } catch (opae_exception &ex) {
-      log_->error("could not allocate {} bytes of memory", chunk);
+      log_->error("could not allocate {} buffers of {} bytes",
+                  buffers_, buffer_sz);
       if (chunk > pg_size) {
         auto hugepage_sz = chunk <= MB(2) ? "2MB" : "1GB";
         log_->error("might need {} hugepages reserved", hugepage_sz);
       }
       return 3;
     }
-    // get a char* of the buffer so we can read into it every chunk iteration
-    auto ptr = reinterpret_cast<char*>(const_cast<uint8_t*>(buffer->c_type()));
-
-    memset(ptr, 0, buffer->size());
-    size_t written = 0;
-    log_->info("starting copy of file:{}, size: {}, chunk size: {}",
-               filename_, sz, chunk);
-    uint32_t n_chunks = 0;
-    // set our xfer size to chunk size
-    // but align it with req. limit size in case
-    // our chunk is the entire file
-    auto xfer_sz = aligned(chunk, data_request_limit_);
+
+    size_t n_chunks = (sz + chunk - 1) / chunk;
+    log_->info("starting copy of file:{}, size: {}, chunk size: {}, "
+               "buffers: {}", filename_, sz, chunk, buffers_);
     // set the data req. limit to CLI arg (default arg is 512, default in HW is 1k)
-    ofs_cpeng_set_data_req_limit(&cpeng, limit_map[data_request_limit_]);
-    while (written < sz) {
-        auto unread = sz-written;
-        inp.read(ptr, chunk);
-        if (ofs_cpeng_copy_chunk(
-              &cpeng, buffer->io_address(),
-              destination_offset_ + written,
-              xfer_sz,
-              timeout_usec_)) {
-          auto status = ofs_cpeng_dma_status(&cpeng);
-          log_->warn("copy chunk: {}, size: {}, unread: {}, dma_status: {:x}",
-                      n_chunks, xfer_sz, unread, status);
-          if (dmastatus_err(&cpeng)) {
-            return 4;
+    ofs_cpeng_set_data_req_limit(cpeng, limit_map[data_request_limit_]);
+
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<bool> full(buffers_, false);
+    bool stop = false;
+
+    std::thread reader([&]() {
+      for (size_t n = 0; n < n_chunks; ++n) {
+        auto slot = n % buffers_;
+        {
+          std::unique_lock<std::mutex> lk(lock);
+          cv.wait(lk, [&]{ return !full[slot] || stop; });
+          if (stop) {
+            return;
           }
         }
-        ++n_chunks;
-        written += chunk;
-        // if we're at the last chunk,
-        // 1. zero out our buffer
-        // 2. set 'chunk' to number of unread bytes
-        // 3. set 'xfer_sz' to the req. limit aligned value of the last chunk
-        if (unread < chunk) {
-          memset(ptr, 0, chunk);
-          chunk = unread;
-          xfer_sz = aligned(chunk, data_request_limit_);
-          log_->info("last chunk {}, aligned {}", chunk, xfer_sz);
+        auto ptr = const_cast<uint8_t*>(buffers[slot]->c_type());
+        auto offset = n * chunk;
+        auto len = std::min(chunk, sz - offset);
+        memcpy(ptr, image + offset, len);
+        // zero the pad of the last chunk up to the request limit
+        memset(ptr + len, 0, buffer_sz - len);
+        {
+          std::lock_guard<std::mutex> lk(lock);
+          full[slot] = true;
         }
-    }
-    log_->info("transferred file in {} chunk(s)", n_chunks);
-    ofs_cpeng_image_complete(&cpeng);
+        cv.notify_all();
+      }
+    });
 
-    // wait for both ssbl and kernel verify (if not skipped)
-    if (!skip_ssbl_verify_) {
-      wait_for_verify("ssbl", &cpeng, ofs_cpeng_hps_ssbl_verify);
-    }
-    if (!skip_kernel_verify_) {
-      wait_for_verify("kernel", &cpeng, ofs_cpeng_hps_kernel_verify);
+    auto finish = [&](int res) {
+      {
+        std::lock_guard<std::mutex> lk(lock);
+        stop = true;
+      }
+      cv.notify_all();
+      reader.join();
+      return res;
+    };
+
+    using clock = std::chrono::steady_clock;
+    using fusec = std::chrono::duration<double, std::micro>;
+    double dma_min = 0.0, dma_max = 0.0, dma_total = 0.0, stall_total = 0.0;
+    auto begin = clock::now();
+    for (size_t n = 0; n < n_chunks; ++n) {
+      auto slot = n % buffers_;
+      auto offset = n * chunk;
+      auto unread = sz - offset;
+      // set our xfer size to chunk size, aligned with req. limit size
+      // in case our chunk is the entire file or this is the last chunk
+      auto xfer_sz = aligned(std::min(chunk, unread), data_request_limit_);
+
+      auto wait_begin = clock::now();
+      {
+        std::unique_lock<std::mutex> lk(lock);
+        cv.wait(lk, [&]{ return full[slot]; });
+      }
+      auto dma_begin = clock::now();
+      ofs_cpeng_start_chunk(cpeng, buffers[slot]->io_address(),
+                            destination_offset_ + offset, xfer_sz);
+      if (ofs_cpeng_wait_for_chunk(cpeng, timeout_usec_, poll_usec_)) {
+        auto status = ofs_cpeng_dma_status(cpeng);
+        log_->warn("copy chunk: {}, size: {}, unread: {}, dma_status: {:x}",
+                    n, xfer_sz, unread, status);
+        if (dmastatus_err(cpeng)) {
+          return finish(4);
+        }
+      }
+      auto dma_end = clock::now();
+      {
+        std::lock_guard<std::mutex> lk(lock);
+        full[slot] = false;
+      }
+      cv.notify_all();
+
+      double stall = fusec(dma_begin - wait_begin).count();
+      double dma = fusec(dma_end - dma_begin).count();
+      log_->debug("chunk {}: size: {}, read stall: {:.1f} us, dma: {:.1f} us",
+                  n, xfer_sz, stall, dma);
+      dma_min = n ? std::min(dma_min, dma) : dma;
+      dma_max = std::max(dma_max, dma);
+      dma_total += dma;
+      stall_total += stall;
     }
-
+    double elapsed = fusec(clock::now() - begin).count();
+    finish(0);
+
+    log_->info("transferred file in {} chunk(s), {:.1f} ms, {:.2f} MB/s",
+               n_chunks, elapsed / 1E3, elapsed ? sz / elapsed : 0.0);
+    log_->info("chunk dma latency min/avg/max: {:.1f}/{:.1f}/{:.1f} us, "
+               "stalled on file read: {:.1f} us",
+               dma_min, dma_total / n_chunks, dma_max, stall_total);
     return 0;
   }
 
-
-private:
   bool dmastatus_err(ofs_cpeng *cpeng)
   {
     if (ofs_cpeng_dma_status_error(cpeng)) {
@@ -260,6 +365,8 @@ private:
   uint32_t timeout_usec_;
   uint32_t chunk_;
   uint32_t data_request_limit_;
+  uint32_t buffers_;
+  uint32_t poll_usec_;
   bool soft_reset_;
   bool skip_ssbl_verify_;
   bool skip_kernel_verify_;
@@ -127,16 +127,18 @@ public:
 	  tg_offset_ = AFU_DFH + (MEM_TG_CFG_OFFSET * (1+tg_exe_->mem_ch_));
 	}
 	
-	tg_exe_->write32(tg_offset_+TG_LOOP_COUNT,  tg_exe_->loop_);
-	tg_exe_->write32(tg_offset_+TG_WRITE_COUNT, tg_exe_->wcnt_);
-	tg_exe_->write32(tg_offset_+TG_READ_COUNT,  tg_exe_->rcnt_);
-	tg_exe_->write32(tg_offset_+TG_BURST_LENGTH, tg_exe_->bcnt_);
-	tg_exe_->write32(tg_offset_+TG_SEQ_ADDR_INCR, tg_exe_->stride_);
-	tg_exe_->write32(tg_offset_+TG_PPPG_SEL, tg_exe_->pattern_);
-
-	// address increment mode
-	tg_exe_->write32(tg_offset_+TG_ADDR_MODE_WR, TG_ADDR_SEQ);
-	tg_exe_->write32(tg_offset_+TG_ADDR_MODE_RD, TG_ADDR_SEQ);
+	std::vector<fpga_mmio_vec> cfg = {
+	  { tg_offset_+TG_LOOP_COUNT,    tg_exe_->loop_,    32, 0 },
+	  { tg_offset_+TG_WRITE_COUNT,   tg_exe_->wcnt_,    32, 0 },
+	  { tg_offset_+TG_READ_COUNT,    tg_exe_->rcnt_,    32, 0 },
+	  { tg_offset_+TG_BURST_LENGTH,  tg_exe_->bcnt_,    32, 0 },
+	  { tg_offset_+TG_SEQ_ADDR_INCR, tg_exe_->stride_,  32, 0 },
+	  { tg_offset_+TG_PPPG_SEL,      tg_exe_->pattern_, 32, 0 },
+	  // address increment mode
+	  { tg_offset_+TG_ADDR_MODE_WR,  TG_ADDR_SEQ,       32, 0 },
+	  { tg_offset_+TG_ADDR_MODE_RD,  TG_ADDR_SEQ,       32, 0 },
+	};
+	tg_exe_->handle()->write_csrs(cfg);
 
         return 0;
     }
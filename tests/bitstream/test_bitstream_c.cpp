@@ -38,6 +38,7 @@ fpga_result opae_bitstream_read_file(const char *file,
 void opae_resolve_legacy_bitstream(opae_bitstream_info *info);
 
 void *opae_bitstream_parse_metadata(const char *metadata,
+				    size_t len,
 				    fpga_guid pr_interface_id,
 				    int *version);
 
@@ -173,7 +174,7 @@ TEST_P(bitstream_c_p, parse_err0) {
   fpga_guid guid;
   int ver = 0;
 
-  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, guid, &ver), nullptr);
+  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, strlen(mdata), guid, &ver), nullptr);
 }
 
 /**
@@ -189,7 +190,7 @@ TEST_P(bitstream_c_p, parse_err1) {
   fpga_guid guid;
   int ver = 0;
 
-  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, guid, &ver), nullptr);
+  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, strlen(mdata), guid, &ver), nullptr);
 }
 
 /**
@@ -207,7 +208,7 @@ TEST_P(bitstream_c_p, parse_err2) {
   fpga_guid guid;
   int ver = 0;
 
-  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, guid, &ver), nullptr);
+  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, strlen(mdata), guid, &ver), nullptr);
 }
 
 /**
@@ -225,7 +226,7 @@ TEST_P(bitstream_c_p, parse_err3) {
   fpga_guid guid;
   int ver = 0;
 
-  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, guid, &ver), nullptr);
+  EXPECT_EQ(opae_bitstream_parse_metadata(mdata, strlen(mdata), guid, &ver), nullptr);
 }
 
 /**
@@ -320,6 +321,117 @@ TEST_P(bitstream_c_p, load_ok0) {
   EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
 }
 
+/**
+ * @test       load_ok1
+ * @brief      Test: opae_load_bitstream, opae_bitstream_get_metadata
+ * @details    Given a valid GBS file,<br>
+ *             opae_load_bitstream maps it, resolves the<br>
+ *             pr_interface_id and defers the metadata parse.<br>
+ *             opae_bitstream_get_metadata then expands and caches<br>
+ *             the metadata, and opae_unload_bitstream releases it.<br>
+ */
+TEST_P(bitstream_c_p, load_ok1) {
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmpnull_gbs_, &info), FPGA_OK);
+  EXPECT_TRUE(info.data_mapped);
+  EXPECT_EQ(info.data_len, null_gbs_.size());
+  EXPECT_EQ(memcmp(info.data, null_gbs_.data(), null_gbs_.size()), 0);
+  EXPECT_EQ(info.rbf_data, info.data + null_gbs_.size());
+  EXPECT_EQ(info.rbf_len, 0);
+  EXPECT_EQ(info.metadata_version, 1);
+  EXPECT_EQ(info.parsed_metadata, nullptr);
+
+  fpga_guid pr_interface_id;
+  memcpy(pr_interface_id, info.pr_interface_id, sizeof(fpga_guid));
+
+  void *md = opae_bitstream_get_metadata(&info);
+  ASSERT_NE(md, nullptr);
+  EXPECT_EQ(info.parsed_metadata, md);
+  EXPECT_EQ(opae_bitstream_get_metadata(&info), md);
+  EXPECT_EQ(memcmp(info.pr_interface_id, pr_interface_id, sizeof(fpga_guid)), 0);
+
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+  EXPECT_EQ(info.data, nullptr);
+  EXPECT_EQ(info.parsed_metadata, nullptr);
+}
+
+/**
+ * @test       load_err2
+ * @brief      Test: opae_load_bitstream
+ * @details    If the metadata is truncated before the end<br>
+ *             of the JSON object,<br>
+ *             the fn returns FPGA_EXCEPTION.<br>
+ */
+TEST_P(bitstream_c_p, load_err2) {
+  std::vector<uint8_t> gbs = null_gbs_;
+  uint32_t len = *reinterpret_cast<uint32_t *>(gbs.data() + 16) / 2;
+  *reinterpret_cast<uint32_t *>(gbs.data() + 16) = len;
+  gbs.resize(20 + len);
+
+  std::ofstream out;
+  out.open(tmpnull_gbs_, std::ios::out|std::ios::binary);
+  out.write((const char *)gbs.data(), gbs.size());
+  out.close();
+
+  opae_bitstream_info info;
+  EXPECT_EQ(opae_load_bitstream(tmpnull_gbs_, &info), FPGA_EXCEPTION);
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+}
+
+/**
+ * @test       get_metadata_err0
+ * @brief      Test: opae_bitstream_get_metadata
+ * @details    When passed NULL or a legacy bitstream,<br>
+ *             the fn returns NULL.<br>
+ */
+TEST_P(bitstream_c_p, get_metadata_err0) {
+  EXPECT_EQ(opae_bitstream_get_metadata(nullptr), nullptr);
+
+  opae_legacy_bitstream_header hdr;
+  hdr.legacy_magic = OPAE_LEGACY_BITSTREAM_MAGIC;
+  memcpy(hdr.legacy_pr_ifc_id, guid, sizeof(fpga_guid));
+
+  std::ofstream gbs;
+  gbs.open(tmpnull_gbs_, std::ios::out|std::ios::binary);
+  gbs.write((const char *)&hdr, sizeof(hdr));
+  gbs.close();
+
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmpnull_gbs_, &info), FPGA_OK);
+  EXPECT_EQ(opae_bitstream_get_metadata(&info), nullptr);
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+}
+
+/**
+ * @test       copy_data
+ * @brief      Test: opae_bitstream_copy_data
+ * @details    Given a mapped GBS,<br>
+ *             the fn replaces the mapping with a heap copy,<br>
+ *             moves rbf_data along with it and returns FPGA_OK.<br>
+ *             A second call, or a NULL info, changes nothing.<br>
+ */
+TEST_P(bitstream_c_p, copy_data) {
+  EXPECT_EQ(opae_bitstream_copy_data(nullptr), FPGA_INVALID_PARAM);
+
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmpnull_gbs_, &info), FPGA_OK);
+  ASSERT_TRUE(info.data_mapped);
+  size_t rbf_offset = info.rbf_data - info.data;
+
+  EXPECT_EQ(opae_bitstream_copy_data(&info), FPGA_OK);
+  EXPECT_FALSE(info.data_mapped);
+  ASSERT_NE(info.data, nullptr);
+  EXPECT_EQ(info.data_len, null_gbs_.size());
+  EXPECT_EQ(memcmp(info.data, null_gbs_.data(), null_gbs_.size()), 0);
+  EXPECT_EQ(info.rbf_data, info.data + rbf_offset);
+
+  uint8_t *data = info.data;
+  EXPECT_EQ(opae_bitstream_copy_data(&info), FPGA_OK);
+  EXPECT_EQ(info.data, data);
+
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+}
+
 /**
  * @test       unload_err0
  * @brief      Test: opae_unload_bitstream
@@ -370,23 +482,20 @@ TEST_P(mock_bitstream_c_p, read_err1) {
 }
 
 /**
- * @test       resolve_err2
- * @brief      Test: opae_resolve_bitstream
- * @details    When malloc fails<br>
- *             the fn returns FPGA_NO_MEMORY.<br>
+ * @test       get_metadata_err1
+ * @brief      Test: opae_bitstream_get_metadata
+ * @details    When calloc fails while expanding the metadata,<br>
+ *             the fn returns NULL and leaves parsed_metadata unset.<br>
  */
-TEST_P(mock_bitstream_c_p, resolve_err2) {
-  opae_bitstream_header hdr;
-  memcpy(hdr.valid_gbs_guid, valid_GBS_guid, sizeof(fpga_guid));
-  hdr.metadata_length = 1;
-
+TEST_P(mock_bitstream_c_p, get_metadata_err1) {
   opae_bitstream_info info;
-  info.filename = tmpnull_gbs_;
-  info.data = (uint8_t *)&hdr;
-  info.data_len = sizeof(hdr);
+  ASSERT_EQ(opae_load_bitstream(tmpnull_gbs_, &info), FPGA_OK);
 
-  system_->invalidate_malloc(0, "opae_resolve_bitstream");
-  EXPECT_EQ(opae_resolve_bitstream(&info), FPGA_NO_MEMORY);
+  system_->invalidate_calloc(0, "opae_bitstream_parse_metadata_v1");
+  EXPECT_EQ(opae_bitstream_get_metadata(&info), nullptr);
+  EXPECT_EQ(info.parsed_metadata, nullptr);
+
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
 }
 
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(mock_bitstream_c_p);
@@ -32,6 +32,8 @@
 #include <fcntl.h>
 #include <glob.h>
 #include <regex>
+#include <vector>
+#include <json-c/json.h>
 
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
@@ -440,6 +442,107 @@ TEST_P(board_dfl_n6000_c_p, board_n6000_12) {
   EXPECT_EQ(print_mac_info(device_token_), FPGA_OK);
 }
 
+/**
+* @test       board_n6000_13
+* @brief      Tests: fpga_event_log, fpga_event_log_json
+* @details    Loads a synthetic event log image into the mock nvmem node,<br>
+*             with the newest boot near the start of flash so the log<br>
+*             wraps. Dumps it as text and as JSON and checks every boot<br>
+*             comes back once, newest first, with its own records.<br>
+*/
+TEST_P(board_dfl_n6000_c_p, board_n6000_13) {
+  const size_t block_size = 0x1000;
+  const uint32_t block_count = 63;
+  const uint32_t newest = 5;
+  std::vector<uint32_t> image((block_count * block_size) / sizeof(uint32_t) + 1,
+                              UINT32_MAX);
+  uint32_t boot;
+
+  // Every fourth boot is left erased; the rest get power on, time of
+  // day and power off records tagged with their boot index.
+  for (boot = 0; boot < block_count; ++boot) {
+    uint32_t block = (newest + block_count - boot) % block_count;
+    uint32_t *w = &image[block * block_size / sizeof(uint32_t)];
+
+    if (boot % 4 == 3)
+      continue;
+
+    std::fill(w, w + 256, 0);
+    w[0] = 0x53696C12;             // power on status
+    w[3] = boot;
+    w[11] = 0x53696CF0;            // time of day
+    w[12] = 1000000 + boot * 1000;
+    w[36] = 0x53696C34;            // power off status
+    w[37] = 2000000 + boot * 1000;
+  }
+  image.back() = newest;
+
+  ASSERT_EQ(write_sysfs_file("dfl_dev*/*/bmc_event_log*/nvmem",
+                             image.data(), image.size() * sizeof(uint32_t)),
+            FPGA_OK);
+
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(fpga_event_log(device_token_, 0, 0, false, false, false), FPGA_OK);
+  std::string text = testing::internal::GetCapturedStdout();
+
+  size_t pos = text.find("Current Boot / Boot 0\n");
+  EXPECT_EQ(pos, 0u);
+  for (boot = 1; boot < block_count; ++boot) {
+    std::string label = "Boot " + std::to_string(boot) +
+                        (boot % 4 == 3 ? ": Empty\n" : "\n");
+    size_t next = text.find("\n" + label);
+    ASSERT_NE(next, std::string::npos) << label;
+    EXPECT_GT(next, pos) << label;
+    pos = next;
+  }
+
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(fpga_event_log(device_token_, 2, 4, false, false, false), FPGA_OK);
+  text = testing::internal::GetCapturedStdout();
+  EXPECT_EQ(text.find("Boot 2\n"), 0u);
+  EXPECT_NE(text.find("\nBoot 3: Empty\n"), std::string::npos);
+  EXPECT_EQ(text.find("Boot 4"), std::string::npos);
+
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(fpga_event_log_json(device_token_, 0, 0, false), FPGA_OK);
+  text = testing::internal::GetCapturedStdout();
+
+  json_object *root = json_tokener_parse(text.c_str());
+  ASSERT_NE(root, nullptr);
+  ASSERT_TRUE(json_object_is_type(root, json_type_array));
+  ASSERT_EQ(json_object_array_length(root), block_count);
+
+  for (boot = 0; boot < block_count; ++boot) {
+    json_object *event = json_object_array_get_idx(root, boot);
+    json_object *field = nullptr;
+    json_object *record = nullptr;
+
+    ASSERT_TRUE(json_object_object_get_ex(event, "boot", &field));
+    EXPECT_EQ(json_object_get_int64(field), boot);
+    ASSERT_TRUE(json_object_object_get_ex(event, "empty", &field));
+    EXPECT_EQ(json_object_get_boolean(field), boot % 4 == 3);
+
+    if (boot % 4 == 3) {
+      EXPECT_FALSE(json_object_object_get_ex(event, "power_on_status", &record));
+      continue;
+    }
+
+    ASSERT_TRUE(json_object_object_get_ex(event, "power_on_status", &record));
+    ASSERT_TRUE(json_object_object_get_ex(record, "status", &field));
+    EXPECT_EQ(json_object_get_int64(field), boot);
+    ASSERT_TRUE(json_object_object_get_ex(event, "power_on_time_ms", &field));
+    EXPECT_EQ(json_object_get_int64(field), 1000000 + boot * 1000);
+    ASSERT_TRUE(json_object_object_get_ex(event, "power_off_time_ms", &field));
+    EXPECT_EQ(json_object_get_int64(field), 2000000 + boot * 1000);
+    EXPECT_FALSE(json_object_object_get_ex(event, "sensors_state", &record));
+  }
+
+  json_object_put(root);
+
+  EXPECT_EQ(fpga_event_log_json(device_token_, block_count + 1, 0, false),
+            FPGA_INVALID_PARAM);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(board_dfl_n6000_c_p);
 INSTANTIATE_TEST_SUITE_P(board_dfl_n6000_c, board_dfl_n6000_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({
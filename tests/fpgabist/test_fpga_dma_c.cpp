@@ -0,0 +1,101 @@
+// Copyright(c) 2026, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <dirent.h>
+#include <linux/ioctl.h>
+
+#include "fpga-dfl.h"
+#include "mock/opae_fixtures.h"
+#include "fpga_dma.h"
+#include "fpga_dma_internal.h"
+
+using namespace opae::testing;
+
+static int mmio_ioctl(mock_object * m, int request, va_list argp){
+    UNUSED_PARAM(m);
+    UNUSED_PARAM(request);
+    struct dfl_fpga_port_region_info *rinfo = va_arg(argp, struct dfl_fpga_port_region_info *);
+    if (!rinfo || rinfo->argsz != sizeof(*rinfo) || rinfo->index > 1) {
+      errno = EINVAL;
+      return -1;
+    }
+    rinfo->flags = DFL_PORT_REGION_READ | DFL_PORT_REGION_WRITE | DFL_PORT_REGION_MMAP;
+    rinfo->size = 0x40000;
+    rinfo->offset = 0;
+    return 0;
+}
+
+static int open_fd_count()
+{
+  DIR *dir = opendir("/proc/self/fd");
+  int count = 0;
+  if (!dir)
+    return -1;
+  while (readdir(dir))
+    ++count;
+  closedir(dir);
+  return count;
+}
+
+class fpga_dma_c_p : public opae_p<> {
+ protected:
+  virtual void SetUp() override
+  {
+    opae_p<>::SetUp();
+    system_->register_ioctl_handler(DFL_FPGA_PORT_GET_REGION_INFO, mmio_ioctl);
+  }
+};
+
+/**
+ * @test       open_not_found
+ * @brief      Test: fpgaDMAOpen
+ * @details    When the AFU's feature list holds no DMA BBB,<br>
+ *             fpgaDMAOpen returns FPGA_NOT_FOUND, leaves *dma NULL,<br>
+ *             and closes the doorbell eventfds it created.<br>
+ */
+TEST_P(fpga_dma_c_p, open_not_found) {
+  // A lone AFU header (type 1) that terminates the feature list.
+  const uint64_t dfh = (1ULL << AFU_DFH_TYPE_OFFSET) |
+                       (1ULL << AFU_DFH_EOL_OFFSET);
+  ASSERT_EQ(fpgaWriteMMIO64(accel_, 0, 0, dfh), FPGA_OK);
+
+  int before = open_fd_count();
+  ASSERT_GT(before, 0);
+
+  fpga_dma_handle_t dma = (fpga_dma_handle_t)this;
+  EXPECT_EQ(fpgaDMAOpen(accel_, 0, &dma), FPGA_NOT_FOUND);
+  EXPECT_EQ(dma, nullptr);
+
+  EXPECT_EQ(open_fd_count(), before);
+}
+
+INSTANTIATE_TEST_SUITE_P(fpga_dma_c, fpga_dma_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({
+                                                                        "dfl-d5005",
+                                                                        "dfl-n3000"
+                                                                      })));
@@ -125,7 +125,7 @@ TEST_P(fpgad_opae_events_api_c_p, events02) {
 
 /**
  * @test       events03
- * @brief      Test: opae_api_send_EVENT_ERROR, check_and_send_EVENT_ERROR
+ * @brief      Test: opae_api_send_EVENT_ERROR, send_event
  * @details    Verifies the fn's ability to correctly signal<br>
  *             an FPGA_EVENT_ERROR.<br>
  */
@@ -148,11 +148,14 @@ TEST_P(fpgad_command_line_c_p, register_err2) {
  * @test       register_null
  * @brief      Test: cmd_register_null_gbs
  * @details    When given a path to a valid NULL GBS,<br>
- *             the fn loads the GBS and returns true.<br>
+ *             the fn loads a private copy of the GBS,<br>
+ *             rather than a mapping of the file,<br>
+ *             and returns true.<br>
  */
 TEST_P(fpgad_command_line_c_p, register_null) {
   EXPECT_TRUE(cmd_register_null_gbs(&config_, tmpnull_gbs_));
   EXPECT_EQ(config_.num_null_gbs, 1);
+  EXPECT_FALSE(config_.null_gbs[0].data_mapped);
 }
 
 /**
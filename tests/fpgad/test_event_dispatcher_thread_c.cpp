@@ -31,18 +31,10 @@ extern "C" {
 #include "fpgad/api/logging.h"
 #include "fpgad/event_dispatcher_thread.h"
 
-#define EVENT_DISPATCH_QUEUE_DEPTH 512
-
-typedef struct _evt_dispatch_queue {
-  event_dispatch_queue_item q[EVENT_DISPATCH_QUEUE_DEPTH];
-  unsigned head;
-  unsigned tail;
-  pthread_mutex_t lock;
-} evt_dispatch_queue;
-
 extern evt_dispatch_queue normal_queue;
 extern evt_dispatch_queue high_priority_queue;
 
+void evt_queue_init(evt_dispatch_queue *q, bool coalesce);
 bool evt_queue_is_full(evt_dispatch_queue *q);
 }
 
@@ -61,6 +53,9 @@ class fpgad_evt_c_p : public opae_base_p<> {
     opae_base_p<>::SetUp();
 
     log_set(stdout);
+
+    evt_queue_init(&normal_queue, true);
+    evt_queue_init(&high_priority_queue, false);
   }
 
   virtual void TearDown() override {
@@ -78,17 +73,22 @@ class fpgad_evt_c_p : public opae_base_p<> {
  *             it returns true.<br>
  */
 TEST_P(fpgad_evt_c_p, q_full0) {
-  evt_dispatch_queue q;
+  evt_dispatch_queue *q = new evt_dispatch_queue;
+
+  evt_queue_init(q, false);
+  EXPECT_FALSE(evt_queue_is_full(q));
 
   // case 0
-  q.head = 0;
-  q.tail = EVENT_DISPATCH_QUEUE_DEPTH - 1;
-  EXPECT_TRUE(evt_queue_is_full(&q));
-
-  // case 1
-  q.head = 1;
-  q.tail = 0;
-  EXPECT_TRUE(evt_queue_is_full(&q));
+  q->head = 0;
+  q->tail = EVENT_DISPATCH_QUEUE_DEPTH;
+  EXPECT_TRUE(evt_queue_is_full(q));
+
+  // case 1 (indices past the wrap point)
+  q->head = 3 * EVENT_DISPATCH_QUEUE_DEPTH + 1;
+  q->tail = 4 * EVENT_DISPATCH_QUEUE_DEPTH + 1;
+  EXPECT_TRUE(evt_queue_is_full(q));
+
+  delete q;
 }
 
 static void test_evt_response(fpgad_monitored_device *dev,
@@ -101,19 +101,137 @@ static void test_evt_response(fpgad_monitored_device *dev,
 /**
  * @test       q_full1
  * @brief      Test: evt_queue_response
- * @details    When normal_queue is full,<br>
- *             the function logs an error and returns false.<br>
+ * @details    When normal_queue stays full,<br>
+ *             the function returns false and counts the drop.<br>
  */
 TEST_P(fpgad_evt_c_p, q_full1) {
   fpgad_monitored_device d;
+  evt_queue_stats stats;
+  int i;
+
+  memset(&d, 0, sizeof(d));
 
-  normal_queue.head = 1;
-  normal_queue.tail = 0;
+  for (i = 0 ; i < EVENT_DISPATCH_QUEUE_DEPTH ; ++i) {
+    EXPECT_TRUE(evt_queue_response(test_evt_response,
+                                   &d,
+                                   NULL));
+  }
   EXPECT_FALSE(evt_queue_response(test_evt_response,
                                   &d,
                                   NULL));
-  normal_queue.head = 0;
-  normal_queue.tail = 0;
+
+  evt_queue_get_stats(&stats, NULL);
+  EXPECT_EQ(stats.depth, EVENT_DISPATCH_QUEUE_DEPTH);
+  EXPECT_EQ(stats.max_depth, EVENT_DISPATCH_QUEUE_DEPTH);
+  EXPECT_EQ(stats.enqueued, EVENT_DISPATCH_QUEUE_DEPTH);
+  EXPECT_EQ(stats.dropped, 1);
+}
+
+/**
+ * @test       coalesce
+ * @brief      Test: evt_queue_response, evt_queue_get
+ * @details    When a (callback, device) pair is already queued,<br>
+ *             a duplicate is coalesced into it until the queued<br>
+ *             item is dequeued.<br>
+ */
+TEST_P(fpgad_evt_c_p, coalesce) {
+  fpgad_monitored_device d;
+  fpgad_respond_event_t responses[] = { test_evt_response, NULL };
+  event_dispatch_queue_item item;
+  evt_queue_stats stats;
+
+  memset(&d, 0, sizeof(d));
+  d.responses = responses;
+
+  EXPECT_TRUE(evt_queue_response(test_evt_response, &d, NULL));
+  EXPECT_TRUE(evt_queue_response(test_evt_response, &d, NULL));
+
+  evt_queue_get_stats(&stats, NULL);
+  EXPECT_EQ(stats.depth, 1);
+  EXPECT_EQ(stats.coalesced, 1);
+
+  EXPECT_TRUE(evt_queue_get(&item));
+  EXPECT_EQ(item.callback, test_evt_response);
+  EXPECT_EQ(item.device, &d);
+  EXPECT_EQ(d.pending_responses, 0);
+
+  EXPECT_TRUE(evt_queue_response(test_evt_response, &d, NULL));
+  evt_queue_get_stats(&stats, NULL);
+  EXPECT_EQ(stats.depth, 1);
+  EXPECT_EQ(stats.coalesced, 1);
+
+  // high priority events are never coalesced
+  EXPECT_TRUE(evt_queue_response_high(test_evt_response, &d, NULL));
+  EXPECT_TRUE(evt_queue_response_high(test_evt_response, &d, NULL));
+  evt_queue_get_stats(NULL, &stats);
+  EXPECT_EQ(stats.depth, 2);
+  EXPECT_EQ(stats.coalesced, 0);
+}
+
+/**
+ * @test       coalesce_context
+ * @brief      Test: evt_queue_response, evt_queue_get
+ * @details    When one callback serves several responses<br>
+ *             with different contexts, an event for one context<br>
+ *             is not coalesced into a queued event for another.<br>
+ */
+TEST_P(fpgad_evt_c_p, coalesce_context) {
+  fpgad_monitored_device d;
+  int ctx0 = 0;
+  int ctx1 = 1;
+  fpgad_respond_event_t responses[] = {
+    test_evt_response, test_evt_response, NULL
+  };
+  void *contexts[] = { &ctx0, &ctx1, NULL };
+  event_dispatch_queue_item item;
+  evt_queue_stats stats;
+
+  memset(&d, 0, sizeof(d));
+  d.responses = responses;
+  d.response_contexts = contexts;
+
+  EXPECT_TRUE(evt_queue_response(test_evt_response, &d, &ctx0));
+  EXPECT_TRUE(evt_queue_response(test_evt_response, &d, &ctx1));
+  EXPECT_TRUE(evt_queue_response(test_evt_response, &d, &ctx1));
+
+  evt_queue_get_stats(&stats, NULL);
+  EXPECT_EQ(stats.depth, 2);
+  EXPECT_EQ(stats.coalesced, 1);
+  EXPECT_EQ(d.pending_responses, 3);
+
+  EXPECT_TRUE(evt_queue_get(&item));
+  EXPECT_EQ(item.context, &ctx0);
+  EXPECT_EQ(d.pending_responses, 2);
+  EXPECT_TRUE(evt_queue_get(&item));
+  EXPECT_EQ(item.context, &ctx1);
+  EXPECT_EQ(d.pending_responses, 0);
+}
+
+/**
+ * @test       batch
+ * @brief      Test: evt_queue_get_batch
+ * @details    The function dequeues up to max_items items<br>
+ *             in FIFO order.<br>
+ */
+TEST_P(fpgad_evt_c_p, batch) {
+  fpgad_monitored_device d[5];
+  event_dispatch_queue_item items[4];
+  int i;
+
+  memset(d, 0, sizeof(d));
+
+  for (i = 0 ; i < 5 ; ++i) {
+    EXPECT_TRUE(evt_queue_response(test_evt_response, &d[i], NULL));
+  }
+
+  ASSERT_EQ(evt_queue_get_batch(items, 4), 4);
+  for (i = 0 ; i < 4 ; ++i) {
+    EXPECT_EQ(items[i].device, &d[i]);
+  }
+
+  ASSERT_EQ(evt_queue_get_batch(items, 4), 1);
+  EXPECT_EQ(items[0].device, &d[4]);
+  EXPECT_EQ(evt_queue_get_batch(items, 4), 0);
 }
 
 static void stop_running_response(fpgad_monitored_device *dev,
@@ -27,20 +27,28 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
-#include <poll.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 extern "C" {
 #include "fpgad/api/logging.h"
+#include "fpgad/api/opae_events_api.h"
 #include "fpgad/events_api_thread.h"
 
-#define MAX_CLIENT_CONNECTIONS 1023
-#define SRV_SOCKET             0
-#define FIRST_CLIENT_SOCKET    1
+typedef struct _api_client {
+  int conn_socket;
+  struct _api_client *prev;
+  struct _api_client *next;
+} api_client;
 
-extern struct pollfd pollfds[MAX_CLIENT_CONNECTIONS+1];
-extern nfds_t num_fds;
+extern api_client *client_list;
+extern unsigned num_clients;
+extern api_client_event_registry *event_registry_list;
 
-void remove_client(int conn_socket);
+api_client *add_client(int conn_socket);
+void remove_client(api_client *client);
+int handle_message(api_client *client);
 }
 
 #define NO_OPAE_C
@@ -67,44 +75,112 @@ class fpgad_events_api_c_p : public opae_base_p<> {
 
 /**
  * @test       remove0
- * @brief      Test: remove_client
- * @details    Test the fn's ability to remove,<br>
- *             clients from various places in the array.<br>
+ * @brief      Test: add_client, remove_client
+ * @details    Test the fn's ability to remove<br>
+ *             clients from various places in the list.<br>
  */
 TEST_P(fpgad_events_api_c_p, remove0) {
-  int conn_socket = -1;
+  api_client *c[3];
+  int i;
 
-  // (only one client)
-  pollfds[FIRST_CLIENT_SOCKET+0].fd = conn_socket;
-  num_fds = 2;
+  ASSERT_EQ(client_list, nullptr);
 
-  remove_client(conn_socket);
-  EXPECT_EQ(num_fds, 1);
+  for (i = 0 ; i < 3 ; ++i) {
+    c[i] = add_client(eventfd(0, 0));
+    ASSERT_NE(c[i], nullptr);
+  }
+  // 2 -> 1 -> 0
+  EXPECT_EQ(num_clients, 3);
+  EXPECT_EQ(client_list, c[2]);
 
   // (client in middle)
-  pollfds[FIRST_CLIENT_SOCKET+0].fd = 0;
-  pollfds[FIRST_CLIENT_SOCKET+1].fd = conn_socket;
-  pollfds[FIRST_CLIENT_SOCKET+2].fd = conn_socket;
-  pollfds[FIRST_CLIENT_SOCKET+3].fd = 3;
-  num_fds = 5;
-
-  remove_client(conn_socket);
-  EXPECT_EQ(num_fds, 3);
-  EXPECT_EQ(pollfds[FIRST_CLIENT_SOCKET+0].fd, 0);
-  EXPECT_EQ(pollfds[FIRST_CLIENT_SOCKET+1].fd, 3);
+  remove_client(c[1]);
+  EXPECT_EQ(num_clients, 2);
+  EXPECT_EQ(client_list, c[2]);
+  EXPECT_EQ(c[2]->next, c[0]);
+  EXPECT_EQ(c[0]->prev, c[2]);
 
   // (client at end)
-  pollfds[FIRST_CLIENT_SOCKET+0].fd = 0;
-  pollfds[FIRST_CLIENT_SOCKET+1].fd = 1;
-  pollfds[FIRST_CLIENT_SOCKET+2].fd = conn_socket;
-  num_fds = 4;
+  remove_client(c[0]);
+  EXPECT_EQ(num_clients, 1);
+  EXPECT_EQ(client_list, c[2]);
+  EXPECT_EQ(c[2]->next, nullptr);
 
-  remove_client(conn_socket);
-  EXPECT_EQ(num_fds, 3);
-  EXPECT_EQ(pollfds[FIRST_CLIENT_SOCKET+0].fd, 0);
-  EXPECT_EQ(pollfds[FIRST_CLIENT_SOCKET+1].fd, 1);
+  // (only one client)
+  remove_client(c[2]);
+  EXPECT_EQ(num_clients, 0);
+  EXPECT_EQ(client_list, nullptr);
+}
+
+/**
+ * @test       batch0
+ * @brief      Test: handle_message
+ * @details    A single message may carry several requests,<br>
+ *             with one passed fd per REGISTER_EVENT request.<br>
+ */
+TEST_P(fpgad_events_api_c_p, batch0) {
+  int sv[2];
+  struct event_request reqs[3];
+  int fds[2];
+  char buf[CMSG_SPACE(sizeof(fds))];
+  struct iovec iov;
+  struct msghdr mh;
+  struct cmsghdr *cmh;
+  api_client *client;
+  api_client_event_registry *r;
+  int count = 0;
+
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  client = add_client(sv[1]);
+  ASSERT_NE(client, nullptr);
+
+  memset(reqs, 0, sizeof(reqs));
+  reqs[0].type = REGISTER_EVENT;
+  reqs[0].event = FPGA_EVENT_ERROR;
+  reqs[0].object_id = 1;
+  reqs[1].type = REGISTER_EVENT;
+  reqs[1].event = FPGA_EVENT_POWER_THERMAL;
+  reqs[1].object_id = 1;
+  reqs[2].type = UNREGISTER_EVENT;
+  reqs[2].event = FPGA_EVENT_ERROR;
+  reqs[2].object_id = 1;
+
+  fds[0] = eventfd(0, 0);
+  fds[1] = eventfd(0, 0);
+
+  iov.iov_base = reqs;
+  iov.iov_len = sizeof(reqs);
+  memset(&mh, 0, sizeof(mh));
+  memset(buf, 0, sizeof(buf));
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+  mh.msg_control = buf;
+  mh.msg_controllen = sizeof(buf);
+  cmh = CMSG_FIRSTHDR(&mh);
+  cmh->cmsg_level = SOL_SOCKET;
+  cmh->cmsg_type = SCM_RIGHTS;
+  cmh->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmh), fds, sizeof(fds));
+
+  ASSERT_EQ(sendmsg(sv[0], &mh, 0), (ssize_t)sizeof(reqs));
+  close(fds[0]);
+  close(fds[1]);
+
+  EXPECT_EQ(handle_message(client), 0);
+
+  for (r = event_registry_list ; r ; r = r->next) {
+    if (r->conn_socket == sv[1]) {
+      EXPECT_EQ(r->event, FPGA_EVENT_POWER_THERMAL);
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, 1);
 
-  num_fds = 1;
+  // peer closed: the client and its registrations are removed.
+  close(sv[0]);
+  EXPECT_EQ(handle_message(client), 0);
+  EXPECT_EQ(client_list, nullptr);
+  EXPECT_EQ(event_registry_list, nullptr);
 }
 
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgad_events_api_c_p);
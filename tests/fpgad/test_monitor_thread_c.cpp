@@ -33,26 +33,28 @@ extern "C" {
 #include "fpgad/monitor_thread.h"
 #include "fpgad/event_dispatcher_thread.h"
 
-#define EVENT_DISPATCH_QUEUE_DEPTH 512
-
-typedef struct _evt_dispatch_queue {
-  event_dispatch_queue_item q[EVENT_DISPATCH_QUEUE_DEPTH];
-  unsigned head;
-  unsigned tail;
-  pthread_mutex_t lock;
-} evt_dispatch_queue;
-
 extern evt_dispatch_queue normal_queue;
 extern evt_dispatch_queue high_priority_queue;
 
+void evt_queue_init(evt_dispatch_queue *q, bool coalesce);
+
 void mon_queue_response(fpgad_detection_status status,
                         fpgad_respond_event_t response,
                         fpgad_monitored_device *d,
                         void *response_context);
 
 void mon_monitor(fpgad_monitored_device *d);
+
+void mon_shard_add(mon_shard *s, fpgad_monitored_device *d);
+void mon_shard_merge(mon_shard *dst, mon_shard *src);
+int mon_shard_setup(mon_shard *s);
+void mon_shard_teardown(mon_shard *s);
+unsigned mon_shard_poll(mon_shard *s, uint64_t timeout_usec);
 }
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
 
@@ -65,6 +67,9 @@ class fpgad_monitor_c_p : public opae_base_p<> {
     opae_base_p<>::SetUp();
 
     log_set(stdout);
+
+    evt_queue_init(&normal_queue, true);
+    evt_queue_init(&high_priority_queue, false);
   }
 
   virtual void TearDown() override {
@@ -90,19 +95,20 @@ static void test_evt_response(fpgad_monitored_device *dev,
  */
 TEST_P(fpgad_monitor_c_p, high_q_full) {
 
-  high_priority_queue.head = 1;
-  high_priority_queue.tail = 0;
+  high_priority_queue.head = 0;
+  high_priority_queue.tail = EVENT_DISPATCH_QUEUE_DEPTH;
 
   fpgad_monitored_device d;
+  memset(&d, 0, sizeof(d));
   mon_queue_response(FPGAD_STATUS_DETECTED_HIGH,
                      test_evt_response,
                      &d,
                      NULL);
-  EXPECT_EQ(high_priority_queue.head, 1);
-  EXPECT_EQ(high_priority_queue.tail, 0);
+  EXPECT_EQ(high_priority_queue.head, 0);
+  EXPECT_EQ(high_priority_queue.tail, EVENT_DISPATCH_QUEUE_DEPTH);
+  EXPECT_EQ(high_priority_queue.dropped, 1);
 
-  high_priority_queue.head = 0;
-  high_priority_queue.tail = 0;
+  evt_queue_init(&high_priority_queue, false);
 }
 
 /**
@@ -113,19 +119,20 @@ TEST_P(fpgad_monitor_c_p, high_q_full) {
  */
 TEST_P(fpgad_monitor_c_p, normal_q_full) {
 
-  normal_queue.head = 1;
-  normal_queue.tail = 0;
+  normal_queue.head = 0;
+  normal_queue.tail = EVENT_DISPATCH_QUEUE_DEPTH;
 
   fpgad_monitored_device d;
+  memset(&d, 0, sizeof(d));
   mon_queue_response(FPGAD_STATUS_DETECTED,
                      test_evt_response,
                      &d,
                      NULL);
-  EXPECT_EQ(normal_queue.head, 1);
-  EXPECT_EQ(normal_queue.tail, 0);
+  EXPECT_EQ(normal_queue.head, 0);
+  EXPECT_EQ(normal_queue.tail, EVENT_DISPATCH_QUEUE_DEPTH);
+  EXPECT_EQ(normal_queue.dropped, 1);
 
-  normal_queue.head = 0;
-  normal_queue.tail = 0;
+  evt_queue_init(&normal_queue, true);
 }
 
 /**
@@ -184,6 +191,131 @@ TEST_P(fpgad_monitor_c_p, null_response0) {
   normal_queue.tail = 0;
 }
 
+static int detections_run;
+
+static fpgad_detection_status
+counting_detection(fpgad_monitored_device *dev,
+                   void *context)
+{
+  UNUSED_PARAM(dev);
+  UNUSED_PARAM(context);
+  ++detections_run;
+  return FPGAD_STATUS_NOT_DETECTED;
+}
+
+/**
+ * @test       fd_driven
+ * @brief      Test: mon_shard_setup, mon_shard_poll, mon_monitor
+ * @details    A detection with a registered fd is skipped by<br>
+ *             mon_monitor and is run once each time its fd<br>
+ *             becomes ready, recording its latency.<br>
+ */
+TEST_P(fpgad_monitor_c_p, fd_driven) {
+  fpgad_monitored_device d;
+  mon_shard s;
+  uint64_t one = 1;
+  int efd;
+
+  memset(&d, 0, sizeof(d));
+  memset(&s, 0, sizeof(s));
+
+  efd = eventfd(0, EFD_NONBLOCK);
+  ASSERT_GE(efd, 0);
+
+  fpgad_detect_event_t detections[] = {
+    counting_detection,
+    nullptr,
+  };
+
+  struct pollfd fds[] = {
+    { efd, POLLIN, 0 },
+  };
+
+  d.detections = detections;
+  d.detection_fds = fds;
+
+  mon_shard_add(&s, &d);
+  ASSERT_EQ(mon_shard_setup(&s), 0);
+  EXPECT_EQ(s.num_pfds, 1);
+
+  detections_run = 0;
+  mon_monitor(&d);
+  EXPECT_EQ(detections_run, 0);
+  EXPECT_EQ(mon_shard_poll(&s, 0), 0);
+  EXPECT_EQ(detections_run, 0);
+
+  ASSERT_EQ(write(efd, &one, sizeof(one)), sizeof(one));
+  EXPECT_EQ(mon_shard_poll(&s, 1000000), 1);
+  EXPECT_EQ(detections_run, 1);
+  EXPECT_EQ(d.detect_count, 1);
+
+  // The eventfd was drained, so nothing fires until the next write.
+  EXPECT_EQ(mon_shard_poll(&s, 0), 0);
+  EXPECT_EQ(detections_run, 1);
+
+  mon_shard_teardown(&s);
+  close(efd);
+}
+
+/**
+ * @test       shard_add
+ * @brief      Test: mon_shard_add
+ * @details    Devices are appended to the shard in order.<br>
+ */
+TEST_P(fpgad_monitor_c_p, shard_add) {
+  fpgad_monitored_device d[3];
+  mon_shard s;
+
+  memset(d, 0, sizeof(d));
+  memset(&s, 0, sizeof(s));
+
+  mon_shard_add(&s, &d[0]);
+  mon_shard_add(&s, &d[1]);
+  mon_shard_add(&s, &d[2]);
+
+  EXPECT_EQ(s.num_devices, 3);
+  EXPECT_EQ(s.devices, &d[0]);
+  EXPECT_EQ(d[0].shard_next, &d[1]);
+  EXPECT_EQ(d[1].shard_next, &d[2]);
+  EXPECT_EQ(d[2].shard_next, nullptr);
+
+  // No fd-driven detections: nothing to poll.
+  EXPECT_EQ(mon_shard_setup(&s), 0);
+  EXPECT_EQ(s.num_pfds, 0);
+  mon_shard_teardown(&s);
+}
+
+/**
+ * @test       shard_merge
+ * @brief      Test: mon_shard_merge
+ * @details    The source shard's devices are appended to the<br>
+ *             destination in order, and the source is left empty.<br>
+ */
+TEST_P(fpgad_monitor_c_p, shard_merge) {
+  fpgad_monitored_device d[3];
+  mon_shard dst;
+  mon_shard src;
+
+  memset(d, 0, sizeof(d));
+  memset(&dst, 0, sizeof(dst));
+  memset(&src, 0, sizeof(src));
+
+  mon_shard_add(&dst, &d[0]);
+  mon_shard_add(&src, &d[1]);
+  mon_shard_add(&src, &d[2]);
+
+  mon_shard_merge(&dst, &src);
+
+  EXPECT_EQ(dst.num_devices, 3);
+  EXPECT_EQ(dst.devices, &d[0]);
+  EXPECT_EQ(d[0].shard_next, &d[1]);
+  EXPECT_EQ(d[1].shard_next, &d[2]);
+  EXPECT_EQ(d[2].shard_next, nullptr);
+
+  EXPECT_EQ(src.num_devices, 0);
+  EXPECT_EQ(src.devices, nullptr);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgad_monitor_c_p);
 INSTANTIATE_TEST_SUITE_P(fpgad_monitor_c, fpgad_monitor_c_p,
                          ::testing::ValuesIn(test_platform::platforms({ "skx-p" })));
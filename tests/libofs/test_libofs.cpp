@@ -28,6 +28,10 @@
 #include <future>
 #include <thread>
 #include <cerrno>
+#ifdef OPAE_BENCHMARK
+#include <atomic>
+#include <iostream>
+#endif // OPAE_BENCHMARK
 #include <ofs/ofs.h>
 
 #include "gtest/gtest.h"
@@ -175,3 +179,128 @@ TEST(libofs, wait_for_eq_timeout)
   EXPECT_EQ(1, status);
   EXPECT_GE(delta_usec, timeout_usec - ff);
 }
+
+/**
+ * @test    clock_ticks
+ * @brief   Tests: ofs_clock_ticks, ofs_usec_to_ticks
+ * @details Sleep for 20 msec and verify that the number of clock ticks
+ *          elapsed, converted back to usec, is at least the sleep time
+ *          and no more than the time measured with std::chrono around
+ *          it, allowing 5% for conversion error. Scheduling delays only
+ *          widen the std::chrono window, so neither bound depends on
+ *          system load.
+ * */
+TEST(libofs, clock_ticks)
+{
+  uint64_t ticks_per_usec = ofs_usec_to_ticks(1);
+  ASSERT_GT(ticks_per_usec, 0);
+
+  auto begin = std::chrono::steady_clock::now();
+  uint64_t t0 = ofs_clock_ticks();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  uint64_t t1 = ofs_clock_ticks();
+  auto end = std::chrono::steady_clock::now();
+
+  double outer =
+    std::chrono::duration<double, std::micro>(end - begin).count();
+  double measured = static_cast<double>(t1 - t0) / ticks_per_usec;
+  EXPECT_GE(measured, 20000.0 * 0.95);
+  EXPECT_LE(measured, outer * 1.05);
+}
+
+/**
+ * @test    wait_saturates
+ * @brief   Tests: ofs_usec_to_ticks, ofs_wait_init, ofs_wait_step
+ * @details A timeout too large to express in clock ticks saturates
+ *          to UINT64_MAX instead of wrapping, so the wait never
+ *          expires, and stepping it through the sleep stage still
+ *          returns promptly.
+ * */
+TEST(libofs, wait_saturates)
+{
+  struct ofs_wait w;
+
+  EXPECT_EQ(ofs_usec_to_ticks(UINT64_MAX), UINT64_MAX);
+
+  ofs_wait_init(&w, UINT64_MAX, 100);
+  EXPECT_EQ(w.deadline, UINT64_MAX);
+
+  auto end = hrc::now() + std::chrono::milliseconds(2);
+  while (hrc::now() < end)
+    ASSERT_EQ(ofs_wait_step(&w), 0);
+}
+
+/**
+ * @test    wait_macros
+ * @brief   Tests: OFS_WAIT_FOR_EQ, OFS_WAIT_FOR_NE
+ * @details Wait on a value that is already (or never) what we wait for,
+ *          with and without sleeping between polls. Verify that the
+ *          macros return 0 immediately when the condition holds, and 1
+ *          no earlier than the timeout when it does not.
+ * */
+TEST(libofs, wait_macros)
+{
+  volatile uint32_t value = 3;
+  const uint64_t timeout_usec = 2000;
+
+  for (uint32_t sleep_usec : { 0, 100 }) {
+    EXPECT_EQ(OFS_WAIT_FOR_EQ(value, 3, timeout_usec, sleep_usec), 0);
+    EXPECT_EQ(OFS_WAIT_FOR_NE(value, 2, timeout_usec, sleep_usec), 0);
+
+    auto begin = hrc::now();
+    EXPECT_EQ(OFS_WAIT_FOR_EQ(value, 2, timeout_usec, sleep_usec), 1);
+    EXPECT_EQ(OFS_WAIT_FOR_NE(value, 3, timeout_usec, sleep_usec), 1);
+    auto end = hrc::now();
+    auto delta_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+      end - begin).count();
+    EXPECT_GE(delta_usec, 2 * timeout_usec);
+  }
+}
+
+#ifdef OPAE_BENCHMARK
+static double thread_cpu_usec()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1E6 + ts.tv_nsec * 1E-3;
+}
+
+/**
+ * @test    bench_wait_latency
+ * @brief   Tests: ofs_wait_for_eq32
+ * @details For several sleep intervals and wake-up delays, have another
+ *          thread set the value the waiter polls for. Report how long
+ *          after the store the waiter returned (wake latency) and how much
+ *          CPU time the waiter used.
+ *          Built only with OPAE_BUILD_BENCHMARKS.
+ * */
+TEST(libofs, bench_wait_latency)
+{
+  const int iters = 20;
+
+  for (uint32_t sleep_usec : { 0, 10, 100 }) {
+    for (uint32_t delay_usec : { 20, 500 }) {
+      double latency = 0.0, cpu = 0.0;
+      for (int i = 0; i < iters; ++i) {
+        volatile uint32_t value = 0;
+        std::atomic<int64_t> stored(0);
+        std::thread setter([&]() {
+          std::this_thread::sleep_for(std::chrono::microseconds(delay_usec));
+          stored = hrc::now().time_since_epoch().count();
+          value = 1;
+        });
+        double cpu0 = thread_cpu_usec();
+        EXPECT_EQ(ofs_wait_for_eq32(&value, 1, 1000000, sleep_usec), 0);
+        auto woke = hrc::now().time_since_epoch().count();
+        cpu += thread_cpu_usec() - cpu0;
+        setter.join();
+        latency += std::chrono::duration<double, std::micro>(
+          hrc::duration(woke - stored)).count();
+      }
+      std::cout << "sleep " << sleep_usec << " us, wake after "
+                << delay_usec << " us: latency " << latency / iters
+                << " us, cpu " << cpu / iters << " us" << std::endl;
+    }
+  }
+}
+#endif // OPAE_BENCHMARK
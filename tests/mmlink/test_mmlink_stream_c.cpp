@@ -0,0 +1,355 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "server.h"
+#include "constants.h"
+#include "common.h"
+
+namespace {
+
+const size_t T2H_PAYLOAD_BYTES = H2T_PACKET_MAX_PAYLOAD_BYTES;
+const size_t PACKET_HEADER_BYTES = SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER;
+
+// Mocked T2H FIFO: hands out fixed-size packets from host memory, each
+// stamped with its sequence number.
+uint64_t t2h_mem[(T2H_PAYLOAD_BYTES + 8) / 8];
+std::atomic<size_t> t2h_packets_left(0);
+std::atomic<size_t> t2h_packets_done(0);
+
+int mock_acquire_t2h_data(H2T_PACKET_HEADER *header, unsigned char **payload)
+{
+  if (t2h_packets_left == 0) {
+    header->DATA_LEN_BYTES = 0;
+    return 0;
+  }
+
+  uint64_t seq = t2h_packets_done;
+  for (size_t i = 0; i < T2H_PAYLOAD_BYTES / 8; ++i)
+    t2h_mem[i] = (seq << 32) | i;
+
+  populate_h2t_packet_header(header, 1, 1, 0, 0, T2H_PAYLOAD_BYTES);
+  *payload = reinterpret_cast<unsigned char *>(t2h_mem);
+  return 0;
+}
+
+void mock_t2h_data_complete()
+{
+  --t2h_packets_left;
+  ++t2h_packets_done;
+}
+
+int quiet_printf(printf_format_arg, ...)
+{
+  return 0;
+}
+
+} // namespace
+
+class mmlink_stream_c : public ::testing::Test {
+ protected:
+  mmlink_stream_c()
+  : port_(0)
+  , ctrl_fd_(-1)
+  , mgmt_fd_(-1)
+  , mgmt_rsp_fd_(-1)
+  , h2t_fd_(-1)
+  , t2h_fd_(-1)
+  {}
+
+  virtual void SetUp() override {
+    t2h_packets_left = 0;
+    t2h_packets_done = 0;
+
+    buffers_ = SERVER_BUFFERS_default;
+    buffers_.ctrl_rx_buff = ctrl_rx_;
+    buffers_.ctrl_rx_buff_sz = sizeof(ctrl_rx_);
+    buffers_.ctrl_tx_buff = ctrl_tx_;
+    buffers_.ctrl_tx_buff_sz = sizeof(ctrl_tx_);
+    buffers_.h2t_rx_buff = reinterpret_cast<char *>(h2t_mem_);
+    buffers_.h2t_rx_buff_sz = T2H_PAYLOAD_BYTES;
+    buffers_.t2h_tx_buff = reinterpret_cast<char *>(t2h_mem);
+    buffers_.t2h_tx_buff_sz = T2H_PAYLOAD_BYTES;
+
+    server_ = SERVER_CONN_default;
+    server_.buff = &buffers_;
+    server_.hw_callbacks = SERVER_HW_CALLBACKS_default;
+    server_.hw_callbacks.acquire_t2h_data = mock_acquire_t2h_data;
+    server_.hw_callbacks.t2h_data_complete = mock_t2h_data_complete;
+    server_.hw_callbacks.server_printf = quiet_printf;
+
+    ASSERT_EQ(initialize_server(0, &server_, nullptr), OK);
+    port_ = ntohs(server_.server_addr.sin_port);
+    server_thread_ = std::thread(server_main, SINGLE_CLIENT, &server_);
+  }
+
+  virtual void TearDown() override {
+    for (int *fd : { &ctrl_fd_, &mgmt_fd_, &mgmt_rsp_fd_, &h2t_fd_, &t2h_fd_ }) {
+      if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+      }
+    }
+    if (server_thread_.joinable())
+      server_thread_.join();
+  }
+
+  int connect_socket() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT_GE(fd, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(connect(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    return fd;
+  }
+
+  std::string recv_string(int fd) {
+    std::string s;
+    char c;
+    while (recv(fd, &c, 1, 0) == 1 && c != '\0')
+      s += c;
+    return s;
+  }
+
+  void send_string(int fd, const std::string &s) {
+    ASSERT_EQ(send(fd, s.c_str(), s.size() + 1, 0), (ssize_t)(s.size() + 1));
+  }
+
+  void recv_all(int fd, void *buf, size_t len) {
+    char *p = static_cast<char *>(buf);
+    while (len) {
+      ssize_t n = recv(fd, p, len, 0);
+      ASSERT_GT(n, 0);
+      p += n;
+      len -= n;
+    }
+  }
+
+  int connect_named(const char *name, int handle) {
+    int fd = connect_socket();
+    send_string(fd, std::string(name) + " HANDLE=" + std::to_string(handle));
+    EXPECT_EQ(recv_string(fd), READY_MSG);
+    return fd;
+  }
+
+  void connect_client() {
+    ctrl_fd_ = connect_socket();
+    std::string welcome = recv_string(ctrl_fd_);
+    ASSERT_NE(welcome.find("INTEL_ST_HOST_EP_SERVER"), std::string::npos);
+    int handle = parse_handle_id(welcome.c_str());
+
+    send_string(ctrl_fd_, std::string(CONTROL_SOCK_NAME) + " HANDLE=" + std::to_string(handle));
+    ASSERT_EQ(recv_string(ctrl_fd_), READY_MSG);
+
+    mgmt_fd_ = connect_named(MANAGEMENT_SOCK_NAME, handle);
+    mgmt_rsp_fd_ = connect_named(MANAGEMENT_RSP_SOCK_NAME, handle);
+    h2t_fd_ = connect_named(H2T_SOCK_NAME, handle);
+    t2h_fd_ = connect_named(T2H_SOCK_NAME, handle);
+    ASSERT_EQ(recv_string(ctrl_fd_), READY_MSG);
+  }
+
+  std::string command(const std::string &cmd) {
+    send_string(ctrl_fd_, cmd);
+    return recv_string(ctrl_fd_);
+  }
+
+  unsigned long long stat_value(const std::string &stats, const char *name) {
+    size_t pos = stats.find(std::string(name) + "=");
+    EXPECT_NE(pos, std::string::npos);
+    return std::stoull(stats.substr(pos + strlen(name) + 1));
+  }
+
+  SERVER_BUFFERS buffers_;
+  SERVER_CONN server_;
+  char ctrl_rx_[512];
+  char ctrl_tx_[512];
+  uint64_t h2t_mem_[(T2H_PAYLOAD_BYTES + 8) / 8];
+  unsigned short port_;
+  std::thread server_thread_;
+  int ctrl_fd_;
+  int mgmt_fd_;
+  int mgmt_rsp_fd_;
+  int h2t_fd_;
+  int t2h_fd_;
+};
+
+/**
+ * @test       t2h_stream
+ * @brief      Test: handle_client, stage_t2h_data, flush_t2h_stage
+ * @details    With a mocked T2H FIFO that always holds data,<br>
+ *             the server streams every packet to the client intact,<br>
+ *             in order, and the XFER_STATS counters account for every byte.<br>
+ */
+TEST_F(mmlink_stream_c, t2h_stream) {
+  const size_t num_packets = 16384;
+
+  connect_client();
+
+  std::vector<uint64_t> payload(T2H_PAYLOAD_BYTES / 8);
+  unsigned char header[PACKET_HEADER_BYTES];
+
+  t2h_packets_left = num_packets;
+  for (size_t seq = 0; seq < num_packets; ++seq) {
+    recv_all(t2h_fd_, header, sizeof(header));
+    ASSERT_EQ(memcmp(header, PACKET_GUARDBAND, SIZEOF_PACKET_GUARDBAND), 0);
+    H2T_PACKET_HEADER hdr;
+    memcpy(&hdr, header + SIZEOF_PACKET_GUARDBAND, sizeof(hdr));
+    ASSERT_EQ(hdr.DATA_LEN_BYTES, T2H_PAYLOAD_BYTES);
+
+    recv_all(t2h_fd_, payload.data(), T2H_PAYLOAD_BYTES);
+    for (size_t i = 0; i < payload.size(); ++i)
+      ASSERT_EQ(payload[i], (((uint64_t)seq) << 32) | i);
+  }
+
+  const unsigned long long total = num_packets * (PACKET_HEADER_BYTES + T2H_PAYLOAD_BYTES);
+
+  std::string stats = command(std::string(GET_PARAM_CMD) + " " + XFER_STATS_PARAM);
+  EXPECT_EQ(stat_value(stats, "T2H_BYTES"), total);
+  EXPECT_LT(stat_value(stats, "T2H_SENDS"), num_packets);
+  EXPECT_EQ(stat_value(stats, "H2T_BYTES"), 0);
+  EXPECT_EQ(t2h_packets_done, num_packets);
+
+  EXPECT_EQ(command(DISCONNECT_CMD), DISCONNECT_CMD_RSP);
+}
+
+#ifdef OPAE_BENCHMARK
+/**
+ * @test       bench_t2h_throughput
+ * @brief      Test: handle_client, stage_t2h_data, flush_t2h_stage
+ * @details    With a mocked T2H FIFO that always holds data,<br>
+ *             report the sustained T2H rate in MB/s.<br>
+ *             Built only with OPAE_BUILD_BENCHMARKS.<br>
+ */
+TEST_F(mmlink_stream_c, bench_t2h_throughput) {
+  const size_t num_packets = 65536;
+
+  connect_client();
+
+  std::vector<uint64_t> payload(T2H_PAYLOAD_BYTES / 8);
+  unsigned char header[PACKET_HEADER_BYTES];
+
+  auto start = std::chrono::steady_clock::now();
+  t2h_packets_left = num_packets;
+  for (size_t seq = 0; seq < num_packets; ++seq) {
+    recv_all(t2h_fd_, header, sizeof(header));
+    ASSERT_EQ(memcmp(header, PACKET_GUARDBAND, SIZEOF_PACKET_GUARDBAND), 0);
+    recv_all(t2h_fd_, payload.data(), T2H_PAYLOAD_BYTES);
+  }
+  auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+
+  const unsigned long long total = num_packets * (PACKET_HEADER_BYTES + T2H_PAYLOAD_BYTES);
+  double mbps = (double)total / (double)(usec ? usec : 1);
+  std::cout << "T2H: " << total << " bytes in " << usec << " us ("
+            << mbps << " MB/s)" << std::endl;
+  EXPECT_GT(mbps, 20.0);
+
+  EXPECT_EQ(command(DISCONNECT_CMD), DISCONNECT_CMD_RSP);
+}
+#endif // OPAE_BENCHMARK
+
+/**
+ * @test       h2t_loopback
+ * @brief      Test: process_h2t_data, flush_t2h_stage
+ * @details    In SERVER_LOOPBACK mode, every H2T packet sent by the client<br>
+ *             is echoed back on the T2H socket unchanged, even when the<br>
+ *             client sends far more than the staging ring holds before reading.<br>
+ */
+TEST_F(mmlink_stream_c, h2t_loopback) {
+  const size_t num_packets = 4096;
+
+  connect_client();
+  EXPECT_EQ(command(std::string(SET_PARAM_CMD) + " " + SERVER_LOOPBACK_MODE_PARAM + " 1"),
+            SET_PARAM_CMD_RSP);
+
+  auto packet_len = [](size_t seq) -> unsigned short {
+    return (unsigned short)(1 + ((seq * 977) % T2H_PAYLOAD_BYTES));
+  };
+
+  std::thread sender([&] {
+    std::vector<unsigned char> pkt(PACKET_HEADER_BYTES + T2H_PAYLOAD_BYTES);
+    for (size_t seq = 0; seq < num_packets; ++seq) {
+      unsigned short len = packet_len(seq);
+      populate_guardband(pkt.data());
+      H2T_PACKET_HEADER hdr;
+      populate_h2t_packet_header(&hdr, 1, 1, (unsigned char)seq, 1, len);
+      memcpy(pkt.data() + SIZEOF_PACKET_GUARDBAND, &hdr, sizeof(hdr));
+      memset(pkt.data() + PACKET_HEADER_BYTES, (int)(seq & 0xff), len);
+      size_t sz = PACKET_HEADER_BYTES + len;
+      const unsigned char *p = pkt.data();
+      while (sz) {
+        ssize_t n = send(h2t_fd_, p, sz, 0);
+        if (n <= 0)
+          return;
+        p += n;
+        sz -= n;
+      }
+    }
+  });
+
+  std::vector<unsigned char> payload(T2H_PAYLOAD_BYTES);
+  unsigned char header[PACKET_HEADER_BYTES];
+  unsigned long long h2t_total = 0;
+  for (size_t seq = 0; seq < num_packets; ++seq) {
+    recv_all(t2h_fd_, header, sizeof(header));
+    ASSERT_EQ(memcmp(header, PACKET_GUARDBAND, SIZEOF_PACKET_GUARDBAND), 0);
+    H2T_PACKET_HEADER hdr;
+    memcpy(&hdr, header + SIZEOF_PACKET_GUARDBAND, sizeof(hdr));
+    ASSERT_EQ(hdr.CONN_ID, (unsigned char)seq);
+    ASSERT_EQ(hdr.DATA_LEN_BYTES, packet_len(seq));
+
+    recv_all(t2h_fd_, payload.data(), hdr.DATA_LEN_BYTES);
+    for (size_t i = 0; i < hdr.DATA_LEN_BYTES; ++i)
+      ASSERT_EQ(payload[i], (unsigned char)(seq & 0xff));
+    h2t_total += hdr.DATA_LEN_BYTES;
+  }
+  sender.join();
+
+  std::string stats = command(std::string(GET_PARAM_CMD) + " " + XFER_STATS_PARAM);
+  EXPECT_EQ(stat_value(stats, "H2T_BYTES"), h2t_total);
+  EXPECT_EQ(stat_value(stats, "T2H_BYTES"), h2t_total + num_packets * PACKET_HEADER_BYTES);
+
+  EXPECT_EQ(command(DISCONNECT_CMD), DISCONNECT_CMD_RSP);
+}
@@ -30,6 +30,11 @@
 #include <unistd.h>
 #include "mock/opae_fixtures.h"
 
+#ifdef OPAE_BENCHMARK
+#include <chrono>
+#include <iostream>
+#endif // OPAE_BENCHMARK
+
 using namespace opae::testing;
 
 class buffer_c_p : public opae_p<> {
@@ -146,3 +151,135 @@ INSTANTIATE_TEST_SUITE_P(buffer_c, buffer_c_p,
                                                                         "dfl-n6000-sku1",
                                                                         "dfl-c6100"
                                                                       })));
+
+class buffer_pool_c_p : public buffer_c_p {
+ public:
+
+  virtual int open_flags() const override {
+    return FPGA_OPEN_BUFFER_POOL;
+  }
+};
+
+/**
+ * @test       reuse
+ * @brief      Test: fpgaPrepareBuffer, fpgaReleaseBuffer
+ * @details    When the handle was opened with FPGA_OPEN_BUFFER_POOL,<br>
+ *             a buffer released with fpgaReleaseBuffer is handed back<br>
+ *             by the next fpgaPrepareBuffer of the same size,<br>
+ *             with the same address, wsid and IO address.<br>
+ */
+TEST_P(buffer_pool_c_p, reuse) {
+  void *buf_addr = nullptr;
+  uint64_t wsid = 0;
+  uint64_t io = 0;
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_,
+                              &buf_addr, &wsid, 0), FPGA_OK);
+  ASSERT_EQ(fpgaGetIOAddress(accel_, wsid, &io), FPGA_OK);
+  ASSERT_EQ(fpgaReleaseBuffer(accel_, wsid), FPGA_OK);
+
+  void *buf_addr2 = nullptr;
+  uint64_t wsid2 = 0;
+  uint64_t io2 = 0;
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_ - 8,
+                              &buf_addr2, &wsid2, 0), FPGA_OK);
+  EXPECT_EQ(buf_addr2, buf_addr);
+  EXPECT_EQ(wsid2, wsid);
+  ASSERT_EQ(fpgaGetIOAddress(accel_, wsid2, &io2), FPGA_OK);
+  EXPECT_EQ(io2, io);
+
+  // A read-only request is not served by a read/write buffer.
+  void *buf_addr3 = nullptr;
+  uint64_t wsid3 = 0;
+  ASSERT_EQ(fpgaReleaseBuffer(accel_, wsid2), FPGA_OK);
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_,
+                              &buf_addr3, &wsid3, FPGA_BUF_READ_ONLY), FPGA_OK);
+  EXPECT_NE(wsid3, wsid);
+  EXPECT_EQ(fpgaReleaseBuffer(accel_, wsid3), FPGA_OK);
+}
+
+/**
+ * @test       bypass
+ * @brief      Test: fpgaPrepareBuffer, fpgaReleaseBuffer
+ * @details    When fpgaPrepareBuffer is given FPGA_BUF_NO_POOL,<br>
+ *             the buffer is neither taken from nor returned to<br>
+ *             the pool.<br>
+ */
+TEST_P(buffer_pool_c_p, bypass) {
+  void *buf_addr = nullptr;
+  uint64_t wsid = 0;
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_,
+                              &buf_addr, &wsid, 0), FPGA_OK);
+  ASSERT_EQ(fpgaReleaseBuffer(accel_, wsid), FPGA_OK);
+
+  void *buf_addr2 = nullptr;
+  uint64_t wsid2 = 0;
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_,
+                              &buf_addr2, &wsid2, FPGA_BUF_NO_POOL), FPGA_OK);
+  EXPECT_NE(wsid2, wsid);
+  EXPECT_EQ(fpgaReleaseBuffer(accel_, wsid2), FPGA_OK);
+}
+
+/**
+ * @test       high_water
+ * @brief      Test: fpgaReleaseBuffer
+ * @details    When LIBOPAE_BUF_POOL_MAX is 0,<br>
+ *             released buffers are not kept by the pool.<br>
+ */
+TEST_P(buffer_pool_c_p, high_water) {
+  ASSERT_EQ(fpgaClose(accel_), FPGA_OK);
+  accel_ = nullptr;
+  setenv("LIBOPAE_BUF_POOL_MAX", "0", 1);
+  ASSERT_EQ(fpgaOpen(accel_token_, &accel_, FPGA_OPEN_BUFFER_POOL), FPGA_OK);
+  unsetenv("LIBOPAE_BUF_POOL_MAX");
+
+  void *buf_addr = nullptr;
+  uint64_t wsid = 0;
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_,
+                              &buf_addr, &wsid, 0), FPGA_OK);
+  ASSERT_EQ(fpgaReleaseBuffer(accel_, wsid), FPGA_OK);
+
+  void *buf_addr2 = nullptr;
+  uint64_t wsid2 = 0;
+  ASSERT_EQ(fpgaPrepareBuffer(accel_, (uint64_t) pg_size_,
+                              &buf_addr2, &wsid2, 0), FPGA_OK);
+  EXPECT_NE(wsid2, wsid);
+  EXPECT_EQ(fpgaReleaseBuffer(accel_, wsid2), FPGA_OK);
+}
+
+#ifdef OPAE_BENCHMARK
+static double alloc_latency_ns(fpga_handle accel, size_t size, int flags)
+{
+  const int iters = 1000;
+  void *buf_addr = nullptr;
+  uint64_t wsid = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < iters; ++i) {
+    EXPECT_EQ(fpgaPrepareBuffer(accel, (uint64_t) size,
+                                &buf_addr, &wsid, flags), FPGA_OK);
+    EXPECT_EQ(fpgaReleaseBuffer(accel, wsid), FPGA_OK);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iters;
+}
+
+/**
+ * @test       bench_latency
+ * @brief      Test: fpgaPrepareBuffer, fpgaReleaseBuffer
+ * @details    Reports the prepare/release latency with the pool<br>
+ *             and with FPGA_BUF_NO_POOL.<br>
+ *             Built only with OPAE_BUILD_BENCHMARKS.<br>
+ */
+TEST_P(buffer_pool_c_p, bench_latency) {
+  double off = alloc_latency_ns(accel_, pg_size_, FPGA_BUF_NO_POOL);
+  double on = alloc_latency_ns(accel_, pg_size_, 0);
+  std::cout << "prepare/release: pool off " << off << " ns, pool on "
+            << on << " ns" << std::endl;
+}
+#endif // OPAE_BENCHMARK
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(buffer_pool_c_p);
+INSTANTIATE_TEST_SUITE_P(buffer_pool_c, buffer_pool_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({
+                                                                        "dfl-d5005",
+                                                                        "dfl-n6000-sku0"
+                                                                      })));
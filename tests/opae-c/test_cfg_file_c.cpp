@@ -1115,3 +1115,76 @@ TEST(cfg_file, free_fpgad_config1) {
   opae_free_fpgad_config(default_fpgad_config_table);
   opae_free_fpgad_config(NULL);
 }
+
+/**
+ * @test       libopae_config_cache
+ * @brief      Test: opae_save_libopae_config_cache, opae_load_libopae_config_cache
+ * @details    A config table saved to the cache loads back identically<br>
+ *             while its config file is unchanged,<br>
+ *             and the cache is rejected once the config file changes.
+ */
+TEST(cfg_file, libopae_config_cache) {
+  char cfg_file[] = "/tmp/opae-cfg-XXXXXX.json";
+  char cache_file[] = "/tmp/opae-cfg-cache-XXXXXX";
+  int fd;
+
+  fd = mkstemps(cfg_file, 5);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(2, write(fd, "{}", 2));
+  close(fd);
+
+  fd = mkstemp(cache_file);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  libopae_config_data *cfg = (libopae_config_data *)
+    opae_calloc(3, sizeof(libopae_config_data));
+  ASSERT_NE((libopae_config_data *)NULL, cfg);
+
+  cfg[0].vendor_id = 0x8086;
+  cfg[0].device_id = 0xbcce;
+  cfg[0].subsystem_vendor_id = 0x8086;
+  cfg[0].subsystem_device_id = 0x1770;
+  cfg[0].module_library = opae_strdup("libxfpga.so");
+  cfg[0].config_json = opae_strdup("{ \"key\": \"value\" }");
+  cfg[1].vendor_id = 0x8086;
+  cfg[1].device_id = 0xbccf;
+  cfg[1].subsystem_vendor_id = OPAE_VENDOR_ANY;
+  cfg[1].subsystem_device_id = OPAE_DEVICE_ANY;
+  cfg[1].module_library = opae_strdup("libopae-v.so");
+  cfg[1].config_json = opae_strdup("{}");
+
+  EXPECT_NE(0, opae_save_libopae_config_cache(cache_file, cfg_file,
+                                               default_libopae_config_table));
+  EXPECT_EQ(0, opae_save_libopae_config_cache(cache_file, cfg_file, cfg));
+
+  libopae_config_data *cached =
+    opae_load_libopae_config_cache(cache_file, cfg_file);
+  ASSERT_NE((libopae_config_data *)NULL, cached);
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    EXPECT_EQ(cfg[i].vendor_id, cached[i].vendor_id);
+    EXPECT_EQ(cfg[i].device_id, cached[i].device_id);
+    EXPECT_EQ(cfg[i].subsystem_vendor_id, cached[i].subsystem_vendor_id);
+    EXPECT_EQ(cfg[i].subsystem_device_id, cached[i].subsystem_device_id);
+    EXPECT_STREQ(cfg[i].module_library, cached[i].module_library);
+    EXPECT_STREQ(cfg[i].config_json, cached[i].config_json);
+    EXPECT_EQ(0, cached[i].flags);
+  }
+  EXPECT_EQ(nullptr, cached[2].module_library);
+  opae_free_libopae_config(cached);
+
+  // A different config file path never matches.
+  EXPECT_EQ(nullptr, opae_load_libopae_config_cache(cache_file, "/dev/null"));
+
+  // Modifying the config file invalidates the cache.
+  fd = open(cfg_file, O_WRONLY | O_APPEND);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, write(fd, "\n", 1));
+  close(fd);
+  EXPECT_EQ(nullptr, opae_load_libopae_config_cache(cache_file, cfg_file));
+
+  opae_free_libopae_config(cfg);
+  unlink(cache_file);
+  unlink(cfg_file);
+}
@@ -41,7 +41,13 @@ const char *_ase_home_configs[HOME_CFG_PATHS] = {
 }
 
 #include <libgen.h>
+#include <sys/wait.h>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "mock/opae_fixtures.h"
+#include "log-async.h"
 
 using namespace opae::testing;
 
@@ -163,6 +169,236 @@ TEST(init, log_file) {
   unlink("opae_log.log");
 }
 
+static std::string read_log(const char *path) {
+  std::ifstream f(path, std::ios::binary);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+static size_t count_of(const std::string &s, const std::string &what) {
+  size_t n = 0;
+  for (size_t pos = s.find(what) ; pos != std::string::npos ;
+       pos = s.find(what, pos + what.size()))
+    ++n;
+  return n;
+}
+
+/**
+ * @test       log_async
+ *
+ * @brief      When LIBOPAE_LOG_MODE is async, then messages logged
+ *             from several threads all reach the log file by
+ *             opae_release, and a call site that floods the log is
+ *             rate limited to LIBOPAE_LOG_RATELIMIT messages, followed
+ *             by a count of those suppressed.
+ */
+TEST(init, log_async) {
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG=1"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOGFILE=opae_async.log"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG_MODE=async"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG_RATELIMIT=5"));
+  opae_init();
+
+  std::vector<std::thread> threads;
+  for (int t = 0 ; t < 4 ; ++t) {
+    threads.emplace_back([t]() {
+      for (int i = 0 ; i < 16 ; ++i) {
+        OPAE_MSG("thread %d message %d", t, i);
+        // keep the per-thread rings from overflowing
+        usleep(1000);
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  for (int i = 0 ; i < 100 ; ++i)
+    OPAE_MSG("flood");
+
+  opae_release();
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_RATELIMIT"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_MODE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOGFILE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG"));
+
+  std::string log = read_log("opae_async.log");
+  unlink("opae_async.log");
+
+  // Each "thread t message i" call shares one call site per thread,
+  // so the first 5 per thread get through.
+  for (int t = 0 ; t < 4 ; ++t) {
+    for (int i = 0 ; i < 5 ; ++i) {
+      std::string m = "thread " + std::to_string(t) +
+                      " message " + std::to_string(i) + "\n";
+      EXPECT_NE(std::string::npos, log.find(m)) << m;
+    }
+  }
+  EXPECT_EQ(5u, count_of(log, ": flood\n"));
+  EXPECT_NE(std::string::npos, log.find("suppressed 95 message(s)"));
+}
+
+/**
+ * @test       log_async_fork
+ *
+ * @brief      When LIBOPAE_LOG_MODE is async and the process forks,
+ *             then the child's messages reach the log file through
+ *             a flusher of its own, and the messages the parent
+ *             queued before the fork are written only once.
+ */
+TEST(init, log_async_fork) {
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG=1"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOGFILE=opae_async_fork.log"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG_MODE=async"));
+  opae_init();
+
+  OPAE_MSG("before fork");
+  // let the flusher empty the ring and the stream buffer
+  usleep(50000);
+
+  pid_t pid = fork();
+  ASSERT_LE(0, pid);
+  if (!pid) {
+    OPAE_MSG("child message");
+    opae_release();
+    _exit(0);
+  }
+
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+
+  OPAE_MSG("after fork");
+
+  opae_release();
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_MODE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOGFILE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG"));
+
+  std::string log = read_log("opae_async_fork.log");
+  unlink("opae_async_fork.log");
+
+  EXPECT_EQ(1u, count_of(log, ": before fork\n"));
+  EXPECT_EQ(1u, count_of(log, ": child message\n"));
+  EXPECT_EQ(1u, count_of(log, ": after fork\n"));
+}
+
+/**
+ * @test       log_binary
+ *
+ * @brief      When LIBOPAE_LOG_MODE is binary, then the log file
+ *             holds one opae_log_record per message, each followed
+ *             by its text.
+ */
+TEST(init, log_binary) {
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG=1"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOGFILE=opae_binary.log"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG_MODE=binary"));
+  opae_init();
+
+  OPAE_ERR("Error log.");
+  OPAE_MSG("Message log.");
+
+  opae_release();
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_MODE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOGFILE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG"));
+
+  std::string log = read_log("opae_binary.log");
+  unlink("opae_binary.log");
+
+  bool found_err = false;
+  bool found_msg = false;
+  size_t pos = 0;
+  while (pos + sizeof(opae_log_record) <= log.size()) {
+    opae_log_record rec;
+    memcpy(&rec, log.data() + pos, sizeof(rec));
+    ASSERT_EQ(OPAE_LOG_RECORD_MAGIC, rec.magic);
+    ASSERT_LE(pos + sizeof(rec) + rec.length, log.size());
+    EXPECT_NE(0u, rec.timestamp);
+    EXPECT_NE(0u, rec.tid);
+
+    std::string text(log.data() + pos + sizeof(rec), rec.length);
+    if (text.find("Error log.") != std::string::npos) {
+      EXPECT_EQ(OPAE_LOG_ERROR, rec.level);
+      found_err = true;
+    }
+    if (text.find("Message log.") != std::string::npos) {
+      EXPECT_EQ(OPAE_LOG_MESSAGE, rec.level);
+      found_msg = true;
+    }
+    pos += sizeof(rec) + rec.length;
+  }
+  EXPECT_EQ(log.size(), pos);
+  EXPECT_TRUE(found_err);
+  EXPECT_TRUE(found_msg);
+}
+
+/**
+ * @test       log_binary_limits
+ *
+ * @brief      When LIBOPAE_LOG_MODE is binary and rate limited, then
+ *             the count of suppressed messages is logged at the level
+ *             of those messages, even when a message of another level
+ *             evicts their call site, and a message longer than
+ *             OPAE_LOG_MSG_MAX is cut short and ends in
+ *             OPAE_LOG_TRUNCATED.
+ */
+TEST(init, log_binary_limits) {
+  // Two format strings 128 bytes apart share a rate limit entry.
+  alignas(128) static char fmts[2][128];
+  strcpy(fmts[0], "colliding error\n");
+  strcpy(fmts[1], "colliding message\n");
+  const std::string big(2 * OPAE_LOG_MSG_MAX, 'x');
+
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG=1"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOGFILE=opae_binary_limits.log"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG_MODE=binary"));
+  ASSERT_EQ(0, putenv((char*)"LIBOPAE_LOG_RATELIMIT=2"));
+  opae_init();
+
+  for (int i = 0 ; i < 5 ; ++i)
+    opae_print(OPAE_LOG_ERROR, fmts[0]);
+  opae_print(OPAE_LOG_MESSAGE, fmts[1]);
+  opae_print(OPAE_LOG_MESSAGE, "%s\n", big.c_str());
+
+  opae_release();
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_RATELIMIT"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_MODE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOGFILE"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG"));
+
+  std::string log = read_log("opae_binary_limits.log");
+  unlink("opae_binary_limits.log");
+
+  const std::string trunc(OPAE_LOG_TRUNCATED);
+  bool found_note = false;
+  bool found_big = false;
+  size_t pos = 0;
+  while (pos + sizeof(opae_log_record) <= log.size()) {
+    opae_log_record rec;
+    memcpy(&rec, log.data() + pos, sizeof(rec));
+    ASSERT_EQ(OPAE_LOG_RECORD_MAGIC, rec.magic);
+    ASSERT_LE(pos + sizeof(rec) + rec.length, log.size());
+
+    std::string text(log.data() + pos + sizeof(rec), rec.length);
+    if (text.find("suppressed 3 message(s)") != std::string::npos) {
+      EXPECT_EQ(OPAE_LOG_ERROR, rec.level);
+      found_note = true;
+    }
+    if (text.find("xxxx") != std::string::npos) {
+      EXPECT_EQ(OPAE_LOG_MSG_MAX - 1, rec.length);
+      EXPECT_EQ(trunc, text.substr(text.size() - trunc.size()));
+      found_big = true;
+    }
+    pos += sizeof(rec) + rec.length;
+  }
+  EXPECT_EQ(log.size(), pos);
+  EXPECT_TRUE(found_note);
+  EXPECT_TRUE(found_big);
+}
+
 /**
  * @test       find_ase_cfg
  *
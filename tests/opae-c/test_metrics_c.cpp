@@ -91,6 +91,22 @@ TEST_P(metrics_c_p, threshold0) {
                                         &num_thresholds), FPGA_OK);
 }
 
+/**
+ * @test       snapshot0
+ * @brief      Test: fpgaGetMetricsSnapshot
+ * @details    When fpgaGetMetricsSnapshot is called with a NULL metrics array,<br>
+ *             then it reports the same count as fpgaGetNumMetrics.<br>
+ */
+TEST_P(metrics_c_p, snapshot0) {
+  uint64_t num_metrics = 0;
+  uint64_t num_snapshot = 0;
+
+  ASSERT_EQ(fpgaGetNumMetrics(device_, &num_metrics), FPGA_OK);
+  EXPECT_EQ(fpgaGetMetricsSnapshot(device_, NULL, &num_snapshot, NULL), FPGA_OK);
+  EXPECT_EQ(num_snapshot, num_metrics);
+  EXPECT_EQ(fpgaGetMetricsSnapshot(device_, NULL, NULL, NULL), FPGA_INVALID_PARAM);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(metrics_c_p);
 INSTANTIATE_TEST_SUITE_P(metrics_c, metrics_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({"dcp-rc"})));
@@ -206,6 +206,60 @@ TEST_P(mmio_c_p, mmio512_neg_test) {
 }
 #endif // TEST_SUPPORTS_AVX512
 
+/**
+ * @test       mmiov
+ * @brief      Test: fpgaWriteMMIOv, fpgaReadMMIOv
+ * @details    Write a batch of 32 and 64 bit registers with fpgaWriteMMIOv,<br>
+ *             read them back with fpgaReadMMIOv.<br>
+ *             Values written should equal values read.<br>
+ */
+TEST_P(mmio_c_p, mmiov) {
+  fpga_mmio_vec wr[] = {
+    { CSR_SCRATCHPAD0,      0xdeadbeefdecafbad, 64, 0 },
+    { CSR_SCRATCHPAD0 + 8,  0xc0cac01a,         32, FPGA_MMIO_FENCE },
+    { CSR_SCRATCHPAD0 + 16, 0x0123456789abcdef, 64, 0 },
+  };
+  fpga_mmio_vec rd[] = {
+    { CSR_SCRATCHPAD0,      0, 64, 0 },
+    { CSR_SCRATCHPAD0 + 8,  0, 32, 0 },
+    { CSR_SCRATCHPAD0 + 16, 0, 64, FPGA_MMIO_FENCE },
+  };
+
+  EXPECT_EQ(fpgaWriteMMIOv(accel_, which_mmio_, wr, 3), FPGA_OK);
+  EXPECT_EQ(fpgaReadMMIOv(accel_, which_mmio_, rd, 3), FPGA_OK);
+  for (int i = 0 ; i < 3 ; ++i) {
+    EXPECT_EQ(wr[i].value, rd[i].value);
+  }
+}
+
+/**
+ * @test       mmiov_neg_test
+ * @brief      Test: fpgaWriteMMIOv, fpgaReadMMIOv
+ * @details    When given an invalid handle, a NULL batch or<br>
+ *             an entry with an unsupported width,<br>
+ *             the API returns FPGA_INVALID_PARAM and<br>
+ *             no entry of the batch is executed.<br>
+ */
+TEST_P(mmio_c_p, mmiov_neg_test) {
+  fpga_mmio_vec vec[] = {
+    { CSR_SCRATCHPAD0, 0x1234, 64, 0 },
+    { CSR_SCRATCHPAD0 + 8, 0, 16, 0 },
+  };
+  uint64_t val_read = 0;
+
+  EXPECT_EQ(fpgaWriteMMIO64(accel_, which_mmio_, CSR_SCRATCHPAD0, 0), FPGA_OK);
+
+  EXPECT_EQ(fpgaWriteMMIOv(NULL, which_mmio_, vec, 2), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReadMMIOv(NULL, which_mmio_, vec, 2), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaWriteMMIOv(accel_, which_mmio_, NULL, 2), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReadMMIOv(accel_, which_mmio_, NULL, 2), FPGA_INVALID_PARAM);
+
+  EXPECT_EQ(fpgaWriteMMIOv(accel_, which_mmio_, vec, 2), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReadMMIO64(accel_, which_mmio_,
+                           CSR_SCRATCHPAD0, &val_read), FPGA_OK);
+  EXPECT_EQ(val_read, 0);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(mmio_c_p);
 INSTANTIATE_TEST_SUITE_P(mmio_c, mmio_c_p,
                          ::testing::ValuesIn(test_platform::platforms({
@@ -29,6 +29,20 @@
 
 #include "mock/opae_fixtures.h"
 
+#include <sched.h>
+
+#include <atomic>
+#include <thread>
+
+#ifdef OPAE_BENCHMARK
+#include <chrono>
+#include <iostream>
+#endif // OPAE_BENCHMARK
+
+extern "C" {
+bool opae_tryref_wrapped_token(opae_wrapped_token *wt);
+}
+
 using namespace opae::testing;
 
 class open_c_p : public opae_base_p<> {
@@ -63,3 +77,167 @@ TEST_P(open_c_p, mallocfails) {
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(open_c_p);
 INSTANTIATE_TEST_SUITE_P(open_c, open_c_p, 
                          ::testing::ValuesIn(test_platform::mock_platforms({})));
+
+static std::atomic<int> destroyed_tokens(0);
+
+static fpga_result stub_destroy_token(fpga_token *token)
+{
+  (void) token;
+  ++destroyed_tokens;
+  return FPGA_OK;
+}
+
+/**
+ * @test       wrapped_token_refcount
+ * @brief      Test: opae_upref_wrapped_token, opae_downref_wrapped_token
+ * @details    A wrapped token starts with one reference,<br>
+ *             is destroyed through its adapter only when the<br>
+ *             last reference is dropped, and can no longer be<br>
+ *             revived by opae_tryref_wrapped_token afterwards.<br>
+ */
+TEST(open_c, wrapped_token_refcount) {
+  opae_api_adapter_table adapter;
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.fpgaDestroyToken = stub_destroy_token;
+  destroyed_tokens = 0;
+
+  opae_wrapped_token *wt = opae_allocate_wrapped_token(nullptr, &adapter);
+  ASSERT_NE(wt, nullptr);
+  EXPECT_EQ(wt->ref_count, 1);
+
+  opae_upref_wrapped_token(wt);
+  EXPECT_TRUE(opae_tryref_wrapped_token(wt));
+  EXPECT_EQ(wt->ref_count, 3);
+
+  EXPECT_EQ(opae_downref_wrapped_token(wt), FPGA_OK);
+  EXPECT_EQ(opae_downref_wrapped_token(wt), FPGA_OK);
+  EXPECT_EQ(destroyed_tokens, 0);
+  EXPECT_EQ(wt->ref_count, 1);
+
+  EXPECT_EQ(opae_destroy_wrapped_token(wt), FPGA_OK);
+  EXPECT_EQ(destroyed_tokens, 1);
+
+  opae_wrapped_token dead;
+  memset(&dead, 0, sizeof(dead));
+  EXPECT_FALSE(opae_tryref_wrapped_token(&dead));
+  EXPECT_EQ(dead.ref_count, 0);
+}
+
+/**
+ * @test       wrapped_token_contention
+ * @brief      Test: opae_upref_wrapped_token, opae_downref_wrapped_token
+ * @details    Several threads upref/downref one shared token while<br>
+ *             also creating and destroying tokens of their own.<br>
+ *             No token is destroyed early, every private token is<br>
+ *             destroyed exactly once.<br>
+ */
+TEST(open_c, wrapped_token_contention) {
+  opae_api_adapter_table adapter;
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.fpgaDestroyToken = stub_destroy_token;
+  destroyed_tokens = 0;
+
+  const unsigned nthreads = 8;
+  const int iters = 200000;
+
+  opae_wrapped_token *shared = opae_allocate_wrapped_token(nullptr, &adapter);
+  ASSERT_NE(shared, nullptr);
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nthreads; ++t) {
+    threads.emplace_back([&adapter, shared, iters]() {
+      for (int i = 0; i < iters; ++i) {
+        opae_upref_wrapped_token(shared);
+        opae_downref_wrapped_token(shared);
+        if (!(i & 15)) {
+          opae_wrapped_token *wt =
+              opae_allocate_wrapped_token(nullptr, &adapter);
+          if (wt)
+            opae_destroy_wrapped_token(wt);
+        }
+      }
+    });
+  }
+  for (auto &th : threads)
+    th.join();
+
+  EXPECT_EQ(shared->ref_count, 1);
+  EXPECT_EQ(destroyed_tokens, (int)(nthreads * ((iters + 15) / 16)));
+
+  EXPECT_EQ(opae_destroy_wrapped_token(shared), FPGA_OK);
+}
+
+#ifdef OPAE_BENCHMARK
+/**
+ * @test       bench_wrapped_token_contention
+ * @brief      Test: opae_upref_wrapped_token, opae_downref_wrapped_token
+ * @details    Reports the cost of an upref/downref pair on one shared<br>
+ *             token for 1, 2, 4, ... threads and for all CPUs this<br>
+ *             process may run on, each thread pinned to its own CPU.<br>
+ *             Skipped when only one CPU is available, since there is<br>
+ *             then no cache-line contention to measure.<br>
+ *             Built only with OPAE_BUILD_BENCHMARKS.<br>
+ */
+TEST(open_c, bench_wrapped_token_contention) {
+  opae_api_adapter_table adapter;
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.fpgaDestroyToken = stub_destroy_token;
+  destroyed_tokens = 0;
+
+  const int iters = 1000000;
+
+  cpu_set_t allowed;
+  std::vector<int> cpus;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  for (int c = 0; c < CPU_SETSIZE; ++c)
+    if (CPU_ISSET(c, &allowed))
+      cpus.push_back(c);
+  if (cpus.size() < 2)
+    GTEST_SKIP() << "only one CPU available";
+
+  opae_wrapped_token *shared = opae_allocate_wrapped_token(nullptr, &adapter);
+  ASSERT_NE(shared, nullptr);
+
+  for (size_t nthreads = 1; nthreads <= cpus.size();
+       nthreads = (nthreads < cpus.size() && 2 * nthreads > cpus.size()) ?
+                  cpus.size() : 2 * nthreads) {
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < nthreads; ++t) {
+      threads.emplace_back([shared, iters, &ready, &go]() {
+        ++ready;
+        while (!go)
+          ;
+        for (int i = 0; i < iters; ++i) {
+          opae_upref_wrapped_token(shared);
+          opae_downref_wrapped_token(shared);
+        }
+      });
+      cpu_set_t one;
+      CPU_ZERO(&one);
+      CPU_SET(cpus[t], &one);
+      EXPECT_EQ(pthread_setaffinity_np(threads.back().native_handle(),
+                                       sizeof(one), &one), 0);
+    }
+
+    while (ready != nthreads)
+      std::this_thread::yield();
+    auto begin = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &th : threads)
+      th.join();
+    auto end = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(shared->ref_count, 1);
+    std::cout << "wrapped token upref/downref: "
+              << std::chrono::duration<double, std::nano>(end - begin).count() /
+                     (double)iters
+              << " ns/pair per thread, " << nthreads
+              << " threads on separate CPUs" << std::endl;
+  }
+
+  EXPECT_EQ(opae_destroy_wrapped_token(shared), FPGA_OK);
+}
+#endif // OPAE_BENCHMARK
@@ -45,6 +45,7 @@ int opae_plugin_mgr_configure_plugin(opae_api_adapter_table *adapter,
 int process_cfg_buffer(const char *buffer, const char *filename);
 extern opae_api_adapter_table *adapter_list;
 extern int finalizing;
+extern int initialized;
 int opae_plugin_mgr_finalize_all(void);
 }
 
@@ -111,13 +112,14 @@ extern "C" {
 static int test_plugin_initialize_called;
 static int test_plugin_initialize(void)
 {
-  ++test_plugin_initialize_called;
+  // Adapters may be initialized on parallel threads.
+  __atomic_add_fetch(&test_plugin_initialize_called, 1, __ATOMIC_SEQ_CST);
   return 0;
 }
 
 static int test_plugin_bad_initialize(void)
 {
-  ++test_plugin_initialize_called;
+  __atomic_add_fetch(&test_plugin_initialize_called, 1, __ATOMIC_SEQ_CST);
   return 1;
 }
 
@@ -188,6 +190,8 @@ class pluginmgr_c_p : public opae_base_p<> {
  *             then the fn returns OPAE_ENUM_STOP.<br>
  */
 TEST_P(pluginmgr_c_p, foreach_err) {
+  // finalize() only runs for adapters that were initialized.
+  EXPECT_EQ(0, opae_plugin_mgr_initialize_all());
   EXPECT_EQ(OPAE_ENUM_STOP, opae_plugin_mgr_for_each_adapter(nullptr, nullptr));
 
   EXPECT_EQ(0, opae_plugin_mgr_finalize_all());
@@ -211,6 +215,136 @@ TEST_P(pluginmgr_c_p, bad_init_all) {
   EXPECT_EQ(2, test_plugin_finalize_called);
 }
 
+extern "C" {
+
+static int count_adapters(const opae_api_adapter_table *adapter, void *context)
+{
+  UNUSED_PARAM(adapter);
+  ++*(int *)context;
+  return OPAE_ENUM_CONTINUE;
+}
+
+}
+
+/**
+ * @test       lazy_init
+ * @brief      Test: opae_plugin_mgr_for_each_adapter
+ * @details    Registered adapters are not initialized until the first<br>
+ *             opae_plugin_mgr_for_each_adapter, which initializes each of them<br>
+ *             exactly once, including one whose initialize fn fails.<br>
+ *             Adapters never initialized are not finalized.<br>
+ */
+TEST_P(pluginmgr_c_p, lazy_init) {
+  int count = 0;
+
+  faux_adapter1_->initialize = test_plugin_bad_initialize;
+  EXPECT_EQ(0, test_plugin_initialize_called);
+
+  EXPECT_EQ(OPAE_ENUM_CONTINUE,
+            opae_plugin_mgr_for_each_adapter(count_adapters, &count));
+  EXPECT_EQ(2, count);
+  EXPECT_EQ(2, test_plugin_initialize_called);
+
+  EXPECT_EQ(OPAE_ENUM_CONTINUE,
+            opae_plugin_mgr_for_each_adapter(count_adapters, &count));
+  EXPECT_EQ(4, count);
+  EXPECT_EQ(2, test_plugin_initialize_called);
+  EXPECT_EQ(0, opae_plugin_mgr_initialize_all());
+
+  opae_api_adapter_table *late = opae_plugin_mgr_alloc_adapter("libopae-c.so");
+  ASSERT_NE(nullptr, late);
+  late->initialize = test_plugin_initialize;
+  late->finalize = test_plugin_finalize;
+  EXPECT_EQ(0, opae_plugin_mgr_register_adapter(late));
+
+  EXPECT_EQ(0, opae_plugin_mgr_finalize_all());
+  EXPECT_EQ(nullptr, adapter_list);
+  EXPECT_EQ(2, test_plugin_initialize_called);
+  EXPECT_EQ(2, test_plugin_finalize_called);
+}
+
+/**
+ * @test       not_initialized
+ * @brief      Test: opae_plugin_mgr_finalize_all
+ * @details    When registered adapters were never initialized,<br>
+ *             opae_plugin_mgr_finalize_all does not call their<br>
+ *             finalize fn.<br>
+ */
+TEST_P(pluginmgr_c_p, not_initialized) {
+  EXPECT_EQ(0, opae_plugin_mgr_finalize_all());
+  EXPECT_EQ(nullptr, adapter_list);
+  EXPECT_EQ(0, test_plugin_initialize_called);
+  EXPECT_EQ(0, test_plugin_finalize_called);
+}
+
+/**
+ * @test       init_reports_failure
+ * @brief      Test: fpgaInitialize
+ * @details    When plugin initialization was deferred and a pending<br>
+ *             adapter's initialize fn fails, then an explicit<br>
+ *             fpgaInitialize runs it and returns FPGA_EXCEPTION.<br>
+ */
+TEST_P(pluginmgr_c_p, init_reports_failure) {
+  int save_initialized = initialized;
+
+  faux_adapter1_->initialize = test_plugin_bad_initialize;
+
+  initialized = 1;
+  EXPECT_EQ(FPGA_EXCEPTION, fpgaInitialize(nullptr));
+  EXPECT_EQ(2, test_plugin_initialize_called);
+
+  // Already-initialized adapters are not run again.
+  EXPECT_EQ(FPGA_OK, fpgaInitialize(nullptr));
+  EXPECT_EQ(2, test_plugin_initialize_called);
+
+  EXPECT_EQ(0, opae_plugin_mgr_finalize_all());
+  EXPECT_EQ(nullptr, adapter_list);
+  EXPECT_EQ(2, test_plugin_finalize_called);
+  initialized = save_initialized;
+}
+
+extern "C" {
+
+static int test_plugin_nested_count;
+static int test_plugin_nested_initialize(void)
+{
+  int count = 0;
+  int res;
+
+  __atomic_add_fetch(&test_plugin_initialize_called, 1, __ATOMIC_SEQ_CST);
+  res = opae_plugin_mgr_for_each_adapter(count_adapters, &count);
+  __atomic_add_fetch(&test_plugin_nested_count, count, __ATOMIC_SEQ_CST);
+  return res;
+}
+
+}
+
+/**
+ * @test       nested_init
+ * @brief      Test: opae_plugin_mgr_for_each_adapter
+ * @details    When an adapter's initialize fn calls back into<br>
+ *             opae_plugin_mgr_for_each_adapter, the nested call<br>
+ *             visits the adapters without waiting for initialization<br>
+ *             to finish, and does not deadlock.<br>
+ */
+TEST_P(pluginmgr_c_p, nested_init) {
+  int count = 0;
+
+  test_plugin_nested_count = 0;
+  faux_adapter0_->initialize = test_plugin_nested_initialize;
+  faux_adapter1_->initialize = test_plugin_nested_initialize;
+
+  EXPECT_EQ(OPAE_ENUM_CONTINUE,
+            opae_plugin_mgr_for_each_adapter(count_adapters, &count));
+  EXPECT_EQ(2, count);
+  EXPECT_EQ(2, test_plugin_initialize_called);
+  EXPECT_EQ(4, test_plugin_nested_count);
+
+  EXPECT_EQ(0, opae_plugin_mgr_finalize_all());
+  EXPECT_EQ(nullptr, adapter_list);
+  EXPECT_EQ(2, test_plugin_finalize_called);
+}
+
 /**
  * @test       bad_final_all
  * @brief      Test: opae_plugin_mgr_finalize_all
@@ -220,6 +354,8 @@ TEST_P(pluginmgr_c_p, bad_init_all) {
 TEST_P(pluginmgr_c_p, bad_final_all) {
   faux_adapter1_->finalize = test_plugin_bad_finalize;
 
+  // finalize() only runs for adapters that were initialized.
+  EXPECT_EQ(0, opae_plugin_mgr_initialize_all());
   EXPECT_NE(0, opae_plugin_mgr_finalize_all());
   EXPECT_EQ(nullptr, adapter_list);
   EXPECT_EQ(2, test_plugin_finalize_called);
@@ -236,6 +372,9 @@ TEST_P(pluginmgr_c_p, bad_final_all) {
 TEST_P(pluginmgr_c_p, register_err01) {
   opae_api_adapter_table *aptr;
 
+  // finalize() only runs for adapters that were initialized.
+  EXPECT_EQ(0, opae_plugin_mgr_initialize_all());
+
   aptr = opae_plugin_mgr_alloc_adapter("libxfpga.so");
   ASSERT_NE(nullptr, aptr);
   EXPECT_NE(0, opae_plugin_mgr_register_adapter(aptr));
@@ -27,7 +27,12 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <condition_variable>
+#include <mutex>
+
+#include "fpga-dfl.h"
 #include "mock/opae_fixtures.h"
+#include "mock/test_utils.h"
 
 using namespace opae::testing;
 
@@ -48,3 +53,210 @@ TEST_P(reconf_c_p, pr) {
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(reconf_c_p);
 INSTANTIATE_TEST_SUITE_P(reconf_c, reconf_c_p,
                          ::testing::ValuesIn(test_platform::platforms({})));
+
+struct reconf_progress {
+  std::vector<fpga_reconf_phase> phases;
+  size_t bytes_written = 0;
+  size_t bytes_total = 0;
+
+  std::mutex lock;
+  std::condition_variable cond;
+  bool hold = false;
+};
+
+static void record_progress(fpga_reconf_phase phase, size_t bytes_written,
+                            size_t bytes_total, void *context) {
+  reconf_progress *p = reinterpret_cast<reconf_progress *>(context);
+  std::unique_lock<std::mutex> lock(p->lock);
+  p->phases.push_back(phase);
+  p->bytes_written = bytes_written;
+  p->bytes_total = bytes_total;
+  p->cond.wait(lock, [p] { return !p->hold; });
+}
+
+class reconf_c_async_p : public opae_device_p<> {
+ protected:
+  virtual void SetUp() override {
+    opae_device_p<>::SetUp();
+
+    test_device device = platform_.devices[0];
+
+    auto bitstream_j = jobject
+    ("version", "640")
+    ("afu-image", jobject
+                  ("interface-uuid", device.fme_guid)
+                  ("magic-no", int32_t(488605312))
+                  ("accelerator-clusters", {
+                                             jobject
+                                             ("total-contexts", int32_t(1))
+                                             ("name", "nlb")
+                                             ("accelerator-type-uuid", device.afu_guid)
+                                            }
+                  )
+    )
+    ("platform-name", "");
+
+    metadata_len_ = strlen(bitstream_j.c_str());
+    bitstream_valid_ = system_->assemble_gbs_header(device, bitstream_j.c_str());
+    bitstream_j.put();
+    op_ = nullptr;
+  }
+
+  virtual void TearDown() override {
+    if (op_) {
+      EXPECT_EQ(fpgaReconfigureDestroy(&op_), FPGA_OK);
+    }
+    opae_device_p<>::TearDown();
+  }
+
+  std::vector<uint8_t> bitstream_valid_;
+  size_t metadata_len_;
+  fpga_reconf_op op_;
+};
+
+/**
+ * @test       async_ok
+ * @brief      Test: fpgaReconfigureSlotAsync, fpgaReconfigureWait,
+ *             fpgaReconfigurePoll, fpgaReconfigureDestroy
+ * @details    Given a valid bitstream,<br>
+ *             fpgaReconfigureSlotAsync starts the reconfiguration and<br>
+ *             the progress callback sees each phase in order, ending with<br>
+ *             the whole payload written. fpgaReconfigureWait and<br>
+ *             fpgaReconfigurePoll then report FPGA_OK, and<br>
+ *             fpgaReconfigureDestroy clears the operation.<br>
+ */
+TEST_P(reconf_c_async_p, async_ok) {
+  reconf_progress progress;
+  fpga_result result = FPGA_EXCEPTION;
+  fpga_reconf_phase phase = FPGA_RECONF_PHASE_VALIDATE;
+  size_t written = 0;
+
+  ASSERT_EQ(fpgaReconfigureSlotAsync(device_, 0, bitstream_valid_.data(),
+                                     bitstream_valid_.size(), 0,
+                                     record_progress, &progress, &op_),
+            FPGA_OK);
+  ASSERT_NE(op_, nullptr);
+
+  EXPECT_EQ(fpgaReconfigureWait(op_, -1, &result), FPGA_OK);
+  EXPECT_EQ(result, FPGA_OK);
+
+  std::vector<fpga_reconf_phase> expected = {
+    FPGA_RECONF_PHASE_VALIDATE,
+    FPGA_RECONF_PHASE_CLEAR_ERRORS,
+    FPGA_RECONF_PHASE_PROGRAM,
+    FPGA_RECONF_PHASE_PROGRAM,
+    FPGA_RECONF_PHASE_DONE
+  };
+  EXPECT_EQ(progress.phases, expected);
+
+  size_t payload = bitstream_valid_.size() - 20 - metadata_len_;
+  EXPECT_EQ(progress.bytes_total, payload);
+  EXPECT_EQ(progress.bytes_written, payload);
+
+  result = FPGA_EXCEPTION;
+  EXPECT_EQ(fpgaReconfigurePoll(op_, &phase, &written, &result), FPGA_OK);
+  EXPECT_EQ(phase, FPGA_RECONF_PHASE_DONE);
+  EXPECT_EQ(written, payload);
+  EXPECT_EQ(result, FPGA_OK);
+
+  EXPECT_EQ(fpgaReconfigureDestroy(&op_), FPGA_OK);
+  EXPECT_EQ(op_, nullptr);
+}
+
+/**
+ * @test       async_einval
+ * @brief      Test: fpgaReconfigureSlotAsync, fpgaReconfigureWait
+ * @details    When the PR ioctl fails with EINVAL,<br>
+ *             the operation completes with FPGA_INVALID_PARAM and<br>
+ *             no payload bytes are reported as written.<br>
+ */
+TEST_P(reconf_c_async_p, async_einval) {
+  reconf_progress progress;
+  fpga_result result = FPGA_OK;
+
+  system_->register_ioctl_handler(DFL_FPGA_FME_PORT_PR, dummy_ioctl<-1, EINVAL>);
+
+  ASSERT_EQ(fpgaReconfigureSlotAsync(device_, 0, bitstream_valid_.data(),
+                                     bitstream_valid_.size(), 0,
+                                     record_progress, &progress, &op_),
+            FPGA_OK);
+
+  EXPECT_EQ(fpgaReconfigureWait(op_, -1, &result), FPGA_OK);
+  EXPECT_EQ(result, FPGA_INVALID_PARAM);
+
+  ASSERT_GE(progress.phases.size(), 2u);
+  EXPECT_EQ(progress.phases[progress.phases.size() - 2],
+            FPGA_RECONF_PHASE_PROGRAM);
+  EXPECT_EQ(progress.phases.back(), FPGA_RECONF_PHASE_DONE);
+  EXPECT_EQ(progress.bytes_written, 0u);
+}
+
+/**
+ * @test       async_timeout
+ * @brief      Test: fpgaReconfigureWait, fpgaReconfigurePoll
+ * @details    While the worker is held in the progress callback,<br>
+ *             fpgaReconfigureWait with a timeout and fpgaReconfigurePoll<br>
+ *             return FPGA_BUSY and leave the result untouched. Once the<br>
+ *             worker is released, the operation completes.<br>
+ */
+TEST_P(reconf_c_async_p, async_timeout) {
+  reconf_progress progress;
+  fpga_result result = FPGA_EXCEPTION;
+  fpga_reconf_phase phase = FPGA_RECONF_PHASE_DONE;
+
+  progress.hold = true;
+
+  ASSERT_EQ(fpgaReconfigureSlotAsync(device_, 0, bitstream_valid_.data(),
+                                     bitstream_valid_.size(), 0,
+                                     record_progress, &progress, &op_),
+            FPGA_OK);
+
+  EXPECT_EQ(fpgaReconfigureWait(op_, 0, &result), FPGA_BUSY);
+  EXPECT_EQ(fpgaReconfigureWait(op_, 10, &result), FPGA_BUSY);
+  EXPECT_EQ(fpgaReconfigurePoll(op_, &phase, nullptr, &result), FPGA_BUSY);
+  EXPECT_EQ(phase, FPGA_RECONF_PHASE_VALIDATE);
+  EXPECT_EQ(result, FPGA_EXCEPTION);
+
+  {
+    std::lock_guard<std::mutex> lock(progress.lock);
+    progress.hold = false;
+  }
+  progress.cond.notify_all();
+
+  EXPECT_EQ(fpgaReconfigureWait(op_, -1, &result), FPGA_OK);
+  EXPECT_EQ(result, FPGA_OK);
+}
+
+/**
+ * @test       async_invalid
+ * @brief      Test: fpgaReconfigureSlotAsync, fpgaReconfigurePoll,
+ *             fpgaReconfigureWait, fpgaReconfigureDestroy
+ * @details    When called with NULL parameters,<br>
+ *             each function returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(reconf_c_async_p, async_invalid) {
+  fpga_reconf_op op = nullptr;
+
+  EXPECT_EQ(fpgaReconfigureSlotAsync(nullptr, 0, bitstream_valid_.data(),
+                                     bitstream_valid_.size(), 0,
+                                     nullptr, nullptr, &op),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReconfigureSlotAsync(device_, 0, nullptr,
+                                     bitstream_valid_.size(), 0,
+                                     nullptr, nullptr, &op),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReconfigureSlotAsync(device_, 0, bitstream_valid_.data(),
+                                     bitstream_valid_.size(), 0,
+                                     nullptr, nullptr, nullptr),
+            FPGA_INVALID_PARAM);
+
+  EXPECT_EQ(fpgaReconfigurePoll(nullptr, nullptr, nullptr, nullptr),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReconfigureWait(nullptr, -1, nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReconfigureDestroy(nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReconfigureDestroy(&op), FPGA_INVALID_PARAM);
+}
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(reconf_c_async_p);
+INSTANTIATE_TEST_SUITE_P(reconf_c, reconf_c_async_p,
+                         ::testing::ValuesIn(test_platform::mock_platforms({ "dfl-n3000","dfl-d5005" })));
@@ -0,0 +1,404 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <vector>
+
+#ifdef OPAE_BENCHMARK
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#endif // OPAE_BENCHMARK
+
+#include "gtest/gtest.h"
+#include "mock/opae_std.h"
+
+#include <opae/hash_map.h>
+
+#define HUGE_2M (2ULL * 1024 * 1024)
+
+static void *aligned_key(uint64_t i)
+{
+  return (void *)(0x7f0000000000ULL + i * HUGE_2M);
+}
+
+static void count_cleanup(void *item, void *context)
+{
+  (void) item;
+  ++*reinterpret_cast<int *>(context);
+}
+
+/**
+ * @test    add_find_remove
+ * @brief   Test: opae_hash_map_add(), opae_hash_map_find(),
+ *          opae_hash_map_remove()
+ * @details Keys that are added can be found and removed,<br>
+ *          and removed keys are no longer found.<br>
+ */
+TEST(hash_map, add_find_remove)
+{
+  opae_hash_map hm;
+  const uint64_t count = 1000;
+  void *value = nullptr;
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 16, 0, 0,
+                               opae_u64_key_hash, opae_u64_key_compare,
+                               nullptr, nullptr), FPGA_OK);
+  EXPECT_TRUE(opae_hash_map_is_empty(&hm));
+
+  for (uint64_t i = 0 ; i < count ; ++i)
+    ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(i), (void *)(i + 1)),
+              FPGA_OK);
+  EXPECT_EQ(hm.num_items, count);
+  EXPECT_FALSE(opae_hash_map_is_empty(&hm));
+
+  for (uint64_t i = 0 ; i < count ; ++i) {
+    ASSERT_EQ(opae_hash_map_find(&hm, aligned_key(i), &value), FPGA_OK);
+    EXPECT_EQ(value, (void *)(i + 1));
+  }
+  EXPECT_EQ(opae_hash_map_find(&hm, aligned_key(count), &value),
+            FPGA_NOT_FOUND);
+
+  // Remove every other key, then make sure the rest survived
+  // the backward shifts.
+  for (uint64_t i = 0 ; i < count ; i += 2)
+    ASSERT_EQ(opae_hash_map_remove(&hm, aligned_key(i)), FPGA_OK);
+  EXPECT_EQ(hm.num_items, count / 2);
+
+  for (uint64_t i = 0 ; i < count ; ++i) {
+    if (i & 1) {
+      ASSERT_EQ(opae_hash_map_find(&hm, aligned_key(i), &value), FPGA_OK);
+      EXPECT_EQ(value, (void *)(i + 1));
+    } else {
+      EXPECT_EQ(opae_hash_map_find(&hm, aligned_key(i), &value),
+                FPGA_NOT_FOUND);
+      EXPECT_EQ(opae_hash_map_remove(&hm, aligned_key(i)), FPGA_NOT_FOUND);
+    }
+  }
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+/**
+ * @test    growth
+ * @brief   Test: opae_hash_map_add()
+ * @details The slot array is rounded up to a prime<br>
+ *          and grows to keep the load factor at or below 3/4.<br>
+ */
+TEST(hash_map, growth)
+{
+  opae_hash_map hm;
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 100, 0, OPAE_HASH_MAP_UNIQUE_KEYSPACE,
+                               opae_u64_key_hash, opae_u64_key_compare,
+                               nullptr, nullptr), FPGA_OK);
+  EXPECT_EQ(hm.num_buckets, 131);
+
+  for (uint64_t i = 0 ; i < 98 ; ++i)
+    ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(i), nullptr), FPGA_OK);
+  EXPECT_EQ(hm.num_buckets, 131);
+
+  ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(98), nullptr), FPGA_OK);
+  EXPECT_EQ(hm.num_buckets, 257);
+
+  for (uint64_t i = 0 ; i <= 98 ; ++i)
+    EXPECT_EQ(opae_hash_map_find(&hm, aligned_key(i), nullptr), FPGA_OK);
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+/**
+ * @test    replace_cleanup
+ * @brief   Test: opae_hash_map_add(), opae_hash_map_destroy()
+ * @details Adding an existing key replaces its value and<br>
+ *          cleans up the old value. Destroying the map<br>
+ *          cleans up every remaining key and value.<br>
+ */
+TEST(hash_map, replace_cleanup)
+{
+  opae_hash_map hm;
+  int cleanups = 0;
+  void *value = nullptr;
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 0, 0, 0,
+                               opae_u64_key_hash, opae_u64_key_compare,
+                               count_cleanup, count_cleanup), FPGA_OK);
+  hm.cleanup_context = &cleanups;
+
+  ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(1), (void *)1), FPGA_OK);
+  ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(1), (void *)2), FPGA_OK);
+  EXPECT_EQ(cleanups, 1);
+  EXPECT_EQ(hm.num_items, 1);
+  ASSERT_EQ(opae_hash_map_find(&hm, aligned_key(1), &value), FPGA_OK);
+  EXPECT_EQ(value, (void *)2);
+
+  ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(2), (void *)3), FPGA_OK);
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+  EXPECT_EQ(cleanups, 5);
+}
+
+/**
+ * @test    aligned_keys
+ * @brief   Test: opae_u64_key_hash()
+ * @details Hugepage-aligned keys each get their own home<br>
+ *          slot, so none of them is displaced by probing.<br>
+ */
+TEST(hash_map, aligned_keys)
+{
+  opae_hash_map hm;
+  const uint64_t count = 10000;
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 1024, 0, OPAE_HASH_MAP_UNIQUE_KEYSPACE,
+                               opae_u64_key_hash, opae_u64_key_compare,
+                               nullptr, nullptr), FPGA_OK);
+
+  for (uint64_t i = 0 ; i < count ; ++i)
+    ASSERT_EQ(opae_hash_map_add(&hm, aligned_key(i), nullptr), FPGA_OK);
+
+  uint32_t occupied = 0;
+  for (uint32_t i = 0 ; i < hm.num_buckets ; ++i) {
+    if (!hm.slots[i].hash)
+      continue;
+    ++occupied;
+    EXPECT_EQ(hm.slots[i].hash & 0x7fffffff, i) << "slot " << i;
+  }
+  EXPECT_EQ(occupied, count);
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+static uint32_t collide_key_hash(uint32_t num_buckets,
+                                 uint32_t hash_seed,
+                                 void *key)
+{
+  (void) hash_seed;
+  // Only four home slots, so most keys probe.
+  return (uint32_t)((uint64_t)key % 4) % num_buckets;
+}
+
+/**
+ * @test    collisions
+ * @brief   Test: opae_hash_map_add(), opae_hash_map_find(),
+ *          opae_hash_map_remove()
+ * @details When many keys share a home slot, they can<br>
+ *          still be found after growth and after removing<br>
+ *          keys from the middle of a probe sequence.<br>
+ */
+TEST(hash_map, collisions)
+{
+  opae_hash_map hm;
+  const uint64_t count = 200;
+  void *value = nullptr;
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 0, 0, 0,
+                               collide_key_hash, opae_u64_key_compare,
+                               nullptr, nullptr), FPGA_OK);
+
+  for (uint64_t i = 0 ; i < count ; ++i)
+    ASSERT_EQ(opae_hash_map_add(&hm, (void *)i, (void *)(i + 1)), FPGA_OK);
+  EXPECT_EQ(hm.num_items, count);
+
+  for (uint64_t i = 0 ; i < count ; i += 3)
+    ASSERT_EQ(opae_hash_map_remove(&hm, (void *)i), FPGA_OK);
+
+  for (uint64_t i = 0 ; i < count ; ++i) {
+    if (i % 3) {
+      ASSERT_EQ(opae_hash_map_find(&hm, (void *)i, &value), FPGA_OK);
+      EXPECT_EQ(value, (void *)(i + 1));
+    } else {
+      EXPECT_EQ(opae_hash_map_find(&hm, (void *)i, &value), FPGA_NOT_FOUND);
+    }
+  }
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+static uint32_t bad_key_hash(uint32_t num_buckets,
+                             uint32_t hash_seed,
+                             void *key)
+{
+  (void) hash_seed;
+  (void) key;
+  return num_buckets;
+}
+
+/**
+ * @test    bad_hash
+ * @brief   Test: opae_hash_map_add(), opae_hash_map_find(),
+ *          opae_hash_map_remove()
+ * @details When key_hash returns a value out of bounds,<br>
+ *          the functions return FPGA_INVALID_PARAM.<br>
+ */
+TEST(hash_map, bad_hash)
+{
+  opae_hash_map hm;
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 0, 0, 0,
+                               bad_key_hash, opae_u64_key_compare,
+                               nullptr, nullptr), FPGA_OK);
+
+  EXPECT_EQ(opae_hash_map_add(&hm, aligned_key(0), nullptr),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(opae_hash_map_find(&hm, aligned_key(0), nullptr),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(opae_hash_map_remove(&hm, aligned_key(0)), FPGA_INVALID_PARAM);
+  EXPECT_TRUE(opae_hash_map_is_empty(&hm));
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+#ifdef OPAE_BENCHMARK
+// The fixed-bucket chained table that opae_hash_map replaced,
+// kept here as the baseline for the latency comparison. Its
+// operations are kept out of line, as they were in libopaemem.
+class legacy_hash_map {
+ public:
+  explicit legacy_hash_map(uint32_t num_buckets)
+    : buckets_(num_buckets, nullptr) {}
+
+  ~legacy_hash_map() {
+    for (auto item : buckets_) {
+      while (item) {
+        opae_hash_map_item *trash = item;
+        item = item->next;
+        delete trash;
+      }
+    }
+  }
+
+  __attribute__((noinline))
+  void add(void *key, void *value) {
+    uint32_t b = (uint64_t)key % buckets_.size();
+    buckets_[b] = new opae_hash_map_item{key, value, buckets_[b]};
+  }
+
+  __attribute__((noinline))
+  bool find(void *key, void **value) {
+    uint32_t b = (uint64_t)key % buckets_.size();
+    for (auto item = buckets_[b] ; item ; item = item->next) {
+      if (!opae_u64_key_compare(key, item->key)) {
+        *value = item->value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  __attribute__((noinline))
+  bool remove(void *key) {
+    uint32_t b = (uint64_t)key % buckets_.size();
+    for (auto link = &buckets_[b] ; *link ; link = &(*link)->next) {
+      if (!opae_u64_key_compare(key, (*link)->key)) {
+        opae_hash_map_item *trash = *link;
+        *link = trash->next;
+        delete trash;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  std::vector<opae_hash_map_item *> buckets_;
+};
+
+/**
+ * @test    bench_latency
+ * @details Reports the per-operation latency of add, find, and<br>
+ *          remove for 4 KiB and 2 MiB strided keys (as stored by<br>
+ *          opae_vfio), looked up in random order, for opae_hash_map<br>
+ *          initialized with 1024 slots versus the previous chained<br>
+ *          table with 19441 buckets.<br>
+ *          Built only with OPAE_BUILD_BENCHMARKS.<br>
+ */
+TEST(hash_map, bench_latency)
+{
+  using nsec = std::chrono::duration<double, std::nano>;
+  using clock = std::chrono::steady_clock;
+  void *value = nullptr;
+
+  for (uint64_t stride : { 4096ULL, HUGE_2M }) {
+    for (uint64_t count : { 16, 128, 1024, 10000 }) {
+      std::vector<void *> keys;
+      for (uint64_t i = 0 ; i < count ; ++i)
+        keys.push_back((void *)(0x7f0000000000ULL + i * stride));
+      // Buffers are looked up and freed in no particular order.
+      std::vector<void *> shuffled(keys);
+      std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(0));
+
+      legacy_hash_map legacy(19441);
+      auto start = clock::now();
+      for (auto key : keys)
+        legacy.add(key, key);
+      auto add = clock::now() - start;
+
+      start = clock::now();
+      for (auto key : shuffled)
+        ASSERT_TRUE(legacy.find(key, &value));
+      auto find = clock::now() - start;
+
+      start = clock::now();
+      for (auto key : shuffled)
+        ASSERT_TRUE(legacy.remove(key));
+      auto remove = clock::now() - start;
+
+      opae_hash_map hm;
+      ASSERT_EQ(opae_hash_map_init(&hm, 1024, 0,
+                                   OPAE_HASH_MAP_UNIQUE_KEYSPACE,
+                                   opae_u64_key_hash, opae_u64_key_compare,
+                                   nullptr, nullptr), FPGA_OK);
+      start = clock::now();
+      for (auto key : keys)
+        ASSERT_EQ(opae_hash_map_add(&hm, key, key), FPGA_OK);
+      auto hm_add = clock::now() - start;
+
+      start = clock::now();
+      for (auto key : shuffled)
+        ASSERT_EQ(opae_hash_map_find(&hm, key, &value), FPGA_OK);
+      auto hm_find = clock::now() - start;
+
+      start = clock::now();
+      for (auto key : shuffled)
+        ASSERT_EQ(opae_hash_map_remove(&hm, key), FPGA_OK);
+      auto hm_remove = clock::now() - start;
+      EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+
+      std::cout << "stride " << stride << ", " << count
+                << " entries, ns per op (legacy / opae_hash_map)"
+                << " add: " << nsec(add).count() / count
+                << " / " << nsec(hm_add).count() / count
+                << ", find: " << nsec(find).count() / count
+                << " / " << nsec(hm_find).count() / count
+                << ", remove: " << nsec(remove).count() / count
+                << " / " << nsec(hm_remove).count() / count
+                << std::endl;
+    }
+  }
+}
+#endif // OPAE_BENCHMARK
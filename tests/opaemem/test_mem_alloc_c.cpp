@@ -27,6 +27,10 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "mock/opae_std.h"
 
@@ -48,6 +52,7 @@ int mem_alloc_allocate_split_node(struct mem_alloc *m,
 				  uint64_t size);
 int mem_alloc_free_node(struct mem_alloc *m,
                         struct mem_link *node);
+int mem_allocated_insert(struct mem_alloc *m, struct mem_link *n);
 }
 
 /**
@@ -87,6 +92,8 @@ TEST(mem_alloc, destroy)
   ASSERT_NE(free_link, nullptr);
   ASSERT_NE(allocated_link, nullptr);
 
+  mem_alloc_init(&m);
+
   m.free.prev = free_link;
   m.free.next = free_link;
   free_link->prev = &m.free;
@@ -376,6 +383,7 @@ TEST(mem_alloc, allocate_node0)
   EXPECT_EQ(l->size, size);
 
   opae_free(l);
+  opae_hash_map_destroy(&allocator.allocated_map);
 }
 
 /**
@@ -422,6 +430,7 @@ TEST(mem_alloc, allocate_node1)
   EXPECT_EQ(l->size, 512);
 
   opae_free(l);
+  opae_hash_map_destroy(&allocator.allocated_map);
 }
 
 /**
@@ -470,6 +479,7 @@ TEST(mem_alloc, alloc_split_node0)
   EXPECT_EQ(l->size, twoM);
 
   opae_free(l);
+  opae_hash_map_destroy(&allocator.allocated_map);
 }
 
 /**
@@ -524,6 +534,7 @@ TEST(mem_alloc, alloc_split_node1)
   EXPECT_EQ(l->size, twoM);
 
   opae_free(l);
+  opae_hash_map_destroy(&allocator.allocated_map);
 }
 
 /**
@@ -568,6 +579,7 @@ TEST(mem_alloc, get0)
   EXPECT_EQ(l->size, 512);
 
   opae_free(l);
+  opae_hash_map_destroy(&allocator.allocated_map);
 }
 
 /**
@@ -616,6 +628,7 @@ TEST(mem_alloc, free_node)
   allocator.allocated.prev = node;
   node->prev = &allocator.allocated;
   node->next = &allocator.allocated;
+  ASSERT_EQ(mem_allocated_insert(&allocator, node), 0);
 
   EXPECT_EQ(mem_alloc_free_node(&allocator, node), 0);
   EXPECT_EQ(allocator.allocated.prev, &allocator.allocated);
@@ -630,7 +643,7 @@ TEST(mem_alloc, free_node)
   EXPECT_EQ(node->address, addr);
   EXPECT_EQ(node->size, size);
 
-  opae_free(node);
+  mem_alloc_destroy(&allocator);
 }
 
 /**
@@ -656,6 +669,7 @@ TEST(mem_alloc, put0)
   allocator.allocated.prev = node;
   node->prev = &allocator.allocated;
   node->next = &allocator.allocated;
+  ASSERT_EQ(mem_allocated_insert(&allocator, node), 0);
 
   EXPECT_EQ(mem_alloc_put(&allocator, addr), 0);
 
@@ -672,7 +686,7 @@ TEST(mem_alloc, put0)
   EXPECT_EQ(node->address, addr);
   EXPECT_EQ(node->size, size);
 
-  opae_free(node);
+  mem_alloc_destroy(&allocator);
 }
 
 /**
@@ -711,3 +725,179 @@ TEST(mem_alloc, put1)
 
   opae_free(node);
 }
+
+/**
+ * @test    get_aligned0
+ * @brief   Test: mem_alloc_get_aligned()
+ * @details The fn returns an address with the requested<br>
+ *          alignment, which need not match the size.
+ */
+TEST(mem_alloc, get_aligned0)
+{
+  struct mem_alloc allocator;
+  const uint64_t fourK = 4096UL;
+  const uint64_t twoM = 2 * 1024UL * 1024UL;
+  uint64_t addr = 0;
+
+  mem_alloc_init(&allocator);
+
+  EXPECT_EQ(mem_alloc_add_free(&allocator, fourK, 8 * twoM), 0);
+
+  EXPECT_EQ(mem_alloc_get_aligned(&allocator, &addr, 3 * twoM, twoM), 0);
+  EXPECT_EQ(addr, twoM);
+
+  EXPECT_EQ(mem_alloc_get_aligned(&allocator, &addr, fourK, 0), 0);
+  EXPECT_EQ(addr, fourK);
+
+  EXPECT_NE(mem_alloc_get_aligned(&allocator, &addr, fourK, 3 * fourK), 0);
+
+  mem_alloc_destroy(&allocator);
+}
+
+/**
+ * @test    stats
+ * @brief   Test: mem_alloc_get_stats()
+ * @details The fn reports the free and allocated totals,<br>
+ *          the number of free blocks, and the size of<br>
+ *          the largest free block.
+ */
+TEST(mem_alloc, stats)
+{
+  struct mem_alloc allocator;
+  struct mem_alloc_stats stats;
+  uint64_t a = 0, b = 0, c = 0;
+
+  mem_alloc_init(&allocator);
+
+  EXPECT_EQ(mem_alloc_add_free(&allocator, 0, 4 * 4096), 0);
+  EXPECT_EQ(mem_alloc_get(&allocator, &a, 4096), 0);
+  EXPECT_EQ(mem_alloc_get(&allocator, &b, 4096), 0);
+  EXPECT_EQ(mem_alloc_get(&allocator, &c, 4096), 0);
+  EXPECT_EQ(mem_alloc_put(&allocator, b), 0);
+
+  // | a | b (free) | c | free |
+  mem_alloc_get_stats(&allocator, &stats);
+  EXPECT_EQ(stats.free_bytes, 2 * 4096);
+  EXPECT_EQ(stats.free_blocks, 2);
+  EXPECT_EQ(stats.largest_free, 4096);
+  EXPECT_EQ(stats.allocated_bytes, 2 * 4096);
+  EXPECT_EQ(stats.allocated_blocks, 2);
+
+  EXPECT_EQ(mem_alloc_put(&allocator, a), 0);
+  EXPECT_EQ(mem_alloc_put(&allocator, c), 0);
+
+  mem_alloc_get_stats(&allocator, &stats);
+  EXPECT_EQ(stats.free_bytes, 4 * 4096);
+  EXPECT_EQ(stats.free_blocks, 1);
+  EXPECT_EQ(stats.largest_free, 4 * 4096);
+  EXPECT_EQ(stats.allocated_bytes, 0);
+  EXPECT_EQ(stats.allocated_blocks, 0);
+
+  mem_alloc_destroy(&allocator);
+}
+
+/**
+ * @test    random
+ * @brief   Test: mem_alloc_get(), mem_alloc_put()
+ * @details After many allocations and frees in random order,<br>
+ *          the free list is address ordered and non-overlapping,<br>
+ *          and freeing everything coalesces the space<br>
+ *          back into a single block.
+ */
+TEST(mem_alloc, random)
+{
+  struct mem_alloc allocator;
+  struct mem_alloc_stats stats;
+  const uint64_t base = 0x100000000ULL;
+  const uint64_t space = 1ULL << 32;
+  std::mt19937 rng(0);
+  std::vector<uint64_t> live;
+
+  mem_alloc_init(&allocator);
+  ASSERT_EQ(mem_alloc_add_free(&allocator, base, space), 0);
+
+  for (int i = 0 ; i < 4000 ; ++i) {
+    if (live.empty() || (rng() % 3)) {
+      uint64_t size = 4096ULL << (rng() % 10);
+      uint64_t addr = 0;
+      ASSERT_EQ(mem_alloc_get(&allocator, &addr, size), 0);
+      EXPECT_EQ(addr % size, 0);
+      live.push_back(addr);
+    } else {
+      size_t j = rng() % live.size();
+      ASSERT_EQ(mem_alloc_put(&allocator, live[j]), 0);
+      live[j] = live.back();
+      live.pop_back();
+    }
+  }
+
+  uint64_t end = 0;
+  for (struct mem_link *l = allocator.free.next ;
+       l != &allocator.free ; l = l->next) {
+    EXPECT_GT(l->address, end);
+    end = l->address + l->size;
+  }
+
+  std::shuffle(live.begin(), live.end(), rng);
+  for (auto addr : live)
+    ASSERT_EQ(mem_alloc_put(&allocator, addr), 0);
+
+  mem_alloc_get_stats(&allocator, &stats);
+  EXPECT_EQ(stats.free_blocks, 1);
+  EXPECT_EQ(stats.largest_free, space);
+  EXPECT_EQ(stats.allocated_blocks, 0);
+  EXPECT_EQ(allocator.free.next->address, base);
+
+  mem_alloc_destroy(&allocator);
+}
+
+/**
+ * @test    get_aligned1
+ * @brief   Test: mem_alloc_get_aligned()
+ * @details With the free space fragmented into many blocks<br>
+ *          that are large enough but mostly misaligned,<br>
+ *          the fn still returns the lowest aligned fit,<br>
+ *          as found by a scan of the free list.
+ */
+TEST(mem_alloc, get_aligned1)
+{
+  struct mem_alloc allocator;
+  const uint64_t fourK = 4096UL;
+  std::mt19937 rng(0);
+  std::vector<uint64_t> live(4096);
+
+  mem_alloc_init(&allocator);
+  ASSERT_EQ(mem_alloc_add_free(&allocator, 0, 1ULL << 32), 0);
+
+  // Leave a free 8K hole every 12K.
+  for (auto &addr : live) {
+    uint64_t pad = 0;
+    ASSERT_EQ(mem_alloc_get(&allocator, &addr, 2 * fourK), 0);
+    ASSERT_EQ(mem_alloc_get_aligned(&allocator, &pad, fourK, fourK), 0);
+  }
+  for (auto addr : live)
+    ASSERT_EQ(mem_alloc_put(&allocator, addr), 0);
+
+  for (int i = 0 ; i < 200 ; ++i) {
+    uint64_t size = fourK << (rng() % 3);
+    uint64_t alignment = fourK << (rng() % 10);
+    uint64_t expected = 0;
+    uint64_t addr = 0;
+
+    for (struct mem_link *l = allocator.free.next ;
+         l != &allocator.free ; l = l->next) {
+      uint64_t a = ALIGNED(l->address, alignment);
+      if (a + size <= l->address + l->size) {
+        expected = a;
+        break;
+      }
+    }
+
+    ASSERT_EQ(mem_alloc_get_aligned(&allocator, &addr, size, alignment), 0);
+    EXPECT_EQ(addr, expected);
+  }
+
+  EXPECT_EQ(allocator.allocated_map.num_items, 4096 + 200);
+
+  mem_alloc_destroy(&allocator);
+}
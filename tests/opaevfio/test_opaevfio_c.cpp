@@ -0,0 +1,158 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <pthread.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+#include "mock/opae_std.h"
+
+#include <opae/vfio.h>
+
+extern "C" {
+size_t opae_vfio_huge_mix_size(size_t len, size_t *len_1g);
+struct opae_vfio_buffer *
+opae_vfio_create_buffer(uint8_t *vaddr,
+                        size_t size,
+                        uint64_t iova,
+                        int flags,
+                        size_t requested_size);
+void opae_vfio_destroy_buffer(struct opae_vfio *v,
+                              struct opae_vfio_buffer *b);
+}
+
+#define SIZE_2M (2ULL * 1024 * 1024)
+#define SIZE_1G (1024ULL * 1024 * 1024)
+
+/**
+ * @test    huge_mix_small
+ * @brief   Test: opae_vfio_huge_mix_size()
+ * @details A request of less than 1GB is rounded up to<br>
+ *          whole 2MB pages, with no 1GB pages.<br>
+ */
+TEST(opaevfio, huge_mix_small)
+{
+  size_t len_1g = 1;
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(4097, &len_1g), SIZE_2M);
+  EXPECT_EQ(len_1g, 0);
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(SIZE_2M, &len_1g), SIZE_2M);
+  EXPECT_EQ(len_1g, 0);
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(3 * 1024 * 1024, &len_1g), 2 * SIZE_2M);
+  EXPECT_EQ(len_1g, 0);
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(SIZE_1G - SIZE_2M, &len_1g),
+            SIZE_1G - SIZE_2M);
+  EXPECT_EQ(len_1g, 0);
+}
+
+/**
+ * @test    huge_mix_bulk
+ * @brief   Test: opae_vfio_huge_mix_size()
+ * @details A request of 1GB or more is backed by whole 1GB<br>
+ *          pages for its bulk and 2MB pages for the rest,<br>
+ *          pinning less than 2MB beyond the request.<br>
+ */
+TEST(opaevfio, huge_mix_bulk)
+{
+  size_t len_1g = 0;
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(SIZE_1G, &len_1g), SIZE_1G);
+  EXPECT_EQ(len_1g, SIZE_1G);
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(SIZE_1G + 1, &len_1g),
+            SIZE_1G + SIZE_2M);
+  EXPECT_EQ(len_1g, SIZE_1G);
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(2 * SIZE_1G + 3 * 1024 * 1024, &len_1g),
+            2 * SIZE_1G + 2 * SIZE_2M);
+  EXPECT_EQ(len_1g, 2 * SIZE_1G);
+}
+
+/**
+ * @test    huge_mix_promote
+ * @brief   Test: opae_vfio_huge_mix_size()
+ * @details When the 2MB remainder adds up to a whole 1GB,<br>
+ *          one more 1GB page is used instead.<br>
+ */
+TEST(opaevfio, huge_mix_promote)
+{
+  size_t len_1g = 0;
+
+  EXPECT_EQ(opae_vfio_huge_mix_size(2 * SIZE_1G - SIZE_2M + 1, &len_1g),
+            2 * SIZE_1G);
+  EXPECT_EQ(len_1g, 2 * SIZE_1G);
+}
+
+/**
+ * @test    buffer_stats
+ * @brief   Test: opae_vfio_buffer_stats()
+ * @details Destroying a buffer subtracts its requested<br>
+ *          and pinned sizes from the device totals.<br>
+ */
+TEST(opaevfio, buffer_stats)
+{
+  struct opae_vfio v;
+  size_t requested = 1;
+  size_t pinned = 1;
+  uint8_t mem[64];
+
+  EXPECT_NE(opae_vfio_buffer_stats(nullptr, &requested, &pinned), 0);
+
+  memset(&v, 0, sizeof(v));
+  v.cont_fd = -1;
+  ASSERT_EQ(pthread_mutex_init(&v.lock, nullptr), 0);
+
+  EXPECT_EQ(opae_vfio_buffer_stats(&v, &requested, &pinned), 0);
+  EXPECT_EQ(requested, 0);
+  EXPECT_EQ(pinned, 0);
+
+  // As recorded by opae_vfio_buffer_allocate_ex().
+  struct opae_vfio_buffer *b =
+    opae_vfio_create_buffer(mem, 2 * SIZE_2M, 0, OPAE_VFIO_BUF_PREALLOCATED,
+                            3 * 1024 * 1024);
+  ASSERT_NE(b, nullptr);
+  v.buf_requested += b->requested_size;
+  v.buf_pinned += b->buffer_size;
+
+  EXPECT_EQ(opae_vfio_buffer_stats(&v, &requested, nullptr), 0);
+  EXPECT_EQ(requested, 3 * 1024 * 1024);
+  EXPECT_EQ(opae_vfio_buffer_stats(&v, nullptr, &pinned), 0);
+  EXPECT_EQ(pinned, 2 * SIZE_2M);
+
+  opae_vfio_destroy_buffer(&v, b);
+
+  EXPECT_EQ(opae_vfio_buffer_stats(&v, &requested, &pinned), 0);
+  EXPECT_EQ(requested, 0);
+  EXPECT_EQ(pinned, 0);
+
+  EXPECT_EQ(pthread_mutex_destroy(&v.lock), 0);
+}
@@ -255,6 +255,40 @@ TEST_P(metrics_c_p, test_metric_04) {
   opae_free(metric_array_search);
 }
 
+/**
+* @test    snapshot
+* @brief   Tests: xfpga_fpgaGetMetricsSnapshot
+* @details Validates the size query, a full snapshot<br>
+*          and invalid parameters.<br>
+*/
+TEST_P(metrics_c_p, snapshot) {
+  uint64_t num_metrics = 0;
+  uint64_t num_snapshot = 0;
+  uint64_t timestamp = 0;
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaGetNumMetrics(device_, &num_metrics));
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaGetMetricsSnapshot(device_, NULL,
+                                                  &num_snapshot, NULL));
+  EXPECT_EQ(num_metrics, num_snapshot);
+
+  std::vector<fpga_metric> metrics(num_snapshot + 1);
+  num_snapshot = metrics.size();
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaGetMetricsSnapshot(device_, metrics.data(),
+                                                  &num_snapshot, &timestamp));
+  EXPECT_EQ(num_metrics, num_snapshot);
+  EXPECT_NE(0, timestamp);
+  for (uint64_t i = 0; i < num_snapshot; ++i) {
+    EXPECT_EQ(i, metrics[i].metric_num);
+  }
+
+  EXPECT_EQ(FPGA_INVALID_PARAM,
+            xfpga_fpgaGetMetricsSnapshot(NULL, metrics.data(),
+                                         &num_snapshot, NULL));
+  EXPECT_EQ(FPGA_INVALID_PARAM,
+            xfpga_fpgaGetMetricsSnapshot(device_, metrics.data(),
+                                         NULL, NULL));
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(metrics_c_p);
 INSTANTIATE_TEST_SUITE_P(metrics_c, metrics_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({"dcp-rc"})));
@@ -295,6 +295,51 @@ TEST_P(metrics_utils_c_p, test_metric_utils_15) {
   EXPECT_NE(FPGA_OK, get_fpga_object_type(device_, NULL));
 }
 
+/**
+ * @test       name_index
+ * @brief      Tests: build_metric_name_index, find_metric_num_by_name,
+ *             find_enum_metric
+ * @details    Name lookups through the hash index are case-insensitive<br>
+ *             and return the first metric of a repeated name.<br>
+ */
+TEST_P(metrics_utils_c_p, name_index) {
+  struct _fpga_handle h;
+  uint64_t metric_num = 99;
+  const char *names[] = { "Board Power", "board power", "FPGA Core Temperature" };
+  uint64_t i;
+
+  memset(&h, 0, sizeof(h));
+  h.magic = FPGA_HANDLE_MAGIC;
+  ASSERT_EQ(FPGA_OK, fpga_vector_init(&h.fpga_enum_metric_vector));
+
+  for (i = 0; i < 3; i++) {
+    ASSERT_EQ(FPGA_OK, add_metric_vector(&h.fpga_enum_metric_vector, i,
+                                         "q", "g", "", names[i], "", "",
+                                         FPGA_METRIC_DATATYPE_DOUBLE,
+                                         FPGA_METRIC_TYPE_POWER,
+                                         FPGA_HW_DCP_D5005, 0));
+  }
+
+  ASSERT_EQ(FPGA_OK, build_metric_name_index(&h));
+  ASSERT_NE(nullptr, h.metric_name_index);
+  EXPECT_GE(h.metric_name_index_size, 6);
+
+  EXPECT_EQ(FPGA_OK, find_metric_num_by_name(&h, "BOARD POWER", &metric_num));
+  EXPECT_EQ(0, metric_num);
+  EXPECT_EQ(FPGA_OK, find_metric_num_by_name(&h, "fpga core temperature",
+                                             &metric_num));
+  EXPECT_EQ(2, metric_num);
+  EXPECT_EQ(FPGA_NOT_FOUND, find_metric_num_by_name(&h, "Board", &metric_num));
+  EXPECT_EQ(FPGA_INVALID_PARAM, find_metric_num_by_name(&h, NULL, &metric_num));
+
+  ASSERT_NE(nullptr, find_enum_metric(&h.fpga_enum_metric_vector, 1));
+  EXPECT_EQ(1, find_enum_metric(&h.fpga_enum_metric_vector, 1)->metric_num);
+  EXPECT_EQ(nullptr, find_enum_metric(&h.fpga_enum_metric_vector, 3));
+
+  EXPECT_EQ(FPGA_OK, free_fpga_enum_metrics_vector(&h));
+  EXPECT_EQ(nullptr, h.metric_name_index);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(metrics_utils_c_p);
 INSTANTIATE_TEST_SUITE_P(metrics_utils_c, metrics_utils_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({"dcp-rc"})));
@@ -32,6 +32,8 @@
 KEEP_XFPGA_SYMBOLS
 
 #include <linux/ioctl.h>
+#include <atomic>
+#include <thread>
 
 #include "fpga-dfl.h"
 #include <opae/access.h>
@@ -49,6 +51,11 @@ using namespace opae::testing;
 
 #ifndef BUILD_ASE
 
+static uint32_t h_readers(fpga_handle handle) {
+  struct _fpga_handle *h = (struct _fpga_handle *)handle;
+  return __atomic_load_n(&h->mmio_regions[0].readers, __ATOMIC_SEQ_CST);
+}
+
 /*
  * On hardware, the mmio map is a hash table.
  */
@@ -446,6 +453,117 @@ TEST_P (mmio_c_p, test_neg_read_write_512) {
 #endif
 }
 
+/**
+* @test       mmio_c_p
+* @brief      Test: test_mmio_vec
+* @details    xfpga_fpgaWriteMMIOv writes every entry of a batch and
+*             xfpga_fpgaReadMMIOv reads them back. A batch containing a
+*             misaligned or out-of-bounds entry is rejected as a whole.
+*
+*/
+TEST_P (mmio_c_p, test_mmio_vec) {
+  fpga_mmio_vec wr[] = {
+    { CSR_SCRATCHPAD0,     0xdecafbad, 32, 0 },
+    { CSR_SCRATCHPAD0 + 8, 0xdeadbeefdeadbeef, 64, FPGA_MMIO_FENCE },
+  };
+  fpga_mmio_vec rd[] = {
+    { CSR_SCRATCHPAD0,     0, 32, 0 },
+    { CSR_SCRATCHPAD0 + 8, 0, 64, 0 },
+  };
+  fpga_mmio_vec bad[] = {
+    { CSR_SCRATCHPAD0,     0, 64, 0 },
+    { CSR_SCRATCHPAD0 + 4, 0, 64, 0 },
+    { MMIO_OUT_REGION_ADDRESS, 0, 64, 0 },
+  };
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaWriteMMIOv(accel_, 0, wr, 2));
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaReadMMIOv(accel_, 0, rd, 2));
+  EXPECT_EQ(rd[0].value, wr[0].value);
+  EXPECT_EQ(rd[1].value, wr[1].value);
+
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaWriteMMIOv(accel_, 0, bad, 2));
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaReadMMIOv(accel_, 0, &bad[2], 1));
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaReadMMIOv(accel_, 0, NULL, 1));
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaReadMMIOv(NULL, 0, rd, 2));
+
+  // The rejected batch left the scratchpad untouched.
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaReadMMIOv(accel_, 0, rd, 1));
+  EXPECT_EQ(rd[0].value, wr[0].value);
+
+#ifndef BUILD_ASE
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaUnmapMMIO(accel_, 0));
+#endif
+}
+
+#ifndef BUILD_ASE
+/**
+* @test       mmio_c_p
+* @brief      Test: test_mmio_region_publish
+* @details    The first MMIO access to a region publishes it in the
+*             handle's lock-free region table.
+*             xfpga_fpgaUnmapMMIO withdraws it again.
+*
+*/
+TEST_P (mmio_c_p, test_mmio_region_publish) {
+  struct _fpga_handle *h = (struct _fpga_handle *)accel_;
+  uint64_t value = 0;
+
+  EXPECT_EQ(h->mmio_regions[0].base, nullptr);
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaReadMMIO64(accel_, 0, CSR_SCRATCHPAD0, &value));
+  EXPECT_NE(h->mmio_regions[0].base, nullptr);
+  EXPECT_EQ(h->mmio_regions[0].len, 0x40000);
+
+  // An access that would run past the end of the region is rejected.
+  EXPECT_EQ(FPGA_INVALID_PARAM,
+            xfpga_fpgaReadMMIO64(accel_, 0, 0x40000, &value));
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaUnmapMMIO(accel_, 0));
+  EXPECT_EQ(h->mmio_regions[0].base, nullptr);
+}
+
+/**
+* @test       mmio_c_p
+* @brief      Test: test_mmio_mt_unmap
+* @details    Several threads access the same handle concurrently
+*             while another thread repeatedly unmaps the region.
+*             In-flight accesses must complete against a live
+*             mapping, and later ones must remap it on demand.
+*
+*/
+TEST_P (mmio_c_p, test_mmio_mt_unmap) {
+  const int num_threads = 4;
+  const int iterations = 10000;
+  std::vector<std::thread> threads;
+  std::atomic<int> failures(0);
+  std::atomic<int> running(num_threads);
+
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      uint64_t v = 0;
+      uint64_t offset = CSR_SCRATCHPAD0 + t * sizeof(uint64_t);
+      for (int i = 0; i < iterations; ++i) {
+        if (xfpga_fpgaWriteMMIO64(accel_, 0, offset, i) ||
+            xfpga_fpgaReadMMIO64(accel_, 0, offset, &v))
+          ++failures;
+      }
+      --running;
+    });
+  }
+
+  // The region may or may not be mapped at any given moment.
+  while (running > 0) {
+    xfpga_fpgaUnmapMMIO(accel_, 0);
+    std::this_thread::yield();
+  }
+
+  for (auto &th : threads)
+    th.join();
+
+  EXPECT_EQ(failures, 0);
+  EXPECT_EQ(h_readers(accel_), 0u);
+}
+#endif // BUILD_ASE
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(mmio_c_p);
 INSTANTIATE_TEST_SUITE_P(mmio_c, mmio_c_p,
                          ::testing::ValuesIn(test_platform::platforms({
@@ -27,6 +27,8 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <chrono>
+
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
 KEEP_XFPGA_SYMBOLS
@@ -232,6 +234,98 @@ TEST_P(sysobject_mock_p, xfpga_fpgaGetSize) {
   EXPECT_EQ(xfpga_fpgaDestroyObject(&object), FPGA_OK);
 }
 
+/**
+ * @test       xfpga_fpgaObjectReadRaw
+ *
+ * @brief      Given an attribute object
+ *             When I call xfpga_fpgaObjectRead with FPGA_OBJECT_RAW
+ *             Then only the requested window is read from the attribute,
+ *             And the attribute fd is opened once and kept open,
+ *             And windows that extend past the end of the attribute
+ *             return FPGA_INVALID_PARAM.
+ */
+TEST_P(sysobject_mock_p, xfpga_fpgaObjectReadRaw) {
+  _fpga_token *tk = static_cast<_fpga_token *>(device_token_);
+  std::string syspath(tk->sysfspath);
+  syspath += "/testdata";
+  auto fp = system_->register_file(syspath);
+  ASSERT_NE(fp, nullptr) << strerror(errno);
+  fwrite(DATA.c_str(), DATA.size(), 1, fp);
+  fflush(fp);
+  opae_fclose(fp);
+  fpga_object object;
+  ASSERT_EQ(xfpga_fpgaTokenGetObject(device_token_, "testdata", &object, 0),
+            FPGA_OK);
+  _fpga_object *obj = static_cast<_fpga_object *>(object);
+  int fd = obj->fd;
+  EXPECT_GE(fd, 0);
+  EXPECT_EQ(obj->file_size, DATA.size());
+
+  std::vector<uint8_t> buffer(11, 0);
+  EXPECT_EQ(xfpga_fpgaObjectRead(object, buffer.data(), 26, 10,
+                                 FPGA_OBJECT_RAW), FPGA_OK);
+  EXPECT_STREQ(reinterpret_cast<const char *>(buffer.data()),
+               DATA.substr(26, 10).c_str());
+  EXPECT_EQ(xfpga_fpgaObjectRead(object, buffer.data(), DATA.size() - 5, 10,
+                                 FPGA_OBJECT_RAW), FPGA_INVALID_PARAM);
+
+  uint32_t size = 0;
+  EXPECT_EQ(xfpga_fpgaObjectGetSize(object, &size, FPGA_OBJECT_SYNC), FPGA_OK);
+  EXPECT_EQ(size, DATA.size());
+  EXPECT_EQ(obj->fd, fd);
+  EXPECT_EQ(xfpga_fpgaDestroyObject(&object), FPGA_OK);
+}
+
+#ifdef OPAE_BENCHMARK
+/**
+ * @test       bench_fpgaObjectRead
+ *
+ * @brief      Reports the latency of reading a small window of a large
+ *             binary attribute with FPGA_OBJECT_SYNC (whole attribute
+ *             re-read into the object buffer) versus FPGA_OBJECT_RAW
+ *             (only the requested window is read).
+ *             Built only with OPAE_BUILD_BENCHMARKS.
+ */
+TEST_P(sysobject_mock_p, bench_fpgaObjectRead) {
+  const int iterations = 1000;
+  const size_t attr_size = 0x20000;
+  _fpga_token *tk = static_cast<_fpga_token *>(device_token_);
+  std::string syspath(tk->sysfspath);
+  syspath += "/nvmem";
+  auto fp = system_->register_file(syspath);
+  ASSERT_NE(fp, nullptr) << strerror(errno);
+  std::vector<uint8_t> contents(attr_size, 0xa5);
+  fwrite(contents.data(), contents.size(), 1, fp);
+  fflush(fp);
+  opae_fclose(fp);
+  fpga_object object;
+  ASSERT_EQ(xfpga_fpgaTokenGetObject(device_token_, "nvmem", &object, 0),
+            FPGA_OK);
+
+  std::vector<uint8_t> buffer(64);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    ASSERT_EQ(xfpga_fpgaObjectRead(object, buffer.data(), attr_size / 2,
+                                   buffer.size(), FPGA_OBJECT_SYNC), FPGA_OK);
+  }
+  auto sync = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    ASSERT_EQ(xfpga_fpgaObjectRead(object, buffer.data(), attr_size / 2,
+                                   buffer.size(), FPGA_OBJECT_RAW), FPGA_OK);
+  }
+  auto raw = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(buffer[0], 0xa5);
+
+  using usec = std::chrono::duration<double, std::micro>;
+  std::cout << "fpgaObjectRead " << attr_size << " byte attribute sync: "
+            << usec(sync).count() / iterations << " us, raw window: "
+            << usec(raw).count() / iterations << " us" << std::endl;
+  EXPECT_EQ(xfpga_fpgaDestroyObject(&object), FPGA_OK);
+}
+#endif // OPAE_BENCHMARK
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(sysobject_mock_p);
 INSTANTIATE_TEST_SUITE_P(sysobject_c, sysobject_mock_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({
@@ -373,6 +373,63 @@ TEST_P(reconf_c_mock_p, fpga_reconf_slot_enotsup) {
   EXPECT_EQ(result, FPGA_EXCEPTION);
 }
 
+static void count_progress(fpga_reconf_phase phase, size_t bytes_written,
+                           size_t bytes_total, void *context) {
+  auto calls = reinterpret_cast<std::vector<std::array<size_t, 3>> *>(context);
+  calls->push_back({ size_t(phase), bytes_written, bytes_total });
+}
+
+/**
+ * @test    fpga_reconf_slot_progress
+ * @brief   Tests: xfpga_fpgaReconfigureSlotProgress
+ * @details Given a valid bitstream, the progress callback is called
+ *          for validation, error clearing and before and after the
+ *          PR ioctl, with the payload size once it is known.
+ */
+TEST_P(reconf_c_mock_p, fpga_reconf_slot_progress) {
+  std::vector<std::array<size_t, 3>> calls;
+
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotProgress(device_, 0,
+                                              bitstream_valid_.data(),
+                                              bitstream_valid_.size(), 0,
+                                              count_progress, &calls),
+            FPGA_OK);
+
+  int header_len = 0;
+  ASSERT_EQ(validate_bitstream(device_, bitstream_valid_.data(),
+                               bitstream_valid_.size(), &header_len),
+            FPGA_OK);
+  size_t payload = bitstream_valid_.size() - header_len;
+
+  std::vector<std::array<size_t, 3>> expected = {
+    { size_t(FPGA_RECONF_PHASE_VALIDATE), 0, 0 },
+    { size_t(FPGA_RECONF_PHASE_CLEAR_ERRORS), 0, payload },
+    { size_t(FPGA_RECONF_PHASE_PROGRAM), 0, payload },
+    { size_t(FPGA_RECONF_PHASE_PROGRAM), payload, payload }
+  };
+  EXPECT_EQ(calls, expected);
+}
+
+/**
+ * @test    fpga_reconf_slot_progress_einval
+ * @brief   Tests: xfpga_fpgaReconfigureSlotProgress
+ * @details When the PR ioctl fails, the callback is not told that
+ *          the payload was written.
+ */
+TEST_P(reconf_c_mock_p, fpga_reconf_slot_progress_einval) {
+  std::vector<std::array<size_t, 3>> calls;
+
+  system_->register_ioctl_handler(DFL_FPGA_FME_PORT_PR, dummy_ioctl<-1, EINVAL>);
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotProgress(device_, 0,
+                                              bitstream_valid_.data(),
+                                              bitstream_valid_.size(), 0,
+                                              count_progress, &calls),
+            FPGA_INVALID_PARAM);
+  ASSERT_FALSE(calls.empty());
+  EXPECT_EQ(calls.back()[0], size_t(FPGA_RECONF_PHASE_PROGRAM));
+  EXPECT_EQ(calls.back()[1], 0u);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(reconf_c_mock_p);
 INSTANTIATE_TEST_SUITE_P(reconf, reconf_c_mock_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({ "dfl-n3000","dfl-d5005" })));
@@ -33,7 +33,10 @@ KEEP_XFPGA_SYMBOLS
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <fcntl.h>
+#include <chrono>
+#include <iostream>
 
 extern "C" {
 #include "sysfs_int.h"
@@ -57,6 +60,8 @@ ssize_t eintr_write(int, void *, size_t);
 int parse_pcie_info(sysfs_fpga_device *device, char *buffer);
 fpga_result sysfs_get_interface_id(fpga_token token, fpga_guid guid);
 sysfs_fpga_region* make_region(sysfs_fpga_device*, char*, int, fpga_objtype);
+extern int _sysfs_uevent_fd;
+extern uint64_t _sysfs_rescans;
 fpga_result re_match_region(const char *fmt, char *inpstr, char type[], size_t,
                             int *num);
 int xfpga_plugin_initialize(void);
@@ -239,6 +244,93 @@ TEST_P(sysfsinit_c_p, sysfs_get_device) {
   EXPECT_EQ(devices.size(), 0);
 }
 
+/**
+ * @test       foreach_cached
+ *
+ * @brief      Given an initialized sysfs device list
+ *             And a stand-in for the kernel uevent socket
+ *             When I call sysfs_foreach_device twice
+ *             And no uevent arrives, or only a "change" uevent
+ *             Then the walks reuse the cached device list
+ *             instead of rescanning sysfs,
+ *             And an "add" uevent makes the next walk rescan,
+ *             And after sysfs_finalize the next walk rescans.
+ */
+TEST_P(sysfsinit_c_p, foreach_cached) {
+  auto cb = [](const sysfs_fpga_device *, void *) -> fpga_result {
+    return FPGA_OK;
+  };
+  const char change[] = "change@/devices/pci0000:00/0000:00:02.0";
+  const char add[] = "add@/devices/pci0000:00/0000:00:02.0";
+  int sv[2];
+
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+
+  // Replace the netlink socket, so that uevents from the host
+  // can't trigger rescans: only those sent below are seen.
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sv), 0);
+  if (_sysfs_uevent_fd >= 0)
+    close(_sysfs_uevent_fd);
+  _sysfs_uevent_fd = sv[0];
+
+  uint64_t rescans = _sysfs_rescans;
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  EXPECT_EQ(rescans, _sysfs_rescans);
+
+  ASSERT_EQ(send(sv[1], change, sizeof(change), 0), (ssize_t)sizeof(change));
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  EXPECT_EQ(rescans, _sysfs_rescans);
+
+  ASSERT_EQ(send(sv[1], add, sizeof(add), 0), (ssize_t)sizeof(add));
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  EXPECT_EQ(rescans + 1, _sysfs_rescans);
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  EXPECT_EQ(rescans + 1, _sysfs_rescans);
+
+  // sysfs_finalize closes sv[0].
+  ASSERT_EQ(sysfs_finalize(), FPGA_OK);
+  EXPECT_EQ(_sysfs_uevent_fd, -1);
+  ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  EXPECT_EQ(rescans + 2, _sysfs_rescans);
+
+  close(sv[1]);
+}
+
+#ifdef OPAE_BENCHMARK
+/**
+ * @test       bench_foreach_device
+ *
+ * @brief      Reports the latency of sysfs_foreach_device when the
+ *             device list must be rebuilt (cold) versus when the
+ *             cached topology is reused (warm).
+ *             Built only with OPAE_BUILD_BENCHMARKS.
+ */
+TEST_P(sysfsinit_c_p, bench_foreach_device) {
+  const int iterations = 100;
+  auto cb = [](const sysfs_fpga_device *, void *) -> fpga_result {
+    return FPGA_OK;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    ASSERT_EQ(sysfs_finalize(), FPGA_OK);
+    ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  }
+  auto cold = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    ASSERT_EQ(sysfs_foreach_device(cb, nullptr), FPGA_OK);
+  }
+  auto warm = std::chrono::steady_clock::now() - start;
+
+  using usec = std::chrono::duration<double, std::micro>;
+  std::cout << "sysfs_foreach_device cold: "
+            << usec(cold).count() / iterations << " us, warm: "
+            << usec(warm).count() / iterations << " us" << std::endl;
+}
+#endif // OPAE_BENCHMARK
 
 TEST(sysfsinit_c_p, sysfs_parse_pcie) {
   sysfs_fpga_device device;
@@ -27,6 +27,10 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
 KEEP_XFPGA_SYMBOLS
@@ -101,6 +105,167 @@ TEST(usrclk_c, get_userclock_null) {
   EXPECT_EQ(result, FPGA_INVALID_PARAM);
 }
 
+/*
+ * Simulated IOPLL behind the user clock CSRs. A model thread watches
+ * IOPLL_FREQ_CMD0 and, like the hardware, acknowledges each AVMM
+ * transaction by echoing its sequence number in IOPLL_FREQ_STS0 after
+ * ack_delay_us, and asserts IOPLL_LOCKED lock_delay_us after the resets
+ * are released. A negative lock_delay_us models a PLL that never locks.
+ */
+class iopll_model {
+ public:
+  iopll_model(uint64_t ack_delay_us, int64_t lock_delay_us)
+    : ack_delay_us_(ack_delay_us),
+      lock_delay_us_(lock_delay_us),
+      csr_(),
+      regs_(),
+      stop_(false) {
+    store(IOPLL_FREQ_STS0, IOPLL_LOCKED);
+    thread_ = std::thread(&iopll_model::run, this);
+  }
+
+  ~iopll_model() {
+    stop_ = true;
+    thread_.join();
+  }
+
+  uint8_t *csr() { return reinterpret_cast<uint8_t *>(csr_); }
+
+  uint32_t reg(uint16_t address) const { return regs_[address]; }
+
+ private:
+  static uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint64_t load(uint32_t offset) {
+    return __atomic_load_n(&csr_[offset / 8], __ATOMIC_ACQUIRE);
+  }
+
+  void store(uint32_t offset, uint64_t value) {
+    __atomic_store_n(&csr_[offset / 8], value, __ATOMIC_RELEASE);
+  }
+
+  void run() {
+    uint64_t last = 0;
+    uint64_t pending = 0;
+    uint64_t ack_at = 0;
+    uint64_t lock_at = 0;
+    uint64_t sts = 0;
+    bool acking = false;
+    bool in_reset = false;
+    bool locked = true;
+
+    while (!stop_) {
+      uint64_t now = now_us();
+      uint64_t cmd = load(IOPLL_FREQ_CMD0);
+
+      if (cmd != last) {
+        last = cmd;
+        if (cmd & (IOPLL_MGMT_RESET | IOPLL_RESET)) {
+          in_reset = true;
+          locked = false;
+          lock_at = 0;
+        } else if (in_reset) {
+          in_reset = false;
+          if (lock_delay_us_ >= 0)
+            lock_at = now + lock_delay_us_;
+        } else {
+          pending = cmd;
+          ack_at = now + ack_delay_us_;
+          acking = true;
+        }
+      }
+
+      if (lock_at && now >= lock_at) {
+        locked = true;
+        lock_at = 0;
+      }
+
+      if (acking && now >= ack_at) {
+        uint16_t address = FIELD_GET(IOPLL_ADDR, pending);
+        if (pending & IOPLL_WRITE)
+          regs_[address] = FIELD_GET(IOPLL_DATA, pending);
+        sts = FIELD_PREP(IOPLL_SEQ, FIELD_GET(IOPLL_SEQ, pending)) |
+              FIELD_PREP(IOPLL_DATA, regs_[address]);
+        acking = false;
+      }
+
+      store(IOPLL_FREQ_STS0, sts | (locked ? IOPLL_LOCKED : 0));
+      std::this_thread::yield();
+    }
+  }
+
+  uint64_t ack_delay_us_;
+  int64_t lock_delay_us_;
+  alignas(64) uint64_t csr_[8];
+  uint32_t regs_[1024];
+  std::atomic<bool> stop_;
+  std::thread thread_;
+};
+
+/**
+* @test    usrclk_program_model
+* @brief   Tests: usrclk_program
+* @details Against a simulated IOPLL, usrclk_program writes the PLL
+*          settings for the requested frequency, waits for lock and
+*          reports the time spent in each phase.
+*/
+TEST(usrclk_c, usrclk_program_model) {
+  iopll_model model(2, 100);
+  struct pll_config *c = (struct pll_config *)&iopll_freq_config[156];
+  struct usrclk_timing timing;
+
+  ASSERT_EQ(usrclk_program(model.csr(), c, &timing), FPGA_OK);
+
+  EXPECT_EQ(model.reg(PLL_M_HIGH_ADDR), FIELD_GET(CFG_PLL_HIGH, c->pll_m));
+  EXPECT_EQ(model.reg(PLL_M_LOW_ADDR), FIELD_GET(CFG_PLL_LOW, c->pll_m));
+  EXPECT_EQ(model.reg(PLL_C1_HIGH_ADDR), FIELD_GET(CFG_PLL_HIGH, c->pll_c1));
+  EXPECT_EQ(model.reg(PLL_ENABLE_CAL_ADDR), PLL_ENABLE_CALIBRATION);
+
+  EXPECT_GT(timing.config_us, 0);
+  EXPECT_GE(timing.reset_us, 2 * IOPLL_RESET_DELAY_US);
+  EXPECT_LT(timing.lock_us, IOPLL_LOCK_TIMEOUT_US);
+  EXPECT_GE(timing.calibrate_us, IOPLL_CAL_DELAY_US);
+}
+
+/**
+* @test    usrclk_program_slow_lock
+* @brief   Tests: usrclk_program
+* @details When the simulated IOPLL takes longer to lock than the
+*          reset hold time, usrclk_program keeps polling the lock bit
+*          and succeeds once it is set.
+*/
+TEST(usrclk_c, usrclk_program_slow_lock) {
+  iopll_model model(2, 5000);
+  struct pll_config *c = (struct pll_config *)&iopll_freq_config[156];
+  struct usrclk_timing timing;
+
+  ASSERT_EQ(usrclk_program(model.csr(), c, &timing), FPGA_OK);
+  EXPECT_GE(timing.lock_us, 4000);
+  EXPECT_LT(timing.lock_us, IOPLL_LOCK_TIMEOUT_US);
+}
+
+/**
+* @test    usrclk_program_no_lock
+* @brief   Tests: usrclk_program
+* @details When the simulated IOPLL never locks, usrclk_program
+*          gives up after IOPLL_LOCK_TIMEOUT_US and returns FPGA_BUSY.
+*/
+TEST(usrclk_c, usrclk_program_no_lock) {
+  iopll_model model(2, -1);
+  struct pll_config *c = (struct pll_config *)&iopll_freq_config[156];
+  struct usrclk_timing timing;
+
+  EXPECT_EQ(usrclk_program(model.csr(), c, &timing), FPGA_BUSY);
+  EXPECT_GE(timing.lock_us, IOPLL_LOCK_TIMEOUT_US);
+
+  EXPECT_EQ(usrclk_program(NULL, c, &timing), FPGA_INVALID_PARAM);
+  EXPECT_EQ(usrclk_program(model.csr(), NULL, &timing), FPGA_INVALID_PARAM);
+  EXPECT_EQ(usrclk_program(model.csr(), c, NULL), FPGA_INVALID_PARAM);
+}
+
 /**
 * @test    fpga_set_user_clock
 * @brief   Tests: fpgaSetUserClock
@@ -32,6 +32,8 @@ extern "C" {
 #include "wsid_list_int.h"
 }
 
+#include <chrono>
+#include <iostream>
 #include <random>
 
 #include "gtest/gtest.h"
@@ -186,3 +188,158 @@ TEST_F(wsid_list_f, stress) {
   EXPECT_EQ(stress_count, 0);
   wsid_root_ = nullptr;
 }
+
+/**
+ * @test    wsid_grow
+ * @brief   Test: wsid_add, wsid_find
+ * @details The tracker grows past its initial capacity hint,<br>
+ *          keeps its load factor at or below one half,<br>
+ *          and every entry is still found after growing.<br>
+ */
+TEST(wsid_list_c, wsid_grow) {
+  struct wsid_tracker *root = wsid_tracker_init(4);
+  ASSERT_NE(root, nullptr);
+  const uint64_t n = 20000;
+  uint64_t i;
+
+  for (i = 0; i < n; ++i) {
+    ASSERT_TRUE(wsid_add(root, index_to_wsid(i), index_to_addr(i),
+                         index_to_phys(i), index_to_len(i),
+                         index_to_offset(i), 0, 0));
+  }
+
+  EXPECT_EQ(root->n_entries, n);
+  EXPECT_LE(root->n_entries * 2, root->n_hash_buckets);
+  EXPECT_EQ(root->n_hash_buckets & (root->n_hash_buckets - 1), 0);
+
+  for (i = 0; i < n; ++i) {
+    wsid_map *ws = wsid_find(root, index_to_wsid(i));
+    ASSERT_NE(ws, nullptr);
+    EXPECT_EQ(ws->addr, index_to_addr(i));
+  }
+  EXPECT_EQ(wsid_find(root, index_to_wsid(n) + 1), nullptr);
+
+  wsid_tracker_cleanup(root, nullptr);
+}
+
+/**
+ * @test    wsid_churn
+ * @brief   Test: wsid_add, wsid_del, wsid_find
+ * @details Deleting every other entry and then re-adding new<br>
+ *          entries leaves every live wsid findable and every<br>
+ *          deleted wsid absent.<br>
+ */
+TEST(wsid_list_c, wsid_churn) {
+  struct wsid_tracker *root = wsid_tracker_init(16);
+  ASSERT_NE(root, nullptr);
+  const uint64_t n = 4096;
+  uint64_t i;
+
+  for (i = 0; i < n; ++i)
+    ASSERT_TRUE(wsid_add(root, i, i, 0, 0, 0, 0, 0));
+
+  for (i = 0; i < n; i += 2)
+    ASSERT_TRUE(wsid_del(root, i));
+
+  for (i = n; i < n + n / 2; ++i)
+    ASSERT_TRUE(wsid_add(root, i, i, 0, 0, 0, 0, 0));
+
+  EXPECT_EQ(root->n_entries, n);
+
+  for (i = 0; i < n + n / 2; ++i) {
+    wsid_map *ws = wsid_find(root, i);
+    if (i < n && !(i & 1)) {
+      EXPECT_EQ(ws, nullptr);
+    } else {
+      ASSERT_NE(ws, nullptr);
+      EXPECT_EQ(ws->addr, i);
+    }
+  }
+
+  stress_count = root->n_entries;
+  wsid_tracker_cleanup(root, cleanup_cb);
+  EXPECT_EQ(stress_count, 0);
+}
+
+/**
+ * @test    wsid_find_by_index_dup
+ * @brief   Test: wsid_find_by_index
+ * @details When several entries share an index, wsid_find_by_index<br>
+ *          returns the most recently added live one, and returns<br>
+ *          NULL once all of them have been deleted. Indices beyond<br>
+ *          the direct index array are still found.<br>
+ */
+TEST(wsid_list_c, wsid_find_by_index_dup) {
+  struct wsid_tracker *root = wsid_tracker_init(4);
+  ASSERT_NE(root, nullptr);
+
+  EXPECT_EQ(wsid_find_by_index(root, 2), nullptr);
+
+  ASSERT_TRUE(wsid_add(root, 100, 0, 0, 0, 0, 2, 0));
+  ASSERT_TRUE(wsid_add(root, 101, 0, 0, 0, 0, 2, 0));
+  ASSERT_TRUE(wsid_add(root, 102, 0, 0, 0, 0, 2, 0));
+  ASSERT_TRUE(wsid_add(root, 200, 0, 0, 0, 0, 7, 0));
+  ASSERT_TRUE(wsid_add(root, 300, 0, 0, 0, 0, 100000, 0));
+
+  ASSERT_NE(wsid_find_by_index(root, 2), nullptr);
+  EXPECT_EQ(wsid_find_by_index(root, 2)->wsid, 102);
+
+  EXPECT_TRUE(wsid_del(root, 101));
+  EXPECT_EQ(wsid_find_by_index(root, 2)->wsid, 102);
+  EXPECT_TRUE(wsid_del(root, 102));
+  EXPECT_EQ(wsid_find_by_index(root, 2)->wsid, 100);
+  EXPECT_TRUE(wsid_del(root, 100));
+  EXPECT_EQ(wsid_find_by_index(root, 2), nullptr);
+
+  ASSERT_NE(wsid_find_by_index(root, 7), nullptr);
+  EXPECT_EQ(wsid_find_by_index(root, 7)->wsid, 200);
+  ASSERT_NE(wsid_find_by_index(root, 100000), nullptr);
+  EXPECT_EQ(wsid_find_by_index(root, 100000)->wsid, 300);
+  EXPECT_EQ(wsid_find_by_index(root, 100001), nullptr);
+
+  wsid_tracker_cleanup(root, nullptr);
+}
+
+#ifdef OPAE_BENCHMARK
+/**
+ * @test    bench_wsid_lookup
+ * @brief   Test: wsid_find, wsid_find_by_index
+ * @details Reports the average wsid_find and wsid_find_by_index<br>
+ *          latency with many live workspaces.<br>
+ *          Built only with OPAE_BUILD_BENCHMARKS.<br>
+ */
+TEST(wsid_list_c, bench_wsid_lookup) {
+  struct wsid_tracker *root = wsid_tracker_init(16);
+  ASSERT_NE(root, nullptr);
+  const uint64_t n = 10000;
+  const uint64_t iters = 1000000;
+  uint64_t i;
+  uint64_t found = 0;
+
+  for (i = 0; i < n; ++i)
+    ASSERT_TRUE(wsid_add(root, index_to_wsid(i), 0, 0, 0, 0, i & 7, 0));
+
+  auto begin = std::chrono::steady_clock::now();
+  for (i = 0; i < iters; ++i)
+    found += wsid_find(root, index_to_wsid(i % n)) != nullptr;
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(found, iters);
+  std::cout << "wsid_find: "
+            << std::chrono::duration<double, std::nano>(end - begin).count() /
+                   iters
+            << " ns/op with " << n << " entries" << std::endl;
+
+  found = 0;
+  begin = std::chrono::steady_clock::now();
+  for (i = 0; i < iters; ++i)
+    found += wsid_find_by_index(root, i & 7) != nullptr;
+  end = std::chrono::steady_clock::now();
+  EXPECT_EQ(found, iters);
+  std::cout << "wsid_find_by_index: "
+            << std::chrono::duration<double, std::nano>(end - begin).count() /
+                   iters
+            << " ns/op" << std::endl;
+
+  wsid_tracker_cleanup(root, nullptr);
+}
+#endif // OPAE_BENCHMARK